@@ -0,0 +1,29 @@
+---@meta
+-- bindings/events.lua
+
+---@alias engine_event event_type|"GameStart"|"ApplyDamageBatch"
+
+---@class DamageEvent
+---@field thing Thing the thing that took the damage, may be dead or gone by the time the batch is delivered
+---@field damage integer
+---@field dealing_player Player
+
+---Subscribes a function to an engine event. It is called with the same parameters as the matching
+---global entry point (e.g. OnApplyDamage for "ApplyDamage"), right after it.
+---"ApplyDamageBatch" has no entry point; its handlers are called once per game turn with a DamageEvent[]
+---holding all damage of the turn, which is much cheaper than "ApplyDamage" when a lot of fighting happens.
+---Handlers are not saved, so register them from the top level of your script, which also runs when a save is loaded.
+---@param event engine_event
+---@param handler function
+---@return integer handler_id to be given to UnregisterEventHandler
+function RegisterEventHandler(event,handler) return 0 end
+
+---Removes a handler added with RegisterEventHandler.
+---@param event engine_event
+---@param handler_id integer
+---@return boolean removed false if there was no such handler for the event
+function UnregisterEventHandler(event,handler_id) return true end
+
+---Tells the engine Game.triggers was changed, so it checks again which events have triggers waiting.
+---Called by the trigger system itself, only needed when editing Game.triggers directly.
+function EventTriggersChanged() end
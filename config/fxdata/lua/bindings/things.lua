@@ -9,6 +9,36 @@
 ---@nodiscard
 function GetThingsOfClass(class) end
 
+---@class ThingView
+---A filtered set of things kept by the engine. Unlike GetThingsOfClass, no Thing is made until it is accessed.
+---view[i] gives the i-th Thing (nil if it died since the query), #view gives the amount of matched things.
+---Views can't be serialized, so don't keep them in the Game table.
+local ThingView = {}
+
+---Runs the query again, reusing the view's memory. Cheaper than a new GetThingsView call every turn.
+---@return integer count amount of things now in the view
+function ThingView:Refresh() return 0 end
+
+---Index of the i-th thing, without making a Thing for it.
+---@param i integer
+---@return integer|nil thing_index nil if out of range or the thing is gone
+function ThingView:Index(i) return 0 end
+
+---Iterates over the things still alive. The same Thing handle is reused for every step,
+---so copy it with GetThingByIdx(thing.ThingIndex) if it needs to be kept.
+---@return fun():integer,Thing
+function ThingView:Each() end
+
+---returns a view on all things of a class, optionally filtered by owner, model and area
+---@param class thing_class
+---@param player? playerrange owner of the things, nil or ALL_PLAYERS for any
+---@param model? creature_type|trap_type|door_type|object_type|integer nil for any model
+---@param location? location center of the area to look in, nil for whole map
+---@param range? integer radius of the area in subtiles, can be left out when location is an action point to use its range
+---@return ThingView
+---@nodiscard
+function GetThingsView(class,player,model,location,range) end
+
 ---gets a single creature based on the given criteria
 ---@param player playerrange
 ---@param creature_type creature_type
@@ -1,6 +1,11 @@
 -- serialization.lua
 -- Internal serialization logic for Lua<->C data.
 -- Used by the engine to serialize complex Lua state; not intended for API users.
+--
+-- The Game table is saved as a list of chunks. Keys registered with TrackGameTable get a chunk
+-- of their own, which is only serialized again once MarkGameTableDirty is called for the key or
+-- another value is assigned to it. Everything else shares the first chunk and is serialized on
+-- every save, like before. Tables shared between two chunks are restored as separate copies.
 
 local binser = require 'external.binser'
 local base64 = require 'external.base64'
@@ -9,28 +14,21 @@ local base64 = require 'external.base64'
 local PlayerMeta = debug.getregistry()["Player"]
 local ThingMeta = debug.getregistry()["Thing"]
 local SlabMeta = debug.getregistry()["Slab"]
+local RoomMeta = debug.getregistry()["Room"]
 
--- Recursively walk table and patch functions + metaclass types
-local function preprocess(value)
-    if type(value) == "function" then
-        return { __serialized_function = base64.encode(string.dump(value)) }
-    elseif type(value) == "table" then
-        local out = {}
-        for k, v in pairs(value) do
-            out[k] = preprocess(v)
-        end
-        return out
-    else
-        return value
-    end
+-- Objects of the C classes are stored as a reference to their metatable, so they need no copying
+for name, meta in pairs({PlayerMeta = PlayerMeta, ThingMeta = ThingMeta, SlabMeta = SlabMeta, RoomMeta = RoomMeta}) do
+    binser.registerResource(meta, name)
 end
 
+-- Recursively walk table and patch functions + metaclass types
+-- Only used to load saves made before the chunked format
 local function postprocess(value)
     if type(value) == "table" then
         if value.__serialized_function then
             local dumped = base64.decode(value.__serialized_function)
             local func, err = load(dumped, nil, "b", _G)
-            assert(func, "Failed to load function" .. (err and (": " .. err) or " (no error given)"))     
+            assert(func, "Failed to load function" .. (err and (": " .. err) or " (no error given)"))
             return func
         end
 
@@ -49,18 +47,89 @@ local function postprocess(value)
     return value
 end
 
-function GetSerializedData()
+-- Keys of Game which are kept in chunks of their own, with the last serialized chunk of each
+local trackedKeys = {}
+
+--- Makes a key of the Game table serialized separately, and only when it changed.
+--- Meant for big tables which rarely change; call MarkGameTableDirty after modifying their contents.
+--- @param key string|number
+function TrackGameTable(key)
+    if trackedKeys[key] == nil then
+        trackedKeys[key] = {}
+    end
+end
+
+--- Puts a tracked key back into the shared chunk, and forgets its last serialized chunk.
+--- @param key string|number
+function UntrackGameTable(key)
+    trackedKeys[key] = nil
+end
+
+--- Tells the serializer the contents of a tracked Game table changed since the last save.
+--- @param key string|number
+function MarkGameTableDirty(key)
+    local tracked = trackedKeys[key]
+    if tracked then
+        tracked.chunk = nil
+    end
+end
+
+--- Returns the Game table as a list of serialized chunks, reusing the ones which did not change.
+--- @return string[]
+function GetSerializedChunks()
     local ok, result = pcall(function()
-        local prepped = preprocess(Game)
-        return binser.serialize(prepped)
+        local untracked = {}
+        for k, v in pairs(Game) do
+            if trackedKeys[k] == nil then
+                untracked[k] = v
+            end
+        end
+        local chunks = { binser.serialize(untracked) }
+        for k, tracked in pairs(trackedKeys) do
+            local value = Game[k]
+            if value ~= nil then
+                if tracked.chunk == nil or not rawequal(tracked.value, value) then
+                    tracked.chunk = binser.serialize(k, value)
+                    tracked.value = value
+                end
+                chunks[#chunks + 1] = tracked.chunk
+            end
+        end
+        return chunks
     end)
-    print("GetSerializedData ok: " .. tostring(ok))
     if not ok then
         error("binser failed: " .. result)
     end
     return result
 end
 
+--- Restores the Game table from chunks made by GetSerializedChunks.
+--- @param chunks string[]
+function SetSerializedChunks(chunks)
+    local ok, result = pcall(function()
+        local restored = binser.deserialize(chunks[1])[1]
+        local keys = {}
+        for i = 2, #chunks do
+            local values = binser.deserialize(chunks[i])
+            local k, v = values[1], values[2]
+            restored[k] = v
+            -- What was just loaded is what would be saved, so keep it as the chunk
+            keys[k] = { chunk = chunks[i], value = v }
+        end
+        -- Keys tracked by the scripts which had nothing to save yet
+        for k in pairs(trackedKeys) do
+            keys[k] = keys[k] or {}
+        end
+        return { game = restored, keys = keys }
+    end)
+    if not ok then
+        error("binser load failed: " .. result)
+    end
+    Game = result.game
+    trackedKeys = result.keys
+end
+
+--- Loads the single blob format of saves made before the chunked one.
 function SetSerializedData(serialized_data)
     local ok, result = pcall(function()
         local values = binser.deserialize(serialized_data)
@@ -0,0 +1,74 @@
+-- serialisation_benchmark.lua
+-- Benchmark for saving and restoring the Lua state of a level.
+--
+-- Fills the Game table with about 10 MB of data, then times GetSerializedChunks and
+-- SetSerializedChunks (what the engine calls when saving and loading) with the data
+-- untracked, tracked but changed, and tracked and unchanged, and prints the results to the log.
+-- The Game table is put back as it was afterwards.
+--
+-- To use:
+--   1. Copy this file to your campaign's lua/ folder
+--   2. Add `require "serialisation_benchmark"` to your init.lua
+--   3. Run BenchmarkSerialisation() from the Lua console
+
+local function make_big_table(target_bytes)
+    local big = {}
+    local padding = string.rep("x", 48)
+    local bytes = 0
+    local i = 0
+    while bytes < target_bytes do
+        i = i + 1
+        big[i] = { name = padding .. i, x = i, y = i * 2, alive = (i % 2 == 0), tags = { i % 7, i % 11 } }
+        -- rough size of one entry once serialized
+        bytes = bytes + 80
+    end
+    return big
+end
+
+local function chunks_size(chunks)
+    local size = 0
+    for _, chunk in ipairs(chunks) do
+        size = size + #chunk
+    end
+    return size
+end
+
+local function time_save(label)
+    local start = os.clock()
+    local chunks = GetSerializedChunks()
+    local elapsed = os.clock() - start
+    print(string.format("  %-28s %8.3f s, %6.2f MB in %d chunks", label, elapsed, chunks_size(chunks) / 1048576, #chunks))
+    return chunks
+end
+
+local function time_restore(label, chunks)
+    local start = os.clock()
+    SetSerializedChunks(chunks)
+    local elapsed = os.clock() - start
+    print(string.format("  %-28s %8.3f s", label, elapsed))
+end
+
+---Runs the benchmark.
+---@param megabytes? integer approximate size of the Lua state to test with, 10 by default
+function BenchmarkSerialisation(megabytes)
+    megabytes = megabytes or 10
+    local original_game = Game
+    Game = {}
+    for k, v in pairs(original_game) do
+        Game[k] = v
+    end
+    Game.benchmark_data = make_big_table(megabytes * 1048576)
+
+    print(string.format("BenchmarkSerialisation: %d MB state", megabytes))
+    local chunks = time_save("save, untracked:")
+    time_restore("restore, untracked:", chunks)
+
+    TrackGameTable("benchmark_data")
+    MarkGameTableDirty("benchmark_data")
+    time_save("save, tracked and changed:")
+    chunks = time_save("save, tracked, no change:")
+    time_restore("restore, tracked:", chunks)
+
+    UntrackGameTable("benchmark_data")
+    Game = original_game
+end
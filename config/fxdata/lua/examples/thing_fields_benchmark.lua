@@ -0,0 +1,53 @@
+-- thing_fields_benchmark.lua
+-- Micro-benchmark for field access on Thing objects.
+--
+-- Reads and writes the fields scripts use most in OnGameTick (pos, health,
+-- owner, and a creature specific one) on every creature of the level, and
+-- prints the time spent per access to the log.
+--
+-- To use:
+--   1. Copy this file to your campaign's lua/ folder
+--   2. Add `require "thing_fields_benchmark"` to your init.lua
+--   3. Run BenchmarkThingFields() from the Lua console, on a level with many creatures
+
+---Runs the benchmark.
+---@param iterations? integer how many times to sweep all creatures, 100 by default
+function BenchmarkThingFields(iterations)
+    iterations = iterations or 100
+    local creatures = GetThingsOfClass("Creature")
+    if #creatures == 0 then
+        print("BenchmarkThingFields: no creatures on the level")
+        return
+    end
+
+    local reads = 0
+    local start = os.clock()
+    for _ = 1, iterations do
+        for _, creature in ipairs(creatures) do
+            local pos = creature.pos
+            local health = creature.health
+            local owner = creature.owner
+            local kills = creature.creature_kills
+            if pos and health and owner and kills then
+                reads = reads + 4
+            end
+        end
+    end
+    local read_time = os.clock() - start
+
+    local writes = 0
+    start = os.clock()
+    for _ = 1, iterations do
+        for _, creature in ipairs(creatures) do
+            creature.health = creature.health
+            creature.orientation = creature.orientation
+            creature.hunger_amount = creature.hunger_amount
+            writes = writes + 3
+        end
+    end
+    local write_time = os.clock() - start
+
+    print(string.format("BenchmarkThingFields: %d creatures, %d iterations", #creatures, iterations))
+    print(string.format("  reads:  %d in %.3f s (%.3f us each)", reads, read_time, read_time * 1000000 / reads))
+    print(string.format("  writes: %d in %.3f s (%.3f us each, including the read of the same field)", writes, write_time, write_time * 1000000 / writes))
+end
@@ -1,6 +1,8 @@
 -- Builtins.lua
 -- Entry points for engine-triggered events (e.g. OnPowerCast, OnGameTick).
 -- These functions are called by the C engine and dispatch event data to the Lua trigger system.
+-- The engine only calls them while Game.triggers holds a trigger for the event, unless a script
+-- replaces them with its own function. Handlers added with RegisterEventHandler are called as well.
 
 ---@alias event_type "PowerCast"|"Death"|"SpecialActivated"|"GameTick"|"ChatMsg"|"DungeonDestroyed"|"TrapPlaced"|"ApplyDamage"|"LevelUp"|"Rebirth"
 
@@ -97,4 +99,18 @@ function OnCreatureRebirth(unit)
     local eventData = {}
     eventData.unit = unit
     ProcessEvent("Rebirth",eventData)
-end
\ No newline at end of file
+end
+
+--- The stock entry points, so the engine can tell them apart from ones a script defined itself
+BuiltinEventHandlers = {
+    PowerCast = OnPowerCast,
+    Death = OnCreatureDeath,
+    GameTick = OnGameTick,
+    SpecialActivated = OnSpecialActivated,
+    ChatMsg = OnChatMsg,
+    TrapPlaced = OnTrapPlaced,
+    DungeonDestroyed = OnDungeonDestroyed,
+    ApplyDamage = OnApplyDamage,
+    LevelUp = OnLevelUp,
+    Rebirth = OnCreatureRebirth,
+}
@@ -83,6 +83,7 @@ function CreateTrigger(event,action,triggerData)
     Game.triggers = Game.triggers or {}
     local trigger = { event = event, conditions = {}, action = action, triggerData = triggerData }
     table.insert(Game.triggers, trigger)
+    EventTriggersChanged()
     return trigger
 end
 
@@ -103,6 +104,7 @@ function RemoveTrigger(trigger)
     for i = #Game.triggers, 1, -1 do
         if Game.triggers[i] == trigger then
             table.remove(Game.triggers, i)
+            EventTriggersChanged()
             return true
         end
     end
@@ -163,6 +165,7 @@ function ProcessEvent(eventType, eventData)
             if ProcessTrigger(trigger, eventData, errors) then
                 if trigger.triggerData.destroyAfterUse == true then
                     table.remove(Game.triggers, i) -- Remove the trigger safely
+                    EventTriggersChanged()
                 end
             end
         end
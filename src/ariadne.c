@@ -47,6 +47,17 @@
 
 typedef long (*NavRules)(NavColour, NavColour);
 
+/** Most areas of navigation map waiting to be retriangulated; more are merged with them. */
+#define NAV_DIRTY_RECTS_MAX 16
+
+/** Area of navigation map changed since last triangulation. */
+struct NavDirtyRect {
+    long start_x;
+    long start_y;
+    long end_x;
+    long end_y;
+};
+
 struct QuadrantOffset {
     long x;
     long y;
@@ -60,6 +71,10 @@ static long tri_initialised;
 static unsigned long edgelen_initialised;
 static uint32_t RadiusEdgeFit[EDGEOR_COUNT][EDGEFIT_LEN];
 static NavRules nav_rulesA2B;
+static struct NavDirtyRect nav_dirty_rects[NAV_DIRTY_RECTS_MAX];
+static int nav_dirty_rects_count;
+static struct NavigationUpdateStats nav_update_stats;
+static struct NavigationUpdateStats nav_update_stats_prev;
 static struct WayPoints wayPoints;
 static uint32_t *EdgeFit;
 static struct Pathway ap_GPathway;
@@ -290,7 +305,7 @@ void init_navigation_map(void)
 {
     MapSubtlCoord stl_x;
     MapSubtlCoord stl_y;
-    memset(game.navigation_map, 0, sizeof(NavColour)*game.navigation_map_size_x*game.navigation_map_size_y);
+    memset(navigation_map, 0, sizeof(NavColour)*game.navigation_map_size_x*game.navigation_map_size_y);
     for (stl_y=0; stl_y < game.navigation_map_size_y; stl_y++)
     {
         for (stl_x=0; stl_x < game.navigation_map_size_x; stl_x++)
@@ -324,9 +339,213 @@ long navigation_rule_normal(NavColour treeA, NavColour treeB)
     return nav_thing_can_travel_over_lava;
 }
 
+static void nav_dirty_rect_union(const struct NavDirtyRect *rect1, const struct NavDirtyRect *rect2, struct NavDirtyRect *out)
+{
+    out->start_x = min(rect1->start_x, rect2->start_x);
+    out->start_y = min(rect1->start_y, rect2->start_y);
+    out->end_x = max(rect1->end_x, rect2->end_x);
+    out->end_y = max(rect1->end_y, rect2->end_y);
+}
+
+static long nav_dirty_rect_area(const struct NavDirtyRect *rect)
+{
+    return (rect->end_x - rect->start_x) * (rect->end_y - rect->start_y);
+}
+
+/**
+ * Adds an area to be retriangulated. Areas are merged with the ones added before
+ * when triangulating them at once is not more work than doing them one by one.
+ */
+static void add_nav_dirty_rect(long start_x, long start_y, long end_x, long end_y)
+{
+    struct NavDirtyRect rect;
+    struct NavDirtyRect merged;
+    rect.start_x = start_x;
+    rect.start_y = start_y;
+    rect.end_x = end_x;
+    rect.end_y = end_y;
+    int i = 0;
+    while (i < nav_dirty_rects_count)
+    {
+        nav_dirty_rect_union(&rect, &nav_dirty_rects[i], &merged);
+        if (nav_dirty_rect_area(&merged) <= nav_dirty_rect_area(&rect) + nav_dirty_rect_area(&nav_dirty_rects[i]))
+        {
+            // The merged area may now reach other areas, so check them all again
+            rect = merged;
+            nav_dirty_rects_count--;
+            nav_dirty_rects[i] = nav_dirty_rects[nav_dirty_rects_count];
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+    if (nav_dirty_rects_count >= NAV_DIRTY_RECTS_MAX)
+    {
+        // No place for another area - grow the one which grows least
+        int best_i = 0;
+        long best_growth = LONG_MAX;
+        for (i = 0; i < nav_dirty_rects_count; i++)
+        {
+            nav_dirty_rect_union(&rect, &nav_dirty_rects[i], &merged);
+            long growth = nav_dirty_rect_area(&merged) - nav_dirty_rect_area(&nav_dirty_rects[i]);
+            if (growth < best_growth)
+            {
+                best_growth = growth;
+                best_i = i;
+            }
+        }
+        nav_dirty_rect_union(&rect, &nav_dirty_rects[best_i], &nav_dirty_rects[best_i]);
+        return;
+    }
+    nav_dirty_rects[nav_dirty_rects_count] = rect;
+    nav_dirty_rects_count++;
+}
+
+static struct NavigationUpdateStats *get_navigation_update_stats_for_turn(void)
+{
+    if (nav_update_stats.turn != game.play_gameturn)
+    {
+        nav_update_stats_prev = nav_update_stats;
+        memset(&nav_update_stats, 0, sizeof(nav_update_stats));
+        nav_update_stats.turn = game.play_gameturn;
+    }
+    return &nav_update_stats;
+}
+
+/**
+ * Retriangulates navigation map areas changed since last call.
+ * Called at start and end of every game turn, so that the triangulation is up to date between turns.
+ */
+void process_navigation_updates(void)
+{
+    if (nav_dirty_rects_count <= 0)
+        return;
+    struct NavigationUpdateStats *stats = get_navigation_update_stats_for_turn();
+    for (int i = 0; i < nav_dirty_rects_count; i++)
+    {
+        struct NavDirtyRect *rect = &nav_dirty_rects[i];
+        triangulate_area(IanMap, rect->start_x, rect->start_y, rect->end_x, rect->end_y);
+        stats->areas_count++;
+        stats->subtiles_count += nav_dirty_rect_area(rect);
+    }
+    nav_dirty_rects_count = 0;
+    SYNCDBG(8,"Turn %lu: %lu changes retriangulated as %lu areas of %lu subtiles",(unsigned long)stats->turn,
+        stats->changes_count,stats->areas_count,stats->subtiles_count);
+}
+
+/**
+ * Gives amount of retriangulation done in the last finished game turn which had navigation changes.
+ */
+const struct NavigationUpdateStats *get_navigation_update_stats(void)
+{
+    get_navigation_update_stats_for_turn();
+    return &nav_update_stats_prev;
+}
+
+/**
+ * Copy of the triangulation and the navigation map it was made from.
+ * Navigation changes are triangulated incrementally, so the result depends on the history;
+ * bringing back a copy is the only way to get the same triangles as when it was made.
+ */
+struct NavigationState {
+    struct Triangle *triangles;
+    long count_triangles;
+    long ix_triangles;
+    long free_triangles;
+    struct Point *points;
+    struct PointsAllocState points_alloc;
+    struct RegionT regions[REGIONS_COUNT];
+    long find_cache[TRIANGLE_FIND_CACHE_LEN][TRIANGLE_FIND_CACHE_LEN];
+    unsigned char tags[TREEITEMS_COUNT];
+    unsigned char tag_current;
+    NavColour *nav_map;
+    unsigned long nav_map_count;
+};
+
+struct NavigationState *alloc_navigation_state(void)
+{
+    struct NavigationState *nstate = (struct NavigationState *)KfxCalloc(1, sizeof(struct NavigationState));
+    if (nstate == NULL)
+        return NULL;
+    nstate->triangles = (struct Triangle *)KfxAlloc(TRIANLGLES_COUNT * sizeof(struct Triangle));
+    nstate->points = (struct Point *)KfxAlloc(POINTS_COUNT * sizeof(struct Point));
+    if ((nstate->triangles == NULL) || (nstate->points == NULL))
+    {
+        free_navigation_state(nstate);
+        return NULL;
+    }
+    return nstate;
+}
+
+void free_navigation_state(struct NavigationState *nstate)
+{
+    if (nstate == NULL)
+        return;
+    KfxFree(nstate->triangles);
+    KfxFree(nstate->points);
+    KfxFree(nstate->nav_map);
+    KfxFree(nstate);
+}
+
+/**
+ * Copies the triangulation, so that it can be brought back along with the map it was made for.
+ * Should be called between game turns, when there are no changes waiting to be triangulated.
+ */
+TbBool navigation_export_state(struct NavigationState *nstate)
+{
+    if ((Triangles == NULL) || (ari_Points == NULL) || (navigation_map == NULL))
+        return false;
+    unsigned long nav_map_count = map_blocks_data_size() / sizeof(struct Map);
+    if (nav_map_count != nstate->nav_map_count)
+    {
+        KfxFree(nstate->nav_map);
+        nstate->nav_map = (NavColour *)KfxAlloc(nav_map_count * sizeof(NavColour));
+        nstate->nav_map_count = (nstate->nav_map != NULL) ? nav_map_count : 0;
+        if (nstate->nav_map == NULL)
+            return false;
+    }
+    if (nav_dirty_rects_count > 0)
+        WARNLOG("Copying triangulation with %d areas not triangulated",nav_dirty_rects_count);
+    memcpy(nstate->triangles, Triangles, TRIANLGLES_COUNT * sizeof(struct Triangle));
+    nstate->count_triangles = count_Triangles;
+    nstate->ix_triangles = ix_Triangles;
+    nstate->free_triangles = free_Triangles;
+    memcpy(nstate->points, ari_Points, POINTS_COUNT * sizeof(struct Point));
+    points_export_alloc_state(&nstate->points_alloc);
+    regions_export_state(nstate->regions);
+    triangle_find_cache_export(nstate->find_cache);
+    tags_export_state(nstate->tags, &nstate->tag_current);
+    memcpy(nstate->nav_map, navigation_map, nav_map_count * sizeof(NavColour));
+    return true;
+}
+
+/**
+ * Brings back the triangulation copied by navigation_export_state(), instead of triangulating the map again.
+ */
+void navigation_import_state(const struct NavigationState *nstate)
+{
+    if ((Triangles == NULL) || (ari_Points == NULL) || (navigation_map == NULL))
+        return;
+    memcpy(Triangles, nstate->triangles, TRIANLGLES_COUNT * sizeof(struct Triangle));
+    count_Triangles = nstate->count_triangles;
+    ix_Triangles = nstate->ix_triangles;
+    free_Triangles = nstate->free_triangles;
+    memcpy(ari_Points, nstate->points, POINTS_COUNT * sizeof(struct Point));
+    points_import_alloc_state(&nstate->points_alloc);
+    regions_import_state(nstate->regions);
+    triangle_find_cache_import(nstate->find_cache);
+    tags_import_state(nstate->tags, nstate->tag_current);
+    unsigned long nav_map_count = map_blocks_data_size() / sizeof(struct Map);
+    memcpy(navigation_map, nstate->nav_map, min(nstate->nav_map_count, nav_map_count) * sizeof(NavColour));
+    // Changes made after the copy are undone along with the map
+    nav_dirty_rects_count = 0;
+}
+
 long init_navigation(void)
 {
-    IanMap = (NavColour *)&game.navigation_map;
+    IanMap = navigation_map;
+    // Whole map is triangulated, so changed areas don't matter anymore
+    nav_dirty_rects_count = 0;
     init_navigation_map();
     triangulate_map(IanMap);
     nav_rulesA2B = navigation_rule_normal;
@@ -369,7 +588,9 @@ long update_navigation_triangulation(long start_x, long start_y, long end_x, lon
             set_navigation_map(x, y, get_navigation_colour(x, y));
         }
     }
-    triangulate_area(IanMap, sx, sy, ex, ey);
+    // Triangles are remade for all changes of a turn at once, in process_navigation_updates()
+    add_nav_dirty_rect(sx, sy, ex, ey);
+    get_navigation_update_stats_for_turn()->changes_count++;
     return true;
 }
 
@@ -38,6 +38,7 @@ extern "C" {
 #pragma pack(1)
 
 struct Thing;
+struct NavigationState;
 
 typedef unsigned char AriadneReturn;
 typedef unsigned char AriadneRouteFlags;
@@ -240,6 +241,17 @@ struct HugStart {
     unsigned char wh_side;
 };
 
+/** Amount of retriangulation done for map changes in one game turn. */
+struct NavigationUpdateStats {
+    GameTurn turn;
+    /** Map areas changed, as requested by update_navigation_triangulation(). */
+    unsigned long changes_count;
+    /** Areas retriangulated after merging the changes. */
+    unsigned long areas_count;
+    /** Subtiles within the retriangulated areas. */
+    unsigned long subtiles_count;
+};
+
 /******************************************************************************/
 
 extern const struct HugStart blocked_x_hug_start[][2];
@@ -253,6 +265,12 @@ extern const struct HugStart blocked_xy_hug_start[][2][2];
 /******************************************************************************/
 long init_navigation(void);
 long update_navigation_triangulation(long start_x, long start_y, long end_x, long end_y);
+void process_navigation_updates(void);
+const struct NavigationUpdateStats *get_navigation_update_stats(void);
+struct NavigationState *alloc_navigation_state(void);
+void free_navigation_state(struct NavigationState *nstate);
+TbBool navigation_export_state(struct NavigationState *nstate);
+void navigation_import_state(const struct NavigationState *nstate);
 TbBool triangulate_area(NavColour *imap, long sx, long sy, long ex, long ey);
 
 AriadneReturn ariadne_initialise_creature_route_f(struct Thing *thing, const struct Coord3d *pos, long speed, AriadneRouteFlags flags, const char *func_name);
@@ -32,7 +32,7 @@
 extern "C" {
 #endif
 /******************************************************************************/
-static long find_cache[4][4];
+static long find_cache[TRIANGLE_FIND_CACHE_LEN][TRIANGLE_FIND_CACHE_LEN];
 
 /******************************************************************************/
 long triangle_brute_find8_near(long pos_x, long pos_y)
@@ -142,6 +142,16 @@ void triangulation_init_cache(long tri_idx)
     }
 }
 
+void triangle_find_cache_export(long cache[TRIANGLE_FIND_CACHE_LEN][TRIANGLE_FIND_CACHE_LEN])
+{
+    memcpy(cache, find_cache, sizeof(find_cache));
+}
+
+void triangle_find_cache_import(const long cache[TRIANGLE_FIND_CACHE_LEN][TRIANGLE_FIND_CACHE_LEN])
+{
+    memcpy(find_cache, cache, sizeof(find_cache));
+}
+
 long triangle_find8(long pt_x, long pt_y)
 {
     NAVIDBG(19,"Starting");
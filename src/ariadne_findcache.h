@@ -26,6 +26,9 @@
 extern "C" {
 #endif
 
+/** Triangles found last are cached for a grid of this many areas in both directions. */
+#define TRIANGLE_FIND_CACHE_LEN 4
+
 /******************************************************************************/
 #pragma pack(1)
 
@@ -36,6 +39,8 @@ long triangle_find_cache_get(long pos_x, long pos_y);
 void triangle_find_cache_put(long pos_x, long pos_y, long ntri);
 
 void triangulation_init_cache(long tri_idx);
+void triangle_find_cache_export(long cache[TRIANGLE_FIND_CACHE_LEN][TRIANGLE_FIND_CACHE_LEN]);
+void triangle_find_cache_import(const long cache[TRIANGLE_FIND_CACHE_LEN][TRIANGLE_FIND_CACHE_LEN]);
 
 long triangle_find8(long pt_x, long pt_y);
 TbBool point_find(long pt_x, long pt_y, int32_t *out_tri_idx, int32_t *out_cor_idx);
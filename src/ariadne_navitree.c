@@ -83,6 +83,22 @@ void tags_init(void)
     tag_current++;
 }
 
+/**
+ * Copies the tags of all TREEITEMS_COUNT items. Stale tags have to go along with the current one,
+ * otherwise items could seem to be visited by the next search.
+ */
+void tags_export_state(unsigned char *tags, unsigned char *tag_cur)
+{
+    memcpy(tags, Tags, sizeof(Tags));
+    *tag_cur = tag_current;
+}
+
+void tags_import_state(const unsigned char *tags, unsigned char tag_cur)
+{
+    memcpy(Tags, tags, sizeof(Tags));
+    tag_current = tag_cur;
+}
+
 /** Sets tags if indices from given border to given tag_id.
  *
  * @param tag_id
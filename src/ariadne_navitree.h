@@ -38,6 +38,8 @@ extern long tree_val[TREEVALS_COUNT];
 #pragma pack()
 /******************************************************************************/
 void tags_init(void);
+void tags_export_state(unsigned char *tags, unsigned char *tag_cur);
+void tags_import_state(const unsigned char *tags, unsigned char tag_cur);
 long update_border_tags(long tag_id, int32_t *border_pt, long border_len);
 long border_tags_to_current(int32_t *border_pt, long border_len);
 TbBool is_current_tag(long tag_id);
@@ -161,6 +161,20 @@ void triangulation_initxy_points(long startx, long starty, long endx, long endy)
     count_Points = 4;
     free_Points = -1;
 }
+
+void points_export_alloc_state(struct PointsAllocState *pstate)
+{
+    pstate->count = count_Points;
+    pstate->ix = ix_Points;
+    pstate->free = free_Points;
+}
+
+void points_import_alloc_state(const struct PointsAllocState *pstate)
+{
+    count_Points = pstate->count;
+    ix_Points = pstate->ix;
+    free_Points = pstate->free;
+}
 /******************************************************************************/
 #ifdef __cplusplus
 }
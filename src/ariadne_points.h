@@ -38,6 +38,13 @@ struct Point { // sizeof = 4
   short y;
 };
 
+/** Allocation state of the points array, kept by copies of the triangulation. */
+struct PointsAllocState {
+  long count;
+  long ix;
+  long free;
+};
+
 /******************************************************************************/
 extern struct Point *ari_Points;
 
@@ -53,6 +60,8 @@ TbBool point_is_invalid(const struct Point *pt);
 TbBool point_equals(AridPointId pt_idx, long pt_x, long pt_y);
 AridPointId point_set_new_or_reuse(long pt_x, long pt_y);
 void triangulation_initxy_points(long startx, long starty, long endx, long endy);
+void points_export_alloc_state(struct PointsAllocState *pstate);
+void points_import_alloc_state(const struct PointsAllocState *pstate);
 /******************************************************************************/
 #ifdef __cplusplus
 }
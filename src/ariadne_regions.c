@@ -198,6 +198,19 @@ void triangulation_init_regions(void)
     memset(Regions, 0, REGIONS_COUNT*sizeof(struct RegionT));
 }
 
+/**
+ * Copies all REGIONS_COUNT regions into given array.
+ */
+void regions_export_state(struct RegionT *regions)
+{
+    memcpy(regions, Regions, REGIONS_COUNT*sizeof(struct RegionT));
+}
+
+void regions_import_state(const struct RegionT *regions)
+{
+    memcpy(Regions, regions, REGIONS_COUNT*sizeof(struct RegionT));
+}
+
 /**
  * Returns whether two regions represented by tree triangles are connected.
  * @param first_tree_region
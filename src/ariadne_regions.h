@@ -52,6 +52,8 @@ void region_set_f(long ntri, unsigned long nreg, const char *func_name);
 void region_unset_f(long ntri, unsigned long nreg, const char *func_name);
 void region_unlock(long ntri);
 void triangulation_init_regions(void);
+void regions_export_state(struct RegionT *regions);
+void regions_import_state(const struct RegionT *regions);
 
 /******************************************************************************/
 #ifdef __cplusplus
@@ -47,6 +47,7 @@ struct Triangle {
 extern struct Triangle *Triangles;
 extern long count_Triangles;
 extern long ix_Triangles;
+extern long free_Triangles;
 
 #pragma pack()
 /******************************************************************************/
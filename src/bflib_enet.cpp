@@ -16,6 +16,7 @@
 #include "pre_inc.h"
 #include "bflib_enet.h"
 #include "bflib_network.h"
+#include "bflib_queue.hpp"
 #include "bflib_math.h"
 #include "net_portforward.h"
 #include "game_legacy.h"
@@ -28,22 +29,270 @@
 #include <enet6/enet.h>
 #include <cstddef>
 #include <climits>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include "post_inc.h"
 
 #define NUM_CHANNELS 2
 #define DEFAULT_PORT 5556
+/** Capacity of the queues between the game and the network thread. */
+#define NET_QUEUE_SIZE 1024
+#define NET_EVENTS_QUEUE_SIZE 64
+/** How long the network thread waits for network traffic before checking for messages to send. */
+#define NET_SERVICE_INTERVAL_MS 1
+/** Amount of peers the host is created with. */
+#define NET_PEERS_COUNT 4
 
 namespace
 {
+    struct OutgoingMessage
+    {
+        /** Peer to send to, or nullptr to send to all of them. */
+        ENetPeer *peer;
+        ENetPacket *packet;
+        enet_uint8 channel;
+    };
+
+    struct PeerEvent
+    {
+        ENetEventType type;
+        ENetPeer *peer;
+    };
+
+    /** Statistics of a peer, as copied by the network thread after servicing the host. */
+    struct PeerStats
+    {
+        bool connected;
+        enet_uint32 round_trip_time;
+        enet_uint32 round_trip_time_variance;
+        /** Packet loss in percent. */
+        enet_uint32 packet_loss;
+        enet_uint32 reliable_data_in_transit;
+        enet_uint32 packets_lost;
+        enet_uint32 outgoing_data_total;
+        enet_uint32 incoming_data_total;
+        enet_uint32 reliable_commands_in_flight;
+    };
+
     NetDropCallback g_drop_callback = nullptr;
     ENetHost *host = nullptr;
     ENetPeer *client_peer = nullptr;
+    /** Peers of users connected to this host; only used by the game thread. */
+    ENetPeer *user_peers[MAX_N_USERS];
+
+    // The host is serviced by the network thread only, once it is started.
+    // The game thread gets received packets and connection changes through the queues, and queues packets to send.
+    std::thread service_thread;
+    std::atomic<bool> service_quit{false};
+    MessageQueue<ENetPacket *, NET_QUEUE_SIZE> incoming_packets;
+    MessageQueue<PeerEvent, NET_EVENTS_QUEUE_SIZE> peer_events;
+    MessageQueue<OutgoingMessage, NET_QUEUE_SIZE> outgoing_messages;
+    // Only used to sleep until something is received; the queues themselves are not locked
+    std::mutex incoming_lock;
+    std::condition_variable incoming_ready;
+    // The peers are changed by the network thread at any time, so the game thread only reads copies of their statistics
+    std::mutex peer_stats_lock;
+    PeerStats peer_stats[NET_PEERS_COUNT];
+
+    void notify_incoming()
+    {
+        std::lock_guard<std::mutex> guard(incoming_lock);
+        incoming_ready.notify_all();
+    }
+
+    void send_outgoing_messages()
+    {
+        OutgoingMessage msg;
+        bool sent = false;
+        while (outgoing_messages.pop(msg))
+        {
+            if (msg.peer == nullptr)
+            {
+                enet_host_broadcast(host, msg.channel, msg.packet);
+            } else
+            if ((msg.peer->state != ENET_PEER_STATE_CONNECTED) || (enet_peer_send(msg.peer, msg.channel, msg.packet) < 0))
+            {
+                enet_packet_destroy(msg.packet);
+            }
+            sent = true;
+        }
+        if (sent)
+            enet_host_flush(host);
+    }
+
+    enet_uint32 clamp_size_to_uint32(size_t value)
+    {
+        if (value > UINT32_MAX)
+            return UINT32_MAX;
+        return static_cast<enet_uint32>(value);
+    }
+
+    /**
+     * Copies statistics of the host peers for the game thread to read.
+     * Called by the network thread, which is the only one changing the peers while it runs.
+     */
+    void store_peer_stats()
+    {
+        PeerStats stats[NET_PEERS_COUNT];
+        memset(stats, 0, sizeof(stats));
+        for (size_t i = 0; (i < host->peerCount) && (i < NET_PEERS_COUNT); i++)
+        {
+            ENetPeer *peer = &host->peers[i];
+            if (peer->state != ENET_PEER_STATE_CONNECTED)
+                continue;
+            PeerStats *pstat = &stats[i];
+            pstat->connected = true;
+            pstat->round_trip_time = (peer->roundTripTime != 0) ? peer->roundTripTime : peer->lastRoundTripTime;
+            pstat->round_trip_time_variance = (peer->roundTripTimeVariance != 0) ? peer->roundTripTimeVariance : peer->lastRoundTripTimeVariance;
+            pstat->packet_loss = static_cast<enet_uint32>((static_cast<unsigned long long>(peer->packetLoss) * 100ULL) / ENET_PEER_PACKET_LOSS_SCALE);
+            pstat->reliable_data_in_transit = peer->reliableDataInTransit;
+            pstat->packets_lost = peer->packetsLost;
+            pstat->outgoing_data_total = peer->outgoingDataTotal;
+            pstat->incoming_data_total = peer->incomingDataTotal;
+            pstat->reliable_commands_in_flight = clamp_size_to_uint32(enet_list_size(&peer->sentReliableCommands));
+        }
+        std::lock_guard<std::mutex> guard(peer_stats_lock);
+        memcpy(peer_stats, stats, sizeof(peer_stats));
+    }
+
+    /**
+     * Network thread. Sends queued packets, and services the host, putting what it receives into the queues.
+     * Logging is left to the game thread, as the log isn't thread safe.
+     */
+    void service_host()
+    {
+        // Packet which didn't fit into the full queue; nothing more is received until it does
+        ENetPacket *held_packet = nullptr;
+        while (!service_quit.load(std::memory_order_acquire))
+        {
+            send_outgoing_messages();
+            if (held_packet != nullptr)
+            {
+                if (!incoming_packets.push(held_packet))
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(NET_SERVICE_INTERVAL_MS));
+                    continue;
+                }
+                held_packet = nullptr;
+                notify_incoming();
+            }
+            ENetEvent ev;
+            int ret = enet_host_service(host, &ev, NET_SERVICE_INTERVAL_MS);
+            while (ret > 0)
+            {
+                switch (ev.type)
+                {
+                case ENET_EVENT_TYPE_RECEIVE:
+                    if (!incoming_packets.push(ev.packet))
+                        held_packet = ev.packet;
+                    break;
+                case ENET_EVENT_TYPE_CONNECT:
+                case ENET_EVENT_TYPE_DISCONNECT:
+                case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+                {
+                    PeerEvent pev = {ev.type, ev.peer};
+                    while (!peer_events.push(pev) && !service_quit.load(std::memory_order_acquire))
+                        std::this_thread::sleep_for(std::chrono::milliseconds(NET_SERVICE_INTERVAL_MS));
+                    break;
+                }
+                case ENET_EVENT_TYPE_NONE:
+                    break;
+                }
+                notify_incoming();
+                if (held_packet != nullptr)
+                    break;
+                ret = enet_host_check_events(host, &ev);
+            }
+            store_peer_stats();
+        }
+        if (held_packet != nullptr)
+            enet_packet_destroy(held_packet);
+    }
 
-    // List
-    ENetPacket *oldest_packet = nullptr;
-    ENetPacket *newest_packet = nullptr;
-    int incoming_queue_size = 0;
+    void start_service_thread()
+    {
+        service_quit.store(false, std::memory_order_release);
+        service_thread = std::thread(service_host);
+    }
+
+    void stop_service_thread()
+    {
+        if (!service_thread.joinable())
+            return;
+        service_quit.store(true, std::memory_order_release);
+        service_thread.join();
+        // Now the game thread owns everything; drop whatever was left in the queues
+        ENetPacket *packet;
+        while (incoming_packets.pop(packet))
+            enet_packet_destroy(packet);
+        OutgoingMessage msg;
+        while (outgoing_messages.pop(msg))
+            enet_packet_destroy(msg.packet);
+        PeerEvent pev;
+        while (peer_events.pop(pev)) {
+        }
+        std::lock_guard<std::mutex> guard(peer_stats_lock);
+        memset(peer_stats, 0, sizeof(peer_stats));
+    }
+
+    void queue_outgoing_message(ENetPeer *peer, enet_uint8 channel, ENetPacket *packet)
+    {
+        OutgoingMessage msg = {peer, packet, channel};
+        // The network thread empties the queue every service interval, so it can't stay full for long
+        while (!outgoing_messages.push(msg))
+            std::this_thread::yield();
+    }
+
+    ENetPeer *get_user_peer(NetUserId user_id)
+    {
+        if (client_peer) // Just send to server
+            return client_peer;
+        if ((user_id < 0) || (user_id >= MAX_N_USERS))
+            return nullptr;
+        return user_peers[user_id];
+    }
+
+    /**
+     * Passes a connection change received by the network thread to the network code.
+     * @param new_user Callback for new connections; if NULL, they're left in the queue.
+     * @return False if the event was left in the queue.
+     */
+    bool dispatch_peer_event(NetNewUserCallback new_user)
+    {
+        const PeerEvent *next = peer_events.peek();
+        if (next == nullptr)
+            return false;
+        if ((next->type == ENET_EVENT_TYPE_CONNECT) && (new_user == nullptr))
+            return false;
+        PeerEvent pev;
+        peer_events.pop(pev);
+        NetUserId user_id;
+        switch (pev.type)
+        {
+        case ENET_EVENT_TYPE_CONNECT:
+            if (new_user(&user_id))
+            {
+                pev.peer->data = reinterpret_cast<void *>(user_id);
+                if ((user_id >= 0) && (user_id < MAX_N_USERS))
+                    user_peers[user_id] = pev.peer;
+            }
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+        case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+            user_id = NetUserId(reinterpret_cast<ptrdiff_t>(pev.peer->data));
+            if ((user_id >= 0) && (user_id < MAX_N_USERS) && (user_peers[user_id] == pev.peer))
+                user_peers[user_id] = nullptr;
+            g_drop_callback(user_id, NETDROP_ERROR);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
 
     TbError bf_enet_init(NetDropCallback drop_callback)
     {
@@ -55,19 +304,8 @@ namespace
 
     void host_destroy()
     {
-        if (oldest_packet)
-        {
-            for (ENetPacket *p = oldest_packet; p != nullptr;)
-            {
-                ENetPacket *pp = p;
-                p = static_cast<ENetPacket *>(p->userData);
-                enet_packet_destroy(pp);
-            }
-
-            oldest_packet = nullptr;
-            newest_packet = nullptr;
-            incoming_queue_size = 0;
-        }
+        stop_service_thread();
+        memset(user_peers, 0, sizeof(user_peers));
         if (client_peer)
         {
             client_peer = nullptr;
@@ -104,12 +342,13 @@ namespace
         int port = atoi(session);
         if (port > 0)
             address.port = port;
-        host = enet_host_create(ENET_ADDRESS_TYPE_ANY, &address, 4, NUM_CHANNELS, 0, 0);
+        host = enet_host_create(ENET_ADDRESS_TYPE_ANY, &address, NET_PEERS_COUNT, NUM_CHANNELS, 0, 0);
         if (!host) {
             return Lb_FAIL;
         }
         enet_host_compress_with_range_coder(host);
         port_forward_add_mapping(address.port);
+        start_service_thread();
         return Lb_OK;
     }
 
@@ -199,7 +438,7 @@ namespace
             return Lb_FAIL;
         }
         connect_address.port = port;
-        host = enet_host_create(connect_address.type, NULL, 4, NUM_CHANNELS, 0, 0);
+        host = enet_host_create(connect_address.type, NULL, NET_PEERS_COUNT, NUM_CHANNELS, 0, 0);
         if (!host)
         {
             return Lb_FAIL;
@@ -216,79 +455,24 @@ namespace
             host_destroy();
             return Lb_FAIL;
         }
+        start_service_thread();
         return Lb_OK;
     }
 
-    /*
-     * @returns -1 if error, +1 if there is a packet, 0 if timeoout or no events
-     */
-    int bf_enet_read_event(NetNewUserCallback new_user, uint timeout)
-    {
-        ENetEvent ev;
-        int ret;
-        NetUserId user_id;
-        if (!host)
-        {
-            return -1;
-        }
-        if ((ret = enet_host_service(host, &ev, timeout)) != 0)
-        {
-            if (ret < 0)
-            {
-                NETDBG(1, "enet_host -> %d", ret);
-                return ret;
-            }
-            switch (ev.type)
-            {
-                case ENET_EVENT_TYPE_CONNECT:
-                    if (new_user(&user_id))
-                    {
-                        ev.peer->data = reinterpret_cast<void *>(user_id);
-                    }
-                    break;
-                case ENET_EVENT_TYPE_DISCONNECT:
-                case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
-                    user_id = NetUserId(reinterpret_cast<ptrdiff_t>(ev.peer->data));
-                    g_drop_callback(user_id, NETDROP_ERROR);
-                    break;
-                case ENET_EVENT_TYPE_RECEIVE:
-                    if (oldest_packet == nullptr)
-                    {
-                        newest_packet = ev.packet;
-                        oldest_packet = newest_packet;
-                        incoming_queue_size = 1;
-                    }
-                    else
-                    {
-                        newest_packet->userData = ev.packet;
-                        newest_packet = ev.packet;
-                        newest_packet->userData = nullptr;
-                        incoming_queue_size +=1;
-                        if (incoming_queue_size > 50)
-                        {
-                            fprintf(stderr, "Too many packets %d\n", incoming_queue_size);
-                            WARNLOG("Too many packets %d", incoming_queue_size);
-                        }
-                    }
-                    return 1;
-                case ENET_EVENT_TYPE_NONE:
-                    break;
-            }
-        }
-        return 0;
-    }
-
     /**
-     * Checks for new connections.
+     * Passes new connections and disconnections to the network code.
+     * Received packets are already waiting in the queue, put there by the network thread.
      * @param new_user Call back if a new user has connected.
      */
     void bf_enet_update(NetNewUserCallback new_user)
     {
-        int packets_read = 0;
-        const int MAX_PACKETS_PER_UPDATE = 100;
-        while (packets_read < MAX_PACKETS_PER_UPDATE && bf_enet_read_event(new_user, 0))
+        while (dispatch_peer_event(new_user))
         {
-            packets_read++;
+        }
+        size_t queued = incoming_packets.size();
+        if (queued > 50)
+        {
+            WARNLOG("Too many packets %d", (int)queued);
         }
     }
 
@@ -300,24 +484,11 @@ namespace
      */
     void bf_enet_sendmsg_single(NetUserId destination, const char *buffer, size_t size)
     {
+        ENetPeer *peer = get_user_peer(destination);
+        if (!peer)
+            return;
         ENetPacket *packet = enet_packet_create(buffer, size, ENET_PACKET_FLAG_RELIABLE);
-        if (client_peer) // Just send to server
-        {
-            enet_peer_send(client_peer, ENET_CHANNEL_RELIABLE, packet);
-        }
-        else
-        {
-            for (ENetPeer *currentPeer = host->peers; currentPeer < &host->peers[host -> peerCount]; ++currentPeer)
-            {
-                if (currentPeer->state != ENET_PEER_STATE_CONNECTED)
-                    continue;
-                if (NetUserId(reinterpret_cast<ptrdiff_t>(currentPeer->data)) == destination)
-                {
-                    enet_peer_send(currentPeer, ENET_CHANNEL_RELIABLE, packet);
-                }
-            }
-        }
-        enet_host_flush(host);
+        queue_outgoing_message(peer, ENET_CHANNEL_RELIABLE, packet);
     }
 
     /**
@@ -328,24 +499,11 @@ namespace
      */
     void bf_enet_sendmsg_single_unsequenced(NetUserId destination, const char *buffer, size_t size)
     {
+        ENetPeer *peer = get_user_peer(destination);
+        if (!peer)
+            return;
         ENetPacket *packet = enet_packet_create(buffer, size, ENET_PACKET_FLAG_UNSEQUENCED);
-        if (client_peer) // Just send to server
-        {
-            enet_peer_send(client_peer, ENET_CHANNEL_UNSEQUENCED, packet);
-        }
-        else
-        {
-            for (ENetPeer *currentPeer = host->peers; currentPeer < &host->peers[host -> peerCount]; ++currentPeer)
-            {
-                if (currentPeer->state != ENET_PEER_STATE_CONNECTED)
-                    continue;
-                if (NetUserId(reinterpret_cast<ptrdiff_t>(currentPeer->data)) == destination)
-                {
-                    enet_peer_send(currentPeer, ENET_CHANNEL_UNSEQUENCED, packet);
-                }
-            }
-        }
-        enet_host_flush(host);
+        queue_outgoing_message(peer, ENET_CHANNEL_UNSEQUENCED, packet);
     }
 
     /**
@@ -356,16 +514,24 @@ namespace
     void bf_enet_sendmsg_all(const char *buffer, size_t size)
     {
         ENetPacket *packet = enet_packet_create(buffer, size, ENET_PACKET_FLAG_RELIABLE);
-        enet_host_broadcast(host, ENET_CHANNEL_RELIABLE, packet);
-        enet_host_flush(host);
+        queue_outgoing_message(nullptr, ENET_CHANNEL_RELIABLE, packet);
     }
 
-    TbBool not_expected_user(NetUserId *user_id)
+    /**
+     * Waits until the network thread receives a packet or a disconnection.
+     * @param timeout Time limit in milliseconds.
+     * @return True if there is a packet to read.
+     */
+    bool wait_for_incoming(unsigned timeout)
     {
-        ERRORLOG("Unexpected connected user\n");
-        fprintf(stderr, "Unexpected connected user\n");
-        return false;
+        std::unique_lock<std::mutex> lock(incoming_lock);
+        return incoming_ready.wait_for(lock, std::chrono::milliseconds(timeout), []() {
+            const PeerEvent *pev = peer_events.peek();
+            bool dropped = (pev != nullptr) && (pev->type != ENET_EVENT_TYPE_CONNECT);
+            return !incoming_packets.empty() || dropped || !service_thread.joinable();
+        }) && !incoming_packets.empty();
     }
+
     /**
      * Completely reads a message. Blocks until entire message has been read.
      * Will not block if msgready has returned > 0.
@@ -377,16 +543,14 @@ namespace
      */
     size_t bf_enet_readmsg(NetUserId source, char *buffer, size_t max_size)
     {
-        size_t sz;
-        while (!oldest_packet)
+        ENetPacket *packet;
+        while (!incoming_packets.pop(packet))
         {
-            bf_enet_read_event(not_expected_user, 0);
+            if (!service_thread.joinable())
+                return 0;
+            wait_for_incoming(TIMEOUT_GAMEPLAY_MISSING_PACKET);
         }
-        ENetPacket *packet = oldest_packet;
-        oldest_packet = static_cast<ENetPacket *>(oldest_packet->userData);
-        incoming_queue_size--;
-
-        sz = min(packet->dataLength, max_size);
+        size_t sz = min(packet->dataLength, max_size);
         memcpy(buffer, packet->data, sz);
         enet_packet_destroy(packet);
         return sz;
@@ -394,10 +558,9 @@ namespace
 
     /**
      * Asks if a message has finished reception and get be read through readmsg.
-     * May block under some circumstances but shouldn't unless it can be presumed
-     * a whole message is on the way.
-     * TODO NET this definition is due to how SDL Net handles sockets.. see if it can
-     *  be improved - ideally this function shouldn't block at all
+     * Packets are received by the network thread, so this only checks the queue,
+     * sleeping until something arrives if there is a timeout.
+     * Disconnections are passed on here too, so waiting for a user who left ends early.
      * @param source The source user.
      * @param timeout If non-zero, this method will wait this number of milliseconds
      *  for a message to arrive before returning.
@@ -405,11 +568,18 @@ namespace
      */
     size_t bf_enet_msgready(NetUserId source, unsigned timeout)
     {
-        if (!oldest_packet)
+        while (dispatch_peer_event(nullptr))
         {
-            bf_enet_read_event(not_expected_user, timeout);
         }
-        return oldest_packet? oldest_packet->dataLength : 0;
+        if (incoming_packets.empty() && (timeout > 0))
+        {
+            wait_for_incoming(timeout);
+            while (dispatch_peer_event(nullptr))
+            {
+            }
+        }
+        ENetPacket *const *packet = incoming_packets.peek();
+        return packet ? (*packet)->dataLength : 0;
     }
 
     /**
@@ -424,281 +594,104 @@ namespace
 
 }
 
-static bool IsPeerConnected(const ENetPeer *peer) {
-    return peer && peer->state == ENET_PEER_STATE_CONNECTED;
-}
-
+// Peer statistics below are read from the copies stored by the network thread, never from the peers themselves.
 static bool IsLocalPeer(NetUserId id) {
     return id == SERVER_ID || id == my_player_number;
 }
 
-static unsigned int ClampSizeToUInt(size_t value) {
-    if (value > UINT_MAX) {
-        return UINT_MAX;
-    }
-    return static_cast<unsigned int>(value);
+static void CopyPeerStats(PeerStats *stats) {
+    std::lock_guard<std::mutex> guard(peer_stats_lock);
+    memcpy(stats, peer_stats, sizeof(peer_stats));
 }
 
-unsigned long GetPing(NetUserId id) {
-    const bool requesting_local_peer = IsLocalPeer(id);
-
-    if (IsPeerConnected(client_peer)) {
-        if (!requesting_local_peer) {
-            return 0;
-        }
-        enet_uint32 value = client_peer->roundTripTime;
-        if (value == 0) {
-            value = client_peer->lastRoundTripTime;
-        }
-        return static_cast<unsigned long>(value);
-    }
-
-    if (!host) {
-        return 0;
-    }
-
-    unsigned long best_value = 0;
-
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
-
-        enet_uint32 peer_round_trip = peer->roundTripTime;
-        if (peer_round_trip == 0) {
-            peer_round_trip = peer->lastRoundTripTime;
-        }
-        unsigned long value = static_cast<unsigned long>(peer_round_trip);
-        if (!requesting_local_peer) {
-            NetUserId peer_id = NetUserId(reinterpret_cast<ptrdiff_t>(peer->data));
-            if (peer_id == id) {
-                return value;
-            }
-            continue;
+static enet_uint32 GetHighestPeerStat(const PeerStats *stats, enet_uint32 PeerStats::*field) {
+    enet_uint32 best_value = 0;
+    for (size_t peer_index = 0; peer_index < NET_PEERS_COUNT; ++peer_index) {
+        if (stats[peer_index].connected && (stats[peer_index].*field > best_value)) {
+            best_value = stats[peer_index].*field;
         }
-        if (value > best_value) {
-            best_value = value;
-        }
-    }
-
-    if (requesting_local_peer) {
-        return best_value;
     }
-
-    return 0;
+    return best_value;
 }
 
-unsigned long GetPingVariance(NetUserId id) {
-    const bool requesting_local_peer = IsLocalPeer(id);
-
-    if (IsPeerConnected(client_peer)) {
-        if (!requesting_local_peer) {
+/**
+ * Gives a statistic of the peer of a remote user.
+ * For the local user, gives the highest value of all connected peers.
+ */
+static enet_uint32 GetUserPeerStat(NetUserId id, enet_uint32 PeerStats::*field) {
+    PeerStats stats[NET_PEERS_COUNT];
+    CopyPeerStats(stats);
+    if (!IsLocalPeer(id)) {
+        // Remote users have their peers only on the host
+        ENetPeer *peer = client_peer ? nullptr : get_user_peer(id);
+        if ((peer == nullptr) || (host == nullptr)) {
             return 0;
         }
-        enet_uint32 value = client_peer->roundTripTimeVariance;
-        if (value == 0) {
-            value = client_peer->lastRoundTripTimeVariance;
+        size_t peer_index = static_cast<size_t>(peer - host->peers);
+        if ((peer_index >= NET_PEERS_COUNT) || !stats[peer_index].connected) {
+            return 0;
         }
-        return static_cast<unsigned long>(value);
-    }
-
-    if (!host) {
-        return 0;
+        return stats[peer_index].*field;
     }
+    return GetHighestPeerStat(stats, field);
+}
 
-    unsigned long best_value = 0;
-
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
+static unsigned int GetHighestPeerStat(enet_uint32 PeerStats::*field) {
+    PeerStats stats[NET_PEERS_COUNT];
+    CopyPeerStats(stats);
+    return static_cast<unsigned int>(GetHighestPeerStat(stats, field));
+}
 
-        enet_uint32 peer_round_trip_variance = peer->roundTripTimeVariance;
-        if (peer_round_trip_variance == 0) {
-            peer_round_trip_variance = peer->lastRoundTripTimeVariance;
-        }
-        unsigned long value = static_cast<unsigned long>(peer_round_trip_variance);
-        if (!requesting_local_peer) {
-            NetUserId peer_id = NetUserId(reinterpret_cast<ptrdiff_t>(peer->data));
-            if (peer_id == id) {
-                return value;
-            }
+static unsigned int GetTotalPeerStat(enet_uint32 PeerStats::*field) {
+    PeerStats stats[NET_PEERS_COUNT];
+    CopyPeerStats(stats);
+    unsigned long long total = 0;
+    for (size_t peer_index = 0; peer_index < NET_PEERS_COUNT; ++peer_index) {
+        if (!stats[peer_index].connected) {
             continue;
         }
-        if (value > best_value) {
-            best_value = value;
+        total += static_cast<unsigned long long>(stats[peer_index].*field);
+        if (total > UINT_MAX) {
+            return UINT_MAX;
         }
     }
+    return static_cast<unsigned int>(total);
+}
 
-    if (requesting_local_peer) {
-        return best_value;
-    }
+unsigned long GetPing(NetUserId id) {
+    return static_cast<unsigned long>(GetUserPeerStat(id, &PeerStats::round_trip_time));
+}
 
-    return 0;
+unsigned long GetPingVariance(NetUserId id) {
+    return static_cast<unsigned long>(GetUserPeerStat(id, &PeerStats::round_trip_time_variance));
 }
 
 unsigned int GetPacketLoss(NetUserId id) {
-    const bool requesting_local_peer = IsLocalPeer(id);
-
-    if (IsPeerConnected(client_peer)) {
-        if (!requesting_local_peer) {
-            return 0;
-        }
-        enet_uint32 value = client_peer->packetLoss;
-        unsigned int percent = static_cast<unsigned int>((static_cast<unsigned long long>(value) * 100ULL) / ENET_PEER_PACKET_LOSS_SCALE);
-        return percent;
-    }
-
-    if (!host) {
-        return 0;
-    }
-
-    unsigned int best_value = 0;
-
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
-
-        enet_uint32 peer_packet_loss = peer->packetLoss;
-        unsigned int value = static_cast<unsigned int>((static_cast<unsigned long long>(peer_packet_loss) * 100ULL) / ENET_PEER_PACKET_LOSS_SCALE);
-        if (!requesting_local_peer) {
-            NetUserId peer_id = NetUserId(reinterpret_cast<ptrdiff_t>(peer->data));
-            if (peer_id == id) {
-                return value;
-            }
-            continue;
-        }
-        if (value > best_value) {
-            best_value = value;
-        }
-    }
-
-    if (requesting_local_peer) {
-        return best_value;
-    }
-
-    return 0;
+    return static_cast<unsigned int>(GetUserPeerStat(id, &PeerStats::packet_loss));
 }
 
 unsigned int GetClientDataInTransit() {
-    if (IsPeerConnected(client_peer)) {
-        return client_peer->reliableDataInTransit;
-    }
-
-    if (!host) {
-        return 0;
-    }
-
-    unsigned int result = 0;
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
-        if (peer->reliableDataInTransit > result) {
-            result = peer->reliableDataInTransit;
-        }
-    }
-    return result;
+    return GetHighestPeerStat(&PeerStats::reliable_data_in_transit);
 }
 
 unsigned int GetIncomingPacketQueueSize() {
-    if (incoming_queue_size <= 0) {
-        return 0;
-    }
-    return static_cast<unsigned int>(incoming_queue_size);
+    return static_cast<unsigned int>(incoming_packets.size());
 }
 
 unsigned int GetClientPacketsLost() {
-    if (IsPeerConnected(client_peer)) {
-        return static_cast<unsigned int>(client_peer->packetsLost);
-    }
-    if (!host) {
-        return 0;
-    }
-    unsigned long long total = 0;
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
-        total += static_cast<unsigned long long>(peer->packetsLost);
-        if (total > UINT_MAX) {
-            return UINT_MAX;
-        }
-    }
-    return static_cast<unsigned int>(total);
+    return GetTotalPeerStat(&PeerStats::packets_lost);
 }
 
 unsigned int GetClientOutgoingDataTotal() {
-    if (IsPeerConnected(client_peer)) {
-        return static_cast<unsigned int>(client_peer->outgoingDataTotal);
-    }
-    if (!host) {
-        return 0;
-    }
-    unsigned long long total = 0;
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
-        total += static_cast<unsigned long long>(peer->outgoingDataTotal);
-        if (total > UINT_MAX) {
-            return UINT_MAX;
-        }
-    }
-    return static_cast<unsigned int>(total);
+    return GetTotalPeerStat(&PeerStats::outgoing_data_total);
 }
 
 unsigned int GetClientIncomingDataTotal() {
-    if (IsPeerConnected(client_peer)) {
-        return static_cast<unsigned int>(client_peer->incomingDataTotal);
-    }
-    if (!host) {
-        return 0;
-    }
-    unsigned long long total = 0;
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
-        total += static_cast<unsigned long long>(peer->incomingDataTotal);
-        if (total > UINT_MAX) {
-            return UINT_MAX;
-        }
-    }
-    return static_cast<unsigned int>(total);
+    return GetTotalPeerStat(&PeerStats::incoming_data_total);
 }
 
 unsigned int GetClientReliableCommandsInFlight() {
-    if (IsPeerConnected(client_peer)) {
-        size_t value = enet_list_size(&client_peer->sentReliableCommands);
-        return ClampSizeToUInt(value);
-    }
-    if (!host) {
-        return 0;
-    }
-    size_t best_value = 0;
-    for (size_t peer_index = 0; peer_index < host->peerCount; ++peer_index) {
-        ENetPeer *peer = &host->peers[peer_index];
-        if (!IsPeerConnected(peer)) {
-            continue;
-        }
-        size_t current = enet_list_size(&peer->sentReliableCommands);
-        if (current > best_value) {
-            best_value = current;
-            if (best_value > UINT_MAX) {
-                return UINT_MAX;
-            }
-        }
-    }
-    return ClampSizeToUInt(best_value);
+    return GetHighestPeerStat(&PeerStats::reliable_commands_in_flight);
 }
 
 struct NetSP *InitEnetSP()
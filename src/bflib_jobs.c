@@ -0,0 +1,212 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_jobs.c
+ *     Pool of worker threads for splitting loops over many items.
+ * @par Purpose:
+ *     Runs a function for ranges of items on several threads at once,
+ *     and returns when all items are processed.
+ * @par Comment:
+ *     Jobs must only change data of their own items; anything shared
+ *     has to be done by the caller after the job.
+ * @author   KeeperFX Team
+ * @date     16 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#include "pre_inc.h"
+#include "bflib_jobs.h"
+
+#include "bflib_basics.h"
+#include "globals.h"
+#include <SDL2/SDL.h>
+#include "post_inc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+struct JobsPool {
+    SDL_Thread *threads[JOBS_THREADS_MAX];
+    int threads_count;
+    SDL_mutex *lock;
+    /** Signalled when a job is given to the workers, or when they should quit. */
+    SDL_cond *work_cond;
+    /** Signalled when the last worker is done with a job. */
+    SDL_cond *done_cond;
+    /** Increased for every job, so workers know when there's a new one. */
+    unsigned long job_id;
+    LbJobFunc func;
+    void *data;
+    long count;
+    long batch;
+    /** First item not taken by any thread yet. */
+    SDL_atomic_t next_item;
+    /** Workers which didn't finish the current job. */
+    int busy_workers;
+    TbBool started;
+    TbBool quit;
+};
+
+static struct JobsPool jobs_pool;
+/******************************************************************************/
+/**
+ * Takes batches of items of the current job until there are none left.
+ */
+static void run_job_batches(struct JobsPool *pool)
+{
+    while (1)
+    {
+        long first = SDL_AtomicAdd(&pool->next_item, pool->batch);
+        if (first >= pool->count)
+            break;
+        long count = pool->count - first;
+        if (count > pool->batch)
+            count = pool->batch;
+        pool->func(pool->data, first, count);
+    }
+}
+
+static int jobs_worker_thread(void *data)
+{
+    struct JobsPool *pool = (struct JobsPool *)data;
+    SDL_LockMutex(pool->lock);
+    unsigned long job_done = pool->job_id;
+    while (!pool->quit)
+    {
+        if (pool->job_id != job_done)
+        {
+            job_done = pool->job_id;
+            SDL_UnlockMutex(pool->lock);
+            run_job_batches(pool);
+            SDL_LockMutex(pool->lock);
+            pool->busy_workers--;
+            if (pool->busy_workers == 0)
+                SDL_CondSignal(pool->done_cond);
+            continue;
+        }
+        SDL_CondWait(pool->work_cond, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+/**
+ * Starts the worker threads; one less than there are CPUs, as the calling thread works too.
+ * If no threads can be started, jobs are just run by the caller.
+ */
+static void start_jobs_pool(struct JobsPool *pool)
+{
+    pool->started = true;
+    int threads_count = SDL_GetCPUCount() - 1;
+    if (threads_count > JOBS_THREADS_MAX)
+        threads_count = JOBS_THREADS_MAX;
+    if (threads_count <= 0)
+        return;
+    pool->lock = SDL_CreateMutex();
+    pool->work_cond = SDL_CreateCond();
+    pool->done_cond = SDL_CreateCond();
+    if ((pool->lock == NULL) || (pool->work_cond == NULL) || (pool->done_cond == NULL))
+    {
+        WARNLOG("Cannot create worker threads sync objects: %s", SDL_GetError());
+        LbJobsFree();
+        pool->started = true;
+        return;
+    }
+    for (int i = 0; i < threads_count; i++)
+    {
+        pool->threads[i] = SDL_CreateThread(jobs_worker_thread, "JobsWorker", pool);
+        if (pool->threads[i] == NULL)
+        {
+            WARNLOG("Cannot start worker thread: %s", SDL_GetError());
+            break;
+        }
+        pool->threads_count++;
+    }
+    JUSTLOG("Started %d worker threads", pool->threads_count);
+}
+
+/**
+ * Calls func for all items from 0 to count-1, split into ranges of up to batch items
+ * which are processed on worker threads and the calling thread at once.
+ * Returns when all the items are processed. Must only be called from one thread.
+ */
+void LbJobsParallelFor(long count, long batch, LbJobFunc func, void *data)
+{
+    struct JobsPool *pool = &jobs_pool;
+    if (count <= 0)
+        return;
+    if (batch <= 0)
+        batch = 1;
+    if (!pool->started)
+        start_jobs_pool(pool);
+    // Waking up the workers costs more than a single batch takes
+    if ((pool->threads_count == 0) || (count <= batch))
+    {
+        func(data, 0, count);
+        return;
+    }
+    SDL_LockMutex(pool->lock);
+    pool->func = func;
+    pool->data = data;
+    pool->count = count;
+    pool->batch = batch;
+    SDL_AtomicSet(&pool->next_item, 0);
+    pool->busy_workers = pool->threads_count;
+    pool->job_id++;
+    SDL_CondBroadcast(pool->work_cond);
+    SDL_UnlockMutex(pool->lock);
+    run_job_batches(pool);
+    SDL_LockMutex(pool->lock);
+    while (pool->busy_workers > 0)
+        SDL_CondWait(pool->done_cond, pool->lock);
+    pool->func = NULL;
+    pool->data = NULL;
+    SDL_UnlockMutex(pool->lock);
+}
+
+/**
+ * Gives amount of worker threads, not counting the thread which gives them work.
+ */
+int LbJobsThreadsCount(void)
+{
+    return jobs_pool.threads_count;
+}
+
+void LbJobsFree(void)
+{
+    struct JobsPool *pool = &jobs_pool;
+    if (pool->threads_count > 0)
+    {
+        SDL_LockMutex(pool->lock);
+        pool->quit = true;
+        SDL_CondBroadcast(pool->work_cond);
+        SDL_UnlockMutex(pool->lock);
+        for (int i = 0; i < pool->threads_count; i++)
+        {
+            SDL_WaitThread(pool->threads[i], NULL);
+            pool->threads[i] = NULL;
+        }
+    }
+    if (pool->done_cond != NULL)
+        SDL_DestroyCond(pool->done_cond);
+    if (pool->work_cond != NULL)
+        SDL_DestroyCond(pool->work_cond);
+    if (pool->lock != NULL)
+        SDL_DestroyMutex(pool->lock);
+    pool->done_cond = NULL;
+    pool->work_cond = NULL;
+    pool->lock = NULL;
+    pool->threads_count = 0;
+    pool->quit = false;
+    pool->started = false;
+}
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
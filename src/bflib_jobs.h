@@ -0,0 +1,43 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_jobs.h
+ *     Header file for bflib_jobs.c.
+ * @par Purpose:
+ *     Pool of worker threads for splitting loops over many items.
+ * @par Comment:
+ *     Just a header file - #defines, typedefs, function prototypes etc.
+ * @author   KeeperFX Team
+ * @date     16 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#ifndef BFLIB_JOBS_H
+#define BFLIB_JOBS_H
+
+#include "bflib_basics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+/** Most worker threads started, besides the thread which gives them work. */
+#define JOBS_THREADS_MAX 7
+
+/** Processes items from first to first+count-1 of a job. */
+typedef void (*LbJobFunc)(void *data, long first, long count);
+
+/******************************************************************************/
+void LbJobsParallelFor(long count, long batch, LbJobFunc func, void *data);
+int LbJobsThreadsCount(void);
+void LbJobsFree(void);
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -93,7 +93,8 @@ void SendFrameToPeers(NetUserId source_id, const void * send_buf, size_t buf_siz
 }
 
 TbError ProcessMessage(NetUserId source, void* server_buf, size_t frame_size) {
-    if (netstate.sp->readmsg(source, netstate.msg_buffer, sizeof(netstate.msg_buffer)) <= 0) {
+    size_t msg_size = netstate.sp->readmsg(source, netstate.msg_buffer, sizeof(netstate.msg_buffer));
+    if (msg_size <= 0) {
         ERRORLOG("Problem reading message from %u", source);
         return Lb_FAIL;
     }
@@ -188,9 +189,13 @@ TbError ProcessMessage(NetUserId source, void* server_buf, size_t frame_size) {
         netstate.users[peer_id].ack = *(int *)ptr;
         ptr += 4;
         if (type == NETMSG_GAMEPLAY) {
-            struct BundledPacket* bundled = (struct BundledPacket*)ptr;
-            memcpy(peer_buf, &bundled->packets[0], frame_size);
-            unbundle_packets(ptr, (PlayerNumber)peer_id);
+            struct Packet current_packet;
+            size_t header_size = ptr - netstate.msg_buffer;
+            if ((msg_size <= header_size) || !unbundle_packets(ptr, msg_size - header_size, (PlayerNumber)peer_id, &current_packet)) {
+                ERRORLOG("Malformed packets bundle received from peer %i", peer_id);
+                return Lb_OK;
+            }
+            memcpy(peer_buf, &current_packet, frame_size);
         } else {
             memcpy(peer_buf, ptr, frame_size);
         }
@@ -269,39 +274,77 @@ TbError LbNetwork_ExchangeLogin(char *plyr_name) {
     return Lb_OK;
 }
 
+static TbBool is_exchange_peer(NetUserId id) {
+    if (id == netstate.my_id) { return false; }
+    if (netstate.users[id].progress == USER_UNUSED) { return false; }
+    if (my_player_number != get_host_player_id() && id != SERVER_ID) { return false; }
+    return true;
+}
+
+/**
+ * Processes the messages which were already received, without waiting for more.
+ * @return True if there was a gameplay message among them.
+ */
+static TbBool process_received_messages(void* server_buf, size_t client_frame_size) {
+    TbBool received_gameplay_msg = false;
+    for (NetUserId id = 0; id < netstate.max_players; id += 1) {
+        if (!is_exchange_peer(id)) { continue; }
+        while (netstate.sp->msgready(id, 0)) {
+            ProcessMessage(id, server_buf, client_frame_size);
+            if (netstate.msg_buffer[0] == NETMSG_GAMEPLAY) {
+                received_gameplay_msg = true;
+            }
+        }
+    }
+    return received_gameplay_msg;
+}
+
+/**
+ * Sleeps until a message is received, or given time passes.
+ * Messages are received by the network thread, so this doesn't poll.
+ */
+static void wait_for_received_messages(int wait_ms) {
+    for (NetUserId id = 0; id < netstate.max_players; id += 1) {
+        if (!is_exchange_peer(id)) { continue; }
+        netstate.sp->msgready(id, wait_ms);
+        return;
+    }
+}
+
+static int get_time_until_draw(long double draw_interval_nanoseconds) {
+    long long time_since_draw_nanoseconds = get_time_tick_ns() - last_draw_completed_time;
+    int remaining_time_until_draw = (int)((draw_interval_nanoseconds - time_since_draw_nanoseconds) / 1000000.0);
+    if (remaining_time_until_draw < 0) {remaining_time_until_draw = 0;}
+    return remaining_time_until_draw;
+}
+
 void LbNetwork_WaitForMissingPackets(void* server_buf, size_t client_frame_size) {
     if (game.skip_initial_input_turns > 0) {
         return;
     }
-    GameTurn historical_turn = game.play_gameturn - game.input_lag_turns;
+    LbNetwork_WaitForTurnPackets(game.play_gameturn - game.input_lag_turns, server_buf, client_frame_size);
+}
+
+void LbNetwork_WaitForTurnPackets(GameTurn historical_turn, void* server_buf, size_t client_frame_size) {
     const struct Packet* received_packets = get_received_packets_for_turn(historical_turn);
     if (received_packets == NULL) {
-        MULTIPLAYER_LOG("LbNetwork_WaitForMissingPackets: Missing packets for turn=%lu, waiting...", (unsigned long)historical_turn);
+        MULTIPLAYER_LOG("LbNetwork_WaitForTurnPackets: Missing packets for turn=%lu, waiting...", (unsigned long)historical_turn);
+        long double draw_interval_nanoseconds = 1000000000.0 / NETWORK_FPS;
         TbClockMSec start = LbTimerClock();
         while (true) {
             int elapsed = LbTimerClock() - start;
             if (elapsed >= TIMEOUT_GAMEPLAY_MISSING_PACKET) {
-                MULTIPLAYER_LOG("LbNetwork_WaitForMissingPackets: Timeout waiting for turn=%lu packets", (unsigned long)historical_turn);
+                MULTIPLAYER_LOG("LbNetwork_WaitForTurnPackets: Timeout waiting for turn=%lu packets", (unsigned long)historical_turn);
                 break;
             }
 
-            NetUserId id;
-            for (id = 0; id < netstate.max_players; id += 1) {
-                if (id == netstate.my_id) { continue; }
-                if (netstate.users[id].progress == USER_UNUSED) { continue; }
-                if (my_player_number != get_host_player_id() && id != SERVER_ID) { continue; }
-
-                int wait_time = TIMEOUT_GAMEPLAY_MISSING_PACKET - elapsed;
-                if (netstate.sp->msgready(id, wait_time)) {
-                    while (netstate.sp->msgready(id, 0)) {
-                        ProcessMessage(id, server_buf, client_frame_size);
-                    }
-                }
-            }
+            int wait_time = min(TIMEOUT_GAMEPLAY_MISSING_PACKET - elapsed, get_time_until_draw(draw_interval_nanoseconds));
+            wait_for_received_messages(wait_time);
+            process_received_messages(server_buf, client_frame_size);
 
             received_packets = get_received_packets_for_turn(historical_turn);
             if (received_packets != NULL) {
-                MULTIPLAYER_LOG("LbNetwork_WaitForMissingPackets: Successfully received packets for turn=%lu after %dms", (unsigned long)historical_turn, elapsed);
+                MULTIPLAYER_LOG("LbNetwork_WaitForTurnPackets: Successfully received packets for turn=%lu after %dms", (unsigned long)historical_turn, elapsed);
                 break;
             }
 
@@ -319,20 +362,23 @@ TbError LbNetwork_Exchange(enum NetMessageType msg_type, void *send_buf, void *s
     memcpy(((char*)server_buf) + netstate.my_id * client_frame_size, send_buf, client_frame_size);
     SendFrameToPeers(netstate.my_id, send_buf, client_frame_size, netstate.seq_nbr, msg_type);
 
+    if (msg_type == NETMSG_GAMEPLAY) {
+        // Gameplay packets are stored by turn as they arrive, and used input_lag_turns later;
+        // only LbNetwork_WaitForMissingPackets waits, if they're late for the turn being processed.
+        process_received_messages(server_buf, client_frame_size);
+        netstate.seq_nbr += 1;
+        return Lb_OK;
+    }
+
     long double draw_interval_nanoseconds = 1000000000.0 / NETWORK_FPS;
     if (msg_type == NETMSG_FRONTEND) {
         draw_interval_nanoseconds = 0;
     }
     int timeout_max = TIMEOUT_LOBBY_EXCHANGE;
-    if (msg_type == NETMSG_GAMEPLAY) {
-        timeout_max = (1000 / game_num_fps);
-    }
 
     NetUserId id;
     for (id = 0; id < netstate.max_players; id += 1) {
-        if (id == netstate.my_id) { continue; }
-        if (netstate.users[id].progress == USER_UNUSED) { continue; }
-        if (my_player_number != get_host_player_id() && id != SERVER_ID) { continue; }
+        if (!is_exchange_peer(id)) { continue; }
 
         TbClockMSec start = LbTimerClock();
         while (true) {
@@ -341,26 +387,11 @@ TbError LbNetwork_Exchange(enum NetMessageType msg_type, void *send_buf, void *s
                 break;
             }
 
-            long long time_since_draw_nanoseconds = get_time_tick_ns() - last_draw_completed_time;
-            int remaining_time_until_draw = (int)((draw_interval_nanoseconds - time_since_draw_nanoseconds) / 1000000.0);
-            if (remaining_time_until_draw < 0) {remaining_time_until_draw = 0;}
-            int wait = min(timeout_max - elapsed, remaining_time_until_draw);
+            int wait = min(timeout_max - elapsed, get_time_until_draw(draw_interval_nanoseconds));
 
             if (netstate.sp->msgready(id, wait)) {
                 ProcessMessage(id, server_buf, client_frame_size);
-                if (msg_type != NETMSG_GAMEPLAY) {
-                    break;
-                }
-                TbBool received_gameplay_msg = (netstate.msg_buffer[0] == NETMSG_GAMEPLAY);
-                while (netstate.sp->msgready(id, 0)) {
-                    ProcessMessage(id, server_buf, client_frame_size);
-                    if (netstate.msg_buffer[0] == NETMSG_GAMEPLAY) {
-                        received_gameplay_msg = true;
-                    }
-                }
-                if (received_gameplay_msg) {
-                    break;
-                }
+                break;
             }
 
             if (LbTimerClock() - start < timeout_max) {
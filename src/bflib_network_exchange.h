@@ -29,6 +29,7 @@ extern "C" {
 TbError LbNetwork_Exchange(enum NetMessageType msg_type, void *send_buf, void *server_buf, size_t buf_size);
 TbError LbNetwork_ExchangeLogin(char *plyr_name);
 void LbNetwork_WaitForMissingPackets(void* server_buf, size_t client_frame_size);
+void LbNetwork_WaitForTurnPackets(GameTurn turn, void* server_buf, size_t client_frame_size);
 void LbNetwork_SendChatMessageImmediate(int player_id, const char *message);
 void LbNetwork_BroadcastUnpauseTimesync(void);
 
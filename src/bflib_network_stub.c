@@ -21,6 +21,7 @@
 #include "net_resync.h"
 #include "net_game.h"
 #include "net_input_lag.h"
+#include "net_rollback.h"
 #include "net_checksums.h"
 #include "net_redundant_packets.h"
 #include "net_received_packets.h"
@@ -66,6 +67,7 @@ void    LbNetwork_UpdateInputLagIfHost(void) {}
 TbError LbNetwork_Exchange(enum NetMessageType msg_type, void *send_buf, void *server_buf, size_t buf_size) { (void)msg_type; (void)send_buf; (void)server_buf; (void)buf_size; return Lb_FAIL; }
 TbError LbNetwork_ExchangeLogin(char *plyr_name) { (void)plyr_name; return Lb_FAIL; }
 void    LbNetwork_WaitForMissingPackets(void *server_buf, size_t client_frame_size) { (void)server_buf; (void)client_frame_size; }
+void    LbNetwork_WaitForTurnPackets(GameTurn turn, void *server_buf, size_t client_frame_size) { (void)turn; (void)server_buf; (void)client_frame_size; }
 void    LbNetwork_SendChatMessageImmediate(int player_id, const char *message) { (void)player_id; (void)message; }
 void    LbNetwork_BroadcastUnpauseTimesync(void) {}
 
@@ -83,13 +85,20 @@ void  store_local_packet_in_input_lag_queue(PlayerNumber my_packet_num) { (void)
 TbBool input_lag_skips_initial_processing(void) { return 0; }
 unsigned short calculate_skip_input(void) { return 0; }
 
+/* net_rollback.c stubs */
+void   rollback_set_enabled(TbBool enabled) { (void)enabled; }
+TbBool rollback_enabled(void) { return 0; }
+void   rollback_reset(void) {}
+void   rollback_wait_for_window(void) {}
+TbBool rollback_load_packets(PlayerNumber my_packet_num) { (void)my_packet_num; return 1; }
+
 /* net_checksums.c stubs */
 void  update_turn_checksums(void) {}
 short checksums_different(void) { return 0; }
 
 /* net_redundant_packets.c stubs */
 void initialize_redundant_packets(void) {}
-void unbundle_packets(const char *bundled_buffer, PlayerNumber source_player) { (void)bundled_buffer; (void)source_player; }
+TbBool unbundle_packets(const char *bundled_buffer, size_t buf_size, PlayerNumber source_player, struct Packet *current_packet) { (void)bundled_buffer; (void)buf_size; (void)source_player; (void)current_packet; return false; }
 
 /* net_received_packets.c stubs */
 void initialize_packet_tracking(void) {}
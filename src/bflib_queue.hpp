@@ -0,0 +1,79 @@
+/******************************************************************************/
+// Bullfrog Engine Emulation Library - for use to remake classic games like
+// Syndicate Wars, Magic Carpet or Dungeon Keeper.
+/******************************************************************************/
+/** @file bflib_queue.hpp
+ *     Queue for passing items between two threads.
+ * @par Purpose:
+ *     Fixed size queue between a producer and a consumer thread, without locking.
+ * @par Comment:
+ *     Just a header file - the whole template is here.
+ * @author   KeeperFX Team
+ * @date     16 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#ifndef BFLIB_QUEUE_HPP
+#define BFLIB_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Fixed size queue between two threads, one only putting items in and the other only taking them out.
+ * Needs no locking; each side only writes its own index.
+ */
+template <typename T, size_t N> class MessageQueue
+{
+public:
+    bool push(const T &item)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % N;
+        if (next == head_.load(std::memory_order_acquire))
+            return false;
+        items_[tail] = item;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+        item = items_[head];
+        head_.store((head + 1) % N, std::memory_order_release);
+        return true;
+    }
+
+    /** Gives the next item without taking it out; only for the side which takes items out. */
+    const T *peek() const
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return nullptr;
+        return &items_[head];
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t size() const
+    {
+        return (tail_.load(std::memory_order_acquire) + N - head_.load(std::memory_order_acquire)) % N;
+    }
+
+private:
+    T items_[N];
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+};
+
+#endif
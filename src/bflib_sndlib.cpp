@@ -6,6 +6,8 @@
 #include "bflib_datetm.h"
 #include "bflib_sound.h"
 #include "bflib_fileio.h"
+#include "bflib_queue.hpp"
+#include "platform/PlatformManager.h"
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <AL/alext.h>
@@ -13,6 +15,7 @@
 #include <SDL2/SDL_mixer.h>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <vector>
 #include <fstream>
@@ -20,11 +23,20 @@
 #include <utility>
 #include <array>
 #include <deque>
+#include <list>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <thread>
 #include <set>
 #include "post_inc.h"
 
+/** Capacity of the queue of commands for the audio thread. */
+#define AUDIO_QUEUE_SIZE 1024
+#define AUDIO_ERRORS_QUEUE_SIZE 64
+/** How long the audio thread sleeps between checking for commands and finished sources. */
+#define AUDIO_THREAD_INTERVAL_MS 2
+
 namespace {
 
 struct device_deleter {
@@ -107,11 +119,9 @@ public:
 class openal_source {
 public:
 	ALuint id = 0;
-	SoundMilesID mss_id = 0;
-	SoundEmitterID emit_id = 0;
-	SoundSmplTblID smptbl_id = 0;
-	SoundBankID bank_id = 0;
-	int flags = 0;
+	ALuint buffer_id = 0;
+	/** Generation of the voice which was last played on this source. */
+	uint32_t generation = 0;
 
 	openal_source() {
 		ALuint sources[1];
@@ -133,6 +143,7 @@ public:
 		if (errcode != AL_NO_ERROR) {
 			throw openal_error("Cannot attach buffer", errcode);
 		}
+		buffer_id = buffer.id;
 		alSourcePlay(id);
 		errcode = alGetError();
 		if (errcode != AL_NO_ERROR) {
@@ -183,6 +194,15 @@ public:
 		}
 	}
 
+	void detach() {
+		alSourcei(id, AL_BUFFER, 0);
+		const auto errcode = alGetError();
+		if (errcode != AL_NO_ERROR) {
+			throw openal_error("Cannot detach buffer", errcode);
+		}
+		buffer_id = 0;
+	}
+
 	bool is_playing() const {
 		ALint state = 0;
 		alGetSourcei(id, AL_SOURCE_STATE, &state);
@@ -198,21 +218,54 @@ public:
 
 	inline openal_source(openal_source && other)
 	: id(std::exchange(other.id, 0))
-	, mss_id(std::exchange(other.mss_id, 0))
-	, emit_id(std::exchange(other.emit_id, 0))
-	, smptbl_id(std::exchange(other.smptbl_id, 0))
-	, bank_id(std::exchange(other.bank_id, 0)){}
+	, buffer_id(std::exchange(other.buffer_id, 0))
+	, generation(std::exchange(other.generation, 0)) {}
 
 	inline openal_source & operator=(openal_source && other) {
 		id = std::exchange(other.id, 0);
-		mss_id = std::exchange(other.mss_id, 0);
-		emit_id = std::exchange(other.emit_id, 0);
-		smptbl_id = std::exchange(other.smptbl_id, 0);
-		bank_id = std::exchange(other.bank_id, 0);
+		buffer_id = std::exchange(other.buffer_id, 0);
+		generation = std::exchange(other.generation, 0);
 		return *this;
 	}
 };
 
+/** What the game thread knows about a source; the source itself belongs to the audio thread. */
+struct sample_voice {
+	SoundMilesID mss_id = 0;
+	SoundEmitterID emit_id = 0;
+	SoundSmplTblID smptbl_id = 0;
+	SoundBankID bank_id = 0;
+	int flags = 0;
+	/** Incremented whenever a sample is started on the voice. */
+	uint32_t generation = 0;
+};
+
+enum class audio_command_type {
+	play,
+	stop,
+	stop_all,
+	gain,
+	pan,
+	pitch,
+	listener_gain,
+};
+
+struct audio_command {
+	audio_command_type type;
+	uint32_t voice;
+	uint32_t generation;
+	SoundSmplTblID smptbl_id;
+	SoundBankID bank_id;
+	bool repeat;
+	SoundVolume volume;
+	SoundPan pan;
+	SoundPitch pitch;
+};
+
+struct audio_error {
+	char text[160];
+};
+
 inline uint32_t make_fourcc(const char (& code)[5]) {
 	return
 		(uint32_t(code[0]) << 0) |
@@ -247,26 +300,40 @@ struct WAVEFORMATEX {
 
 class wave_file {
 public:
-	wave_file(std::ifstream & stream) {
+	wave_file(const uint8_t * data, size_t size) {
+		size_t pos = 0;
+		const auto read = [&](void * dest, size_t len) {
+			if (len > size - pos) {
+				throw std::runtime_error("Unexpected end of sample data");
+			}
+			memcpy(dest, data + pos, len);
+			pos += len;
+		};
+		const auto skip = [&](size_t len) {
+			if (len > size - pos) {
+				throw std::runtime_error("Unexpected end of sample data");
+			}
+			pos += len;
+		};
 		riff_chunk_t riff_header;
-		stream.read(reinterpret_cast<char *>(&riff_header), sizeof(riff_header));
+		read(&riff_header, sizeof(riff_header));
 		if (riff_header.tag != make_fourcc("RIFF")) {
 			throw std::runtime_error("Expected RIFF chunk");
 		}
 		uint32_t filetype;
-		stream.read(reinterpret_cast<char *>(&filetype), sizeof(filetype));
+		read(&filetype, sizeof(filetype));
 		if (filetype != make_fourcc("WAVE")) {
 			throw std::runtime_error("Expected WAVE chunk");
 		}
 		riff_chunk_t chunk;
 		for (bool have_format = false, have_data = false; !(have_format && have_data);) {
-			stream.read(reinterpret_cast<char *>(&chunk), sizeof(chunk));
+			read(&chunk, sizeof(chunk));
 			if (chunk.tag == make_fourcc("fmt ")) {
 				if (chunk.size < sizeof(WAVEFORMATEX)) {
 					throw std::runtime_error("Expected WAVEFORMATEX struct");
 				}
 				WAVEFORMATEX formatex;
-				stream.read(reinterpret_cast<char *>(&formatex), sizeof(formatex));
+				read(&formatex, sizeof(formatex));
 				if (!(formatex.wFormatTag == WAVE_FORMAT_PCM || formatex.wFormatTag == WAVE_FORMAT_ADPCM)) {
 					throw std::runtime_error("Unsupported format");
 				} else if (formatex.nChannels == 1 && formatex.wBitsPerSample == 4) {
@@ -286,23 +353,29 @@ public:
 				}
 				m_samplerate = formatex.nSamplesPerSec;
 				if (chunk.size > sizeof(formatex)) {
-					stream.seekg(chunk.size - sizeof(formatex), std::ios::cur);
+					skip(chunk.size - sizeof(formatex));
 				}
 				have_format = true;
 			} else if (chunk.tag == make_fourcc("data")) {
-				m_pcm.resize(chunk.size);
-				stream.read(reinterpret_cast<char *>(m_pcm.data()), m_pcm.size());
+				// The samples stay where they are, in the bank file
+				m_pcm = data + pos;
+				m_pcm_size = chunk.size;
+				skip(chunk.size);
 				have_data = true;
 			} else {
-				stream.seekg(chunk.size, std::ios::cur);
+				skip(chunk.size);
 			}
 		}
 	}
 
-	inline const std::vector<uint8_t> & pcm() const {
+	inline const uint8_t * pcm() const {
 		return m_pcm;
 	}
 
+	inline size_t pcm_size() const {
+		return m_pcm_size;
+	}
+
 	inline int samplerate() const {
 		return m_samplerate;
 	}
@@ -314,37 +387,118 @@ public:
 protected:
 	int m_samplerate = 0;
 	ALenum m_format = 0;
-	std::vector<uint8_t> m_pcm;
+	const uint8_t * m_pcm = nullptr;
+	size_t m_pcm_size = 0;
 };
 
+/** Contents of a sound bank file; mapped into memory if the platform can, or read whole otherwise. */
+class bank_file {
+public:
+	explicit bank_file(const char * filename) {
+		m_data = static_cast<const uint8_t *>(PlatformManager_FileMap(filename, &m_size));
+		if (m_data) {
+			m_mapped = true;
+			return;
+		}
+		std::ifstream stream(filename, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!stream.is_open()) {
+			throw std::runtime_error("Cannot open sound bank file");
+		}
+		m_buffer.resize(stream.tellg());
+		stream.seekg(0, std::ios::beg);
+		stream.read(reinterpret_cast<char *>(m_buffer.data()), m_buffer.size());
+		m_data = m_buffer.data();
+		m_size = m_buffer.size();
+	}
+
+	inline ~bank_file() noexcept {
+		if (m_mapped) {
+			PlatformManager_FileUnmap(m_data, m_size);
+		}
+	}
+
+	bank_file(const bank_file &) = delete;
+	bank_file & operator=(const bank_file &) = delete;
+
+	template <typename T>
+	T read(size_t offset) const {
+		if (offset > m_size || sizeof(T) > m_size - offset) {
+			throw std::runtime_error("Sound bank offset out of file");
+		}
+		T value;
+		memcpy(&value, m_data + offset, sizeof(T));
+		return value;
+	}
+
+	inline const uint8_t * data() const {
+		return m_data;
+	}
+
+	inline size_t size() const {
+		return m_size;
+	}
+
+	inline bool mapped() const {
+		return m_mapped;
+	}
+
+protected:
+	const uint8_t * m_data = nullptr;
+	size_t m_size = 0;
+	bool m_mapped = false;
+	std::vector<uint8_t> m_buffer;
+};
+
+using sample_key = std::pair<SoundBankID, SoundSmplTblID>;
+
 struct sound_sample {
 
 	std::string name;
-	SoundSFXID sfx_id;
-	openal_buffer buffer;
-
-	sound_sample(const char * _name, SoundSFXID _sfx_id, const wave_file & wav) {
-		name = _name;
-		sfx_id = _sfx_id;
-		const auto & pcm = wav.pcm();
+	SoundSFXID sfx_id = 0;
+	/** Place of the sample's wave file in the bank file. */
+	size_t data_offset = 0;
+	size_t data_size = 0;
+	/** Made when the sample is first played, and released when unused and over the budget. */
+	std::unique_ptr<openal_buffer> buffer;
+	size_t buffer_size = 0;
+	std::list<sample_key>::iterator lru_pos;
+	bool broken = false;
+
+	void upload(const bank_file & file) {
+		const wave_file wav(file.data() + data_offset, data_size);
+		auto new_buffer = std::make_unique<openal_buffer>();
+		const auto pcm = wav.pcm();
+		const auto pcm_size = wav.pcm_size();
 		const auto format = wav.format();
 		if (format == AL_FORMAT_MONO_MSADPCM_SOFT) {
 			// Needed for heart6a.wav
-			std::vector<uint8_t> converted(pcm.size() * 2);
-			for (size_t i = 0; i < pcm.size(); ++i) {
+			std::vector<uint8_t> converted(pcm_size * 2);
+			for (size_t i = 0; i < pcm_size; ++i) {
 				converted[(i * 2) + 0] = (pcm[i] >> 4) * 2;
 				converted[(i * 2) + 1] = (pcm[i] & 0x7) * 2;
 			}
-			alBufferData(buffer.id, AL_FORMAT_MONO8, converted.data(), converted.size(), wav.samplerate());
+			alBufferData(new_buffer->id, AL_FORMAT_MONO8, converted.data(), converted.size(), wav.samplerate());
+			buffer_size = converted.size();
 		} else if (format == AL_FORMAT_STEREO_MSADPCM_SOFT) {
 			throw std::runtime_error("Format not implemented");
 		} else {
-			alBufferData(buffer.id, format, pcm.data(), pcm.size(), wav.samplerate());
+			alBufferData(new_buffer->id, format, pcm, pcm_size, wav.samplerate());
+			buffer_size = pcm_size;
 		}
 		const auto errcode = alGetError();
 		if (errcode != AL_NO_ERROR) {
 			throw openal_error("Cannot buffer sample data", errcode);
 		}
+		buffer = std::move(new_buffer);
+	}
+};
+
+struct sound_bank {
+	std::unique_ptr<bank_file> file;
+	std::vector<sound_sample> samples;
+
+	inline size_t size() const {
+		return samples.size();
 	}
 };
 
@@ -378,43 +532,102 @@ struct SoundBankEntry { // sizeof = 16
 };
 #pragma pack()
 
-std::vector<sound_sample> load_sound_bank(const char * filename) {
+sound_bank load_sound_bank(const char * filename) {
 	const int directory_index = 2; // a5 was always 1622
-	std::ifstream stream(filename, std::ios::in | std::ios::binary);
-	if (!stream.is_open()) {
-		throw std::runtime_error("Cannot open sound bank file");
-	}
-	stream.seekg(-4, std::ios::end);
-	uint32_t head_offset;
-	stream.read(reinterpret_cast<char *>(&head_offset), sizeof(head_offset));
-	stream.seekg(head_offset, std::ios::beg);
-	SoundBankHead bhead;
-	stream.read(reinterpret_cast<char *>(&bhead), sizeof(bhead));
-	SoundBankEntry bentries[9];
-	stream.read(reinterpret_cast<char *>(bentries), sizeof(bentries));
-	const auto & directory = bentries[directory_index];
+	sound_bank bank;
+	bank.file = std::make_unique<bank_file>(filename);
+	const auto & file = *bank.file;
+	if (file.size() < sizeof(uint32_t)) {
+		throw std::runtime_error("Sound bank file too short");
+	}
+	const auto head_offset = file.read<uint32_t>(file.size() - sizeof(uint32_t));
+	const auto directory = file.read<SoundBankEntry>(head_offset + sizeof(SoundBankHead) + sizeof(SoundBankEntry) * directory_index);
 	if (directory.first_sample_offset == 0) {
 		throw std::runtime_error("Invalid sample offset");
 	} else if (directory.total_samples_size < sizeof(SoundBankSample)) {
 		throw std::runtime_error("Invalid samples size");
 	}
 	const int sample_count = directory.total_samples_size / sizeof(SoundBankSample);
-	stream.seekg(directory.first_sample_offset, std::ios::beg);
-	std::vector<sound_sample> buffers;
-	buffers.reserve(sample_count);
-	SoundBankSample sample;
+	// Only the index is read here; sample data is uploaded when first played
+	bank.samples.resize(sample_count);
 	for (int i = 0; i < sample_count; ++i) {
-		stream.seekg(directory.first_sample_offset + (sizeof(sample) * i), std::ios::beg);
-		stream.read(reinterpret_cast<char *>(&sample), sizeof(sample));
-		stream.seekg(directory.first_data_offset + sample.data_offset, std::ios::beg);
-		buffers.emplace_back(sample.filename, sample.sfxid, wave_file(stream));
+		const auto sample = file.read<SoundBankSample>(directory.first_sample_offset + (sizeof(SoundBankSample) * i));
+		const size_t data_offset = size_t(directory.first_data_offset) + sample.data_offset;
+		if (data_offset >= file.size()) {
+			throw std::runtime_error("Invalid sample data offset");
+		}
+		auto & smp = bank.samples[i];
+		smp.name.assign(sample.filename, strnlen(sample.filename, sizeof(sample.filename)));
+		smp.sfx_id = sample.sfxid;
+		smp.data_offset = data_offset;
+		smp.data_size = file.size() - data_offset;
 	}
-	JUSTLOG("Loaded %d sound samples from %s", (int) buffers.size(), filename);
-	return buffers;
+	JUSTLOG("Indexed %d sound samples from %s%s", sample_count, filename, file.mapped() ? " (mapped)" : "");
+	return bank;
 }
 
+// Sources and sample buffers are only used by the audio thread while it runs
 std::vector<openal_source> g_sources;
-std::array<std::vector<sound_sample>, 2> g_banks;
+std::array<sound_bank, 2> g_banks;
+/** Samples with an OpenAL buffer, most recently played first. */
+std::list<sample_key> g_loaded_samples;
+size_t g_loaded_samples_size = 0;
+/** Bytes of sample buffers kept before unused ones are released. */
+constexpr size_t sample_buffers_budget = 32 * 1024 * 1024;
+
+/** Detaches the buffer from stopped sources. Returns false if a source still plays it. */
+bool release_buffer_from_sources(ALuint buffer_id) {
+	for (auto & source : g_sources) {
+		if (source.buffer_id == buffer_id && source.is_playing()) {
+			return false;
+		}
+	}
+	for (auto & source : g_sources) {
+		if (source.buffer_id == buffer_id) {
+			source.detach();
+		}
+	}
+	return true;
+}
+
+void release_samples_over_budget() {
+	auto it = g_loaded_samples.end();
+	while (g_loaded_samples_size > sample_buffers_budget && it != g_loaded_samples.begin()) {
+		--it;
+		if (it == g_loaded_samples.begin()) {
+			break; // the sample about to be played
+		}
+		auto & smp = g_banks[it->first].samples[it->second];
+		if (!release_buffer_from_sources(smp.buffer->id)) {
+			continue;
+		}
+		g_loaded_samples_size -= smp.buffer_size;
+		smp.buffer.reset();
+		smp.buffer_size = 0;
+		it = g_loaded_samples.erase(it);
+	}
+}
+
+const openal_buffer & get_sample_buffer(SoundBankID bank_id, SoundSmplTblID smptbl_id) {
+	auto & smp = g_banks[bank_id].samples[smptbl_id];
+	if (smp.buffer) {
+		g_loaded_samples.splice(g_loaded_samples.begin(), g_loaded_samples, smp.lru_pos);
+		return *smp.buffer;
+	} else if (smp.broken) {
+		throw std::runtime_error("Sample " + smp.name + " cannot be loaded");
+	}
+	try {
+		smp.upload(*g_banks[bank_id].file);
+	} catch (const std::exception &) {
+		smp.broken = true;
+		throw;
+	}
+	g_loaded_samples.emplace_front(bank_id, smptbl_id);
+	smp.lru_pos = g_loaded_samples.begin();
+	g_loaded_samples_size += smp.buffer_size;
+	release_samples_over_budget();
+	return *smp.buffer;
+}
 
 void load_sound_banks() {
 	char snd_fname[2048];
@@ -468,28 +681,180 @@ void SDLCALL on_music_finished() {
 	Mix_FreeMusic(g_mix_music.exchange(nullptr));
 }
 
+std::vector<sample_voice> g_voices;
+/** Generation of each voice whose sample the audio thread saw finished; voice is playing until it matches. */
+std::unique_ptr<std::atomic<uint32_t>[]> g_voices_finished;
+std::thread g_audio_thread;
+std::atomic<bool> g_audio_quit{false};
+MessageQueue<audio_command, AUDIO_QUEUE_SIZE> g_audio_commands;
+// The log isn't thread safe; errors of the audio thread are logged by the game thread
+MessageQueue<audio_error, AUDIO_ERRORS_QUEUE_SIZE> g_audio_errors;
+
+void report_audio_error(const char * text) {
+	audio_error err;
+	snprintf(err.text, sizeof(err.text), "%s", text);
+	g_audio_errors.push(err);
+}
+
+void run_audio_command(const audio_command & cmd) {
+	if (cmd.type == audio_command_type::stop_all) {
+		for (auto & source : g_sources) {
+			try {
+				source.stop();
+			} catch (const std::exception & e) {
+				report_audio_error(e.what());
+			}
+		}
+		return;
+	} else if (cmd.type == audio_command_type::listener_gain) {
+		alListenerf(AL_GAIN, float(cmd.volume) / FULL_LOUDNESS);
+		const auto errcode = alGetError();
+		if (errcode != AL_NO_ERROR) {
+			report_audio_error(openal_error("Cannot set master volume", errcode).what());
+		}
+		return;
+	}
+	auto & source = g_sources[cmd.voice];
+	try {
+		switch (cmd.type) {
+			case audio_command_type::play:
+				source.generation = cmd.generation;
+				source.gain(cmd.volume);
+				source.pan(cmd.pan);
+				source.repeat(cmd.repeat);
+				source.pitch(cmd.pitch);
+				source.play(get_sample_buffer(cmd.bank_id, cmd.smptbl_id));
+				break;
+			case audio_command_type::stop:
+				source.stop();
+				break;
+			case audio_command_type::gain:
+				source.gain(cmd.volume);
+				break;
+			case audio_command_type::pan:
+				source.pan(cmd.pan);
+				break;
+			case audio_command_type::pitch:
+				source.pitch(cmd.pitch);
+				break;
+			default:
+				break;
+		}
+	} catch (const std::exception & e) {
+		report_audio_error(e.what());
+		if (cmd.type == audio_command_type::play) {
+			g_voices_finished[cmd.voice].store(cmd.generation, std::memory_order_release);
+		}
+	}
+}
+
+/** Lets the game thread know which voices stopped playing. */
+void update_finished_voices() {
+	for (size_t i = 0; i < g_sources.size(); ++i) {
+		auto & source = g_sources[i];
+		if (g_voices_finished[i].load(std::memory_order_relaxed) == source.generation) {
+			continue;
+		}
+		try {
+			if (!source.is_playing()) {
+				g_voices_finished[i].store(source.generation, std::memory_order_release);
+			}
+		} catch (const std::exception & e) {
+			report_audio_error(e.what());
+			g_voices_finished[i].store(source.generation, std::memory_order_release);
+		}
+	}
+}
+
+/**
+ * Audio thread. Owns the OpenAL sources and sample buffers, and does what the game thread queued.
+ */
+void audio_thread_main() {
+	while (!g_audio_quit.load(std::memory_order_acquire)) {
+		audio_command cmd;
+		while (g_audio_commands.pop(cmd)) {
+			run_audio_command(cmd);
+		}
+		update_finished_voices();
+		std::this_thread::sleep_for(std::chrono::milliseconds(AUDIO_THREAD_INTERVAL_MS));
+	}
+}
+
+void start_audio_thread() {
+	g_audio_quit.store(false, std::memory_order_release);
+	g_audio_thread = std::thread(audio_thread_main);
+}
+
+void stop_audio_thread() {
+	if (!g_audio_thread.joinable()) {
+		return;
+	}
+	g_audio_quit.store(true, std::memory_order_release);
+	g_audio_thread.join();
+	// Now the game thread owns OpenAL again; whatever was left doesn't matter anymore
+	audio_command cmd;
+	while (g_audio_commands.pop(cmd)) {
+	}
+}
+
+void queue_audio_command(const audio_command & cmd) {
+	if (!g_audio_thread.joinable()) {
+		return;
+	}
+	// The audio thread empties the queue every interval, so it can't stay full for long
+	while (!g_audio_commands.push(cmd)) {
+		std::this_thread::yield();
+	}
+}
+
+void queue_voice_command(audio_command_type type, const sample_voice & voice) {
+	audio_command cmd = {};
+	cmd.type = type;
+	cmd.voice = voice.mss_id - 1;
+	cmd.generation = voice.generation;
+	queue_audio_command(cmd);
+}
+
+void log_audio_errors() {
+	audio_error err;
+	while (g_audio_errors.pop(err)) {
+		ERRORLOG("%s", err.text);
+	}
+}
+
+bool voice_is_playing(const sample_voice & voice) {
+	return g_voices_finished[voice.mss_id - 1].load(std::memory_order_acquire) != voice.generation;
+}
+
+void clear_voice(sample_voice & voice) {
+	voice.emit_id = 0;
+	voice.smptbl_id = 0;
+	voice.bank_id = 0;
+}
+
 } // local
 
 extern "C" void FreeAudio() {
+	stop_audio_thread();
+	log_audio_errors();
+	g_voices.clear();
+	g_voices_finished.reset();
 	g_sources.clear();
-	g_banks[0].clear();
-	g_banks[1].clear();
+	g_loaded_samples.clear();
+	g_loaded_samples_size = 0;
+	g_banks[0] = sound_bank();
+	g_banks[1] = sound_bank();
 	g_openal_context = nullptr;
 	g_openal_device = nullptr;
 }
 
 extern "C" void SetSoundMasterVolume(SoundVolume volume) {
-	try {
-		// Set OpenAL listener gain to maximum so we can split up the mentor speech volume slider from the sound effects volume slider
-		alListenerf(AL_GAIN, 1.0f);
-		const auto errcode = alGetError();
-		if (errcode != AL_NO_ERROR) {
-			throw openal_error("Cannot set master volume", errcode);
-		}
-		g_master_volume = volume;
-	} catch (const std::exception & e) {
-		ERRORLOG("%s", e.what());
-	}
+	// Set OpenAL listener gain to maximum so we can split up the mentor speech volume slider from the sound effects volume slider
+	audio_command cmd = {};
+	cmd.type = audio_command_type::listener_gain;
+	cmd.volume = FULL_LOUDNESS;
+	queue_audio_command(cmd);
+	g_master_volume = volume;
 }
 
 extern "C" void set_music_volume(SoundVolume value) {
@@ -576,15 +941,10 @@ extern "C" TbBool GetSoundInstalled() {
 
 // This function gets called every tick
 extern "C" void MonitorStreamedSoundTrack() {
-	for (auto & source : g_sources) {
-		try {
-			if (source.emit_id > 0 && !source.is_playing()) {
-				source.emit_id = 0;
-				source.smptbl_id = 0;
-				source.bank_id = 0;
-			}
-		} catch (const std::exception & e) {
-			ERRORLOG("%s", e.what());
+	log_audio_errors();
+	for (auto & voice : g_voices) {
+		if (voice.emit_id > 0 && !voice_is_playing(voice)) {
+			clear_voice(voice);
 		}
 	}
 	g_tick_samples.clear();
@@ -597,12 +957,11 @@ extern "C" void * GetSoundDriver() {
 }
 
 extern "C" void StopAllSamples() {
-	for (auto & source : g_sources) {
-		try {
-			source.stop();
-		} catch (const std::exception & e) {
-			ERRORLOG("%s", e.what());
-		}
+	audio_command cmd = {};
+	cmd.type = audio_command_type::stop_all;
+	queue_audio_command(cmd);
+	for (auto & voice : g_voices) {
+		clear_voice(voice);
 	}
 }
 
@@ -633,12 +992,17 @@ extern "C" TbBool InitAudio(const SoundSettings * settings) {
 			throw openal_error("Cannot make context current");
 		}
 		g_sources.resize(settings->max_number_of_samples);
-		for (size_t i = 0; i < g_sources.size(); ++i) {
-			g_sources[i].mss_id = i + 1;
-		}
 		load_sound_banks();
+		g_voices.assign(g_sources.size(), sample_voice());
+		g_voices_finished.reset(new std::atomic<uint32_t>[g_sources.size()]);
+		for (size_t i = 0; i < g_voices.size(); ++i) {
+			g_voices[i].mss_id = i + 1;
+			g_voices_finished[i].store(0, std::memory_order_relaxed);
+		}
 		g_openal_device = std::move(device);
 		g_openal_context = std::move(context);
+		// From now on only the audio thread makes OpenAL calls
+		start_audio_thread();
 		return true;
 	} catch (const std::exception & e) {
 		ERRORLOG("%s", e.what());
@@ -648,14 +1012,10 @@ extern "C" TbBool InitAudio(const SoundSettings * settings) {
 }
 
 extern "C" TbBool IsSamplePlaying(SoundMilesID mss_id) {
-	try {
-		for (const auto & source : g_sources) {
-			if (source.mss_id == mss_id) {
-				return source.is_playing();
-			}
+	for (const auto & voice : g_voices) {
+		if (voice.mss_id == mss_id) {
+			return (voice.emit_id != 0) && voice_is_playing(voice);
 		}
-	} catch (const std::exception & e) {
-		ERRORLOG("%s", e.what());
 	}
 	return false;
 }
@@ -665,41 +1025,40 @@ extern "C" SoundVolume GetCurrentSoundMasterVolume() {
 }
 
 extern "C" void SetSampleVolume(SoundEmitterID emit_id, SoundSmplTblID smptbl_id, SoundVolume volume) {
-	for (auto & source : g_sources) {
-		if (source.emit_id == emit_id && source.smptbl_id == smptbl_id) {
-			try {
-				source.gain(volume);
-			} catch (const std::exception & e) {
-				ERRORLOG("%s", e.what());
-			}
+	for (auto & voice : g_voices) {
+		if (voice.emit_id == emit_id && voice.smptbl_id == smptbl_id) {
+			audio_command cmd = {};
+			cmd.type = audio_command_type::gain;
+			cmd.voice = voice.mss_id - 1;
+			cmd.volume = volume;
+			queue_audio_command(cmd);
 		}
 	}
 }
 
 extern "C" void SetSamplePan(SoundEmitterID emit_id, SoundSmplTblID smptbl_id, SoundPan pan) {
-	for (auto & source : g_sources) {
-		if (source.emit_id == emit_id && source.smptbl_id == smptbl_id) {
-			try {
-				source.pan(pan);
-			} catch (const std::exception & e) {
-				ERRORLOG("%s", e.what());
-			}
+	for (auto & voice : g_voices) {
+		if (voice.emit_id == emit_id && voice.smptbl_id == smptbl_id) {
+			audio_command cmd = {};
+			cmd.type = audio_command_type::pan;
+			cmd.voice = voice.mss_id - 1;
+			cmd.pan = pan;
+			queue_audio_command(cmd);
 		}
 	}
 }
 
 extern "C" void SetSamplePitch(SoundEmitterID emit_id, SoundSmplTblID smptbl_id, SoundPitch pitch) {
-	for (auto & source : g_sources) {
-		if (source.emit_id == emit_id && source.smptbl_id == smptbl_id) {
-			try {
-				if (source.flags & bb_king_mode) {
-					return; // ben enjoyed dofi's stream so much I made random pitch an easter egg
-				} else {
-					source.pitch(pitch);
-				}
-			} catch (const std::exception & e) {
-				ERRORLOG("%s", e.what());
+	for (auto & voice : g_voices) {
+		if (voice.emit_id == emit_id && voice.smptbl_id == smptbl_id) {
+			if (voice.flags & bb_king_mode) {
+				return; // ben enjoyed dofi's stream so much I made random pitch an easter egg
 			}
+			audio_command cmd = {};
+			cmd.type = audio_command_type::pitch;
+			cmd.voice = voice.mss_id - 1;
+			cmd.pitch = pitch;
+			queue_audio_command(cmd);
 		}
 	}
 }
@@ -731,54 +1090,48 @@ extern "C" SoundMilesID play_sample(
 	if (g_tick_samples.count(tick_sample_key) > 0) {
 		return 0; // don't play the same sample multiple times on the same tick
 	}
-	try {
-		g_tick_samples.emplace(tick_sample_key);
-		for (auto & source : g_sources) {
-			if (source.emit_id == 0) {
-				source.gain(volume);
-				source.pan(pan);
-				source.repeat(repeats == -1);
-				if (g_bb_king_mode) {
-					// ben enjoyed dofi's stream so much I made random pitch an easter egg
-                    if (SOUND_RANDOM(10000) <= 3) { // ~0.03% of the time
-						source.flags |= bb_king_mode;
-						source.pitch((NORMAL_PITCH / 2) + SOUND_RANDOM(NORMAL_PITCH));
-					} else {
-						source.flags &= ~bb_king_mode;
-						source.pitch(pitch);
-					}
+	g_tick_samples.emplace(tick_sample_key);
+	for (auto & voice : g_voices) {
+		if (voice.emit_id == 0) {
+			audio_command cmd = {};
+			cmd.type = audio_command_type::play;
+			cmd.voice = voice.mss_id - 1;
+			cmd.generation = ++voice.generation;
+			cmd.smptbl_id = smptbl_id;
+			cmd.bank_id = bank_id;
+			cmd.volume = volume;
+			cmd.pan = pan;
+			cmd.repeat = (repeats == -1);
+			cmd.pitch = pitch;
+			if (g_bb_king_mode) {
+				// ben enjoyed dofi's stream so much I made random pitch an easter egg
+				if (SOUND_RANDOM(10000) <= 3) { // ~0.03% of the time
+					voice.flags |= bb_king_mode;
+					cmd.pitch = (NORMAL_PITCH / 2) + SOUND_RANDOM(NORMAL_PITCH);
 				} else {
-					source.pitch(pitch);
+					voice.flags &= ~bb_king_mode;
 				}
-				source.play(g_banks[bank_id][smptbl_id].buffer);
-				source.emit_id = emit_id;
-				source.smptbl_id = smptbl_id;
-				source.bank_id = bank_id;
-				return source.mss_id;
 			}
+			// The sample is loaded and started by the audio thread; a failure there just finishes the voice
+			queue_audio_command(cmd);
+			voice.emit_id = emit_id;
+			voice.smptbl_id = smptbl_id;
+			voice.bank_id = bank_id;
+			return voice.mss_id;
 		}
-        if (game.frame_skip < 2)
-        {
-            ERRORLOG("Can't play sample %d from bank %u, too many samples playing at once", smptbl_id, bank_id);
-        }
-		return 0;
-	} catch (const std::exception & e) {
-		ERRORLOG("%s", e.what());
+	}
+	if (game.frame_skip < 2)
+	{
+		ERRORLOG("Can't play sample %d from bank %u, too many samples playing at once", smptbl_id, bank_id);
 	}
 	return 0;
 }
 
 extern "C" void stop_sample(SoundEmitterID emit_id, SoundSmplTblID smptbl_id, SoundBankID bank_id) {
-	for (auto & source : g_sources) {
-		if (emit_id == source.emit_id && smptbl_id == source.smptbl_id && bank_id == source.bank_id) {
-			try {
-				source.stop();
-				source.emit_id = 0;
-				source.smptbl_id = 0;
-				source.bank_id = 0;
-			} catch (const std::exception & e) {
-				ERRORLOG("%s", e.what());
-			}
+	for (auto & voice : g_voices) {
+		if (emit_id == voice.emit_id && smptbl_id == voice.smptbl_id && bank_id == voice.bank_id) {
+			queue_voice_command(audio_command_type::stop, voice);
+			clear_voice(voice);
 		}
 	}
 }
@@ -789,7 +1142,7 @@ extern "C" SoundSFXID get_sample_sfxid(SoundSmplTblID smptbl_id, SoundBankID ban
 	} else if (smptbl_id < 0 || smptbl_id >= g_banks[bank_id].size()) {
 		return 0;
 	}
-	return g_banks[bank_id][smptbl_id].sfx_id;
+	return g_banks[bank_id].samples[smptbl_id].sfx_id;
 }
 
 extern "C" int InitialiseSDLAudio()
@@ -48,6 +48,16 @@ static long MaxNoSounds;
 static struct S3DSample SampleList[SOUNDS_MAX_COUNT];
 static S3D_LineOfSight_Func LineOfSightFunction;
 static long deadzone_radius;
+/** Set when anything which affects all emitters changed, so their parameters have to be recomputed. */
+static TbBool receiver_changed;
+
+/** Parameters last applied to samples of each emitter. */
+struct EmitterParams {
+    int32_t pan;
+    int32_t volume;
+    int32_t pitch;
+};
+static struct EmitterParams emitter_params[SOUND_EMITTERS_MAX];
 
 TbBool SoundDisabled;
 int atmos_sound_volume = 128;
@@ -174,12 +184,16 @@ long S3DSetMaximumSoundDistance(long nDistance)
         nDistance = 65536;
     if (nDistance < 1)
         nDistance = 1;
+    if (MaxSoundDistance != nDistance)
+        receiver_changed = true;
     MaxSoundDistance = nDistance;
     return 1;
 }
 
 long S3DSetSoundReceiverPosition(int pos_x, int pos_y, int pos_z)
 {
+    if ((Receiver.pos.val_x != (unsigned long)pos_x) || (Receiver.pos.val_y != (unsigned long)pos_y) || (Receiver.pos.val_z != (unsigned long)pos_z))
+        receiver_changed = true;
     Receiver.pos.val_x = pos_x;
     Receiver.pos.val_y = pos_y;
     Receiver.pos.val_z = pos_z;
@@ -188,6 +202,9 @@ long S3DSetSoundReceiverPosition(int pos_x, int pos_y, int pos_z)
 
 long S3DSetSoundReceiverOrientation(int ori_a, int ori_b, int ori_c)
 {
+    if ((Receiver.rotation_angle_x != (ori_a & ANGLE_MASK)) || (Receiver.rotation_angle_y != (ori_b & ANGLE_MASK))
+      || (Receiver.rotation_angle_z != (ori_c & ANGLE_MASK)))
+        receiver_changed = true;
     Receiver.rotation_angle_x = ori_a & ANGLE_MASK;
     Receiver.rotation_angle_y = ori_b & ANGLE_MASK;
     Receiver.rotation_angle_z = ori_c & ANGLE_MASK;
@@ -196,6 +213,8 @@ long S3DSetSoundReceiverOrientation(int ori_a, int ori_b, int ori_c)
 
 void S3DSetSoundReceiverSensitivity(unsigned short nsensivity)
 {
+    if (Receiver.sensivity != nsensivity)
+        receiver_changed = true;
     Receiver.sensivity = nsensivity;
 }
 
@@ -255,6 +274,8 @@ TbBool S3DMoveSoundEmitterTo(SoundEmitterID eidx, long x, long y, long z)
     if (!S3DEmitterIsAllocated(eidx))
         return false;
     struct SoundEmitter* emit = S3DGetSoundEmitter(eidx);
+    if ((emit->pos.val_x != (unsigned long)x) || (emit->pos.val_y != (unsigned long)y) || (emit->pos.val_z != (unsigned long)z))
+        emit->flags |= Emi_NeedsUpdate;
     emit->pos.val_x = x;
     emit->pos.val_y = y;
     emit->pos.val_z = z;
@@ -305,10 +326,13 @@ TbBool S3DEmitterIsPlayingAnySample(SoundEmitterID eidx)
 void S3DSetLineOfSightFunction(S3D_LineOfSight_Func callback)
 {
     LineOfSightFunction = callback;
+    receiver_changed = true;
 }
 
 void S3DSetDeadzoneRadius(long dzradius)
 {
+    if (deadzone_radius != dzradius)
+        receiver_changed = true;
     deadzone_radius = dzradius;
 }
 
@@ -488,30 +512,56 @@ long set_emitter_pan_volume_pitch(struct SoundEmitter *emit, long pan, long volu
     return 1;
 }
 
+/**
+ * Updates pan, volume and pitch of the samples being played by emitters.
+ * Only emitters owning a sample are visited, and their parameters are recomputed
+ * only if the emitter or the receiver moved since last time; emitters out of hearing
+ * range get their samples kicked out by process_sound_samples() instead.
+ */
 TbBool process_sound_emitters(void)
 {
-    struct SoundEmitter *emit;
+    unsigned char has_samples[SOUND_EMITTERS_MAX];
     int32_t pan;
     int32_t volume;
     int32_t pitch;
     long i;
+    memset(has_samples, 0, sizeof(has_samples));
+    for (i = 0; i < MaxNoSounds; i++)
+    {
+        struct S3DSample* sample = &SampleList[i];
+        if ((sample->is_playing == 0) || (sample->emit_ptr == NULL))
+            continue;
+        long eidx = sample->emit_ptr->index;
+        if ((eidx <= 0) || (eidx >= NoSoundEmitters) || has_samples[eidx])
+            continue;
+        has_samples[eidx] = 1;
+        struct SoundEmitter* emit = sample->emit_ptr;
+        if ((emit->flags & (Emi_IsAllocated|Emi_IsPlaying)) != (Emi_IsAllocated|Emi_IsPlaying))
+            continue;
+        if (eidx == Non3DEmitter || eidx == SpeechEmitter)
+            continue; // don't touch
+        if (!receiver_changed && ((emit->flags & Emi_NeedsUpdate) == 0))
+            continue;
+        get_emitter_pan_volume_pitch(&Receiver, emit, &pan, &volume, &pitch);
+        struct EmitterParams* params = &emitter_params[eidx];
+        if ((params->pan == pan) && (params->volume == volume) && (params->pitch == pitch)) {
+            // Settled; doppler pitch may need a few turns to get there after the emitter stops
+            emit->flags &= ~Emi_NeedsUpdate;
+            continue;
+        }
+        params->pan = pan;
+        params->volume = volume;
+        params->pitch = pitch;
+        emit->flags |= Emi_NeedsUpdate;
+        set_emitter_pan_volume_pitch(emit, pan, volume, pitch);
+    }
+    receiver_changed = false;
     for (i = 0; i < NoSoundEmitters; i++)
     {
-        emit = S3DGetSoundEmitter(i);
-        if ( ((emit->flags & Emi_IsAllocated) != 0) && ((emit->flags & Emi_IsPlaying) != 0) )
+        struct SoundEmitter* emit = &emitter[i];
+        if (((emit->flags & Emi_IsPlaying) != 0) && !has_samples[i])
         {
-            if ( emitter_is_playing(emit) )
-            {
-                if (i == Non3DEmitter || i == SpeechEmitter) {
-                    continue; // don't touch
-                } else {
-                    get_emitter_pan_volume_pitch(&Receiver, emit, &pan, &volume, &pitch);
-                    set_emitter_pan_volume_pitch(emit, pan, volume, pitch);
-                }
-            } else
-            {
-                emit->flags ^= Emi_IsPlaying;
-            }
+            emit->flags &= ~Emi_IsPlaying;
         }
     }
     return true;
@@ -564,37 +614,43 @@ long stop_emitter_samples(struct SoundEmitter *emit)
     return num_stopped;
 }
 
+/**
+ * Finds a sample slot for a new sample of given emitter.
+ * Reuses the slot if the emitter already plays the same sample (for ctype 2 and 3),
+ * otherwise takes a free slot. If all slots are busy, steals the voice with lowest priority;
+ * among equal priorities the quietest, then the one playing for longest, is stolen.
+ * @return Sample slot index, or -1 if no voice has priority lower than spcmax.
+ */
 short find_slot(long fild8, SoundBankID bank_id, struct SoundEmitter *emit, long ctype, long spcmax)
 {
-    struct S3DSample *sample;
-    long i;
-    int32_t spcval = INT32_MAX;
-    short min_sample_id = SOUNDS_MAX_COUNT;
-    if ((ctype == 2) || (ctype == 3))
+    TbBool same_sample_allowed = ((ctype == 2) || (ctype == 3));
+    short free_sample_id = -1;
+    short min_sample_id = -1;
+    struct S3DSample* victim = NULL;
+    for (long i = 0; i < MaxNoSounds; i++)
     {
-        for (i=0; i < MaxNoSounds; i++)
+        struct S3DSample* sample = &SampleList[i];
+        if (sample->is_playing == 0)
         {
-            sample = &SampleList[i];
-            if ( (sample->is_playing) && (sample->emit_ptr != NULL) )
-            {
-                if ( (sample->emit_ptr->index == emit->index)
-                  && (sample->smptbl_id == fild8) && (sample->bank_id == bank_id) )
-                    return i;
-            }
+            if (free_sample_id < 0)
+                free_sample_id = i;
+            continue;
         }
-    }
-    for (i=0; i < MaxNoSounds; i++)
-    {
-        sample = &SampleList[i];
-        if (sample->is_playing == 0)
+        if (same_sample_allowed && (sample->emit_ptr != NULL) && (sample->emit_ptr->index == emit->index)
+          && (sample->smptbl_id == fild8) && (sample->bank_id == bank_id))
             return i;
-        if (spcval > (int32_t) sample->priority)
+        if ((victim == NULL) || ((int32_t)sample->priority < (int32_t)victim->priority)
+          || (((int32_t)sample->priority == (int32_t)victim->priority)
+            && ((sample->volume < victim->volume)
+              || ((sample->volume == victim->volume) && (sample->time_turn > victim->time_turn)))))
         {
+            victim = sample;
             min_sample_id = i;
-            spcval = sample->priority;
         }
     }
-    if (spcval >= spcmax)
+    if (free_sample_id >= 0)
+        return free_sample_id;
+    if ((victim == NULL) || ((int32_t)victim->priority >= spcmax))
     {
         return -1;
     }
@@ -702,8 +758,9 @@ SoundEmitterID allocate_free_sound_emitter(void)
         if (!S3DEmitterIsAllocated(i))
         {
             struct SoundEmitter* emit = S3DGetSoundEmitter(i);
-            emit->flags = Emi_IsAllocated;
+            emit->flags = Emi_IsAllocated|Emi_NeedsUpdate;
             emit->index = i;
+            emitter_params[i].volume = -1;
             return i;
         }
     }
@@ -866,6 +923,10 @@ long start_emitter_playing(struct SoundEmitter *emit, SoundSmplTblID smptbl_id,
     int32_t volume;
     int32_t pitch;
     get_emitter_pan_volume_pitch(&Receiver, emit, &pan, &volume, &pitch);
+    struct EmitterParams* params = &emitter_params[emit->index];
+    params->pan = pan;
+    params->volume = volume;
+    params->pitch = pitch;
     long smpl_idx = find_slot(smptbl_id, bank_id, emit, ctype, priority);
     volume = (volume * loudness) / 256;
     if (smpl_idx < 0)
@@ -55,6 +55,7 @@ enum SoundEmitterFlags {
     Emi_IsAllocated  = 0x01,
     Emi_IsPlaying    = 0x02,
     Emi_IsMoving     = 0x04,
+    Emi_NeedsUpdate  = 0x08, /**< Pan, volume and pitch have to be recomputed. */
 };
 
 enum SoundSampleFlags {
@@ -39,11 +39,12 @@ extern "C" {
 #endif
 /******************************************************************************/
 static TbBool load_effects_config_file(const char *fname, unsigned short flags);
+static void set_effects_defaults();
 
 const struct ConfigFileData keeper_effects_file_data = {
     .filename = "effects.toml",
     .load_func = load_effects_config_file,
-    .pre_load_func = NULL,
+    .pre_load_func = set_effects_defaults,
     .post_load_func = NULL,
 };
 
@@ -101,6 +102,29 @@ struct NamedCommand effectgen_desc[EFFECTSGEN_TYPES_MAX];
 struct NamedCommand effectelem_desc[EFFECTSELLEMENTS_TYPES_MAX];
 /******************************************************************************/
 
+static void set_effects_defaults()
+{
+    game.conf.effects_conf.elements_budget = EFFECT_ELEMENTS_BUDGET_DEFAULT;
+    game.conf.effects_conf.elements_lod_distance = EFFECT_ELEMENTS_LOD_DISTANCE_DEFAULT;
+}
+
+static void load_effects_common(VALUE *value, unsigned short flags)
+{
+    VALUE *section = value_dict_get(value, "common");
+    if (value_type(section) != VALUE_DICT)
+        return;
+    struct EffectsConfig *effects_conf = &game.conf.effects_conf;
+    CONDITIONAL_ASSIGN_INT(section,"ElementsBudget",effects_conf->elements_budget);
+    CONDITIONAL_ASSIGN_INT_SCALED(section,"ElementsLodDistance",effects_conf->elements_lod_distance, COORD_PER_STL);
+    if ((effects_conf->elements_budget <= 0) || (effects_conf->elements_budget > UNSYNCED_THINGS_COUNT))
+    {
+        WARNLOG("ElementsBudget must be from 1 to %d, got %d", UNSYNCED_THINGS_COUNT, (int)effects_conf->elements_budget);
+        effects_conf->elements_budget = UNSYNCED_THINGS_COUNT;
+    }
+    if (effects_conf->elements_lod_distance < 0)
+        effects_conf->elements_lod_distance = 0;
+}
+
 static void load_effects(VALUE *value, unsigned short flags)
 {
     char key[64] = "";
@@ -235,6 +259,7 @@ static TbBool load_effects_config_file(const char *fname, unsigned short flags)
     VALUE file_root;
     if (!load_toml_file(fname,&file_root,flags))
         return false;
+    load_effects_common(&file_root,flags);
     load_effects(&file_root,flags);
     load_effectsgenerators(&file_root,flags);
     load_effectelements(&file_root,flags);
@@ -33,6 +33,9 @@ extern "C" {
 #define EFFECTS_TYPES_MAX 2048
 #define EFFECTSGEN_TYPES_MAX 2048
 #define EFFECTSELLEMENTS_TYPES_MAX 2048
+/** Default amount of effect elements existing at once; leaves a quarter of unsynced things for effects and sounds. */
+#define EFFECT_ELEMENTS_BUDGET_DEFAULT 3072
+#define EFFECT_ELEMENTS_LOD_DISTANCE_DEFAULT (12*COORD_PER_STL)
 
 /******************************************************************************/
 
@@ -126,6 +129,10 @@ struct EffectsConfig {
     int32_t effectgen_cfgstats_count;
     struct EffectGeneratorConfigStats effectgen_cfgstats[EFFECTSGEN_TYPES_MAX];
     struct EffectElementConfigStats effectelement_cfgstats[EFFECTSELLEMENTS_TYPES_MAX];
+    /** Amount of effect elements which may exist at once; the oldest element is replaced by a new one above it. */
+    int32_t elements_budget;
+    /** When close to the budget, elements are only created this near to a player camera. */
+    int32_t elements_lod_distance;
 };
 /******************************************************************************/
 extern const struct ConfigFileData keeper_effects_file_data;
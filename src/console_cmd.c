@@ -22,6 +22,7 @@
 #include "globals.h"
 
 #include "actionpt.h"
+#include "ariadne.h"
 #include "bflib_datetm.h"
 #include "bflib_sound.h"
 #include "bflib_sndlib.h"
@@ -52,6 +53,7 @@
 #include "map_blocks.h"
 #include "map_columns.h"
 #include "map_utils.h"
+#include "net_checksums.h"
 #include "packets.h"
 #include "player_computer.h"
 #include "player_instances.h"
@@ -61,6 +63,7 @@
 #include "room_treasure.h"
 #include "room_util.h"
 #include "slab_data.h"
+#include "thing_effects.h"
 #include "thing_factory.h"
 #include "thing_list.h"
 #include "thing_objects.h"
@@ -345,6 +348,14 @@ TbBool cmd_network_stats(PlayerNumber plyr_idx, char * args)
     return true;
 }
 
+TbBool cmd_navigation_stats(PlayerNumber plyr_idx, char * args)
+{
+    const struct NavigationUpdateStats *stats = get_navigation_update_stats();
+    targeted_message_add(MsgType_Player, plyr_idx, plyr_idx, GUI_MESSAGES_DELAY, "navigation turn %lu: %lu changes, %lu areas, %lu subtiles",
+        (unsigned long)stats->turn, stats->changes_count, stats->areas_count, stats->subtiles_count);
+    return true;
+}
+
 TbBool cmd_quit(PlayerNumber plyr_idx, char * args)
 {
     quit_game = 1;
@@ -417,10 +428,9 @@ TbBool cmd_game_save(PlayerNumber plyr_idx, char * args)
         fill_game_catalogue_slot(slot_num, pr3str);
     }
     set_flag(game.operation_flags, GOF_Paused); // games are saved in a paused state
+    // The player is told once the save is written
     TbBool result = save_game(slot_num);
-    if (result) {
-        output_message(SMsg_GameSaved, 0);
-    } else {
+    if (!result) {
         ERRORLOG("Error in save!");
         create_error_box(GUIStr_ErrorSaving);
     }
@@ -452,6 +462,20 @@ TbBool cmd_game_load(PlayerNumber plyr_idx, char * args)
     return false;
 }
 
+TbBool cmd_replay_seek(PlayerNumber plyr_idx, char * args)
+{
+    char * pr2str = strsep(&args, " ");
+    if (pr2str == NULL) {
+        return false;
+    }
+    GameTurn turn = atol(pr2str);
+    if (!seek_packet_file(turn)) {
+        targeted_message_add(MsgType_Player, plyr_idx, plyr_idx, GUI_MESSAGES_DELAY, "Unable to seek replay to turn %lu", (unsigned long)turn);
+        return false;
+    }
+    return true;
+}
+
 TbBool cmd_cls(PlayerNumber plyr_idx, char * args)
 {
     zero_messages();
@@ -1169,6 +1193,107 @@ TbBool cmd_place_slab(PlayerNumber plyr_idx, char * args)
     return true;
 }
 
+/**
+ * Times column lookups: rebuilds the columns index as after loading a level, then places
+ * every slab of the map again, which finds or creates each of its columns.
+ */
+TbBool cmd_columns_bench(PlayerNumber plyr_idx, char * args)
+{
+    if (game.easter_eggs_enabled == false) {
+        targeted_message_add(MsgType_Player, plyr_idx, plyr_idx, GUI_MESSAGES_DELAY, "require 'cheat mode'");
+        return false;
+    }
+    struct Column col;
+    memset(&col, 0, sizeof(struct Column));
+    long double start = get_time_tick_ns();
+    invalidate_columns_index();
+    find_column(&col);
+    long double index_ms = (get_time_tick_ns() - start) / 1000000.0;
+    start = get_time_tick_ns();
+    for (MapSlabCoord slb_y = 0; slb_y < game.map_tiles_y; slb_y++)
+    {
+        for (MapSlabCoord slb_x = 0; slb_x < game.map_tiles_x; slb_x++)
+        {
+            struct SlabMap *slb = get_slabmap_block(slb_x, slb_y);
+            place_single_slab_type_on_map(slb->kind, slb_x, slb_y, slabmap_owner(slb));
+        }
+    }
+    long double place_ms = (get_time_tick_ns() - start) / 1000000.0;
+    update_blocks_in_area(0, 0, game.map_subtiles_x, game.map_subtiles_y);
+    int used = 0;
+    for (int i = 1; i < COLUMNS_COUNT; i++)
+    {
+        struct Column *colmn = get_column(i);
+        if ((colmn->use > 0) || ((colmn->bitfields & CLF_ACTIVE) != 0))
+            used++;
+    }
+    JUSTMSG("Columns bench on %dx%d map: index rebuilt in %.2f ms, all slabs placed in %.2f ms, %d columns used",
+        (int)game.map_tiles_x, (int)game.map_tiles_y, (double)index_ms, (double)place_ms, used);
+    targeted_message_add(MsgType_Player, plyr_idx, plyr_idx, GUI_MESSAGES_DELAY, "index %.2f ms, placing %.2f ms, %d columns",
+        (double)index_ms, (double)place_ms, used);
+    return true;
+}
+
+/**
+ * Times sweeping thing lists: fills the map with effect elements first, then computes
+ * checksums of all lists by following their links and by the dense index.
+ */
+TbBool cmd_things_bench(PlayerNumber plyr_idx, char * args)
+{
+    if (game.easter_eggs_enabled == false) {
+        targeted_message_add(MsgType_Player, plyr_idx, plyr_idx, GUI_MESSAGES_DELAY, "require 'cheat mode'");
+        return false;
+    }
+    char * pr2str = strsep(&args, " ");
+    long count = (pr2str != NULL) ? atoi(pr2str) : 5000;
+    const int repeats = 100;
+    struct StructureList *list = &game.thing_lists[TngList_EffectElems];
+    struct Coord3d pos = {0};
+    while ((long)list->count < count)
+    {
+        pos.x.val = subtile_coord_center(UNSYNC_RANDOM(game.map_subtiles_x));
+        pos.y.val = subtile_coord_center(UNSYNC_RANDOM(game.map_subtiles_y));
+        pos.z.val = get_floor_height_at(&pos) + COORD_PER_STL;
+        if (thing_is_invalid(create_effect_element(&pos, TngEffElm_Cloud1, plyr_idx)))
+            break;
+    }
+    TbBigChecksum linked_sum = 0;
+    long double start = get_time_tick_ns();
+    for (int n = 0; n < repeats; n++)
+    {
+        for (int list_id = 0; list_id < TngList_StaticLights; list_id++)
+        {
+            unsigned long k = 0;
+            ThingIndex i = game.thing_lists[list_id].index;
+            while ((i != 0) && (k <= THINGS_COUNT))
+            {
+                struct Thing *thing = thing_get(i);
+                i = thing->next_of_class;
+                linked_sum += get_thing_checksum(thing);
+                k++;
+            }
+        }
+    }
+    long double linked_ms = (get_time_tick_ns() - start) / 1000000.0 / repeats;
+    TbBigChecksum index_sum = 0;
+    start = get_time_tick_ns();
+    for (int n = 0; n < repeats; n++)
+    {
+        for (int list_id = 0; list_id < TngList_StaticLights; list_id++)
+        {
+            struct ThingListSweep sweep;
+            for (struct Thing *thing = thing_list_sweep_first(&sweep, &game.thing_lists[list_id]); thing != NULL; thing = thing_list_sweep_next(&sweep))
+                index_sum += get_thing_checksum(thing);
+        }
+    }
+    long double index_ms = (get_time_tick_ns() - start) / 1000000.0 / repeats;
+    JUSTMSG("Things bench with %lu effect elements: links %.3f ms, index %.3f ms per sweep of all lists%s",
+        list->count, (double)linked_ms, (double)index_ms, (linked_sum == index_sum) ? "" : ", CHECKSUMS DIFFER");
+    targeted_message_add(MsgType_Player, plyr_idx, plyr_idx, GUI_MESSAGES_DELAY, "%lu elems: links %.3f ms, index %.3f ms",
+        list->count, (double)linked_ms, (double)index_ms);
+    return true;
+}
+
 TbBool cmd_room_available(PlayerNumber plyr_idx, char * args)
 {
     if (game.easter_eggs_enabled == false) {
@@ -2202,6 +2327,7 @@ static const struct ConsoleCommand console_commands[] = {
     { "frametime.max", cmd_frametime_max },
     { "ft.max", cmd_frametime_max },
     { "netstats", cmd_network_stats },
+    { "navstats", cmd_navigation_stats },
     { "quit", cmd_quit },
     { "time", cmd_time },
     { "timer.toggle", cmd_timer_toggle },
@@ -2211,6 +2337,7 @@ static const struct ConsoleCommand console_commands[] = {
     { "step", cmd_step },
     { "game.save", cmd_game_save },
     { "game.load", cmd_game_load },
+    { "replay.seek", cmd_replay_seek },
     { "cls", cmd_cls },
     { "ver", cmd_ver },
     { "volume", cmd_volume },
@@ -2246,6 +2373,8 @@ static const struct ConsoleCommand console_commands[] = {
     { "create.thing", cmd_create_thing },
     { "slab.place", cmd_place_slab },
     { "place.slab", cmd_place_slab },
+    { "columns.bench", cmd_columns_bench },
+    { "things.bench", cmd_things_bench },
     { "room.available", cmd_room_available },
     { "power.give", cmd_give_power },
     { "spell.give", cmd_give_power },
@@ -2678,16 +2678,18 @@ TbBool find_random_valid_position_for_thing_in_room_avoiding_object(struct Thing
     }
     struct RoomConfigStats* roomst = get_room_kind_stats(room->kind);
     long selected = THING_RANDOM(thing, room->slabs_count);
-    unsigned long n = 0;
-    long i = room->slabs_list;
-    // Get the selected index
-    while (i != 0)
+    unsigned long slabs_count;
+    const SlabCodedCoords* slabs = get_room_slabs(room, &slabs_count);
+    unsigned long n;
+    long i;
+    struct PlayerInfo *player = get_player(room->owner);
+    if (player->roomspace.is_active)
     {
-        struct PlayerInfo *player = get_player(room->owner);
-        if (player->roomspace.is_active)
+        // Make sure the room wasn't merged with a neighbour one while building it
+        for (n = 0; (n <= selected) && (n < slabs_count); n++)
         {
-            MapSlabCoord slb_x = slb_num_decode_x(i);
-            MapSlabCoord slb_y = slb_num_decode_y(i);
+            MapSlabCoord slb_x = slb_num_decode_x(slabs[n]);
+            MapSlabCoord slb_y = slb_num_decode_y(slabs[n]);
             for (long j = 0; j < SMALL_AROUND_LENGTH; j++)
             {
                 MapSlabCoord aslb_x = slb_x + small_around[j].delta_x;
@@ -2706,31 +2708,21 @@ TbBool find_random_valid_position_for_thing_in_room_avoiding_object(struct Thing
                 }
             }
         }
-        // Per room tile code
-        if (n >= selected)
-        {
-            break;
-        }
-        // Per room tile code ends
-        i = get_next_slab_number_in_room(i);
-        n++;
     }
-    if (i == 0)
+    n = selected;
+    if (n >= slabs_count)
     {
-        if (n < room->slabs_count)
-        {
-            WARNLOG("Number of slabs in %s (%lu) is smaller than count (%u)",room_code_name(room->kind), n, room->slabs_count);
-        }
+        WARNLOG("Number of slabs in %s (%lu) is smaller than count (%u)",room_code_name(room->kind), slabs_count, room->slabs_count);
         n = 0;
-        i = room->slabs_list;
     }
     // Sweep rooms starting on that index
     unsigned long k = 0;
     long nround;
     MapSubtlCoord stl_x;
     MapSubtlCoord stl_y;
-    while (i != 0)
+    while (n < slabs_count)
     {
+        i = slabs[n];
         stl_x = slab_subtile(slb_num_decode_x(i), 0);
         stl_y = slab_subtile(slb_num_decode_y(i), 0);
         // Per room tile code
@@ -2758,10 +2750,8 @@ TbBool find_random_valid_position_for_thing_in_room_avoiding_object(struct Thing
         if (n+1 >= room->slabs_count)
         {
             n = 0;
-            i = room->slabs_list;
         } else {
             n++;
-            i = get_next_slab_number_in_room(i);
         }
         k++;
         if (k > room->slabs_count) {
@@ -96,7 +96,7 @@ void person_eat_food(struct Thing *creatng, struct Thing *foodtng, struct Room *
         int required_cap = get_required_room_capacity_for_object(RoRoF_FoodStorage, foodtng->model, 0);
         if (room->used_capacity >= required_cap)
         {
-            room->used_capacity -= required_cap;
+            change_room_used_capacity(room, -required_cap);
             delete_thing_structure(foodtng, 0);
         } else
         {
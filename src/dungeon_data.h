@@ -300,6 +300,9 @@ struct Dungeon {
     unsigned char         room_buildable[TERRAIN_ITEMS_MAX];
     unsigned char         room_resrchable[TERRAIN_ITEMS_MAX];
     unsigned char         room_discrete_count[TERRAIN_ITEMS_MAX+1];
+    /** Sums of total and used capacity of all rooms of given kind owned by the player; kept updated by room capacity setters. */
+    int32_t               room_kind_total_capacity[TERRAIN_ITEMS_MAX];
+    int32_t               room_kind_used_capacity[TERRAIN_ITEMS_MAX];
     ThingIndex            backup_heart_idx;
     ThingIndex            free_soul_idx;
     struct HandRule       hand_rules[CREATURE_TYPES_MAX][HAND_RULE_SLOTS_COUNT];
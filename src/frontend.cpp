@@ -103,6 +103,7 @@ long double get_time_tick_ns();
 TbClockMSec gui_message_timeout = 0;
 char gui_message_text[TEXT_BUFFER_LENGTH];
 static char path_string[178];
+static long frontend_background_size = 0;
 MenuID vid_change_query_menu = GMnu_CREATURE_QUERY1;
 TbBool right_click_tag_mode_toggle = false;
 unsigned char default_tag_mode = 1;
@@ -951,19 +952,29 @@ TbResult frontend_load_data(void)
     // TODO: There is no "frontend_unload_data", find a better spot for this
     free_spritesheet(&frontend_sprite);
     ret = Lb_SUCCESS;
-    frontend_background = (unsigned char *)game.map;
 #ifdef SPRITE_FORMAT_V2
     fname = prepare_file_fmtpath(FGrp_LoData,"front-%d.raw",64);
 #else
     fname = prepare_file_path(FGrp_LoData,"front.raw");
 #endif
+    // The background used to be loaded over map blocks; now it has a buffer of its own
+    len = LbFileLength(fname);
+    if (len < 640*480)
+        len = 640*480;
+    if (len > frontend_background_size)
+    {
+        KfxFree(frontend_background);
+        frontend_background = (unsigned char *)KfxCalloc(len, 1);
+        frontend_background_size = (frontend_background != NULL) ? len : 0;
+    }
+    if (frontend_background == NULL) {
+        ERRORLOG("Cannot allocate frontend background.");
+        return Lb_FAIL;
+    }
     len = LbFileLoadAt(fname, frontend_background);
     if (len < 307200) {
         ret = Lb_FAIL;
     }
-    if (len > sizeof(game.map)) {
-        WARNLOG("Reused memory area exceeded for frontend background.");
-    }
     char dat_fname[2048];
     char tab_fname[2048];
 #ifdef SPRITE_FORMAT_V2
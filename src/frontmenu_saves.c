@@ -125,10 +125,8 @@ void gui_save_game(struct GuiButton *gbtn)
     {
         long slot_num = (gbtn->btype_value & LbBFeF_IntValueMask) % TOTAL_SAVE_SLOTS_COUNT;
         fill_game_catalogue_slot(slot_num, gbtn->content.str);
-        if (save_game(slot_num))
-        {
-            output_message(SMsg_GameSaved, 0);
-        } else
+        // The player is told once the save is written
+        if (!save_game(slot_num))
       {
           ERRORLOG("Error in save!");
           create_error_box(GUIStr_ErrorSaving);
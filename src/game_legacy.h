@@ -214,14 +214,12 @@ struct Game {
     struct LightsShadows lish;
     struct CreatureControl cctrl_data[CREATURES_COUNT];
     struct Thing things_data[THINGS_COUNT];
-    NavColour navigation_map[MAX_SUBTILES_X*MAX_SUBTILES_Y];
-    struct Map map[MAX_SUBTILES_X*MAX_SUBTILES_Y];
     struct ComputerTask computer_task[COMPUTER_TASKS_COUNT];
     struct Computer2 computer[PLAYERS_COUNT];
     struct SlabMap slabmap[MAX_TILES_X*MAX_TILES_Y];
     struct Room rooms[ROOMS_COUNT];
     struct Dungeon dungeon[DUNGEONS_COUNT];
-    struct StructureList thing_lists[13];
+    struct StructureList thing_lists[THING_LISTS_COUNT];
     ColumnIndex unrevealed_column_idx;
     unsigned char packet_save_enable;
     unsigned char packet_load_enable;
@@ -46,9 +46,16 @@
 #include "keeperfx.hpp"
 #include "api.h"
 #include "lvl_filesdk1.h"
+#include "map_data.h"
 #include "lua_base.h"
 #include "lua_triggers.h"
 #include "moonphase.h"
+#include "config_strings.h"
+
+#include <SDL2/SDL.h>
+#ifdef KEEPERFX_ZLIB_AVAILABLE
+#include <zlib.h>
+#endif
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -71,6 +78,59 @@ struct CatalogueEntry save_game_catalogue[TOTAL_SAVE_SLOTS_COUNT];
 
 int number_of_saved_games;
 /******************************************************************************/
+/** A chunk with its header, ready to be written. */
+struct SaveBlob {
+    unsigned char *data;
+    unsigned long len;
+    unsigned long size;
+};
+
+/**
+ * One save to be written by the save writer thread.
+ * All buffers are allocated by the game thread before the job is queued,
+ * so the writer only compresses and writes; they're freed once the job is finished.
+ */
+struct SaveJob {
+    long slot_num;
+    char fname[2048];
+    struct CatalogueEntry centry;
+    struct Game *snapshot;
+    struct IntralevelData intralvl;
+    char *lua_data;
+    unsigned long lua_len;
+    /** Copy of the map blocks in use; stored whole in every save, as they're not a part of the Game struct. */
+    struct Map *map_data;
+    unsigned long map_len;
+    struct SaveBlob game_blob;
+    struct SaveBlob map_blob;
+    struct SaveBlob intralvl_blob;
+    struct SaveBlob lua_blob;
+    TbBool result;
+    const char *error;
+};
+
+/**
+ * Writer thread for savegames and other files which are too big to be written while the game waits.
+ * It does one job at a time; the job data is prepared by the game thread, and not touched by it
+ * until the job is completed.
+ */
+struct SaveWriter {
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+    TbBool busy;
+    TbBool finished;
+    TbBool quit;
+    BackgroundWriteFunc run;
+    BackgroundWriteDoneFunc done;
+    void *data;
+    TbBool result;
+    /** Data of the savegame jobs. */
+    struct SaveJob job;
+};
+
+static struct SaveWriter save_writer;
+/******************************************************************************/
 TbBool is_primitive_save_version(long filesize)
 {
     if (filesize < (char *)&game.loaded_level_number - (char *)&game)
@@ -102,6 +162,14 @@ TbBool save_game_chunks(TbFileHandle fhandle, struct CatalogueEntry *centry)
         if (LbFileWrite(fhandle, &game, sizeof(struct Game)) == sizeof(struct Game))
             chunks_done |= SGF_GameOrig;
     }
+    { // Map blocks chunk
+        hdr.id = SGC_MapData;
+        hdr.ver = 0;
+        hdr.len = map_blocks_data_size();
+        if (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+        if (LbFileWrite(fhandle, map_blocks, hdr.len) == hdr.len)
+            chunks_done |= SGF_MapData;
+    }
     { // IntralevelData data chunk
         hdr.id = SGC_IntralevelData;
         hdr.ver = 0;
@@ -161,10 +229,18 @@ TbBool save_packet_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
             if (LbFileWrite(fhandle, &game, sizeof(struct Game)) == sizeof(struct Game))
                 chunks_done |= SGF_GameOrig;
         }
+        { // Map blocks chunk
+            hdr.id = SGC_MapData;
+            hdr.ver = 0;
+            hdr.len = map_blocks_data_size();
+            if (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+            if (LbFileWrite(fhandle, map_blocks, hdr.len) == hdr.len)
+                chunks_done |= SGF_MapData;
+        }
     }
     { // Packet file data start indicator
         hdr.id = SGC_PacketData;
-        hdr.ver = 0;
+        hdr.ver = PACKET_DATA_VER_THING_HASH;
         hdr.len = 0;
         if (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
             chunks_done |= SGF_PacketData;
@@ -174,9 +250,46 @@ TbBool save_packet_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry)
     return true;
 }
 
+static void skip_chunk_data(TbFileHandle fhandle, unsigned long len)
+{
+    if (LbFileSeek(fhandle, len, Lb_FILE_SEEK_CURRENT) < 0)
+        LbFileSeek(fhandle, 0, Lb_FILE_SEEK_END);
+}
+
+/**
+ * Reads zlib stream of given length from the file, and decompresses it into dest.
+ * Succeeds only if it decompresses to exactly raw_len bytes.
+ */
+static TbBool read_compressed_data(TbFileHandle fhandle, unsigned long packed_len, void *dest, unsigned long raw_len)
+{
+#ifdef KEEPERFX_ZLIB_AVAILABLE
+    unsigned char *packed = (unsigned char *)KfxAlloc(packed_len);
+    if (packed == NULL)
+    {
+        skip_chunk_data(fhandle, packed_len);
+        return false;
+    }
+    TbBool done = (LbFileRead(fhandle, packed, packed_len) == packed_len);
+    if (done)
+    {
+        uLongf len = raw_len;
+        done = (uncompress((Bytef *)dest, &len, packed, packed_len) == Z_OK) && (len == raw_len);
+    }
+    KfxFree(packed);
+    return done;
+#else
+    WARNLOG("Compressed saves are not supported on this platform");
+    skip_chunk_data(fhandle, packed_len);
+    return false;
+#endif
+}
+
 int load_game_chunks(TbFileHandle fhandle, struct CatalogueEntry *centry)
 {
     long chunks_done = 0;
+    // Lua data is applied once the level is known; if there's more than one LuaData chunk, the last one is used
+    char* lua_data = NULL;
+    unsigned long lua_data_len = 0;
     while (!LbFileEof(fhandle))
     {
         struct FileChunkHeader hdr;
@@ -190,6 +303,7 @@ int load_game_chunks(TbFileHandle fhandle, struct CatalogueEntry *centry)
                 chunks_done |= SGF_InfoBlock;
                 if (!change_campaign(centry->campaign_fname)) {
                     ERRORLOG("Unable to load campaign");
+                    KfxFree(lua_data);
                     return GLoad_Failed;
                 }
                 free_level_strings_data();
@@ -218,6 +332,20 @@ int load_game_chunks(TbFileHandle fhandle, struct CatalogueEntry *centry)
                 WARNLOG("Could not read GameOrig chunk");
             }
             break;
+        case SGC_MapData:
+            // Size of the map comes from the Game struct, so it has to be loaded first
+            if (((chunks_done & SGF_GameOrig) == 0) || !alloc_map_blocks() || (hdr.len != map_blocks_data_size()))
+            {
+                skip_chunk_data(fhandle, hdr.len);
+                WARNLOG("Incompatible MapData chunk");
+                break;
+            }
+            if (LbFileRead(fhandle, map_blocks, hdr.len) == hdr.len) {
+                chunks_done |= SGF_MapData;
+            } else {
+                WARNLOG("Could not read MapData chunk");
+            }
+            break;
         case SGC_PacketHeader:
             if (hdr.len != sizeof(struct PacketSaveHead))
             {
@@ -242,6 +370,7 @@ int load_game_chunks(TbFileHandle fhandle, struct CatalogueEntry *centry)
                 break;
             }
             chunks_done |= SGF_PacketData;
+            KfxFree(lua_data);
             if ((chunks_done & SGF_PacketContinue) == SGF_PacketContinue)
                 return GLoad_PacketContinue;
             if ((chunks_done & SGF_PacketStart) == SGF_PacketStart)
@@ -263,20 +392,79 @@ int load_game_chunks(TbFileHandle fhandle, struct CatalogueEntry *centry)
             break;
         case SGC_LuaData:
             {
-                char* lua_data = (char*)KfxAlloc(hdr.len);
-                if (lua_data == NULL) {
+                char* data = (char*)KfxAlloc(hdr.len);
+                if (data == NULL) {
                     WARNLOG("Could not allocate memory for LuaData chunk");
+                    skip_chunk_data(fhandle, hdr.len);
                     break;
                 }
-                if (LbFileRead(fhandle, lua_data, hdr.len) == hdr.len) {
-                    //has to be loaded here as level num only filled while gamestruct loaded, and need it for setting serialised_data
-                    open_lua_script(get_loaded_level_number());
-
-                    lua_set_serialised_data(lua_data, hdr.len);
+                if (LbFileRead(fhandle, data, hdr.len) == hdr.len) {
+                    KfxFree(lua_data);
+                    lua_data = data;
+                    lua_data_len = hdr.len;
                     chunks_done |= SGF_LuaData;
                 } else {
                     WARNLOG("Could not read LuaData chunk");
-                    KfxFree(lua_data);
+                    KfxFree(data);
+                }
+            }
+            break;
+        case SGC_Compressed:
+            {
+                struct CompressedChunkHeader zhdr;
+                if ((hdr.len < sizeof(struct CompressedChunkHeader)) ||
+                    (LbFileRead(fhandle, &zhdr, sizeof(struct CompressedChunkHeader)) != sizeof(struct CompressedChunkHeader)))
+                {
+                    WARNLOG("Could not read Compressed chunk");
+                    skip_chunk_data(fhandle, hdr.len);
+                    break;
+                }
+                unsigned long packed_len = hdr.len - sizeof(struct CompressedChunkHeader);
+                switch (zhdr.id)
+                {
+                case SGC_GameOrig:
+                    if ((zhdr.raw_len == sizeof(struct Game)) && read_compressed_data(fhandle, packed_len, &game, zhdr.raw_len)) {
+                        chunks_done |= SGF_GameOrig;
+                    } else {
+                        WARNLOG("Could not read compressed GameOrig chunk");
+                    }
+                    break;
+                case SGC_MapData:
+                    if (((chunks_done & SGF_GameOrig) == 0) || !alloc_map_blocks() || (zhdr.raw_len != map_blocks_data_size())) {
+                        WARNLOG("Incompatible compressed MapData chunk");
+                        skip_chunk_data(fhandle, packed_len);
+                    } else
+                    if (read_compressed_data(fhandle, packed_len, map_blocks, zhdr.raw_len)) {
+                        chunks_done |= SGF_MapData;
+                    } else {
+                        WARNLOG("Could not read compressed MapData chunk");
+                    }
+                    break;
+                case SGC_IntralevelData:
+                    if ((zhdr.raw_len == sizeof(struct IntralevelData)) && read_compressed_data(fhandle, packed_len, &intralvl, zhdr.raw_len)) {
+                        chunks_done |= SGF_IntralevelData;
+                    } else {
+                        WARNLOG("Could not read compressed IntralevelData chunk");
+                    }
+                    break;
+                case SGC_LuaData:
+                    {
+                        char* data = (char*)KfxAlloc(zhdr.raw_len + 1);
+                        if ((data != NULL) && read_compressed_data(fhandle, packed_len, data, zhdr.raw_len)) {
+                            KfxFree(lua_data);
+                            lua_data = data;
+                            lua_data_len = zhdr.raw_len;
+                            chunks_done |= SGF_LuaData;
+                        } else {
+                            WARNLOG("Could not read compressed LuaData chunk");
+                            KfxFree(data);
+                        }
+                    }
+                    break;
+                default:
+                    WARNLOG("Unrecognized compressed chunk, ID = %08lx", zhdr.id);
+                    skip_chunk_data(fhandle, packed_len);
+                    break;
                 }
             }
             break;
@@ -289,20 +477,316 @@ int load_game_chunks(TbFileHandle fhandle, struct CatalogueEntry *centry)
     }
     if ((chunks_done & SGF_SavedGame) == SGF_SavedGame)
     {
+        //has to be loaded here as level num only filled while gamestruct loaded, and need it for setting serialised_data
+        open_lua_script(get_loaded_level_number());
+        lua_set_serialised_data(lua_data, lua_data_len);
+        KfxFree(lua_data);
         // Update interface items
         update_trap_tab_to_config();
         update_room_tab_to_config();
         return GLoad_SavedGame;
     }
+    KfxFree(lua_data);
     return GLoad_Failed;
 }
 
+/******************************************************************************/
+static unsigned long compressed_chunk_bound(unsigned long raw_len)
+{
+#ifdef KEEPERFX_ZLIB_AVAILABLE
+    return sizeof(struct FileChunkHeader) + sizeof(struct CompressedChunkHeader) + compressBound(raw_len);
+#else
+    return sizeof(struct FileChunkHeader) + raw_len;
+#endif
+}
+
+static TbBool alloc_save_blob(struct SaveBlob *blob, unsigned long size)
+{
+    blob->data = (unsigned char *)KfxAlloc(size);
+    blob->len = 0;
+    blob->size = (blob->data != NULL) ? size : 0;
+    return (blob->data != NULL);
+}
+
+static void free_save_blob(struct SaveBlob *blob)
+{
+    KfxFree(blob->data);
+    blob->data = NULL;
+    blob->len = 0;
+    blob->size = 0;
+}
+
+/**
+ * Stores given data as a chunk of given id; compressed inside SGC_Compressed chunk if zlib is available.
+ * Called by the writer thread.
+ */
+static TbBool pack_save_chunk(struct SaveBlob *blob, unsigned long id, const void *data, unsigned long len)
+{
+    struct FileChunkHeader hdr;
+    hdr.ver = 0;
+#ifdef KEEPERFX_ZLIB_AVAILABLE
+    struct CompressedChunkHeader zhdr;
+    zhdr.id = id;
+    zhdr.ver = 0;
+    zhdr.raw_len = len;
+    unsigned long head_len = sizeof(struct FileChunkHeader) + sizeof(struct CompressedChunkHeader);
+    uLongf packed_len = blob->size - head_len;
+    if (compress(blob->data + head_len, &packed_len, (const Bytef *)data, len) != Z_OK)
+        return false;
+    hdr.id = SGC_Compressed;
+    hdr.len = sizeof(struct CompressedChunkHeader) + packed_len;
+    memcpy(blob->data + sizeof(struct FileChunkHeader), &zhdr, sizeof(struct CompressedChunkHeader));
+#else
+    if (sizeof(struct FileChunkHeader) + len > blob->size)
+        return false;
+    hdr.id = id;
+    hdr.len = len;
+    memcpy(blob->data + sizeof(struct FileChunkHeader), data, len);
+#endif
+    memcpy(blob->data, &hdr, sizeof(struct FileChunkHeader));
+    blob->len = sizeof(struct FileChunkHeader) + hdr.len;
+    return true;
+}
+
+static TbBool write_save_blob(TbFileHandle fhandle, const struct SaveBlob *blob)
+{
+    return (LbFileWrite(fhandle, blob->data, blob->len) == blob->len);
+}
+
+/**
+ * Compresses the snapshot of a job and writes the save file.
+ * The file is written under a temporary name first, so a failed save leaves the previous one intact.
+ * Runs on the writer thread.
+ */
+static TbBool run_save_job(struct SaveJob *job)
+{
+    if (!pack_save_chunk(&job->game_blob, SGC_GameOrig, job->snapshot, sizeof(struct Game)))
+    {
+        job->error = "Cannot compress GameOrig chunk";
+        return false;
+    }
+    if (!pack_save_chunk(&job->map_blob, SGC_MapData, job->map_data, job->map_len) ||
+        !pack_save_chunk(&job->intralvl_blob, SGC_IntralevelData, &job->intralvl, sizeof(struct IntralevelData)) ||
+        !pack_save_chunk(&job->lua_blob, SGC_LuaData, job->lua_data, job->lua_len))
+    {
+        job->error = "Cannot compress save chunks";
+        return false;
+    }
+
+    char tmp_fname[2048+8];
+    snprintf(tmp_fname, sizeof(tmp_fname), "%s.tmp", job->fname);
+    TbFileHandle fhandle = LbFileOpen(tmp_fname, Lb_FILE_MODE_NEW);
+    if (!fhandle)
+    {
+        job->error = "Cannot open file to save";
+        return false;
+    }
+    TbBool written = true;
+    struct FileChunkHeader hdr;
+    hdr.id = SGC_InfoBlock;
+    hdr.ver = 0;
+    hdr.len = sizeof(struct CatalogueEntry);
+    written &= (LbFileWrite(fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader));
+    written &= (LbFileWrite(fhandle, &job->centry, sizeof(struct CatalogueEntry)) == sizeof(struct CatalogueEntry));
+    written &= write_save_blob(fhandle, &job->game_blob);
+    written &= write_save_blob(fhandle, &job->map_blob);
+    written &= write_save_blob(fhandle, &job->intralvl_blob);
+    written &= write_save_blob(fhandle, &job->lua_blob);
+    LbFileClose(fhandle);
+    if (!written)
+    {
+        LbFileDelete(tmp_fname);
+        job->error = "Cannot write to save file";
+        return false;
+    }
+    LbFileDelete(job->fname);
+    if (rename(tmp_fname, job->fname) != 0)
+    {
+        job->error = "Cannot rename temporary save file";
+        return false;
+    }
+    return true;
+}
+
+static int save_writer_thread(void *data)
+{
+    struct SaveWriter *wr = (struct SaveWriter *)data;
+    SDL_LockMutex(wr->lock);
+    while (!wr->quit)
+    {
+        if (wr->busy && !wr->finished)
+        {
+            SDL_UnlockMutex(wr->lock);
+            TbBool result = wr->run(wr->data);
+            SDL_LockMutex(wr->lock);
+            wr->result = result;
+            wr->finished = true;
+            SDL_CondBroadcast(wr->cond);
+            continue;
+        }
+        SDL_CondWait(wr->cond, wr->lock);
+    }
+    SDL_UnlockMutex(wr->lock);
+    return 0;
+}
+
+static TbBool start_save_writer(struct SaveWriter *wr)
+{
+    if (wr->thread != NULL)
+        return true;
+    wr->lock = SDL_CreateMutex();
+    wr->cond = SDL_CreateCond();
+    if ((wr->lock != NULL) && (wr->cond != NULL))
+        wr->thread = SDL_CreateThread(save_writer_thread, "SaveWriter", wr);
+    if (wr->thread == NULL)
+    {
+        WARNLOG("Cannot start save writer thread, writing on the game thread: %s", SDL_GetError());
+        if (wr->cond != NULL)
+            SDL_DestroyCond(wr->cond);
+        if (wr->lock != NULL)
+            SDL_DestroyMutex(wr->lock);
+        wr->cond = NULL;
+        wr->lock = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void free_save_job_buffers(struct SaveJob *job)
+{
+    free_save_blob(&job->game_blob);
+    free_save_blob(&job->map_blob);
+    free_save_blob(&job->intralvl_blob);
+    free_save_blob(&job->lua_blob);
+    KfxFree(job->snapshot);
+    job->snapshot = NULL;
+    KfxFree(job->map_data);
+    job->map_data = NULL;
+    job->map_len = 0;
+    KfxFree(job->lua_data);
+    job->lua_data = NULL;
+    job->lua_len = 0;
+}
+
+static TbBool run_save_job_cb(void *data)
+{
+    return run_save_job((struct SaveJob *)data);
+}
+
+/**
+ * Takes the result of a finished job on the game thread, and frees its buffers.
+ * The player is told the game was saved only here, once the file is written.
+ * Failures of saves written in background are shown here too, as nobody else waits for them.
+ */
+static void complete_save_job(void *data, TbBool result, TbBool in_background)
+{
+    struct SaveJob *job = (struct SaveJob *)data;
+    job->result = result;
+    if (job->result)
+    {
+        SYNCDBG(6,"Saved slot %d",(int)job->slot_num);
+        output_message(SMsg_GameSaved, 0);
+        api_event("GAME_SAVED");
+    } else
+    {
+        WARNMSG("%s, \"%s\".", job->error, job->fname);
+        if (in_background)
+            create_error_box(GUIStr_ErrorSaving);
+    }
+    free_save_job_buffers(job);
+}
+
+/**
+ * Takes the result of the job being written, if it is finished. Called every game turn.
+ */
+void process_finished_saves(void)
+{
+    struct SaveWriter *wr = &save_writer;
+    if (!wr->busy)
+        return;
+    SDL_LockMutex(wr->lock);
+    TbBool finished = wr->finished;
+    SDL_UnlockMutex(wr->lock);
+    if (!finished)
+        return;
+    wr->busy = false;
+    wr->done(wr->data, wr->result, true);
+}
+
+/**
+ * Waits until the job being written is finished, and takes its result.
+ */
+void finish_pending_saves(void)
+{
+    struct SaveWriter *wr = &save_writer;
+    if (!wr->busy)
+        return;
+    SDL_LockMutex(wr->lock);
+    while (!wr->finished)
+        SDL_CondWait(wr->cond, wr->lock);
+    SDL_UnlockMutex(wr->lock);
+    wr->busy = false;
+    wr->done(wr->data, wr->result, true);
+}
+
+/**
+ * Gives a job to the writer thread. Any previous job has to be finished before its data is prepared,
+ * see finish_pending_saves().
+ * If the thread can't be started, the job is done right away on the game thread.
+ * @param run Called on the writer thread to do the job.
+ * @param done Called on the game thread with the result, once the job is finished.
+ * @return False only if the job was done right away and failed.
+ */
+TbBool queue_background_write(BackgroundWriteFunc run, BackgroundWriteDoneFunc done, void *data)
+{
+    struct SaveWriter *wr = &save_writer;
+    finish_pending_saves();
+    if (!start_save_writer(wr))
+    {
+        TbBool result = run(data);
+        done(data, result, false);
+        return result;
+    }
+    SDL_LockMutex(wr->lock);
+    wr->run = run;
+    wr->done = done;
+    wr->data = data;
+    wr->result = false;
+    wr->busy = true;
+    wr->finished = false;
+    SDL_CondBroadcast(wr->cond);
+    SDL_UnlockMutex(wr->lock);
+    return true;
+}
+
+void free_save_writer(void)
+{
+    struct SaveWriter *wr = &save_writer;
+    finish_pending_saves();
+    if (wr->thread != NULL)
+    {
+        SDL_LockMutex(wr->lock);
+        wr->quit = true;
+        SDL_CondBroadcast(wr->cond);
+        SDL_UnlockMutex(wr->lock);
+        SDL_WaitThread(wr->thread, NULL);
+        SDL_DestroyCond(wr->cond);
+        SDL_DestroyMutex(wr->lock);
+        wr->thread = NULL;
+        wr->cond = NULL;
+        wr->lock = NULL;
+        wr->quit = false;
+    }
+}
+
 /**
  * Saves the game state file (savegame).
+ * The state is copied right away, then compressed and written to disk in background;
+ * the player is told, and GAME_SAVED event is raised, once the file is written.
  * @note fill_game_catalogue_entry() should be called before to fill level information.
  *
  * @param slot_num
- * @return
+ * @return False if the save could not be started, or written when there's no writer thread.
  */
 TbBool save_game(long slot_num)
 {
@@ -311,22 +795,49 @@ TbBool save_game(long slot_num)
         ERRORLOG("Outranged slot index %d",(int)slot_num);
         return false;
     }
-    char* fname = prepare_file_fmtpath(FGrp_Save, saved_game_filename, slot_num);
-    TbFileHandle handle = LbFileOpen(fname, Lb_FILE_MODE_NEW);
-    if (!handle)
+    struct SaveWriter *wr = &save_writer;
+    // Only one job is written at a time, and the previous save may still use the buffers
+    finish_pending_saves();
+    struct SaveJob *job = &wr->job;
+    job->snapshot = (struct Game *)KfxAlloc(sizeof(struct Game));
+    job->map_len = map_blocks_data_size();
+    job->map_data = (struct Map *)KfxAlloc(job->map_len + 1);
+    if ((job->snapshot == NULL) || (job->map_data == NULL) ||
+        !alloc_save_blob(&job->game_blob, compressed_chunk_bound(sizeof(struct Game))) ||
+        !alloc_save_blob(&job->map_blob, compressed_chunk_bound(job->map_len)) ||
+        !alloc_save_blob(&job->intralvl_blob, compressed_chunk_bound(sizeof(struct IntralevelData))))
     {
-        WARNMSG("Cannot open file to save, \"%s\".",fname);
+        ERRORLOG("Cannot allocate buffers for saving");
+        free_save_job_buffers(job);
         return false;
     }
-    if (!save_game_chunks(handle,&save_game_catalogue[slot_num]))
+    // Currently there is some game data outside of structs - make sure it is updated
+    light_export_system_state(&game.lightst);
+    memcpy(job->snapshot, &game, sizeof(struct Game));
+    if (job->map_len > 0)
+        memcpy(job->map_data, map_blocks, job->map_len);
+    memcpy(&job->intralvl, &intralvl, sizeof(struct IntralevelData));
+    memcpy(&job->centry, &save_game_catalogue[slot_num], sizeof(struct CatalogueEntry));
+    snprintf(job->fname, sizeof(job->fname), "%s", prepare_file_fmtpath(FGrp_Save, saved_game_filename, slot_num));
     {
-        LbFileClose(handle);
-        WARNMSG("Cannot write to save file, \"%s\".",fname);
-        return false;
+        size_t lua_data_len;
+        const char* lua_data = lua_get_serialised_data(&lua_data_len);
+        job->lua_data = (char *)KfxAlloc(lua_data_len + 1);
+        if ((job->lua_data != NULL) && (lua_data_len > 0))
+            memcpy(job->lua_data, lua_data, lua_data_len);
+        job->lua_len = lua_data_len;
+        cleanup_serialized_data();
+        if ((job->lua_data == NULL) || !alloc_save_blob(&job->lua_blob, compressed_chunk_bound(job->lua_len)))
+        {
+            ERRORLOG("Cannot allocate buffers for saving");
+            free_save_job_buffers(job);
+            return false;
+        }
     }
-    LbFileClose(handle);
-    api_event("GAME_SAVED");
-    return true;
+    job->slot_num = slot_num;
+    job->result = false;
+    job->error = NULL;
+    return queue_background_write(run_save_job_cb, complete_save_job, job);
 }
 
 TbBool is_save_game_loadable(long slot_num)
@@ -359,6 +870,8 @@ TbBool load_game(long slot_num)
 //  unsigned char buf[14];
 //  char cmpgn_fname[CAMPAIGN_FNAME_LEN];
     SYNCDBG(6,"Starting");
+    // Make sure the file is not being written while we read it
+    finish_pending_saves();
     reset_eye_lenses();
     {
         // Use fname only here - it is overwritten by next use of prepare_file_fmtpath()
@@ -372,7 +885,11 @@ TbBool load_game(long slot_num)
         }
     }
     long file_len = LbFileLengthHandle(fh);
-    if (is_primitive_save_version(file_len))
+    // Compressed saves may be shorter than primitive ones, but start with a chunk header
+    struct FileChunkHeader hdr;
+    TbBool has_chunks = (LbFileRead(fh, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+        && (hdr.id == SGC_InfoBlock);
+    if (!has_chunks && is_primitive_save_version(file_len))
     {
         {
           LbFileClose(fh);
@@ -515,6 +1032,7 @@ TbBool load_catalogue_entry(TbFileHandle fh,struct FileChunkHeader *hdr,struct C
 TbBool load_game_save_catalogue(void)
 {
     long saves_found = 0;
+    finish_pending_saves();
     for (long slot_num = 0; slot_num < TOTAL_SAVE_SLOTS_COUNT; slot_num++)
     {
         struct CatalogueEntry* centry = &save_game_catalogue[slot_num];
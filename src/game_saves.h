@@ -37,20 +37,30 @@ enum SaveGameChunks {
      SGC_PacketHeader   = 0x52444850, //"PHDR"
      SGC_PacketData     = 0x544B4350, //"PCKT"
      SGC_IntralevelData = 0x4C564C49, //"ILVL"
-     SGC_LuaData        = 0x2041554C  //"LUA "
+     SGC_LuaData        = 0x2041554C, //"LUA "
+     SGC_Compressed     = 0x42494C5A, //"ZLIB"
+     SGC_ReplayTurns    = 0x4E525452, //"RTRN"
+     SGC_ReplayKeyframe = 0x4D52464B, //"KFRM"
+     SGC_MapData        = 0x4450414D, //"MAPD"
 };
 
+/** Version of SGC_PacketData chunk; before blocks, it was followed by a flat stream of turns. */
+#define PACKET_DATA_VER_BLOCKS 1
+/** Turn checksums are sums of hashes of things; before, plain sums of their coordinates. */
+#define PACKET_DATA_VER_THING_HASH 2
+
 enum SaveGameChunkFlags {
      SGF_InfoBlock      = 0x0001,
      SGF_GameOrig       = 0x0002,
+     SGF_MapData        = 0x0004,
      SGF_PacketHeader   = 0x0100,
      SGF_PacketData     = 0x0200,
      SGF_IntralevelData = 0x0400,
      SGF_LuaData        = 0x0800,
 };
-#define SGF_SavedGame      (SGF_InfoBlock|SGF_GameOrig|SGF_IntralevelData|SGF_LuaData)
+#define SGF_SavedGame      (SGF_InfoBlock|SGF_GameOrig|SGF_MapData|SGF_IntralevelData|SGF_LuaData)
 #define SGF_PacketStart    (SGF_PacketHeader|SGF_PacketData|SGF_InfoBlock)
-#define SGF_PacketContinue (SGF_PacketHeader|SGF_PacketData|SGF_InfoBlock|SGF_GameOrig)
+#define SGF_PacketContinue (SGF_PacketHeader|SGF_PacketData|SGF_InfoBlock|SGF_GameOrig|SGF_MapData)
 
 enum GameLoadStatus {
     GLoad_Failed = 0,
@@ -87,12 +97,24 @@ struct FileChunkHeader {
     unsigned long ver;
 };
 
+/** Starts the data of SGC_Compressed chunk; the zlib stream of a chunk with given id follows. */
+struct CompressedChunkHeader {
+    unsigned long id;
+    unsigned long ver;
+    unsigned long raw_len;
+};
+
 /******************************************************************************/
 extern int number_of_saved_games;
 extern const char* continue_game_filename;
 
 #pragma pack()
 /******************************************************************************/
+/** Job done by the save writer thread; returns false on failure. */
+typedef TbBool (*BackgroundWriteFunc)(void *data);
+/** Called on the game thread once a background write job is finished. */
+typedef void (*BackgroundWriteDoneFunc)(void *data, TbBool result, TbBool in_background);
+/******************************************************************************/
 extern const short VersionMajor;
 extern const short VersionMinor;
 extern short const VersionRelease;
@@ -106,6 +128,10 @@ TbBool save_packet_chunks(TbFileHandle fhandle,struct CatalogueEntry *centry);
 /******************************************************************************/
 TbBool load_game(long slot_idx);
 TbBool save_game(long slot_idx);
+void process_finished_saves(void);
+void finish_pending_saves(void);
+TbBool queue_background_write(BackgroundWriteFunc run, BackgroundWriteDoneFunc done, void *data);
+void free_save_writer(void);
 TbBool initialise_load_game_slots(void);
 int count_valid_saved_games(void);
 TbBool is_save_game_loadable(long slot_num);
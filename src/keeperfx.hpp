@@ -137,6 +137,9 @@ struct StartupParameters {
     TbBool packet_load_enable;
     char packet_fname[150];
     unsigned char packet_checksum_verify;
+    TbBool packet_verify;
+    TbBool packet_checksum_full_scan;
+    TbBool net_rollback;
     int frame_skip;
     char selected_campaign[CMDLN_MAXLEN+1];
     TbBool overrides[CMDLINE_OVERRIDES];
@@ -213,6 +216,7 @@ short setup_game(void);
 void game_loop(void);
 short reset_game(void);
 void update(void);
+void process_game_turn(void);
 
 TbBool can_thing_be_queried(struct Thing *thing, PlayerNumber plyr_idx);
 struct Thing *get_queryable_object_near(MapCoord pos_x, MapCoord pos_y, PlayerNumber plyr_idx);
@@ -257,6 +261,7 @@ void draw_mini_things_in_hand(long x, long y);
 TbBool screen_to_map(struct Camera *camera, int32_t screen_x, int32_t screen_y, struct Coord3d *mappos);
 void update_creatr_model_activities_list(TbBool forced);
 TbBool any_player_close_enough_to_see(const struct Coord3d *pos);
+TbBool any_player_camera_within(const struct Coord3d *pos, MapCoordDelta dist);
 void affect_nearby_stuff_with_vortex(struct Thing *thing);
 void affect_nearby_friends_with_alarm(struct Thing *thing);
 long apply_wallhug_force_to_boulder(struct Thing *thing);
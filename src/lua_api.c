@@ -2251,6 +2251,8 @@ void Thing_register(lua_State *L);
 void Slab_register(lua_State *L);
 void room_register(lua_State *L);
 void Lens_register(lua_State *L);
+void Events_register(lua_State *L);
+void ThingView_register(lua_State *L);
 
 void reg_host_functions(lua_State *L)
 {
@@ -2260,4 +2262,6 @@ void reg_host_functions(lua_State *L)
     Slab_register(L);
     room_register(L);
     Lens_register(L);
+    Events_register(L);
+    ThingView_register(L);
 }
@@ -0,0 +1,325 @@
+#include "pre_inc.h"
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "lua_base.h"
+#include "lua_params.h"
+
+#include "actionpt.h"
+#include "config.h"
+#include "config_creature.h"
+#include "config_magic.h"
+#include "config_objects.h"
+#include "config_trapdoor.h"
+#include "game_legacy.h"
+#include "kfx_memory.h"
+#include "map_data.h"
+#include "map_locations.h"
+#include "player_instances.h"
+#include "thing_data.h"
+#include "thing_list.h"
+#include "thing_stats.h"
+
+#include "post_inc.h"
+
+/******************************************************************************/
+/**
+ * Result of a thing query, kept on the C side.
+ * Scripts get one ThingView per query instead of a Thing table per matched thing;
+ * Thing tables are only made for the entries actually accessed.
+ */
+struct ThingView {
+    ThingClass class_id;
+    long model;
+    PlayerNumber plyr_idx;
+    TbBool in_area;
+    struct Coord3d center;
+    MapCoordDelta range;
+    long count;
+    long alloc;
+    /** Indices of the matched things, and their creation turns to notice the ones replaced since. */
+    ThingIndex *tng_idxs;
+    GameTurn *creation_turns;
+};
+
+static struct ThingView *luaL_checkThingView(lua_State *L, int index)
+{
+    return (struct ThingView *)luaL_checkudata(L, index, "ThingView");
+}
+
+static struct Thing *thing_view_get(const struct ThingView *view, long i)
+{
+    struct Thing *thing = thing_get(view->tng_idxs[i]);
+    if (!thing_exists(thing) || (thing->creation_turn != view->creation_turns[i]))
+        return INVALID_THING;
+    return thing;
+}
+
+static TbBool thing_view_refresh(struct ThingView *view)
+{
+    const struct StructureList *slist = get_list_for_thing_class(view->class_id);
+    long needed = (slist != NULL) ? (long)slist->count : 0;
+    if (needed > view->alloc)
+    {
+        ThingIndex *new_idxs = (ThingIndex *)KfxRealloc(view->tng_idxs, needed * sizeof(ThingIndex));
+        if (new_idxs == NULL)
+            return false;
+        view->tng_idxs = new_idxs;
+        GameTurn *new_turns = (GameTurn *)KfxRealloc(view->creation_turns, needed * sizeof(GameTurn));
+        if (new_turns == NULL)
+            return false;
+        view->creation_turns = new_turns;
+        view->alloc = needed;
+    }
+    long count = collect_things_of_class_and_model_owned_by(view->class_id, view->model, view->plyr_idx,
+        view->in_area ? &view->center : NULL, view->range, view->tng_idxs, view->alloc);
+    if (count > view->alloc)
+        count = view->alloc;
+    for (long i = 0; i < count; i++)
+    {
+        view->creation_turns[i] = thing_get(view->tng_idxs[i])->creation_turn;
+    }
+    view->count = count;
+    return true;
+}
+
+static long luaL_checkModelOfClass(lua_State *L, int index, ThingClass class_id)
+{
+    if (lua_isnoneornil(L, index))
+        return (class_id == TCls_Creature) ? CREATURE_ANY : -1;
+    if (class_id == TCls_Creature)
+        return luaL_checkCreature_or_creature_wildcard(L, index);
+    if (lua_isnumber(L, index))
+        return lua_tointeger(L, index);
+    const struct NamedCommand *desc;
+    switch (class_id)
+    {
+    case TCls_Object:
+        desc = object_desc;
+        break;
+    case TCls_Trap:
+        desc = trap_desc;
+        break;
+    case TCls_Door:
+        desc = door_desc;
+        break;
+    case TCls_Shot:
+        desc = shot_desc;
+        break;
+    default:
+        luaL_argerror(L, index, "models of this class can only be given as numbers");
+        return -1;
+    }
+    const char *text = luaL_checkstring(L, index);
+    long model = get_rid(desc, text);
+    luaL_argcheck(L, model != -1, index, "unrecognized model");
+    return model;
+}
+
+/******************************************************************************/
+
+static int thing_view_get_field(lua_State *L)
+{
+    struct ThingView *view = luaL_checkThingView(L, 1);
+    if (lua_type(L, 2) == LUA_TNUMBER)
+    {
+        long i = lua_tointeger(L, 2);
+        if ((i < 1) || (i > view->count))
+        {
+            lua_pushnil(L);
+            return 1;
+        }
+        lua_pushThing(L, thing_view_get(view, i - 1));
+        return 1;
+    }
+    const char *key = luaL_checkstring(L, 2);
+    lua_getfield(L, lua_upvalueindex(1), key);
+    if (lua_isnil(L, -1))
+    {
+        return luaL_error(L, "Unknown field or method '%s' for ThingView", key);
+    }
+    return 1;
+}
+
+static int thing_view_len(lua_State *L)
+{
+    struct ThingView *view = luaL_checkThingView(L, 1);
+    lua_pushinteger(L, view->count);
+    return 1;
+}
+
+static int thing_view_tostring(lua_State *L)
+{
+    struct ThingView *view = luaL_checkThingView(L, 1);
+    char buff[64];
+    snprintf(buff, sizeof(buff), "[ThingView %s %ld]", thing_class_code_name(view->class_id), view->count);
+    lua_pushstring(L, buff);
+    return 1;
+}
+
+static int thing_view_gc(lua_State *L)
+{
+    struct ThingView *view = luaL_checkThingView(L, 1);
+    KfxFree(view->tng_idxs);
+    KfxFree(view->creation_turns);
+    view->tng_idxs = NULL;
+    view->creation_turns = NULL;
+    view->count = 0;
+    view->alloc = 0;
+    return 0;
+}
+
+static int thing_view_refresh_method(lua_State *L)
+{
+    struct ThingView *view = luaL_checkThingView(L, 1);
+    if (!thing_view_refresh(view))
+    {
+        return luaL_error(L, "Out of memory refreshing ThingView");
+    }
+    lua_pushinteger(L, view->count);
+    return 1;
+}
+
+static int thing_view_index_method(lua_State *L)
+{
+    struct ThingView *view = luaL_checkThingView(L, 1);
+    long i = luaL_checkinteger(L, 2);
+    if ((i < 1) || (i > view->count) || thing_is_invalid(thing_view_get(view, i - 1)))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushinteger(L, view->tng_idxs[i - 1]);
+    return 1;
+}
+
+static int thing_view_each_next(lua_State *L)
+{
+    struct ThingView *view = (struct ThingView *)lua_touserdata(L, lua_upvalueindex(1));
+    long i = luaL_optinteger(L, 2, 0);
+    while (i < view->count)
+    {
+        struct Thing *thing = thing_view_get(view, i);
+        i++;
+        if (thing_is_invalid(thing))
+            continue;
+        lua_pushinteger(L, i);
+        // Rewrite the one handle instead of making a Thing table per step
+        lua_pushvalue(L, lua_upvalueindex(2));
+        lua_pushliteral(L, "ThingIndex");
+        lua_pushinteger(L, thing->index);
+        lua_rawset(L, -3);
+        lua_pushliteral(L, "creation_turn");
+        lua_pushinteger(L, thing->creation_turn);
+        lua_rawset(L, -3);
+        return 2;
+    }
+    return 0;
+}
+
+static int thing_view_each_method(lua_State *L)
+{
+    luaL_checkThingView(L, 1);
+    lua_pushvalue(L, 1);
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, 0);
+    lua_setfield(L, -2, "ThingIndex");
+    lua_pushinteger(L, 0);
+    lua_setfield(L, -2, "creation_turn");
+    lua_pushstring(L, "Thing");
+    lua_setfield(L, -2, "__class");
+    luaL_getmetatable(L, "Thing");
+    lua_setmetatable(L, -2);
+    lua_pushcclosure(L, thing_view_each_next, 2);
+    return 1;
+}
+
+static const struct luaL_Reg thing_view_methods[] = {
+    {"Refresh", thing_view_refresh_method},
+    {"Index",   thing_view_index_method},
+    {"Each",    thing_view_each_method},
+    {NULL, NULL}
+};
+
+static const struct luaL_Reg thing_view_meta[] = {
+    {"__index",    thing_view_get_field},
+    {"__len",      thing_view_len},
+    {"__tostring", thing_view_tostring},
+    {"__gc",       thing_view_gc},
+    {NULL, NULL}
+};
+
+/******************************************************************************/
+
+static int lua_get_things_view(lua_State *L)
+{
+    ThingClass class_id = luaL_checkNamedCommand(L, 1, class_commands);
+    PlayerNumber plyr_idx = -1;
+    if (!lua_isnoneornil(L, 2))
+    {
+        plyr_idx = luaL_checkPlayerRangeId(L, 2);
+        if (plyr_idx == ALL_PLAYERS)
+            plyr_idx = -1;
+    }
+    long model = luaL_checkModelOfClass(L, 3, class_id);
+
+    struct Coord3d center = {0};
+    MapCoordDelta range = 0;
+    TbBool in_area = !lua_isnoneornil(L, 4);
+    if (in_area)
+    {
+        TbMapLocation location = luaL_checkLocation(L, 4);
+        if (!get_coords_at_location(&center, location, false))
+        {
+            return luaL_argerror(L, 4, "location has no position");
+        }
+        if (!lua_isnoneornil(L, 5))
+        {
+            range = luaL_checkinteger(L, 5) * COORD_PER_STL;
+        } else
+        if (get_map_location_type(location) == MLoc_ACTIONPOINT)
+        {
+            range = action_point_get(get_map_location_longval(location))->range;
+        } else
+        {
+            return luaL_argerror(L, 5, "range is needed unless the location is an action point");
+        }
+    }
+
+    struct ThingView *view = (struct ThingView *)lua_newuserdata(L, sizeof(struct ThingView));
+    memset(view, 0, sizeof(struct ThingView));
+    view->class_id = class_id;
+    view->model = model;
+    view->plyr_idx = plyr_idx;
+    view->in_area = in_area;
+    view->center = center;
+    view->range = range;
+    luaL_getmetatable(L, "ThingView");
+    lua_setmetatable(L, -2);
+    if (!thing_view_refresh(view))
+    {
+        return luaL_error(L, "Out of memory creating ThingView");
+    }
+    return 1;
+}
+
+static const struct luaL_Reg thing_view_functions[] = {
+    {"GetThingsView", lua_get_things_view},
+    {NULL, NULL}
+};
+
+void ThingView_register(lua_State *L)
+{
+    luaL_newmetatable(L, "ThingView");
+    // Methods are reached through __index, which gets them as its upvalue
+    luaL_newlib(L, thing_view_methods);
+    luaL_setfuncs(L, thing_view_meta, 1);
+    lua_pop(L, 1);
+
+    for (int i = 0; thing_view_functions[i].name != NULL; i++)
+    {
+        lua_register(L, thing_view_functions[i].name, thing_view_functions[i].func);
+    }
+}
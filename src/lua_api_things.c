@@ -194,318 +194,479 @@ static int thing_tostring(lua_State *L)
     return 1;
 }
 
-// Function to set field values
-static int thing_set_field(lua_State *L) {
-    struct Thing* thing = luaL_checkThing(L, 1);
-    const char* key = luaL_checkstring(L, 2);
+/**********************************************/
+// field access
+/**********************************************/
 
-    //Fields working for all thing classes
-    if (strcmp(key, "orientation") == 0) {
-        thing->move_angle_xy = luaL_checkinteger(L, 3);
+typedef int (*ThingFieldFunc)(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl);
+
+/**
+ * Field accessible through the Thing metatable.
+ * Names are interned into a Lua table kept as upvalue of __index and __newindex,
+ * so an access costs one table lookup instead of a chain of string compares.
+ */
+struct ThingField {
+    const char *name;
+    ThingClass class_id; /**< Class the field is specific to, or TCls_Empty for all things */
+    ThingFieldFunc get;
+    ThingFieldFunc set;  /**< NULL for read-only fields */
+};
 
-    } else if (strcmp(key, "owner") == 0) {
-        PlayerNumber new_owner = luaL_checkPlayerSingle(L, 3);
-        if (is_thing_some_way_controlled(thing)) {
-            prepare_to_controlled_creature_death(thing);
-        }
-        change_creature_owner(thing, new_owner);
+#define THING_INT_FIELD(fname, member) \
+    static int thing_get_##fname(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl) \
+    { lua_pushinteger(L, member); return 1; } \
+    static int thing_set_##fname(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl) \
+    { member = luaL_checkinteger(L, 3); return 1; }
+
+#define THING_INT_FIELD_RO(fname, value) \
+    static int thing_get_##fname(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl) \
+    { lua_pushinteger(L, value); return 1; }
+
+// Fields shared by all thing classes
+THING_INT_FIELD_RO(ThingIndex, thing->index)
+THING_INT_FIELD_RO(creation_turn, thing->creation_turn)
+THING_INT_FIELD(orientation, thing->move_angle_xy)
+THING_INT_FIELD(health, thing->health)
+THING_INT_FIELD(anim_speed, thing->anim_speed)
+THING_INT_FIELD(sprite_size, thing->sprite_size)
+THING_INT_FIELD(sprite_size_min, thing->sprite_size_min)
+THING_INT_FIELD(sprite_size_max, thing->sprite_size_max)
+THING_INT_FIELD(transformation_speed, thing->transformation_speed)
+THING_INT_FIELD(clipbox_size_xy, thing->clipbox_size_xy)
+THING_INT_FIELD(clipbox_size_z, thing->clipbox_size_z)
+THING_INT_FIELD(solid_size_xy, thing->solid_size_xy)
+THING_INT_FIELD(solid_size_z, thing->solid_size_z)
+THING_INT_FIELD_RO(max_health, get_thing_max_health(thing))
+
+static int thing_get_model(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushstring(L, thing_model_only_name(thing->class_id, thing->model));
+    return 1;
+}
 
-    } else if (strcmp(key, "health") == 0)
-    {
-        thing->health = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "pos") == 0) 
-    {
-        struct Coord3d pos;
-        luaL_checkCoord3d(L, 3, &pos);
-        move_thing_in_map(thing, &pos);
-    } else if (strcmp(key, "anim_sprite") == 0)
-    {
-        thing->anim_sprite = luaL_checkAnimationId(L, 3);
-        thing->max_frames = keepersprite_frames(thing->anim_sprite);
-    } else if (strcmp(key, "anim_speed") == 0)
-    {
-        thing->anim_speed = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "sprite_size") == 0)
-    {
-        thing->sprite_size = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "sprite_size_min") == 0)
+static int thing_get_owner(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushPlayer(L, thing->owner);
+    return 1;
+}
+
+static int thing_set_owner(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    PlayerNumber new_owner = luaL_checkPlayerSingle(L, 3);
+    if (is_thing_some_way_controlled(thing)) {
+        prepare_to_controlled_creature_death(thing);
+    }
+    change_creature_owner(thing, new_owner);
+    return 1;
+}
+
+static int thing_get_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushPos(L, &thing->mappos);
+    return 1;
+}
+
+static int thing_set_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    struct Coord3d pos;
+    luaL_checkCoord3d(L, 3, &pos);
+    move_thing_in_map(thing, &pos);
+    return 1;
+}
+
+static int thing_get_anim_sprite(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushinteger(L, thing->anim_sprite);
+    return 1;
+}
+
+static int thing_set_anim_sprite(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    thing->anim_sprite = luaL_checkAnimationId(L, 3);
+    thing->max_frames = keepersprite_frames(thing->anim_sprite);
+    return 1;
+}
+
+static int thing_get_picked_up(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushboolean(L, thing_is_picked_up(thing));
+    return 1;
+}
+
+// Creature fields
+THING_INT_FIELD(gold_held, thing->creature.gold_carried)
+THING_INT_FIELD_RO(level, cctrl->exp_level + 1)
+THING_INT_FIELD(max_speed, cctrl->max_speed)
+THING_INT_FIELD(creature_kills, cctrl->kills_num)
+THING_INT_FIELD(creature_kills_enemies, cctrl->kills_num_enemy)
+THING_INT_FIELD(creature_kills_allies, cctrl->kills_num_allied)
+THING_INT_FIELD(hunger_amount, cctrl->hunger_amount)
+THING_INT_FIELD(hunger_level, cctrl->hunger_level)
+THING_INT_FIELD(hunger_loss, cctrl->hunger_loss)
+THING_INT_FIELD_RO(opponents_melee_count, cctrl->opponents_melee_count)
+THING_INT_FIELD_RO(opponents_ranged_count, cctrl->opponents_ranged_count)
+THING_INT_FIELD_RO(opponents_count, cctrl->opponents_melee_count + cctrl->opponents_ranged_count)
+THING_INT_FIELD(hand_blocked_turns, cctrl->hand_blocked_turns)
+THING_INT_FIELD(patrol_countdown, cctrl->patrol.countdown)
+THING_INT_FIELD(conscious_back_turns, cctrl->conscious_back_turns)
+
+static int thing_get_name(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushstring(L, creature_own_name(thing));
+    return 1;
+}
+
+static int thing_set_name(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    const char* name = luaL_checkstring(L, 3);
+    if (strlen(name) > CREATURE_NAME_MAX)
     {
-        thing->sprite_size_min = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "sprite_size_max") == 0)
+        return luaL_error(L, "Creature name too long (max %d)", CREATURE_NAME_MAX);
+    }
+    strncpy(cctrl->creature_name, name, CREATURE_NAME_MAX);
+    return 1;
+}
+
+static int thing_get_party(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushPartyTable(L, get_group_leader(thing));
+    return 1;
+}
+
+static int thing_get_exp_points(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushinteger(L, cctrl->exp_points);
+    return 1;
+}
+
+static int thing_set_exp_points(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    cctrl->exp_points = luaL_checkinteger(L, 3);
+    check_experience_upgrade(thing);
+    return 1;
+}
+
+static int thing_get_force_health_flower_displayed(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushinteger(L, cctrl->force_health_flower_displayed);
+    return 1;
+}
+
+static int thing_set_force_health_flower_displayed(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    cctrl->force_health_flower_displayed = lua_toboolean(L, 3);
+    return 1;
+}
+
+static int thing_get_force_health_flower_hidden(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushinteger(L, cctrl->force_health_flower_hidden);
+    return 1;
+}
+
+static int thing_set_force_health_flower_hidden(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    cctrl->force_health_flower_hidden = lua_toboolean(L, 3);
+    return 1;
+}
+
+static int thing_get_state(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushstring(L, get_conf_parameter_text(creatrstate_desc, thing->active_state));
+    return 1;
+}
+
+static int thing_set_state(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    internal_set_thing_state(thing, luaL_checkNamedCommand(L, 3, creatrstate_desc));
+    return 1;
+}
+
+static int thing_get_continue_state(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushstring(L, get_conf_parameter_text(creatrstate_desc, thing->continue_state));
+    return 1;
+}
+
+static int thing_set_continue_state(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    thing->continue_state = luaL_checkNamedCommand(L, 3, creatrstate_desc);
+    return 1;
+}
+
+static int thing_get_workroom(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushRoom(L, room_get(cctrl->work_room_id));
+    return 1;
+}
+
+static int thing_get_moveto_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushPos(L, &cctrl->moveto_pos);
+    return 1;
+}
+
+static int thing_set_moveto_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    luaL_checkCoord3d(L, 3, &cctrl->moveto_pos);
+    return 1;
+}
+
+static int thing_get_flee_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushPos(L, &cctrl->flee_pos);
+    return 1;
+}
+
+static int thing_set_flee_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    luaL_checkCoord3d(L, 3, &cctrl->flee_pos);
+    return 1;
+}
+
+static int thing_get_patrol_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushPos(L, &cctrl->patrol.pos);
+    return 1;
+}
+
+static int thing_set_patrol_pos(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    luaL_checkCoord3d(L, 3, &cctrl->patrol.pos);
+    return 1;
+}
+
+static int thing_get_party_objective(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushstring(L, get_conf_parameter_text(hero_objective_desc, cctrl->party.objective));
+    return 1;
+}
+
+static int thing_set_party_objective(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    cctrl->party.objective = luaL_checkNamedCommand(L, 3, hero_objective_desc);
+    return 1;
+}
+
+static int thing_get_party_original_objective(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushstring(L, get_conf_parameter_text(hero_objective_desc, cctrl->party.original_objective));
+    return 1;
+}
+
+static int thing_set_party_original_objective(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    cctrl->party.original_objective = luaL_checkNamedCommand(L, 3, hero_objective_desc);
+    return 1;
+}
+
+static int thing_get_party_target_player(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushPlayer(L, cctrl->party.target_plyr_idx);
+    return 1;
+}
+
+static int thing_set_party_target_player(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    cctrl->party.target_plyr_idx = luaL_checkPlayerSingle(L, 3);
+    return 1;
+}
+
+// Trap fields
+THING_INT_FIELD(revealed, thing->trap.revealed)
+THING_INT_FIELD(rearm_turn, thing->trap.rearm_turn)
+THING_INT_FIELD(shooting_finished_turn, thing->trap.shooting_finished_turn)
+
+static int thing_get_shots(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    lua_pushinteger(L, thing->trap.num_shots);
+    return 1;
+}
+
+static int thing_set_shots(lua_State *L, struct Thing *thing, struct CreatureControl *cctrl)
+{
+    set_trap_shots(thing, luaL_checkinteger(L, 3));
+    return 1;
+}
+
+#undef THING_INT_FIELD
+#undef THING_INT_FIELD_RO
+
+static const struct ThingField thing_fields[] = {
+    {"ThingIndex",                    TCls_Empty,    thing_get_ThingIndex,                    NULL},
+    {"creation_turn",                 TCls_Empty,    thing_get_creation_turn,                 NULL},
+    {"model",                         TCls_Empty,    thing_get_model,                         NULL},
+    {"owner",                         TCls_Empty,    thing_get_owner,                         thing_set_owner},
+    {"pos",                           TCls_Empty,    thing_get_pos,                           thing_set_pos},
+    {"orientation",                   TCls_Empty,    thing_get_orientation,                   thing_set_orientation},
+    {"health",                        TCls_Empty,    thing_get_health,                        thing_set_health},
+    {"anim_sprite",                   TCls_Empty,    thing_get_anim_sprite,                   thing_set_anim_sprite},
+    {"anim_speed",                    TCls_Empty,    thing_get_anim_speed,                    thing_set_anim_speed},
+    {"sprite_size",                   TCls_Empty,    thing_get_sprite_size,                   thing_set_sprite_size},
+    {"sprite_size_min",               TCls_Empty,    thing_get_sprite_size_min,               thing_set_sprite_size_min},
+    {"sprite_size_max",               TCls_Empty,    thing_get_sprite_size_max,               thing_set_sprite_size_max},
+    {"transformation_speed",          TCls_Empty,    thing_get_transformation_speed,          thing_set_transformation_speed},
+    {"clipbox_size_xy",               TCls_Empty,    thing_get_clipbox_size_xy,               thing_set_clipbox_size_xy},
+    {"clipbox_size_z",                TCls_Empty,    thing_get_clipbox_size_z,                thing_set_clipbox_size_z},
+    {"solid_size_xy",                 TCls_Empty,    thing_get_solid_size_xy,                 thing_set_solid_size_xy},
+    {"solid_size_z",                  TCls_Empty,    thing_get_solid_size_z,                  thing_set_solid_size_z},
+    {"max_health",                    TCls_Empty,    thing_get_max_health,                    NULL},
+    {"picked_up",                     TCls_Empty,    thing_get_picked_up,                     NULL},
+    {"name",                          TCls_Creature, thing_get_name,                          thing_set_name},
+    {"gold_held",                     TCls_Creature, thing_get_gold_held,                     thing_set_gold_held},
+    {"party",                         TCls_Creature, thing_get_party,                         NULL},
+    {"level",                         TCls_Creature, thing_get_level,                         NULL},
+    {"max_speed",                     TCls_Creature, thing_get_max_speed,                     thing_set_max_speed},
+    {"exp_points",                    TCls_Creature, thing_get_exp_points,                    thing_set_exp_points},
+    {"creature_kills",                TCls_Creature, thing_get_creature_kills,                thing_set_creature_kills},
+    {"creature_kills_enemies",        TCls_Creature, thing_get_creature_kills_enemies,        thing_set_creature_kills_enemies},
+    {"creature_kills_allies",         TCls_Creature, thing_get_creature_kills_allies,         thing_set_creature_kills_allies},
+    {"hunger_amount",                 TCls_Creature, thing_get_hunger_amount,                 thing_set_hunger_amount},
+    {"hunger_level",                  TCls_Creature, thing_get_hunger_level,                  thing_set_hunger_level},
+    {"hunger_loss",                   TCls_Creature, thing_get_hunger_loss,                   thing_set_hunger_loss},
+    {"opponents_melee_count",         TCls_Creature, thing_get_opponents_melee_count,         NULL},
+    {"opponents_ranged_count",        TCls_Creature, thing_get_opponents_ranged_count,        NULL},
+    {"opponents_count",               TCls_Creature, thing_get_opponents_count,               NULL},
+    {"force_health_flower_displayed", TCls_Creature, thing_get_force_health_flower_displayed, thing_set_force_health_flower_displayed},
+    {"force_health_flower_hidden",    TCls_Creature, thing_get_force_health_flower_hidden,    thing_set_force_health_flower_hidden},
+    {"hand_blocked_turns",            TCls_Creature, thing_get_hand_blocked_turns,            thing_set_hand_blocked_turns},
+    {"state",                         TCls_Creature, thing_get_state,                         thing_set_state},
+    {"continue_state",                TCls_Creature, thing_get_continue_state,                thing_set_continue_state},
+    {"workroom",                      TCls_Creature, thing_get_workroom,                      NULL},
+    {"moveto_pos",                    TCls_Creature, thing_get_moveto_pos,                    thing_set_moveto_pos},
+    {"flee_pos",                      TCls_Creature, thing_get_flee_pos,                      thing_set_flee_pos},
+    {"patrol_pos",                    TCls_Creature, thing_get_patrol_pos,                    thing_set_patrol_pos},
+    {"patrol_countdown",              TCls_Creature, thing_get_patrol_countdown,              thing_set_patrol_countdown},
+    {"party_objective",               TCls_Creature, thing_get_party_objective,               thing_set_party_objective},
+    {"party_original_objective",      TCls_Creature, thing_get_party_original_objective,      thing_set_party_original_objective},
+    {"party_target_player",           TCls_Creature, thing_get_party_target_player,           thing_set_party_target_player},
+    {"conscious_back_turns",          TCls_Creature, thing_get_conscious_back_turns,          thing_set_conscious_back_turns},
+    {"shots",                         TCls_Trap,     thing_get_shots,                         thing_set_shots},
+    {"revealed",                      TCls_Trap,     thing_get_revealed,                      thing_set_revealed},
+    {"rearm_turn",                    TCls_Trap,     thing_get_rearm_turn,                    thing_set_rearm_turn},
+    {"shooting_finished_turn",        TCls_Trap,     thing_get_shooting_finished_turn,        thing_set_shooting_finished_turn},
+    {NULL,                            TCls_Empty,    NULL,                                    NULL},
+};
+
+/**
+ * Pushes the table which maps field names to thing_fields[] indexes and
+ * method names to the C functions.
+ */
+static void push_thing_field_index(lua_State *L)
+{
+    lua_newtable(L);
+    for (int i = 0; thing_fields[i].name != NULL; i++)
     {
-        thing->sprite_size_max = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "transformation_speed") == 0)
+        lua_pushinteger(L, i);
+        lua_setfield(L, -2, thing_fields[i].name);
+    }
+    // Methods go last, so they take precedence over fields like they always did
+    for (int i = 0; thing_methods[i].name != NULL; i++)
     {
-        thing->transformation_speed = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "clipbox_size_xy") == 0)
+        lua_pushcfunction(L, thing_methods[i].func);
+        lua_setfield(L, -2, thing_methods[i].name);
+    }
+}
+
+/**
+ * Looks up the key at stack index 2 in the field index upvalue.
+ * Returns the field, or NULL after leaving a method on the stack or if the key is unknown.
+ */
+static const struct ThingField *find_thing_field(lua_State *L, TbBool *is_method)
+{
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    *is_method = lua_iscfunction(L, -1);
+    if (*is_method)
     {
-        thing->clipbox_size_xy = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "clipbox_size_z") == 0)
+        return NULL;
+    }
+    const struct ThingField *field = NULL;
+    if (lua_isnumber(L, -1))
     {
-        thing->clipbox_size_z = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "solid_size_xy") == 0)
+        field = &thing_fields[lua_tointeger(L, -1)];
+    }
+    lua_pop(L, 1);
+    return field;
+}
+
+// Function to set field values
+static int thing_set_field(lua_State *L) {
+    struct Thing* thing = luaL_checkThing(L, 1);
+    const char* key = luaL_checkstring(L, 2);
+    TbBool is_method;
+    const struct ThingField *field = find_thing_field(L, &is_method);
+    if (is_method)
     {
-        thing->solid_size_xy = luaL_checkinteger(L, 3);
-    } else if (strcmp(key, "solid_size_z") == 0)
+        lua_pop(L, 1);
+    }
+    if ((field != NULL) && (field->set == NULL))
     {
-        thing->solid_size_z = luaL_checkinteger(L, 3);
+        field = NULL;
     }
 
+    //Fields working for all thing classes
+    if ((field != NULL) && (field->class_id == TCls_Empty))
+    {
+        return field->set(L, thing, NULL);
+    }
     //Fields working for specific classes
-    else if (thing->class_id == TCls_Creature)
+    if (thing->class_id == TCls_Creature)
     {
         struct CreatureControl* cctrl = creature_control_get_from_thing(thing);
         if (creature_control_invalid(cctrl)) {
             return luaL_error(L, "Invalid creature control block");
         }
-        if (strcmp(key, "name") == 0)
-        {
-            const char* name = luaL_checkstring(L, 3);
-            if (strlen(name) > CREATURE_NAME_MAX)
-            {
-                return luaL_error(L, "Creature name too long (max %d)", CREATURE_NAME_MAX);
-            }
-            strncpy(cctrl->creature_name, name, CREATURE_NAME_MAX);
-        } else if (strcmp(key, "gold_held") == 0)
-        {
-             thing->creature.gold_carried = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "exp_points") == 0)
-        {
-            cctrl->exp_points = luaL_checkinteger(L, 3);
-            check_experience_upgrade(thing);
-        } else if (strcmp(key, "pos") == 0)
-        {
-            luaL_checkCoord3d(L, 3, &thing->mappos);
-        } else if (strcmp(key, "moveto_pos") == 0)
-        {
-            luaL_checkCoord3d(L, 3, &cctrl->moveto_pos);
-        } else if (strcmp(key, "flee_pos") == 0)
-        {
-            luaL_checkCoord3d(L, 3, &cctrl->flee_pos);
-        }
-        else if (strcmp(key, "max_speed") == 0)
-        {
-            cctrl->max_speed = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "patrol_pos") == 0)
-        {
-            luaL_checkCoord3d(L, 3, &cctrl->patrol.pos);
-        } else if (strcmp(key, "patrol_countdown") == 0)
-        {
-            cctrl->patrol.countdown = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "party_objective") == 0)
-        {
-            cctrl->party.objective = luaL_checkNamedCommand(L, 3, hero_objective_desc);
-        } else if (strcmp(key, "party_original_objective") == 0)
-        {
-            cctrl->party.original_objective = luaL_checkNamedCommand(L, 3, hero_objective_desc);
-        } else if (strcmp(key, "party_target_player") == 0)
-        {
-            cctrl->party.target_plyr_idx = luaL_checkPlayerSingle(L, 3);
-        } else if (strcmp(key, "state") == 0)
-        {
-            internal_set_thing_state(thing, luaL_checkNamedCommand(L, 3, creatrstate_desc));
-        } else if (strcmp(key, "continue_state") == 0)
-        {
-            thing->continue_state = luaL_checkNamedCommand(L, 3, creatrstate_desc);
-        } else if (strcmp(key, "hunger_amount") == 0)
-        {
-            cctrl->hunger_amount = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "hunger_level") == 0)
-        {
-            cctrl->hunger_level = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "creature_kills") == 0)
-        {
-            cctrl->kills_num = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "creature_kills_allies") == 0)
-        {
-            cctrl->kills_num_allied = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "creature_kills_enemies") == 0)
-        {
-            cctrl->kills_num_enemy = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "hunger_loss") == 0)
-        {
-            cctrl->hunger_loss = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "hand_blocked_turns") == 0)
-        {
-            cctrl->hand_blocked_turns = luaL_checkinteger(L, 3);
-        } else if (strcmp(key, "force_health_flower_displayed") == 0)
-        {
-            cctrl->force_health_flower_displayed = lua_toboolean(L, 3);
-        } else if (strcmp(key, "force_health_flower_hidden") == 0)
-        {
-            cctrl->force_health_flower_hidden = lua_toboolean(L, 3);
-        } else if (strcmp(key, "conscious_back_turns") == 0)
-        {
-            cctrl->conscious_back_turns = luaL_checkinteger(L, 3);
-        } else
+        if ((field == NULL) || (field->class_id != TCls_Creature))
         {
             return luaL_error(L, "Field '%s' is not writable on Creature thing", key);
         }
+        return field->set(L, thing, cctrl);
     } else if (thing->class_id == TCls_Trap) // Fields working for Traps
     {
-        if (strcmp(key, "shots") == 0)
-        {
-            set_trap_shots(thing, luaL_checkinteger(L, 3));
-        } else if (strcmp(key, "revealed") == 0)
-        {
-            thing->trap.revealed = luaL_checkinteger(L, 3);
-        }
-        else if (strcmp(key, "rearm_turn") == 0)
-        {
-            thing->trap.rearm_turn = luaL_checkinteger(L, 3);
-        }
-        else if (strcmp(key, "shooting_finished_turn") == 0)
-        {
-            thing->trap.shooting_finished_turn = luaL_checkinteger(L, 3);
-        } else
+        if ((field == NULL) || (field->class_id != TCls_Trap))
         {
             return luaL_error(L, "Field '%s' is not writable on Trap thing", key);
         }
-    } else
-    {
-        return luaL_error(L, "Field '%s' is not writable on Thing", key);
+        return field->set(L, thing, NULL);
     }
-    return 1;
+    return luaL_error(L, "Field '%s' is not writable on Thing", key);
 }
 
 static int thing_get_field(lua_State *L) {
     const char* key = luaL_checkstring(L, 2);
-
-    if (try_get_c_method(L, key, thing_methods))
+    TbBool is_method;
+    const struct ThingField *field = find_thing_field(L, &is_method);
+    if (is_method)
     {
         return 1;
     }
     struct Thing* thing = luaL_checkThing(L, 1);
-    struct CreatureControl* cctrl;
     // Built-in fields shared by all thing classes
-    if (strcmp(key, "ThingIndex") == 0) {
-        lua_pushinteger(L, thing->index);
-    } else if (strcmp(key, "creation_turn") == 0) {
-        lua_pushinteger(L, thing->creation_turn);
-    } else if (strcmp(key, "model") == 0) {
-        lua_pushstring(L, thing_model_only_name(thing->class_id, thing->model));
-    } else if (strcmp(key, "owner") == 0) {
-        lua_pushPlayer(L, thing->owner);
-    } else if (strcmp(key, "pos") == 0) {
-        lua_pushPos(L, &thing->mappos);
-    } else if (strcmp(key, "orientation") == 0) {
-        lua_pushinteger(L, thing->move_angle_xy);
-    } else if (strcmp(key, "health") == 0) {
-        lua_pushinteger(L, thing->health);
-    } else if (strcmp(key, "anim_sprite") == 0) {
-        lua_pushinteger(L, thing->anim_sprite);
-    } else if (strcmp(key, "anim_speed") == 0) {
-        lua_pushinteger(L, thing->anim_speed);
-    } else if (strcmp(key, "sprite_size") == 0) {
-        lua_pushinteger(L, thing->sprite_size);
-    } else if (strcmp(key, "sprite_size_min") == 0) {
-        lua_pushinteger(L, thing->sprite_size_min);
-    } else if (strcmp(key, "sprite_size_max") == 0) {
-        lua_pushinteger(L, thing->sprite_size_max);
-    } else if (strcmp(key, "transformation_speed") == 0) {
-        lua_pushinteger(L, thing->transformation_speed);
-    } else if (strcmp(key, "clipbox_size_xy") == 0) {
-        lua_pushinteger(L, thing->clipbox_size_xy);
-    } else if (strcmp(key, "clipbox_size_z") == 0) {
-        lua_pushinteger(L, thing->clipbox_size_z);
-    } else if (strcmp(key, "solid_size_xy") == 0) {
-        lua_pushinteger(L, thing->solid_size_xy);
-    } else if (strcmp(key, "solid_size_z") == 0) {
-        lua_pushinteger(L, thing->solid_size_z);
-    } else if (strcmp(key, "max_health") == 0) {
-        lua_pushinteger(L, get_thing_max_health(thing));
-    } else if (strcmp(key, "picked_up") == 0) {
-        lua_pushboolean(L, thing_is_picked_up(thing));
-    } else if (try_get_from_methods(L, 1, key)) {
+    if ((field != NULL) && (field->class_id == TCls_Empty))
+    {
+        return field->get(L, thing, NULL);
+    }
+    if (try_get_from_methods(L, 1, key))
+    {
         return 1;
     }
-
     //build in fields specific to one thing class
-    else if (thing_is_creature(thing))
+    if (thing_is_creature(thing))
     {
-        cctrl = creature_control_get_from_thing(thing);
+        struct CreatureControl* cctrl = creature_control_get_from_thing(thing);
         if (creature_control_invalid(cctrl))
             return luaL_error(L, "Invalid creature control block");
-
-        if (strcmp(key, "name") == 0) {
-            lua_pushstring(L, creature_own_name(thing));
-        } else if (strcmp(key, "gold_held") == 0) {
-            lua_pushinteger(L, thing->creature.gold_carried);
-        } else if (strcmp(key, "party") == 0) {
-            lua_pushPartyTable(L, get_group_leader(thing));
-        } else if (strcmp(key, "level") == 0) {
-            lua_pushinteger(L, cctrl->exp_level + 1);
-        } else if (strcmp(key, "max_speed") == 0) {
-            lua_pushinteger(L, cctrl->max_speed);
-        } else if (strcmp(key, "exp_points") == 0) {
-            lua_pushinteger(L, cctrl->exp_points);
-        } else if (strcmp(key, "creature_kills") == 0) {
-            lua_pushinteger(L, cctrl->kills_num);
-        } else if (strcmp(key, "creature_kills_enemies") == 0) {
-            lua_pushinteger(L, cctrl->kills_num_enemy);
-        } else if (strcmp(key, "creature_kills_allies") == 0) {
-            lua_pushinteger(L, cctrl->kills_num_allied);
-        } else if (strcmp(key, "hunger_amount") == 0) {
-            lua_pushinteger(L, cctrl->hunger_amount);
-        } else if (strcmp(key, "hunger_level") == 0) {
-            lua_pushinteger(L, cctrl->hunger_level);
-        } else if (strcmp(key, "hunger_loss") == 0) {
-            lua_pushinteger(L, cctrl->hunger_loss);
-        } else if (strcmp(key, "opponents_melee_count") == 0) {
-            lua_pushinteger(L, cctrl->opponents_melee_count);
-        } else if (strcmp(key, "opponents_ranged_count") == 0) {
-            lua_pushinteger(L, cctrl->opponents_ranged_count);
-        } else if (strcmp(key, "opponents_count") == 0) {
-            lua_pushinteger(L, (cctrl->opponents_melee_count + cctrl->opponents_ranged_count));
-        } else if (strcmp(key, "force_health_flower_displayed") == 0) {
-            lua_pushinteger(L, cctrl->force_health_flower_displayed);
-        } else if (strcmp(key, "force_health_flower_hidden") == 0) {
-            lua_pushinteger(L, cctrl->force_health_flower_hidden);
-        } else if (strcmp(key, "hand_blocked_turns") == 0) {
-            lua_pushinteger(L, cctrl->hand_blocked_turns);
-        } else if (strcmp(key, "state") == 0) {
-            lua_pushstring(L, get_conf_parameter_text(creatrstate_desc, thing->active_state));
-        } else if (strcmp(key, "continue_state") == 0) {
-            lua_pushstring(L, get_conf_parameter_text(creatrstate_desc, thing->continue_state));
-        } else if (strcmp(key, "workroom") == 0) {
-            lua_pushRoom(L, room_get(cctrl->work_room_id));
-        } else if (strcmp(key, "moveto_pos") == 0) {
-            lua_pushPos(L, &cctrl->moveto_pos);
-        } else if (strcmp(key, "flee_pos") == 0) {
-            lua_pushPos(L, &cctrl->flee_pos);
-        } else if (strcmp(key, "patrol_pos") == 0) {
-            lua_pushPos(L, &cctrl->patrol.pos);
-        } else if (strcmp(key, "patrol_countdown") == 0) {
-            lua_pushinteger(L, cctrl->patrol.countdown);
-        } else if (strcmp(key, "party_objective") == 0) {
-            lua_pushstring(L, get_conf_parameter_text(hero_objective_desc, cctrl->party.objective));
-        } else if (strcmp(key, "party_original_objective") == 0) {
-            lua_pushstring(L, get_conf_parameter_text(hero_objective_desc, cctrl->party.original_objective));
-        } else if (strcmp(key, "party_target_player") == 0) {
-            lua_pushPlayer(L, cctrl->party.target_plyr_idx);
-        } else if (strcmp(key, "conscious_back_turns") == 0) {
-            lua_pushinteger(L, cctrl->conscious_back_turns);
-        } else {
+        if ((field == NULL) || (field->class_id != TCls_Creature))
             return luaL_error(L, "Unknown field or method '%s' for Creature thing", key);
-        }
+        return field->get(L, thing, cctrl);
     } else if (thing->class_id == TCls_Trap)
     {
-        if (strcmp(key, "shots") == 0) {
-            lua_pushinteger(L, thing->trap.num_shots);
-        } else if (strcmp(key, "revealed") == 0) {
-            lua_pushinteger(L, thing->trap.revealed);
-        } else if (strcmp(key, "rearm_turn") == 0) {
-            lua_pushinteger(L, thing->trap.rearm_turn);
-        } else if (strcmp(key, "shooting_finished_turn") == 0) {
-            lua_pushinteger(L, thing->trap.shooting_finished_turn);
-        } else {
+        if ((field == NULL) || (field->class_id != TCls_Trap))
             return luaL_error(L, "Unknown field or method '%s' for Trap thing", key);
-        }
-    } else {
-        return luaL_error(L, "Unknown or unavailable field or method '%s' for Thing", key);
+        return field->get(L, thing, NULL);
     }
-
-    return 1;
+    return luaL_error(L, "Unknown or unavailable field or method '%s' for Thing", key);
 }
 
 static int thing_eq(lua_State *L) {
@@ -589,8 +750,9 @@ void Thing_register(lua_State *L) {
     // Create and register the metatable as "Thing"
     luaL_newmetatable(L, "Thing");
 
-    // Set metamethods (__index, __eq, etc.) from thing_meta[]
-    luaL_setfuncs(L, thing_meta, 0);
+    // Set metamethods (__index, __eq, etc.) from thing_meta[], sharing the field index as upvalue
+    push_thing_field_index(L);
+    luaL_setfuncs(L, thing_meta, 1);
 
     // Create the method table for Lua-accessible methods
     lua_newtable(L);
@@ -6,6 +6,7 @@
 #include <lualib.h>
 
 #include "lua_api.h"
+#include "lua_triggers.h"
 
 #include "bflib_basics.h"
 #include "bflib_fileio.h"
@@ -59,6 +60,7 @@ void close_lua_script()
     if(Lvl_script)
         lua_close(Lvl_script);
     Lvl_script = NULL;
+    lua_reset_event_handlers();
 }
 
 
@@ -100,6 +102,7 @@ TbBool execute_lua_code_from_console(const char* code)
     }
 
     int result = luaL_dostring(Lvl_script, code);
+    lua_invalidate_event_listeners();
     if (result != LUA_OK) {
         const char *message = lua_tostring(Lvl_script, -1);
         ERRORLOG("Failed to execute Lua code: %s", message ? message : "Unknown error");
@@ -126,6 +129,7 @@ TbBool execute_lua_code_from_script(const char* code)
     }
 
     int result = luaL_dostring(Lvl_script, code);
+    lua_invalidate_event_listeners();
     if (result != LUA_OK) {
         const char *message = lua_tostring(Lvl_script, -1);
         ERRORLOG("Failed to execute Lua code: %s", message ? message : "Unknown error");
@@ -163,6 +167,7 @@ void lua_set_random_seed(unsigned int seed)
 
 TbBool open_lua_script(LevelNumber lvnum)
 {
+    lua_reset_event_handlers();
 	Lvl_script = luaL_newstate();
 
 	luaL_openlibs(Lvl_script);
@@ -213,43 +218,137 @@ TbBool open_lua_script(LevelNumber lvnum)
 
 static char* lua_serialized_data = NULL;
 
+void cleanup_serialized_data() {
+    if (lua_serialized_data != NULL) {
+        KfxFree(lua_serialized_data);
+        lua_serialized_data = NULL;
+    }
+}
+
+/**
+ * Header of the serialized Lua state. It is followed by the chunks returned by GetSerializedChunks(),
+ * each preceded by its length. Data without this header comes from older saves, and is a single blob.
+ */
+#define LUA_CHUNKS_MAGIC   0x4C58464B // 'KFXL'
+#define LUA_CHUNKS_VERSION 1
+
+struct LuaChunksHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t chunks_count;
+};
+
 const char* lua_get_serialised_data(size_t *len)
 {
-    lua_getglobal(Lvl_script, "GetSerializedData");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-        JUSTLOG("calling GetSerializedData");
-        int result = lua_pcall(Lvl_script, 0, 1, 0);
-        JUSTLOG("lua_pcall result: %d", result);
-        if (!CheckLua(Lvl_script, result, "GetSerializedData")) {
-            ERRORLOG("Failed to call GetSerializedData");
+    *len = 0;
+    if (Lvl_script == NULL)
+    {
+        ERRORLOG("Lvl_script not initialised");
+        return NULL;
+    }
+    lua_getglobal(Lvl_script, "GetSerializedChunks");
+    if (!lua_isfunction(Lvl_script, -1))
+    {
+        ERRORLOG("failed to find GetSerializedChunks lua function");
+        lua_pop(Lvl_script, 1);  // Pop nil
+        return NULL;
+    }
+    SYNCDBG(7,"calling GetSerializedChunks");
+    if (!CheckLua(Lvl_script, lua_pcall(Lvl_script, 0, 1, 0), "GetSerializedChunks")) {
+        ERRORLOG("Failed to call GetSerializedChunks");
+        return NULL;
+    }
+    if (!lua_istable(Lvl_script, -1)) {
+        ERRORLOG("Expected 'GetSerializedChunks' to return a table");
+        lua_pop(Lvl_script, 1);
+        return NULL;
+    }
+#if LUA_VERSION_NUM >= 502
+    uint32_t chunks_count = (uint32_t)lua_rawlen(Lvl_script, -1);
+#else
+    uint32_t chunks_count = (uint32_t)lua_objlen(Lvl_script, -1);
+#endif
+    // Chunks are strings kept alive by the table, so they can be copied straight into one buffer
+    size_t total_len = sizeof(struct LuaChunksHeader);
+    for (uint32_t i = 1; i <= chunks_count; i++)
+    {
+        lua_rawgeti(Lvl_script, -1, i);
+        size_t chunk_len = 0;
+        if (lua_type(Lvl_script, -1) != LUA_TSTRING) {
+            ERRORLOG("Serialized Lua chunk %u is not a string", (unsigned)i);
+            lua_pop(Lvl_script, 2);
             return NULL;
         }
+        lua_tolstring(Lvl_script, -1, &chunk_len);
+        total_len += sizeof(uint32_t) + chunk_len;
+        lua_pop(Lvl_script, 1);
+    }
+    cleanup_serialized_data();
+    lua_serialized_data = (char*)KfxAlloc(total_len);
+    if (lua_serialized_data == NULL) {
+        ERRORLOG("Cannot allocate %lu bytes for serialized Lua data", (unsigned long)total_len);
+        lua_pop(Lvl_script, 1);
+        return NULL;
+    }
+    struct LuaChunksHeader hdr;
+    hdr.magic = LUA_CHUNKS_MAGIC;
+    hdr.version = LUA_CHUNKS_VERSION;
+    hdr.reserved = 0;
+    hdr.chunks_count = chunks_count;
+    memcpy(lua_serialized_data, &hdr, sizeof(hdr));
+    size_t pos = sizeof(hdr);
+    for (uint32_t i = 1; i <= chunks_count; i++)
+    {
+        lua_rawgeti(Lvl_script, -1, i);
+        size_t chunk_len = 0;
+        const char *chunk = lua_tolstring(Lvl_script, -1, &chunk_len);
+        uint32_t chunk_len32 = (uint32_t)chunk_len;
+        memcpy(lua_serialized_data + pos, &chunk_len32, sizeof(chunk_len32));
+        pos += sizeof(chunk_len32);
+        memcpy(lua_serialized_data + pos, chunk, chunk_len);
+        pos += chunk_len;
+        lua_pop(Lvl_script, 1);
+    }
+    lua_pop(Lvl_script, 1);  // Pop the chunks table
+    SYNCDBG(7,"serialized Lua state into %u chunks, %lu bytes", (unsigned)chunks_count, (unsigned long)total_len);
+    *len = total_len;
+    return lua_serialized_data;
+}
 
-        JUSTLOG("called GetSerializedData");
-        if (!lua_isstring(Lvl_script, -1)) {
-            ERRORLOG("Expected 'GetSerializedData' to return a string");
-            lua_pop(Lvl_script, 1);
-            return NULL;
+static TbBool push_serialised_chunks(lua_State *L, const char *data, size_t len)
+{
+    struct LuaChunksHeader hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.version != LUA_CHUNKS_VERSION) {
+        ERRORLOG("Unsupported serialized Lua data version %d", (int)hdr.version);
+        return false;
+    }
+    size_t pos = sizeof(hdr);
+    lua_createtable(L, hdr.chunks_count, 0);
+    for (uint32_t i = 1; i <= hdr.chunks_count; i++)
+    {
+        uint32_t chunk_len;
+        if (len - pos < sizeof(chunk_len)) {
+            break;
         }
-		const char *data = lua_tolstring(Lvl_script, -1, len);  // Get the result
-        if (data) {
-            lua_serialized_data = (char*)KfxAlloc(*len);
-            memcpy(lua_serialized_data, data, *len);
-            lua_pop(Lvl_script, 1);  // Pop the result
-            return lua_serialized_data;
+        memcpy(&chunk_len, data + pos, sizeof(chunk_len));
+        pos += sizeof(chunk_len);
+        if (len - pos < chunk_len) {
+            break;
         }
-		return NULL;
-	}
-	else
-	{
-		ERRORLOG("failed to find GetSerializedData lua function");
-        lua_pop(Lvl_script, 1);  // Pop nil
-		return NULL;
-	}
+        lua_pushlstring(L, data + pos, chunk_len);
+        lua_rawseti(L, -2, i);
+        pos += chunk_len;
+    }
+    if (pos != len) {
+        ERRORLOG("Serialized Lua data is truncated or damaged");
+        lua_pop(L, 1);
+        return false;
+    }
+    return true;
 }
 
-
 void lua_set_serialised_data(const char *data, size_t len)
 {
 	if(Lvl_script == NULL)
@@ -258,11 +357,36 @@ void lua_set_serialised_data(const char *data, size_t len)
 		return;
 	}
 
+    uint32_t magic = 0;
+    if (len >= sizeof(struct LuaChunksHeader))
+        memcpy(&magic, data, sizeof(magic));
+    if (magic == LUA_CHUNKS_MAGIC)
+    {
+        lua_getglobal(Lvl_script, "SetSerializedChunks");
+        if (!lua_isfunction(Lvl_script, -1))
+        {
+            ERRORLOG("failed to find SetSerializedChunks lua function");
+            lua_pop(Lvl_script, 1);  // Pop nil
+            return;
+        }
+        if (!push_serialised_chunks(Lvl_script, data, len))
+        {
+            lua_pop(Lvl_script, 1);  // Pop the function
+            return;
+        }
+        CheckLua(Lvl_script, lua_pcall(Lvl_script, 1, 0, 0),"SetSerializedChunks");
+        // Game.triggers was replaced by the saved one
+        lua_invalidate_event_listeners();
+        return;
+    }
+
     lua_getglobal(Lvl_script, "SetSerializedData");
 	if (lua_isfunction(Lvl_script, -1))
 	{
 		lua_pushlstring(Lvl_script, data, len);
 		CheckLua(Lvl_script, lua_pcall(Lvl_script, 1, 0, 0),"SetSerializedData");
+		// Game.triggers was replaced by the saved one
+		lua_invalidate_event_listeners();
 	}
 	else
 	{
@@ -271,13 +395,6 @@ void lua_set_serialised_data(const char *data, size_t len)
 	}
 }
 
-void cleanup_serialized_data() {
-    if (lua_serialized_data != NULL) {
-        KfxFree(lua_serialized_data);
-        lua_serialized_data = NULL;
-    }
-}
-
 void generate_lua_types_file()
 {
     char filepath[DISKPATH_SIZE];
@@ -17,47 +17,475 @@
 #include "config_magic.h"
 #include "globals.h"
 #include "thing_data.h"
+#include "kfx_memory.h"
 
 
 #include "post_inc.h"
 
+/******************************************************************************/
+/**
+ * Events the engine raises into Lua. The names are the same ones the trigger
+ * system in triggers/TriggerSystem.lua uses for Game.triggers entries.
+ */
+enum LuaEventKind {
+    LuaEvt_DungeonDestroyed = 0,
+    LuaEvt_ChatMsg,
+    LuaEvt_GameStart,
+    LuaEvt_GameTick,
+    LuaEvt_PowerCast,
+    LuaEvt_SpecialActivated,
+    LuaEvt_TrapPlaced,
+    LuaEvt_Death,
+    LuaEvt_Rebirth,
+    LuaEvt_ApplyDamage,
+    LuaEvt_ApplyDamageBatch,
+    LuaEvt_LevelUp,
+    LuaEvt_Count,
+};
+
+struct LuaEventDesc {
+    const char *name;
+    /** Global entry point called for the event, or NULL if there is none. */
+    const char *global_name;
+};
+
+static const struct LuaEventDesc lua_event_desc[LuaEvt_Count] = {
+    {"DungeonDestroyed", "OnDungeonDestroyed"},
+    {"ChatMsg",          "OnChatMsg"},
+    {"GameStart",        "OnGameStart"},
+    {"GameTick",         "OnGameTick"},
+    {"PowerCast",        "OnPowerCast"},
+    {"SpecialActivated", "OnSpecialActivated"},
+    {"TrapPlaced",       "OnTrapPlaced"},
+    {"Death",            "OnCreatureDeath"},
+    {"Rebirth",          "OnCreatureRebirth"},
+    {"ApplyDamage",      "OnApplyDamage"},
+    {"ApplyDamageBatch", NULL},
+    {"LevelUp",          "OnLevelUp"},
+};
+
+struct LuaEventListeners {
+    /** Registry refs of handlers added with RegisterEventHandler(); LUA_NOREF marks removed ones. */
+    int *handler_refs;
+    int handlers_num;
+    int handlers_alloc;
+    /** Registry ref of the global entry point, as resolved by refresh_event_listeners(). */
+    int global_ref;
+    /** True if the global entry point is the stock one from triggers/Builtins.lua. */
+    TbBool global_is_builtin;
+    /** Amount of Game.triggers waiting for this event. */
+    int triggers_num;
+};
+
+struct LuaDamageEvent {
+    ThingIndex thing_idx;
+    GameTurn creation_turn;
+    HitPoints dmg;
+    PlayerNumber dealing_plyr_idx;
+};
+
+static struct LuaEventListeners lua_event_listeners[LuaEvt_Count];
+/** Set when globals or triggers might have changed, so the listeners have to be looked up again. */
+static TbBool lua_event_listeners_dirty = true;
+/** Nonzero while handlers are being called, removed handlers are only compacted when it drops to zero. */
+static int lua_event_dispatch_depth = 0;
+static TbBool lua_event_handlers_removed = false;
+
+static struct LuaDamageEvent *lua_damage_events = NULL;
+static int lua_damage_events_num = 0;
+static int lua_damage_events_alloc = 0;
+/******************************************************************************/
+
+static long get_lua_event_kind(const char *name)
+{
+    for (long evt = 0; evt < LuaEvt_Count; evt++)
+    {
+        if (strcmp(lua_event_desc[evt].name, name) == 0)
+            return evt;
+    }
+    return -1;
+}
+
+static void release_global_ref(lua_State *L, struct LuaEventListeners *evlist)
+{
+    if (evlist->global_ref != LUA_NOREF)
+        luaL_unref(L, LUA_REGISTRYINDEX, evlist->global_ref);
+    evlist->global_ref = LUA_NOREF;
+    evlist->global_is_builtin = false;
+}
+
+/**
+ * Resolves the global entry points into registry refs and counts the triggers of each event.
+ * Done once after anything that could change them, instead of on every raised event.
+ */
+static void refresh_event_listeners(lua_State *L)
+{
+    SYNCDBG(9,"Starting");
+    for (long evt = 0; evt < LuaEvt_Count; evt++)
+    {
+        struct LuaEventListeners *evlist = &lua_event_listeners[evt];
+        release_global_ref(L, evlist);
+        evlist->triggers_num = 0;
+        if (lua_event_desc[evt].global_name == NULL)
+            continue;
+        lua_getglobal(L, lua_event_desc[evt].global_name);
+        if (!lua_isfunction(L, -1))
+        {
+            lua_pop(L, 1);
+            continue;
+        }
+        lua_getglobal(L, "BuiltinEventHandlers");
+        if (lua_istable(L, -1))
+        {
+            lua_getfield(L, -1, lua_event_desc[evt].name);
+            evlist->global_is_builtin = lua_rawequal(L, -1, -3);
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+        evlist->global_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    // The stock entry points only forward to Game.triggers, so count those per event
+    lua_getglobal(L, "Game");
+    if (lua_istable(L, -1))
+    {
+        lua_getfield(L, -1, "triggers");
+        if (lua_istable(L, -1))
+        {
+#if LUA_VERSION_NUM >= 502
+            int count = (int)lua_rawlen(L, -1);
+#else
+            int count = (int)lua_objlen(L, -1);
+#endif
+            for (int i = 1; i <= count; i++)
+            {
+                lua_rawgeti(L, -1, i);
+                if (lua_istable(L, -1))
+                {
+                    lua_getfield(L, -1, "event");
+                    if (lua_type(L, -1) == LUA_TSTRING)
+                    {
+                        long evt = get_lua_event_kind(lua_tostring(L, -1));
+                        if (evt >= 0)
+                            lua_event_listeners[evt].triggers_num++;
+                    }
+                    lua_pop(L, 1);
+                }
+                lua_pop(L, 1);
+            }
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+    lua_event_listeners_dirty = false;
+}
+
+static TbBool global_entry_is_listening(const struct LuaEventListeners *evlist)
+{
+    if (evlist->global_ref == LUA_NOREF)
+        return false;
+    // A custom entry point is always called; the stock one only when triggers wait for the event
+    return (!evlist->global_is_builtin) || (evlist->triggers_num > 0);
+}
+
+/**
+ * Checks whether anything in Lua would react to the event.
+ * Cheap enough to be called before pushing any of the event parameters.
+ */
+static TbBool lua_event_has_listeners(enum LuaEventKind evt)
+{
+    if (Lvl_script == NULL)
+        return false;
+    if (lua_event_listeners_dirty)
+        refresh_event_listeners(Lvl_script);
+    const struct LuaEventListeners *evlist = &lua_event_listeners[evt];
+    return (evlist->handlers_num > 0) || global_entry_is_listening(evlist);
+}
+
+static void compact_event_handlers(void)
+{
+    for (long evt = 0; evt < LuaEvt_Count; evt++)
+    {
+        struct LuaEventListeners *evlist = &lua_event_listeners[evt];
+        int k = 0;
+        for (int i = 0; i < evlist->handlers_num; i++)
+        {
+            if (evlist->handler_refs[i] != LUA_NOREF)
+                evlist->handler_refs[k++] = evlist->handler_refs[i];
+        }
+        evlist->handlers_num = k;
+    }
+    lua_event_handlers_removed = false;
+}
+
+static void call_event_function(lua_State *L, int func_ref, int args_base, int nargs, const char *func_name)
+{
+    lua_rawgeti(L, LUA_REGISTRYINDEX, func_ref);
+    for (int i = 1; i <= nargs; i++)
+        lua_pushvalue(L, args_base + i);
+    CheckLua(L, lua_pcall(L, nargs, 0, 0), func_name);
+}
+
+/**
+ * Calls the global entry point and all registered handlers of an event.
+ * Expects the event parameters on top of the stack, and pops them.
+ */
+static void dispatch_lua_event(enum LuaEventKind evt, int nargs)
+{
+    lua_State *L = Lvl_script;
+    int args_base = lua_gettop(L) - nargs;
+    struct LuaEventListeners *evlist = &lua_event_listeners[evt];
+    lua_event_dispatch_depth++;
+    if (global_entry_is_listening(evlist))
+    {
+        call_event_function(L, evlist->global_ref, args_base, nargs, lua_event_desc[evt].global_name);
+    }
+    // Handlers added while dispatching are not called for this event
+    int handlers_num = evlist->handlers_num;
+    for (int i = 0; i < handlers_num; i++)
+    {
+        int ref = evlist->handler_refs[i];
+        if (ref != LUA_NOREF)
+            call_event_function(L, ref, args_base, nargs, lua_event_desc[evt].name);
+    }
+    lua_event_dispatch_depth--;
+    if ((lua_event_dispatch_depth == 0) && lua_event_handlers_removed)
+        compact_event_handlers();
+    lua_settop(L, args_base);
+}
+
+static void push_thing_by_index(lua_State *L, ThingIndex tng_idx, GameTurn creation_turn)
+{
+    // Same layout as lua_pushThing(), but the thing may be gone since the event was queued
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, tng_idx);
+    lua_setfield(L, -2, "ThingIndex");
+    lua_pushinteger(L, creation_turn);
+    lua_setfield(L, -2, "creation_turn");
+    lua_pushstring(L, "Thing");
+    lua_setfield(L, -2, "__class");
+    luaL_getmetatable(L, "Thing");
+    lua_setmetatable(L, -2);
+}
+
+static TbBool reserve_damage_events(int events_num)
+{
+    if (events_num <= lua_damage_events_alloc)
+        return true;
+    int new_alloc = (lua_damage_events_alloc > 0) ? 2 * lua_damage_events_alloc : 64;
+    if (new_alloc < events_num)
+        new_alloc = events_num;
+    struct LuaDamageEvent *new_events = (struct LuaDamageEvent *)KfxRealloc(lua_damage_events, new_alloc * sizeof(struct LuaDamageEvent));
+    if (new_events == NULL)
+        return false;
+    lua_damage_events = new_events;
+    lua_damage_events_alloc = new_alloc;
+    return true;
+}
+
+static void queue_damage_event(struct Thing *thing, HitPoints dmg, PlayerNumber dealing_plyr_idx)
+{
+    if (!reserve_damage_events(lua_damage_events_num + 1))
+    {
+        ERRORLOG("Cannot queue damage event, out of memory");
+        return;
+    }
+    struct LuaDamageEvent *devt = &lua_damage_events[lua_damage_events_num++];
+    devt->thing_idx = thing->index;
+    devt->creation_turn = thing->creation_turn;
+    devt->dmg = dmg;
+    devt->dealing_plyr_idx = dealing_plyr_idx;
+}
+
+/**
+ * Delivers all damage queued during the turn to ApplyDamageBatch handlers, as one array.
+ */
+static void flush_damage_events(void)
+{
+    if (lua_damage_events_num == 0)
+        return;
+    int events_num = lua_damage_events_num;
+    lua_damage_events_num = 0;
+    if (!lua_event_has_listeners(LuaEvt_ApplyDamageBatch))
+        return;
+    lua_State *L = Lvl_script;
+    lua_createtable(L, events_num, 0);
+    for (int i = 0; i < events_num; i++)
+    {
+        const struct LuaDamageEvent *devt = &lua_damage_events[i];
+        lua_createtable(L, 0, 3);
+        push_thing_by_index(L, devt->thing_idx, devt->creation_turn);
+        lua_setfield(L, -2, "thing");
+        lua_pushinteger(L, devt->dmg);
+        lua_setfield(L, -2, "damage");
+        lua_pushPlayer(L, devt->dealing_plyr_idx);
+        lua_setfield(L, -2, "dealing_player");
+        lua_rawseti(L, -2, i + 1);
+    }
+    dispatch_lua_event(LuaEvt_ApplyDamageBatch, 1);
+}
+
+/**
+ * Gives the damage events which wait for the next tick, so they can be kept with a copy of the game state.
+ */
+const void *lua_get_queued_damage_events(size_t *len)
+{
+    *len = lua_damage_events_num * sizeof(struct LuaDamageEvent);
+    return lua_damage_events;
+}
+
+/**
+ * Replaces the damage events which wait for the next tick with ones given by lua_get_queued_damage_events().
+ */
+TbBool lua_set_queued_damage_events(const void *data, size_t len)
+{
+    int events_num = len / sizeof(struct LuaDamageEvent);
+    if (!reserve_damage_events(events_num))
+    {
+        ERRORLOG("Cannot restore %d damage events, out of memory",events_num);
+        lua_damage_events_num = 0;
+        return false;
+    }
+    if (events_num > 0)
+        memcpy(lua_damage_events, data, events_num * sizeof(struct LuaDamageEvent));
+    lua_damage_events_num = events_num;
+    return true;
+}
+
+void lua_invalidate_event_listeners(void)
+{
+    lua_event_listeners_dirty = true;
+}
+
+/**
+ * Forgets all handlers and queued events. Registry refs die with the Lua state,
+ * so this has to be called whenever it is closed.
+ */
+void lua_reset_event_handlers(void)
+{
+    for (long evt = 0; evt < LuaEvt_Count; evt++)
+    {
+        struct LuaEventListeners *evlist = &lua_event_listeners[evt];
+        KfxFree(evlist->handler_refs);
+        evlist->handler_refs = NULL;
+        evlist->handlers_num = 0;
+        evlist->handlers_alloc = 0;
+        evlist->global_ref = LUA_NOREF;
+        evlist->global_is_builtin = false;
+        evlist->triggers_num = 0;
+    }
+    KfxFree(lua_damage_events);
+    lua_damage_events = NULL;
+    lua_damage_events_num = 0;
+    lua_damage_events_alloc = 0;
+    lua_event_listeners_dirty = true;
+    lua_event_dispatch_depth = 0;
+    lua_event_handlers_removed = false;
+}
+/******************************************************************************/
+
+static long luaL_checkEventKind(lua_State *L, int index)
+{
+    const char *name = luaL_checkstring(L, index);
+    long evt = get_lua_event_kind(name);
+    if (evt < 0)
+    {
+        luaL_argerror(L, index, lua_pushfstring(L, "unknown event '%s'", name));
+    }
+    return evt;
+}
+
+static int lua_Register_event_handler(lua_State *L)
+{
+    long evt = luaL_checkEventKind(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    struct LuaEventListeners *evlist = &lua_event_listeners[evt];
+    if (evlist->handlers_num >= evlist->handlers_alloc)
+    {
+        int new_alloc = (evlist->handlers_alloc > 0) ? 2 * evlist->handlers_alloc : 4;
+        int *new_refs = (int *)KfxRealloc(evlist->handler_refs, new_alloc * sizeof(int));
+        if (new_refs == NULL)
+        {
+            return luaL_error(L, "out of memory registering handler for event '%s'", lua_event_desc[evt].name);
+        }
+        evlist->handler_refs = new_refs;
+        evlist->handlers_alloc = new_alloc;
+    }
+    lua_pushvalue(L, 2);
+    int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    evlist->handler_refs[evlist->handlers_num++] = ref;
+    lua_pushinteger(L, ref);
+    return 1;
+}
+
+static int lua_Unregister_event_handler(lua_State *L)
+{
+    long evt = luaL_checkEventKind(L, 1);
+    int ref = luaL_checkinteger(L, 2);
+    struct LuaEventListeners *evlist = &lua_event_listeners[evt];
+    for (int i = 0; i < evlist->handlers_num; i++)
+    {
+        if (evlist->handler_refs[i] == ref)
+        {
+            luaL_unref(L, LUA_REGISTRYINDEX, ref);
+            evlist->handler_refs[i] = LUA_NOREF;
+            lua_event_handlers_removed = true;
+            if (lua_event_dispatch_depth == 0)
+                compact_event_handlers();
+            lua_pushboolean(L, true);
+            return 1;
+        }
+    }
+    lua_pushboolean(L, false);
+    return 1;
+}
+
+static int lua_Event_triggers_changed(lua_State *L)
+{
+    lua_invalidate_event_listeners();
+    return 0;
+}
+
+static const luaL_Reg event_methods[] = {
+    {"RegisterEventHandler",   lua_Register_event_handler  },
+    {"UnregisterEventHandler", lua_Unregister_event_handler},
+    {"EventTriggersChanged",   lua_Event_triggers_changed  },
+};
+
+void Events_register(lua_State *L)
+{
+    for (size_t i = 0; i < (sizeof(event_methods)/sizeof(event_methods[0])); i++)
+    {
+        lua_register(L, event_methods[i].name, event_methods[i].func);
+    }
+}
+/******************************************************************************/
+
 void lua_on_dungeon_destroyed(PlayerNumber plyr_idx)
 {
 	SYNCDBG(6,"Starting");
-	lua_getglobal(Lvl_script, "OnDungeonDestroyed");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		lua_pushPlayer(Lvl_script, plyr_idx);
-		// the 1 there is the number of arguments, so the number of push lines above
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 1, 0, 0),"OnDungeonDestroyed");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	if (!lua_event_has_listeners(LuaEvt_DungeonDestroyed))
+		return;
+	lua_pushPlayer(Lvl_script, plyr_idx);
+	// the 1 there is the number of arguments, so the number of push lines above
+	dispatch_lua_event(LuaEvt_DungeonDestroyed, 1);
 }
 
 void lua_on_chatmsg(PlayerNumber plyr_idx, char *msg)
 {
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnChatMsg");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		lua_pushPlayer(Lvl_script, plyr_idx);
-		lua_pushstring(Lvl_script, msg);
-
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 2, 0, 0),"OnChatMsg");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	if (!lua_event_has_listeners(LuaEvt_ChatMsg))
+		return;
+	lua_pushPlayer(Lvl_script, plyr_idx);
+	lua_pushstring(Lvl_script, msg);
+	dispatch_lua_event(LuaEvt_ChatMsg, 2);
 }
 
 
 void lua_on_game_start()
 {
 	SYNCDBG(6,"Starting");
+	if (Lvl_script == NULL)
+		return;
 
 	lua_getglobal(Lvl_script, "OnCampaignGameStart");
 	if (lua_isfunction(Lvl_script, -1))
@@ -68,149 +496,105 @@ void lua_on_game_start()
 	{
 		lua_pop(Lvl_script, 1);
 	}
+	// The campaign script could have defined the level entry points
+	lua_invalidate_event_listeners();
 
-    lua_getglobal(Lvl_script, "OnGameStart");
-	if (lua_isfunction(Lvl_script, -1))
+	if (lua_event_has_listeners(LuaEvt_GameStart))
 	{
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 0, 0, 0),"OnGameStart");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
+		dispatch_lua_event(LuaEvt_GameStart, 0);
 	}
+	lua_invalidate_event_listeners();
 }
 
 void lua_on_game_tick()
 {
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnGameTick");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 0, 0, 0), "OnGameTick");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	flush_damage_events();
+	if (!lua_event_has_listeners(LuaEvt_GameTick))
+		return;
+	dispatch_lua_event(LuaEvt_GameTick, 0);
 }
 
 void lua_on_power_cast(PlayerNumber plyr_idx, PowerKind pwkind,
     unsigned short splevel, MapSubtlCoord stl_x, MapSubtlCoord stl_y, struct Thing *thing)
 	{
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnPowerCast");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		lua_pushstring(Lvl_script,get_conf_parameter_text(power_desc,pwkind));
-		lua_pushPlayer(Lvl_script, plyr_idx);
-		lua_pushThing(Lvl_script, thing); 
-		lua_pushinteger(Lvl_script, stl_x);
-		lua_pushinteger(Lvl_script, stl_y);
-		lua_pushinteger(Lvl_script, splevel + 1); // Lua is 1-based, so we add 1 to the level
-
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 6, 0, 0),"OnPowerCast");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	if (!lua_event_has_listeners(LuaEvt_PowerCast))
+		return;
+	lua_pushstring(Lvl_script,get_conf_parameter_text(power_desc,pwkind));
+	lua_pushPlayer(Lvl_script, plyr_idx);
+	lua_pushThing(Lvl_script, thing);
+	lua_pushinteger(Lvl_script, stl_x);
+	lua_pushinteger(Lvl_script, stl_y);
+	lua_pushinteger(Lvl_script, splevel + 1); // Lua is 1-based, so we add 1 to the level
+
+	dispatch_lua_event(LuaEvt_PowerCast, 6);
 }
 
 void lua_on_special_box_activate(PlayerNumber plyr_idx, struct Thing *cratetng)
 {
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnSpecialActivated");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		lua_pushPlayer(Lvl_script, plyr_idx);
-		lua_pushThing(Lvl_script, cratetng);
-		lua_pushinteger(Lvl_script, cratetng->custom_box.box_kind);
+	if (!lua_event_has_listeners(LuaEvt_SpecialActivated))
+		return;
+	lua_pushPlayer(Lvl_script, plyr_idx);
+	lua_pushThing(Lvl_script, cratetng);
+	lua_pushinteger(Lvl_script, cratetng->custom_box.box_kind);
 
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 3, 0, 0),"OnSpecialActivated");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	dispatch_lua_event(LuaEvt_SpecialActivated, 3);
 }
 
 void lua_on_trap_placed(struct Thing *traptng)
 {
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnTrapPlaced");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		lua_pushThing(Lvl_script, traptng);
+	if (!lua_event_has_listeners(LuaEvt_TrapPlaced))
+		return;
+	lua_pushThing(Lvl_script, traptng);
 
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 1, 0, 0),"OnTrapPlaced");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	dispatch_lua_event(LuaEvt_TrapPlaced, 1);
 }
 
 void lua_on_creature_death(struct Thing *crtng)
 {
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnCreatureDeath");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		lua_pushThing(Lvl_script, crtng);
+	if (!lua_event_has_listeners(LuaEvt_Death))
+		return;
+	lua_pushThing(Lvl_script, crtng);
 
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 1, 0, 0),"OnCreatureDeath");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	dispatch_lua_event(LuaEvt_Death, 1);
 }
 
 void lua_on_creature_rebirth(struct Thing* crtng)
 {
     SYNCDBG(6, "Starting");
-    lua_getglobal(Lvl_script, "OnCreatureRebirth");
-    if (lua_isfunction(Lvl_script, -1))
-    {
-        lua_pushThing(Lvl_script, crtng);
-        CheckLua(Lvl_script, lua_pcall(Lvl_script, 1, 0, 0), "OnCreatureRebirth");
-    }
-    else
-    {
-        lua_pop(Lvl_script, 1);
-    }
+    if (!lua_event_has_listeners(LuaEvt_Rebirth))
+        return;
+    lua_pushThing(Lvl_script, crtng);
+    dispatch_lua_event(LuaEvt_Rebirth, 1);
 }
 
 
 void lua_on_apply_damage_to_thing(struct Thing *thing, HitPoints dmg, PlayerNumber dealing_plyr_idx)
 {
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnApplyDamage");
-	if (lua_isfunction(Lvl_script, -1))
+	// Batch handlers get everything at the next game tick, so just remember it
+	if (lua_event_has_listeners(LuaEvt_ApplyDamageBatch))
 	{
-		lua_pushThing(Lvl_script, thing);
-		lua_pushinteger(Lvl_script, dmg);
-		lua_pushPlayer(Lvl_script, dealing_plyr_idx);
-
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 3, 0, 0),"OnApplyDamage");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
+		queue_damage_event(thing, dmg, dealing_plyr_idx);
 	}
+	if (!lua_event_has_listeners(LuaEvt_ApplyDamage))
+		return;
+	lua_pushThing(Lvl_script, thing);
+	lua_pushinteger(Lvl_script, dmg);
+	lua_pushPlayer(Lvl_script, dealing_plyr_idx);
+
+	dispatch_lua_event(LuaEvt_ApplyDamage, 3);
 }
 
 void lua_on_level_up(struct Thing *thing)
 {
 	SYNCDBG(6,"Starting");
-    lua_getglobal(Lvl_script, "OnLevelUp");
-	if (lua_isfunction(Lvl_script, -1))
-	{
-		lua_pushThing(Lvl_script, thing);
-		CheckLua(Lvl_script, lua_pcall(Lvl_script, 1, 0, 0),"OnLevelUp");
-	}
-	else
-	{
-		lua_pop(Lvl_script, 1);
-	}
+	if (!lua_event_has_listeners(LuaEvt_LevelUp))
+		return;
+	lua_pushThing(Lvl_script, thing);
+	dispatch_lua_event(LuaEvt_LevelUp, 1);
 }
@@ -37,6 +37,11 @@ void lua_on_creature_rebirth(struct Thing* crtng);
 void lua_on_trap_placed(struct Thing *traptng);
 void lua_on_apply_damage_to_thing(struct Thing *thing, HitPoints dmg, PlayerNumber dealing_plyr_idx);
 void lua_on_level_up(struct Thing *thing);
+
+void lua_invalidate_event_listeners(void);
+void lua_reset_event_handlers(void);
+const void *lua_get_queued_damage_events(size_t *len);
+TbBool lua_set_queued_damage_events(const void *data, size_t len);
 //void lua_on_room_claimed(PlayerNumber plyr_idx, struct Room *room);
 
 
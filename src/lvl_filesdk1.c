@@ -683,6 +683,7 @@ TbBool load_column_file(LevelNumber lv_num)
         set_column_floor_filled_subtiles(colmn, n);
         i += sizeof(struct Column);
     }
+    invalidate_columns_index();
     KfxFree(buf);
     return true;
 }
@@ -23,6 +23,7 @@
 #include "lvl_script.h"
 
 #include "globals.h"
+#include "bflib_fileio.h"
 #include "player_instances.h"
 #include "player_data.h"
 #include "player_utils.h"
@@ -175,10 +176,78 @@ char* get_next_token(char *data, struct CommandToken *token)
     return p;
 }
 
+/******************************************************************************/
+#define COMMAND_HASH_SLOTS 1024
+
+/** Open-addressing index over one CommandDesc list; built on first lookup. */
+struct CommandHashIndex {
+    const struct CommandDesc *cmdlist_desc;
+    short slots[COMMAND_HASH_SLOTS]; /**< Position in cmdlist_desc plus one; zero marks an empty slot. */
+};
+
+static struct CommandHashIndex command_hash_index[3];
+
+static uint32_t script_name_hash(const char *name, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static const struct CommandHashIndex *get_command_hash_index(const struct CommandDesc *cmdlist_desc)
+{
+    for (int n = 0; n < sizeof(command_hash_index)/sizeof(command_hash_index[0]); n++)
+    {
+        struct CommandHashIndex *chidx = &command_hash_index[n];
+        if (chidx->cmdlist_desc == cmdlist_desc)
+            return chidx;
+        if (chidx->cmdlist_desc != NULL)
+            continue;
+        int count = 0;
+        while (cmdlist_desc[count].textptr != NULL)
+            count++;
+        // Keep the table at most half full, so probe chains stay short
+        if (count > COMMAND_HASH_SLOTS / 2)
+        {
+            WARNLOG("Too many script commands (%d) to hash; using linear search", count);
+            return NULL;
+        }
+        chidx->cmdlist_desc = cmdlist_desc;
+        // Inserting in list order keeps the first of duplicated names found first
+        for (int i = 0; i < count; i++)
+        {
+            const char *name = cmdlist_desc[i].textptr;
+            uint32_t k = script_name_hash(name, strlen(name)) & (COMMAND_HASH_SLOTS - 1);
+            while (chidx->slots[k] != 0)
+                k = (k + 1) & (COMMAND_HASH_SLOTS - 1);
+            chidx->slots[k] = i + 1;
+        }
+        return chidx;
+    }
+    return NULL;
+}
+
 static struct CommandDesc const *find_command_desc(const struct CommandToken *token, const struct CommandDesc *cmdlist_desc)
 {
     const struct CommandDesc* cmnd_desc = NULL;
     int token_len = token->end - token->start;
+    const struct CommandHashIndex *chidx = get_command_hash_index(cmdlist_desc);
+    if (chidx != NULL)
+    {
+        uint32_t k = script_name_hash(token->start, token_len) & (COMMAND_HASH_SLOTS - 1);
+        while (chidx->slots[k] != 0)
+        {
+            cmnd_desc = &cmdlist_desc[chidx->slots[k] - 1];
+            if ((strncmp(cmnd_desc->textptr, token->start, token_len) == 0) && (cmnd_desc->textptr[token_len] == 0))
+                return cmnd_desc;
+            k = (k + 1) & (COMMAND_HASH_SLOTS - 1);
+        }
+        return NULL;
+    }
     for (int i = 0; cmdlist_desc[i].textptr != NULL; i++)
     {
         if ((cmdlist_desc[i].textptr[token_len] == 0) && (strncmp(cmdlist_desc[i].textptr, token->start, token_len) == 0))
@@ -401,6 +470,466 @@ TbBool script_command_param_to_text(char type_chr, struct ScriptLine *scline, in
     return true;
 }
 
+/******************************************************************************/
+/**
+ * Level script cache.
+ * Recognized script lines are stored in a binary file, so that the next load
+ * of the same script can skip tokenizing and command lookup. The file is named
+ * after the script path and validated by a hash of the script text and of the
+ * command tables. Names which depend on loaded configs (creatures, rooms, slabs,
+ * locations) are kept as text and re-resolved on replay; lines using functions
+ * like DRAWFROM, and lines which failed to parse, are stored as raw text and
+ * go through the parser again.
+ *
+ * File format:
+ *   struct ScriptCacheHeader
+ *   preload section entries, then main section entries; each entry is:
+ *     u32 line number, u8 kind
+ *     SCEK_Parsed: u8 commands list, u16 position in list,
+ *                  i64 np[COMMANDDESC_ARGS_COUNT], (u16 len, chars) tp[COMMANDDESC_ARGS_COUNT]
+ *     SCEK_Text:   u32 len, chars
+ */
+#define SCRIPT_CACHE_MAGIC   0x43535846u /* 'FXSC' */
+#define SCRIPT_CACHE_VERSION 1
+
+enum ScriptCacheEntryKind {
+    SCEK_Parsed = 1,
+    SCEK_Text,
+};
+
+enum ScriptCacheSection {
+    SCSec_Preload = 0,
+    SCSec_Main,
+    SCSec_Count,
+};
+
+enum ScriptCacheLineState {
+    SCLS_Text = 0, /**< Line has to be stored as text */
+    SCLS_Ignored,  /**< Line has no effect within the current pass */
+    SCLS_Recorded, /**< Line was recorded as parsed command */
+};
+
+struct ScriptCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tables_sig;
+    uint32_t script_len;
+    uint64_t script_hash;
+    uint32_t count[SCSec_Count];
+    uint32_t size[SCSec_Count];
+};
+
+struct ScriptCacheSectionData {
+    unsigned char *data;
+    uint32_t len;
+    uint32_t cap;
+    uint32_t count;
+};
+
+struct ScriptCache {
+    LevelNumber lvnum;
+    uint32_t script_len;
+    uint64_t script_hash;
+    char fname[2048];
+    TbBool valid;     /**< Sections were read from a matching cache file */
+    TbBool recording; /**< Sections are being filled by the parser */
+    int rec_section;
+    enum ScriptCacheLineState line_state;
+    TbBool line_cacheable;
+    char *line_copy;
+    size_t line_copy_cap;
+    struct ScriptCacheSectionData sect[SCSec_Count];
+};
+
+static struct ScriptCache script_cache = { 0 };
+
+static const struct CommandDesc *const script_cache_cmdlists[] = {
+    command_desc,
+    dk1_command_desc,
+};
+
+static uint64_t script_data_hash(const char *data, size_t len)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * Signature of the command tables; any change to commands or their
+ * parameter types makes the old cache files invalid.
+ */
+static uint32_t script_cache_tables_signature(void)
+{
+    uint32_t sig = SCRIPT_CACHE_VERSION;
+    for (int n = 0; n < sizeof(script_cache_cmdlists)/sizeof(script_cache_cmdlists[0]); n++)
+    {
+        const struct CommandDesc *cmdlist_desc = script_cache_cmdlists[n];
+        for (int i = 0; cmdlist_desc[i].textptr != NULL; i++)
+        {
+            sig = sig * 31 + script_name_hash(cmdlist_desc[i].textptr, strlen(cmdlist_desc[i].textptr));
+            sig = sig * 31 + script_name_hash(cmdlist_desc[i].args, strlen(cmdlist_desc[i].args));
+            sig = sig * 31 + cmdlist_desc[i].index;
+        }
+        sig = sig * 31 + n;
+    }
+    return sig;
+}
+
+static void script_cache_clear(void)
+{
+    for (int n = 0; n < SCSec_Count; n++)
+    {
+        KfxFree(script_cache.sect[n].data);
+    }
+    KfxFree(script_cache.line_copy);
+    memset(&script_cache, 0, sizeof(script_cache));
+}
+
+static void script_cache_put(struct ScriptCacheSectionData *sect, const void *src, uint32_t len)
+{
+    if (sect->len + len > sect->cap)
+    {
+        uint32_t cap = max(sect->cap * 2, 4096);
+        while (cap < sect->len + len)
+            cap *= 2;
+        sect->data = KfxRealloc(sect->data, cap);
+        sect->cap = cap;
+    }
+    memcpy(sect->data + sect->len, src, len);
+    sect->len += len;
+}
+
+static void script_cache_put_entry_start(struct ScriptCacheSectionData *sect, unsigned char kind)
+{
+    uint32_t line_num = text_line_number;
+    script_cache_put(sect, &line_num, sizeof(line_num));
+    script_cache_put(sect, &kind, sizeof(kind));
+    sect->count++;
+}
+
+static void script_cache_record_parsed(const struct CommandDesc *cmdlist_desc, const struct CommandDesc *cmd_desc, const struct ScriptLine *scline)
+{
+    struct ScriptCacheSectionData *sect = &script_cache.sect[script_cache.rec_section];
+    unsigned char list_idx = (cmdlist_desc == command_desc) ? 0 : 1;
+    uint16_t pos = cmd_desc - cmdlist_desc;
+    script_cache_put_entry_start(sect, SCEK_Parsed);
+    script_cache_put(sect, &list_idx, sizeof(list_idx));
+    script_cache_put(sect, &pos, sizeof(pos));
+    for (int i = 0; i < COMMANDDESC_ARGS_COUNT; i++)
+    {
+        int64_t np = scline->np[i];
+        script_cache_put(sect, &np, sizeof(np));
+    }
+    for (int i = 0; i < COMMANDDESC_ARGS_COUNT; i++)
+    {
+        uint16_t len = strnlen(scline->tp[i], MAX_TEXT_LENGTH - 1);
+        script_cache_put(sect, &len, sizeof(len));
+        script_cache_put(sect, scline->tp[i], len);
+    }
+    script_cache.line_state = SCLS_Recorded;
+}
+
+static void script_cache_record_text(const char *line, uint32_t len)
+{
+    struct ScriptCacheSectionData *sect = &script_cache.sect[script_cache.rec_section];
+    script_cache_put_entry_start(sect, SCEK_Text);
+    script_cache_put(sect, &len, sizeof(len));
+    script_cache_put(sect, line, len);
+}
+
+/**
+ * Walks through all entries of a section, checking that they are complete
+ * and refer to existing commands. Replay relies on that being checked.
+ */
+static TbBool script_cache_section_valid(const struct ScriptCacheSectionData *sect)
+{
+    const unsigned char *p = sect->data;
+    const unsigned char *end = sect->data + sect->len;
+    for (uint32_t n = 0; n < sect->count; n++)
+    {
+        if (end - p < 5)
+            return false;
+        unsigned char kind = p[4];
+        p += 5;
+        if (kind == SCEK_Parsed)
+        {
+            if (end - p < 3 + COMMANDDESC_ARGS_COUNT * sizeof(int64_t))
+                return false;
+            unsigned char list_idx = p[0];
+            uint16_t pos;
+            memcpy(&pos, p + 1, sizeof(pos));
+            if (list_idx >= sizeof(script_cache_cmdlists)/sizeof(script_cache_cmdlists[0]))
+                return false;
+            for (int i = 0; i <= pos; i++)
+            {
+                if (script_cache_cmdlists[list_idx][i].textptr == NULL)
+                    return false;
+            }
+            p += 3 + COMMANDDESC_ARGS_COUNT * sizeof(int64_t);
+            for (int i = 0; i < COMMANDDESC_ARGS_COUNT; i++)
+            {
+                uint16_t len;
+                if (end - p < sizeof(len))
+                    return false;
+                memcpy(&len, p, sizeof(len));
+                p += sizeof(len);
+                if ((len >= MAX_TEXT_LENGTH) || (end - p < len))
+                    return false;
+                p += len;
+            }
+        } else
+        if (kind == SCEK_Text)
+        {
+            uint32_t len;
+            if (end - p < sizeof(len))
+                return false;
+            memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            if (end - p < len)
+                return false;
+            p += len;
+        } else
+        {
+            return false;
+        }
+    }
+    return (p == end);
+}
+
+static TbBool script_cache_read_file(void)
+{
+    struct ScriptCacheHeader hdr;
+    if (!LbFileExists(script_cache.fname))
+        return false;
+    TbFileHandle fh = LbFileOpen(script_cache.fname, Lb_FILE_MODE_READ_ONLY);
+    if (!fh)
+        return false;
+    long fsize = LbFileLengthHandle(fh);
+    TbBool ok = (LbFileRead(fh, &hdr, sizeof(hdr)) == sizeof(hdr));
+    ok = ok && ((int64_t)fsize == (int64_t)sizeof(hdr) + hdr.size[SCSec_Preload] + hdr.size[SCSec_Main]);
+    ok = ok && (hdr.magic == SCRIPT_CACHE_MAGIC) && (hdr.version == SCRIPT_CACHE_VERSION);
+    ok = ok && (hdr.tables_sig == script_cache_tables_signature());
+    ok = ok && (hdr.script_len == script_cache.script_len) && (hdr.script_hash == script_cache.script_hash);
+    for (int n = 0; ok && (n < SCSec_Count); n++)
+    {
+        struct ScriptCacheSectionData *sect = &script_cache.sect[n];
+        sect->data = KfxAlloc(hdr.size[n] + 1);
+        sect->cap = hdr.size[n] + 1;
+        sect->len = hdr.size[n];
+        sect->count = hdr.count[n];
+        ok = (LbFileRead(fh, sect->data, sect->len) == (int)sect->len) && script_cache_section_valid(sect);
+    }
+    LbFileClose(fh);
+    if (!ok)
+    {
+        for (int n = 0; n < SCSec_Count; n++)
+        {
+            KfxFree(script_cache.sect[n].data);
+            memset(&script_cache.sect[n], 0, sizeof(struct ScriptCacheSectionData));
+        }
+    }
+    return ok;
+}
+
+static void script_cache_write_file(void)
+{
+    struct ScriptCacheHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SCRIPT_CACHE_MAGIC;
+    hdr.version = SCRIPT_CACHE_VERSION;
+    hdr.tables_sig = script_cache_tables_signature();
+    hdr.script_len = script_cache.script_len;
+    hdr.script_hash = script_cache.script_hash;
+    for (int n = 0; n < SCSec_Count; n++)
+    {
+        hdr.count[n] = script_cache.sect[n].count;
+        hdr.size[n] = script_cache.sect[n].len;
+    }
+    TbFileHandle fh = LbFileOpen(script_cache.fname, Lb_FILE_MODE_NEW);
+    if (!fh)
+    {
+        WARNLOG("Can't create script cache \"%s\"", script_cache.fname);
+        return;
+    }
+    TbBool ok = (LbFileWrite(fh, &hdr, sizeof(hdr)) == sizeof(hdr));
+    for (int n = 0; ok && (n < SCSec_Count); n++)
+    {
+        ok = (LbFileWrite(fh, script_cache.sect[n].data, script_cache.sect[n].len) == script_cache.sect[n].len);
+    }
+    LbFileClose(fh);
+    if (!ok)
+    {
+        WARNLOG("Can't write script cache \"%s\"", script_cache.fname);
+        LbFileDelete(script_cache.fname);
+    }
+}
+
+/**
+ * Prepares the cache for given script text. Either loads matching cache file,
+ * or starts recording the lines parsed in the preload pass.
+ */
+static void script_cache_begin(LevelNumber lvnum, const char *script_data, long script_len)
+{
+    script_cache_clear();
+    script_cache.lvnum = lvnum;
+    script_cache.script_len = script_len;
+    script_cache.script_hash = script_data_hash(script_data, script_len);
+    const char *script_fname = prepare_file_fmtpath(get_level_fgroup(lvnum), "map%05lu.txt", (unsigned long)lvnum);
+    uint32_t path_hash = script_name_hash(script_fname, strlen(script_fname));
+    snprintf(script_cache.fname, sizeof(script_cache.fname), "%s", prepare_file_fmtpath(FGrp_Save, "scrc%08lx.dat", (unsigned long)path_hash));
+    if (script_cache_read_file())
+    {
+        SYNCDBG(7,"Using script cache \"%s\"", script_cache.fname);
+        script_cache.valid = true;
+        return;
+    }
+    script_cache.recording = true;
+    script_cache.rec_section = SCSec_Preload;
+}
+
+static void script_cache_skip_lines(unsigned long line_num)
+{
+    // Every scanned line, including empty ones, counts down the reusable flag
+    unsigned long steps = line_num - text_line_number;
+    if (steps >= next_command_reusable)
+        next_command_reusable = 0;
+    else
+        next_command_reusable -= steps;
+    text_line_number = line_num;
+}
+
+static void script_cache_replay_parsed(const unsigned char **pp, struct ScriptLine *scline)
+{
+    const unsigned char *p = *pp;
+    const struct CommandDesc *cmd_desc;
+    uint16_t pos;
+    if (next_command_reusable > 0)
+        next_command_reusable--;
+    memcpy(&pos, p + 1, sizeof(pos));
+    cmd_desc = &script_cache_cmdlists[p[0]][pos];
+    p += 3;
+    memset(scline, 0, sizeof(struct ScriptLine));
+    scline->command = cmd_desc->index;
+    snprintf(scline->tcmnd, MAX_TEXT_LENGTH, "%s", cmd_desc->textptr);
+    for (int i = 0; i < COMMANDDESC_ARGS_COUNT; i++)
+    {
+        int64_t np;
+        memcpy(&np, p, sizeof(np));
+        scline->np[i] = np;
+        p += sizeof(np);
+    }
+    for (int i = 0; i < COMMANDDESC_ARGS_COUNT; i++)
+    {
+        uint16_t len;
+        memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        memcpy(scline->tp[i], p, len);
+        p += len;
+    }
+    *pp = p;
+    // Names of things defined by configs may have changed their numbers
+    for (int dst = 0, src = 0; (dst < COMMANDDESC_ARGS_COUNT) && (src < COMMANDDESC_ARGS_COUNT); dst++, src++)
+    {
+        char chr = cmd_desc->args[src];
+        if (chr == '!')
+        {
+            dst--;
+            continue;
+        }
+        if (scline->tp[dst][0] == '\0')
+            break;
+        TbBool extended = false;
+        if (cmd_desc->args[src + 1] == '+')
+            src -= 1;
+        else
+        if (cmd_desc->args[src + 1] == '!')
+            extended = true;
+        switch (toupper(chr))
+        {
+        case 'P':
+        case 'C':
+        case 'R':
+        case 'S':
+        case 'L':
+            if (!script_command_param_to_number(chr, scline, dst, extended))
+            {
+                SCRPTERRLOG("Parameter %d of command \"%s\", type %c, has unexpected value; discarding command", dst + 1, scline->tcmnd, chr);
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    script_add_command(cmd_desc, scline, level_file_version);
+}
+
+/**
+ * Executes lines of one section of the loaded script cache, in the same way
+ * the parser would have done.
+ */
+static void script_cache_replay(int section, TbBool preloaded)
+{
+    const struct ScriptCacheSectionData *sect = &script_cache.sect[section];
+    struct ScriptLine* scline = (struct ScriptLine*)KfxCalloc(1, sizeof(struct ScriptLine));
+    const unsigned char *p = sect->data;
+    text_line_number = 0;
+    for (uint32_t n = 0; n < sect->count; n++)
+    {
+        uint32_t line_num;
+        memcpy(&line_num, p, sizeof(line_num));
+        unsigned char kind = p[4];
+        p += 5;
+        if (kind == SCEK_Parsed)
+        {
+            script_cache_skip_lines(line_num - 1);
+            text_line_number = line_num;
+            script_cache_replay_parsed(&p, scline);
+        } else
+        {
+            uint32_t len;
+            memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            // The parser modifies the line, so it needs a copy
+            char* line = (char*)KfxAlloc(len + 1);
+            memcpy(line, p, len);
+            line[len] = '\0';
+            p += len;
+            script_cache_skip_lines(line_num - 1);
+            text_line_number = line_num;
+            script_scan_line(line, preloaded, level_file_version);
+            KfxFree(line);
+        }
+    }
+    KfxFree(scline);
+}
+
+static void script_scan_and_record_line(char *line, TbBool preloaded)
+{
+    if (!script_cache.recording)
+    {
+        script_scan_line(line, preloaded, level_file_version);
+        return;
+    }
+    size_t len = strlen(line);
+    if (len + 1 > script_cache.line_copy_cap)
+    {
+        script_cache.line_copy_cap = max(len + 1, 256);
+        script_cache.line_copy = KfxRealloc(script_cache.line_copy, script_cache.line_copy_cap);
+    }
+    memcpy(script_cache.line_copy, line, len + 1);
+    script_cache.line_state = SCLS_Text;
+    script_cache.line_cacheable = true;
+    script_scan_line(line, preloaded, level_file_version);
+    if (script_cache.line_state == SCLS_Text)
+        script_cache_record_text(script_cache.line_copy, len);
+}
+
 static int count_required_parameters(const char *args)
 {
     int required = 0;
@@ -670,6 +1199,8 @@ static int script_recognize_params(char **line, const struct CommandDesc *cmd_de
 
             if (funcmd_desc != NULL)
             {
+                // Functions may draw random numbers or read campaign flags, so their results can't be cached
+                script_cache.line_cacheable = false;
                 int r = process_subfunc(line, scline, cmd_desc, funcmd_desc, para_level, src, dst, file_version);
                 if (r == -1)
                     return -1;
@@ -736,6 +1267,7 @@ TbBool script_scan_line(char *line, TbBool preloaded, long file_version)
     line = get_next_token(line, &token);
     if (token.type == TkEnd)
     {
+        script_cache.line_state = SCLS_Ignored;
         KfxFree(scline);
         return false;
     }
@@ -746,13 +1278,8 @@ TbBool script_scan_line(char *line, TbBool preloaded, long file_version)
         return false;
     }
     memcpy(scline->tcmnd, token.start, min((token.end - token.start), MAX_TEXT_LENGTH));
-    if (file_version > 0)
-    {
-        cmd_desc = find_command_desc(&token, command_desc);
-    } else
-    {
-        cmd_desc = find_command_desc(&token, dk1_command_desc);
-    }
+    const struct CommandDesc *cmdlist_desc = (file_version > 0) ? command_desc : dk1_command_desc;
+    cmd_desc = find_command_desc(&token, cmdlist_desc);
     if (cmd_desc == NULL)
     {
         if (isalnum(scline->tcmnd[0])) {
@@ -765,6 +1292,7 @@ TbBool script_scan_line(char *line, TbBool preloaded, long file_version)
     // Handling comments
     if (cmd_desc->index == Cmd_REM)
     {
+        script_cache.line_state = SCLS_Ignored;
         KfxFree(scline);
         return false;
     }
@@ -773,6 +1301,7 @@ TbBool script_scan_line(char *line, TbBool preloaded, long file_version)
     // selecting only preloaded/not preloaded commands
     if (script_is_preloaded_command(cmd_desc->index) != preloaded)
     {
+        script_cache.line_state = SCLS_Ignored;
         KfxFree(scline);
         return true;
     }
@@ -817,6 +1346,11 @@ TbBool script_scan_line(char *line, TbBool preloaded, long file_version)
     if (token.type != TkEnd)
     {
         SCRPTERRLOG("Syntax error: Unexpected end of line");
+        script_cache.line_cacheable = false;
+    }
+    if (script_cache.recording && script_cache.line_cacheable)
+    {
+        script_cache_record_parsed(cmdlist_desc, cmd_desc, scline);
     }
     script_add_command(cmd_desc, scline, file_version);
     KfxFree(scline);
@@ -893,7 +1427,7 @@ static void parse_txt_data(char *script_data, long script_len)
       }
       //SCRPTLOG("Analyse");
       // Analyze the line
-      script_scan_line(buf, true, level_file_version);
+      script_scan_and_record_line(buf, true);
       // Set new line start
       text_line_number++;
       buf += lnlen;
@@ -914,13 +1448,36 @@ TbBool preload_script(long lvnum)
   if (script_data == NULL)
   {
       // Here we could load lua instead
+      script_cache_clear();
       return false;
   }
-  parse_txt_data(script_data, script_len);
+  script_cache_begin(lvnum, script_data, script_len);
+  if (script_cache.valid)
+  {
+      script_cache_replay(SCSec_Preload, true);
+      KfxFree(script_data);
+  } else
+  {
+      parse_txt_data(script_data, script_len);
+  }
   SYNCDBG(8,"Finished");
   return true;
 }
 
+static void finish_script_loading(void)
+{
+    if (game.script.win_conditions_num == 0 && luascript_loaded == false)
+      WARNMSG("No WIN GAME conditions in script file.");
+    if (get_script_current_condition() != CONDITION_ALWAYS)
+      WARNMSG("Missing ENDIF's in script file.");
+    JUSTLOG("Used script resources: %d/%d tunneller triggers, %d/%d party triggers, %d/%d script values, %d/%d IF conditions, %d/%d party definitions",
+        (int)game.script.tunneller_triggers_num,TUNNELLER_TRIGGERS_COUNT,
+        (int)game.script.party_triggers_num,PARTY_TRIGGERS_COUNT,
+        (int)game.script.values_num,SCRIPT_VALUES_COUNT,
+        (int)game.script.conditions_num,CONDITIONS_COUNT,
+        (int)game.script.creature_partys_num,CREATURE_PARTYS_COUNT);
+}
+
 short load_script(long lvnum)
 {
     SYNCDBG(7,"Starting");
@@ -937,11 +1494,28 @@ short load_script(long lvnum)
     reset_creature_max_levels();
     reset_script_timers_and_flags();
     reset_hand_rules();
+    if ((script_cache.valid) && (script_cache.lvnum == lvnum))
+    {
+        script_cache_replay(SCSec_Main, false);
+        script_cache_clear();
+        finish_script_loading();
+        return true;
+    }
     // Load the file
     int32_t script_len = 1;
     char* script_data = (char*)load_single_map_file_to_buffer(lvnum, "txt", &script_len, LMFF_None);
     if (script_data == NULL)
+    {
+      script_cache_clear();
       return false;
+    }
+    // Record only if the text is the one which was preloaded
+    if ((script_cache.recording) && ((script_cache.lvnum != lvnum) || (script_cache.script_len != script_len) ||
+        (script_cache.script_hash != script_data_hash(script_data, script_len))))
+    {
+        script_cache_clear();
+    }
+    script_cache.rec_section = SCSec_Main;
     // Process the file lines
     char* buf = script_data;
     char* buffer_end_pointer = script_data + script_len;
@@ -964,22 +1538,18 @@ short load_script(long lvnum)
           p[-1] = 0;
       }
       // Analyze the line
-      script_scan_line(buf, false, level_file_version);
+      script_scan_and_record_line(buf, false);
       // Set new line start
       text_line_number++;
       buf = p;
     }
     KfxFree(script_data);
-    if (game.script.win_conditions_num == 0 && luascript_loaded == false)
-      WARNMSG("No WIN GAME conditions in script file.");
-    if (get_script_current_condition() != CONDITION_ALWAYS)
-      WARNMSG("Missing ENDIF's in script file.");
-    JUSTLOG("Used script resources: %d/%d tunneller triggers, %d/%d party triggers, %d/%d script values, %d/%d IF conditions, %d/%d party definitions",
-        (int)game.script.tunneller_triggers_num,TUNNELLER_TRIGGERS_COUNT,
-        (int)game.script.party_triggers_num,PARTY_TRIGGERS_COUNT,
-        (int)game.script.values_num,SCRIPT_VALUES_COUNT,
-        (int)game.script.conditions_num,CONDITIONS_COUNT,
-        (int)game.script.creature_partys_num,CREATURE_PARTYS_COUNT);
+    if (script_cache.recording)
+    {
+        script_cache_write_file();
+    }
+    script_cache_clear();
+    finish_script_loading();
     return true;
 }
 
@@ -42,6 +42,7 @@
 #include "bflib_network.h"
 #include "net_resync.h"
 #include "bflib_planar.h"
+#include "bflib_jobs.h"
 
 #include "api.h"
 #include "custom_sprites.h"
@@ -135,6 +136,7 @@
 #include "steam_api.hpp"
 #include "game_loop.h"
 #include "net_input_lag.h"
+#include "net_rollback.h"
 #include "moonphase.h"
 #include "frontmenu_ingame_map.h"
 #include <stdint.h>
@@ -845,6 +847,25 @@ TbBool any_player_close_enough_to_see(const struct Coord3d *pos)
     return false;
 }
 
+/**
+ * Checks if a camera of any human player is within given distance from the position.
+ * Cameras of all players are checked, not just the local one, so that the result is the same for every player.
+ */
+TbBool any_player_camera_within(const struct Coord3d *pos, MapCoordDelta dist)
+{
+    for (int i = 0; i < PLAYERS_COUNT; i++)
+    {
+        struct PlayerInfo *player = get_player(i);
+        if ((!player_exists(player)) || ((player->allocflags & PlaF_CompCtrl) != 0))
+            continue;
+        if (player->acamera == NULL)
+            continue;
+        if (get_chessboard_distance(&player->acamera->mappos, pos) <= dist)
+            return true;
+    }
+    return false;
+}
+
 void update_thing_animation(struct Thing *thing)
 {
     SYNCDBG(18,"Starting for %s",thing_model_name(thing));
@@ -1682,6 +1703,9 @@ void clear_things_and_persons_data(void)
     {
       memset(&game.cctrl_data[i], 0, sizeof(struct CreatureControl));
     }
+    invalidate_thing_lists_index();
+    invalidate_all_room_slabs_index();
+    invalidate_replay_integrity();
 }
 
 void clear_computer(void)
@@ -1813,6 +1837,7 @@ void clear_game(void)
     clear_slabsets();
     game.skip_initial_input_turns = 0;
     clear_input_lag_queue();
+    rollback_reset();
 }
 
 void clear_game_for_save(void)
@@ -2724,6 +2749,44 @@ void update_global_lighting()
     }
 }
 
+/**
+ * Runs game logic for one turn, after the packets of the turn were processed.
+ * Everything done here must give the same results for all players of a network game;
+ * this is also used to simulate turns again after rollback.
+ */
+void process_game_turn(void)
+{
+    // Changes done while processing packets
+    process_navigation_updates();
+    clear_active_dungeons_stats();
+    update_creature_pool_state();
+    if ((game.play_gameturn & 0x01) != 0)
+        update_animating_texture_maps();
+    update_things();
+    process_rooms();
+    process_dungeons();
+    update_research();
+    update_manufacturing();
+    event_process_events();
+    update_all_events();
+    process_level_script();
+    process_fx_lines();
+    lua_on_game_tick();
+    if ((game.view_mode_flags & GNFldD_ComputerPlayerProcessing) != 0)
+        process_computer_players2();
+    process_players();
+    process_action_points();
+    process_armageddon();
+    update_global_lighting();
+    process_navigation_updates();
+#if (BFDEBUG_LEVEL > 9)
+    lights_stats_debug_dump();
+    things_stats_debug_dump();
+    creature_stats_debug_dump();
+#endif
+    game.play_gameturn++;
+}
+
 void update(void)
 {
     struct PlayerInfo *player;
@@ -2749,24 +2812,7 @@ void update(void)
             PaletteSetPlayerPalette(player, engine_palette);
             clear_flag(player->additional_flags, PlaAF_LightningPaletteIsActive);
         }
-        clear_active_dungeons_stats();
-        update_creature_pool_state();
-        if ((game.play_gameturn & 0x01) != 0)
-            update_animating_texture_maps();
-        update_things();
-        process_rooms();
-        process_dungeons();
-        update_research();
-        update_manufacturing();
-        event_process_events();
-        update_all_events();
-        process_level_script();
-        process_fx_lines();
-        lua_on_game_tick();
-        if ((game.view_mode_flags & GNFldD_ComputerPlayerProcessing) != 0)
-            process_computer_players2();
-        process_players();
-        process_action_points();
+        process_game_turn();
         player = get_my_player();
         if (player->view_mode == PVM_CreatureView)
         {
@@ -2775,14 +2821,6 @@ void update(void)
         }
         update_footsteps_nearest_camera(player->acamera);
         PaletteFadePlayer(player);
-        process_armageddon();
-        update_global_lighting();
-#if (BFDEBUG_LEVEL > 9)
-        lights_stats_debug_dump();
-        things_stats_debug_dump();
-        creature_stats_debug_dump();
-#endif
-        game.play_gameturn++;
     }
 
     message_update();
@@ -3459,6 +3497,7 @@ TbBool keeper_wait_for_screen_focus(void)
 
 void gameplay_loop_logic()
 {
+    process_finished_saves();
     if(flag_is_set(start_params.debug_flags, DFlg_PauseAtGameTurn))
     {
         static GameTurn previous_gameturn = 0;
@@ -4086,6 +4125,11 @@ short reset_game(void)
     SYNCDBG(6,"Starting");
 
     KeeperSpeechExit();
+    free_save_writer();
+    free_map_blocks();
+    free_mapwho_sweeps_cache();
+    free_room_slabs_index();
+    LbJobsFree();
 
     LbMouseSuspend();
     LbIKeyboardClose();
@@ -4216,6 +4260,27 @@ short process_command_line(unsigned short argc, char *argv[])
          set_flag(start_params.debug_flags, DFlg_ShowGameTurns | DFlg_FrameStep);
          narg++;
       } else
+      if (strcasecmp(parstr,"packetverify") == 0)
+      {
+         // Plays the whole packet file as fast as possible and quits; for regression tools
+         start_params.packet_load_enable = true;
+         start_params.packet_save_enable = false;
+         start_params.packet_checksum_verify = 1;
+         start_params.packet_verify = true;
+         snprintf(start_params.packet_fname, sizeof(start_params.packet_fname), "%s", pr2str);
+         set_flag(start_params.operation_flags, GOF_SingleLevel);
+         narg++;
+      } else
+      if (strcasecmp(parstr,"packetfullscan") == 0)
+      {
+         // Computes replay checksums by scanning all things, to validate the ones kept up to date
+         start_params.packet_checksum_full_scan = true;
+      } else
+      if (strcasecmp(parstr,"rollback") == 0)
+      {
+         // Predicts late packets in network games instead of waiting; the host's choice is used by everyone
+         start_params.net_rollback = true;
+      } else
       if (strcasecmp(parstr,"packetsave") == 0)
       {
          if (start_params.packet_load_enable)
@@ -4528,16 +4593,21 @@ int LbBullfrogMain(unsigned short argc, char *argv[])
     {
         SYNCDBG(0,"finished properly");
     }
+    if (start_params.packet_verify)
+        retval = report_replay_verification();
+    else
+        retval = 0;
 
     LbErrorLogClose();
     steam_api_shutdown();
-    return 0;
+    return retval;
 }
 
 int kfxmain(int argc, char *argv[])
 {
+  int retval;
   try {
-  LbBullfrogMain(argc, argv);
+  retval = LbBullfrogMain(argc, argv);
   } catch (...)
   {
       error_dialog(__func__, 1, "Exception raised!");
@@ -4552,7 +4622,7 @@ int kfxmain(int argc, char *argv[])
   }
 #endif
 
-  return 0;
+  return retval;
 }
 
 void update_time(void)
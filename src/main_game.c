@@ -40,6 +40,7 @@
 #include "lua_base.h"
 #include "lua_triggers.h"
 #include "net_resync.h"
+#include "room_data.h"
 #include "room_library.h"
 #include "room_list.h"
 #include "power_specials.h"
@@ -150,6 +151,9 @@ void init_lookups(void)
         game.columns.lookup[i] = &game.columns_data[i];
     }
     game.columns.end = &game.columns_data[COLUMNS_COUNT];
+    invalidate_columns_index();
+    invalidate_thing_lists_index();
+    invalidate_all_room_slabs_index();
 }
 
 static void init_level(void)
@@ -334,6 +338,8 @@ void startup_saved_packet_game(void)
         game.game_kind = GKind_LocalGame;
     if (game.turns_stored < game.turns_fastforward)
         game.turns_fastforward = game.turns_stored;
+    if (start_params.packet_verify)
+        start_replay_verification();
     post_init_level();
     post_init_players();
     set_selected_level_number(0);
@@ -647,6 +647,7 @@ void delete_column(ColumnIndex col_idx)
     col = &game.columns_data[col_idx];
     memcpy(col, &game.columns_data[0], sizeof(struct Column));
     col->use = 0;
+    update_column_in_index(col_idx);
 }
 
 void remove_block_from_map_element(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
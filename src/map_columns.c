@@ -30,6 +30,26 @@
 extern "C" {
 #endif
 /******************************************************************************/
+/** Amount of buckets in the columns content index; needs to be a power of two. */
+#define COLUMNS_HASH_SIZE COLUMNS_COUNT
+
+/**
+ * Index of columns by their content, for find_column(), and a hint for create_column().
+ * It is derived from game.columns_data and isn't saved; it is rebuilt when first needed
+ * after invalidate_columns_index().
+ */
+struct ColumnsIndex {
+    /** First column in each bucket; chains are sorted by column index. */
+    ColumnIndex bucket_head[COLUMNS_HASH_SIZE];
+    ColumnIndex next[COLUMNS_COUNT];
+    unsigned short bucket[COLUMNS_COUNT];
+    /** No column below this one is free. */
+    ColumnIndex first_free;
+    TbBool valid;
+};
+
+static struct ColumnsIndex columns_index;
+/******************************************************************************/
 struct Column *get_column(long idx)
 {
   if ((idx < 1) || (idx >= COLUMNS_COUNT))
@@ -273,15 +293,102 @@ static TbBool column_is_equivalent(struct Column * const src, struct Column *dst
     return 0 == memcmp(src->cubes, dst->cubes, sizeof(src->cubes));
 }
 
+static unsigned short column_hash(const struct Column *col)
+{
+    // FNV-1a over the fields compared by column_is_equivalent()
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ col->floor_texture) * 16777619u;
+    hash = (hash ^ col->solidmask) * 16777619u;
+    hash = (hash ^ col->orient) * 16777619u;
+    for (int i = 0; i < COLUMN_STACK_HEIGHT; i++) {
+        hash = (hash ^ col->cubes[i]) * 16777619u;
+    }
+    return (hash ^ (hash >> 16)) & (COLUMNS_HASH_SIZE - 1);
+}
+
+static TbBool column_is_free(const struct Column *col)
+{
+    return (col->use == 0) && ((col->bitfields & CLF_ACTIVE) == 0);
+}
+
+static void columns_index_unlink(ColumnIndex col_idx)
+{
+    ColumnIndex *prev = &columns_index.bucket_head[columns_index.bucket[col_idx]];
+    while (*prev != 0)
+    {
+        if (*prev == col_idx) {
+            *prev = columns_index.next[col_idx];
+            break;
+        }
+        prev = &columns_index.next[*prev];
+    }
+    columns_index.next[col_idx] = 0;
+}
+
+static void columns_index_link(ColumnIndex col_idx)
+{
+    unsigned short bucket = column_hash(&game.columns_data[col_idx]);
+    ColumnIndex *prev = &columns_index.bucket_head[bucket];
+    // Keep the chain sorted, so the first match is the same column a linear search would find
+    while ((*prev != 0) && (*prev < col_idx))
+        prev = &columns_index.next[*prev];
+    columns_index.next[col_idx] = *prev;
+    *prev = col_idx;
+    columns_index.bucket[col_idx] = bucket;
+}
+
+static void rebuild_columns_index(void)
+{
+    memset(columns_index.bucket_head, 0, sizeof(columns_index.bucket_head));
+    // Going backwards, prepending keeps the chains sorted
+    for (ColumnIndex i = COLUMNS_COUNT - 1; i > 0; i--)
+    {
+        unsigned short bucket = column_hash(&game.columns_data[i]);
+        columns_index.next[i] = columns_index.bucket_head[bucket];
+        columns_index.bucket_head[bucket] = i;
+        columns_index.bucket[i] = bucket;
+    }
+    columns_index.next[0] = 0;
+    columns_index.first_free = 1;
+    columns_index.valid = true;
+}
+
+/**
+ * Marks the columns index as out of date. Needs to be called after columns_data
+ * is changed in bulk, like when it is loaded or cleared.
+ */
+void invalidate_columns_index(void)
+{
+    columns_index.valid = false;
+}
+
+/**
+ * Updates the columns index after content of a single column was changed.
+ */
+void update_column_in_index(ColumnIndex col_idx)
+{
+    if (!columns_index.valid || (col_idx <= 0) || (col_idx >= COLUMNS_COUNT))
+        return;
+    columns_index_unlink(col_idx);
+    columns_index_link(col_idx);
+    if (column_is_free(&game.columns_data[col_idx]) && (col_idx < columns_index.first_free))
+        columns_index.first_free = col_idx;
+}
+
+/**
+ * Returns the lowest index of a column with the same content as given one, or 0 if there's none.
+ */
 long find_column(struct Column *srccol)
 {
-    int i;
-    for (i=1; i < COLUMNS_COUNT; i++) {
-        struct Column *col;
-        col = get_column(i);
-        if (column_is_equivalent(srccol, col)) {
+    if (!columns_index.valid)
+        rebuild_columns_index();
+    ColumnIndex i = columns_index.bucket_head[column_hash(srccol)];
+    while (i != 0)
+    {
+        if (column_is_equivalent(srccol, &game.columns_data[i])) {
           return i;
         }
+        i = columns_index.next[i];
     }
     return 0;
 }
@@ -293,19 +400,23 @@ long create_column(struct Column *col)
     unsigned char cube_index;
     unsigned char top_of_floor;
 
+    if (!columns_index.valid)
+        rebuild_columns_index();
     // Find an empty column
-    result = 1;
-    dst = &game.columns_data[1];
-    while (dst->use || dst->bitfields & CLF_ACTIVE )
+    result = columns_index.first_free;
+    dst = &game.columns_data[result];
+    while (!column_is_free(dst))
     {
         ++result;
         ++dst;
         if ( result >= COLUMNS_COUNT )
         {
+            columns_index.first_free = COLUMNS_COUNT;
             ERRORLOG("Could not create column: None free");
             return 0;
         }
     }
+    columns_index.first_free = result;
     // Copy data
     memcpy(dst, col, sizeof(struct Column));
     // Create cubemask
@@ -354,6 +465,7 @@ long create_column(struct Column *col)
             }
         }
     }
+    update_column_in_index(result);
     return result;
 }
 
@@ -373,6 +485,7 @@ void clear_columns(void)
   {
     game.col_static_entries[i] = 0;
   }
+  invalidate_columns_index();
 }
 
 void init_columns(void)
@@ -431,6 +544,8 @@ void init_columns(void)
             }
         }
     }
+    // Solid masks were remade
+    invalidate_columns_index();
 }
 
 void init_whole_blocks(void)
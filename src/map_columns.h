@@ -68,6 +68,8 @@ void clear_columns(void);
 void init_columns(void);
 long find_column(struct Column *col);
 long create_column(struct Column *col);
+void invalidate_columns_index(void);
+void update_column_in_index(ColumnIndex col_idx);
 unsigned short find_column_height(struct Column *col);
 void init_whole_blocks(void);
 void init_top_texture_to_cube_table(void);
@@ -43,6 +43,13 @@ MapSubtlCoord map_subtiles_z = 8;
 
 NavColour *IanMap = NULL;
 long nav_map_initialised = 0;
+
+/** Map blocks of the current map, (map_subtiles_x+1)*(map_subtiles_y+1) of them; see alloc_map_blocks(). */
+struct Map *map_blocks = NULL;
+/** Navigation colours of the current map; same size as map_blocks, but remade from them after loading. */
+NavColour *navigation_map = NULL;
+/** Amount of entries allocated in map_blocks and navigation_map. */
+static unsigned long map_blocks_count = 0;
 /******************************************************************************/
 /**
  * Returns if the subtile coords are in range of subtiles which have slab entry.
@@ -73,14 +80,14 @@ struct Map *get_map_block_at(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
       return INVALID_MAP_BLOCK;
   if ((stl_y < 0) || (stl_y > game.map_subtiles_y))
       return INVALID_MAP_BLOCK;
-  return &game.map[get_subtile_number(stl_x,stl_y)];
+  return &map_blocks[get_subtile_number(stl_x,stl_y)];
 }
 
 struct Map *get_map_block_at_pos(SubtlCodedCoords stl_num)
 {
   if ((stl_num < 0) || (stl_num > get_subtile_number(game.map_subtiles_x,game.map_subtiles_y)))
       return INVALID_MAP_BLOCK;
-  return &game.map[stl_num];
+  return &map_blocks[stl_num];
 }
 
 TbBool map_block_invalid(const struct Map *map)
@@ -89,7 +96,7 @@ TbBool map_block_invalid(const struct Map *map)
     return true;
   if (map == INVALID_MAP_BLOCK)
     return true;
-  return (map < &game.map[0]);
+  return (map < &map_blocks[0]);
 }
 
 NavColour get_navigation_map(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
@@ -98,7 +105,7 @@ NavColour get_navigation_map(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
       return 0;
   if ((stl_y < 0) || (stl_y > game.map_subtiles_y))
       return 0;
-  return game.navigation_map[navmap_tile_number(stl_x,stl_y)];
+  return navigation_map[navmap_tile_number(stl_x,stl_y)];
 }
 
 void set_navigation_map(MapSubtlCoord stl_x, MapSubtlCoord stl_y, NavColour navcolour)
@@ -107,7 +114,7 @@ void set_navigation_map(MapSubtlCoord stl_x, MapSubtlCoord stl_y, NavColour navc
       return;
   if ((stl_y < 0) || (stl_y > game.map_subtiles_y))
       return;
-  game.navigation_map[navmap_tile_number(stl_x,stl_y)] = navcolour;
+  navigation_map[navmap_tile_number(stl_x,stl_y)] = navcolour;
 }
 
 unsigned long get_navigation_map_floor_height(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
@@ -118,7 +125,7 @@ unsigned long get_navigation_map_floor_height(MapSubtlCoord stl_x, MapSubtlCoord
 long get_ceiling_height(const struct Coord3d *pos)
 {
     long i = get_subtile_number(pos->x.stl.num, pos->y.stl.num);
-    return game.map[i].filled_subtiles * COORD_PER_STL;
+    return map_blocks[i].filled_subtiles * COORD_PER_STL;
 }
 
 ThingIndex get_mapwho_thing_index(const struct Map *mapblk)
@@ -558,27 +565,18 @@ MapSubtlCoord stl_slab_ending_subtile(MapSubtlCoord stl_v)
 
 void clear_mapwho(void)
 {
-    for (MapSubtlCoord y = 0; y < (game.map_subtiles_y + 1); y++)
+    for (unsigned long i = 0; i < map_blocks_count; i++)
     {
-        for (MapSubtlCoord x = 0; x < (game.map_subtiles_x + 1); x++)
-        {
-            struct Map* mapblk = &game.map[get_subtile_number(x, y)];
-            mapblk->mapwho = 0;
-        }
-  }
+        map_blocks[i].mapwho = 0;
+    }
 }
 
 void clear_mapmap(void)
 {
-    for (unsigned long y = 0; y < (game.map_subtiles_y + 1); y++)
+    if (map_blocks_count > 0)
     {
-        for (unsigned long x = 0; x < (game.map_subtiles_x + 1); x++)
-        {
-            struct Map* mapblk = get_map_block_at(x, y);
-            NavColour* flg = &game.navigation_map[get_subtile_number(x, y)];
-            memset(mapblk, 0, sizeof(struct Map));
-            *flg = 0;
-        }
+        memset(map_blocks, 0, map_blocks_count * sizeof(struct Map));
+        memset(navigation_map, 0, map_blocks_count * sizeof(NavColour));
     }
     clear_subtiles_lightness(&game.lish);
 }
@@ -861,6 +859,7 @@ void set_map_size(MapSlabCoord x,MapSlabCoord y)
 
     game.navigation_map_size_x = game.map_subtiles_x + 1;
     game.navigation_map_size_y = game.map_subtiles_y + 1;
+    alloc_map_blocks();
 
     game.small_around_slab[0] = -game.map_tiles_x;
     game.small_around_slab[1] = 1;
@@ -907,6 +906,50 @@ void init_map_size(LevelNumber lvnum)
         set_map_size(lvinfo->mapsize_x,lvinfo->mapsize_y);
 }
 
+/**
+ * Makes map_blocks and navigation_map fit the map size stored in the game structure.
+ * The arrays are cleared if their size has to change; otherwise they are left intact,
+ * so this may be called whenever map size could have been restored from a saved state.
+ */
+TbBool alloc_map_blocks(void)
+{
+    unsigned long count = (unsigned long)(game.map_subtiles_x + 1) * (game.map_subtiles_y + 1);
+    if ((count == map_blocks_count) && (map_blocks != NULL))
+        return true;
+    free_map_blocks();
+    map_blocks = (struct Map *)KfxCalloc(count, sizeof(struct Map));
+    navigation_map = (NavColour *)KfxCalloc(count, sizeof(NavColour));
+    if ((map_blocks == NULL) || (navigation_map == NULL))
+    {
+        ERRORLOG("Cannot allocate map blocks for %dx%d subtiles",(int)game.map_subtiles_x,(int)game.map_subtiles_y);
+        free_map_blocks();
+        return false;
+    }
+    map_blocks_count = count;
+    IanMap = navigation_map;
+    SYNCDBG(8,"Allocated %lu map blocks",count);
+    return true;
+}
+
+void free_map_blocks(void)
+{
+    KfxFree(map_blocks);
+    KfxFree(navigation_map);
+    map_blocks = NULL;
+    navigation_map = NULL;
+    IanMap = NULL;
+    map_blocks_count = 0;
+}
+
+/**
+ * Gives size of the map blocks array which is in use; only this part of the
+ * map data is stored in saves and sent between players.
+ */
+unsigned long map_blocks_data_size(void)
+{
+    return map_blocks_count * sizeof(struct Map);
+}
+
 /******************************************************************************/
 #ifdef __cplusplus
 }
@@ -60,6 +60,8 @@ extern struct Map bad_map_block;
 extern MapSubtlCoord map_subtiles_z;
 extern NavColour *IanMap;
 extern long nav_map_initialised;
+extern struct Map *map_blocks;
+extern NavColour *navigation_map;
 /******************************************************************************/
 /** Convert subtile to slab. */
 #define subtile_slab(stl) ((stl)/STL_PER_SLB)
@@ -151,6 +153,9 @@ void clear_mapwho(void);
 void clear_mapmap(void);
 
 void set_map_size(MapSlabCoord slb_x,MapSlabCoord slb_y);
+TbBool alloc_map_blocks(void);
+void free_map_blocks(void);
+unsigned long map_blocks_data_size(void);
 void init_map_size(LevelNumber lvnum);
 /******************************************************************************/
 #ifdef __cplusplus
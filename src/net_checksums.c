@@ -29,6 +29,7 @@
 #include "creature_control.h"
 #include "frontend.h"
 #include "thing_list.h"
+#include "net_rollback.h"
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -103,21 +104,9 @@ static TbBigChecksum get_room_checksum(const struct Room* room) {
 
 static TbBigChecksum compute_things_list_checksum(struct StructureList *list) {
     TbBigChecksum sum = 0;
-    unsigned long k = 0;
-    int i = list->index;
-    while (i != 0) {
-        struct Thing* thing = thing_get(i);
-        if (thing_is_invalid(thing)) {
-            ERRORLOG("Jump to invalid thing detected in list");
-            break;
-        }
-        i = thing->next_of_class;
+    struct ThingListSweep sweep;
+    for (struct Thing* thing = thing_list_sweep_first(&sweep, list); thing != NULL; thing = thing_list_sweep_next(&sweep)) {
         sum += get_thing_checksum(thing);
-        k++;
-        if (k > THINGS_COUNT) {
-            ERRORLOG("Infinite loop detected in thing list");
-            break;
-        }
     }
     return sum;
 }
@@ -159,6 +148,15 @@ static struct ChecksumSnapshot* find_snapshot(GameTurn turn) {
     return NULL;
 }
 
+/**
+ * Returns how many turns old the state is whose checksum gets sent in packets.
+ * In rollback mode the current state may still change, but the one from before
+ * the limit of predicted turns cannot.
+ */
+static GameTurn get_checksum_delay_turns(void) {
+    return rollback_enabled() ? ROLLBACK_MAX_TURNS : 0;
+}
+
 short checksums_different(void) {
     int host_player_id = get_host_player_id();
     struct Packet* host_packet = get_packet(host_player_id);
@@ -178,7 +176,7 @@ short checksums_different(void) {
         }
         if (packet->checksum != host_checksum) {
             ERRORLOG("Checksums %08x(Host) != %08x(Client) turn: %d vs %d", host_checksum, packet->checksum, host_packet->turn, packet->turn);
-            desync_turn = host_packet->turn;
+            desync_turn = host_packet->turn - get_checksum_delay_turns();
             mismatch = true;
         }
     }
@@ -186,7 +184,12 @@ short checksums_different(void) {
 }
 
 void update_turn_checksums(void) {
-    struct ChecksumSnapshot* snapshot = &snapshot_buffer[snapshot_head];
+    // Turns simulated again after rollback replace their previous snapshot
+    struct ChecksumSnapshot* snapshot = find_snapshot(game.play_gameturn);
+    if (snapshot == NULL) {
+        snapshot = &snapshot_buffer[snapshot_head];
+        snapshot_head = (snapshot_head + 1) % SNAPSHOT_BUFFER_SIZE;
+    }
     struct LogDetailedSnapshot* snapshot_info = &snapshot->log_details;
     snapshot->turn = game.play_gameturn;
     snapshot->valid = true;
@@ -237,8 +240,17 @@ void update_turn_checksums(void) {
             room_snapshot->checksum = get_room_checksum(room);
         }
     }
-    snapshot_head = (snapshot_head + 1) % SNAPSHOT_BUFFER_SIZE;
 
+    GameTurn delay = get_checksum_delay_turns();
+    if (delay > 0) {
+        snapshot = (game.play_gameturn >= delay) ? find_snapshot(game.play_gameturn - delay) : NULL;
+    }
+    struct Packet* packet = get_packet(my_player_number);
+    packet->checksum = 0;
+    if (snapshot == NULL) {
+        MULTIPLAYER_LOG("update_turn_checksums: turn=%lu no checksum yet", (unsigned long)game.play_gameturn);
+        return;
+    }
     struct DesyncChecksums* checksums = &snapshot->checksums;
     TbBigChecksum things_sum = 0;
     things_sum += checksums->creatures;
@@ -250,8 +262,6 @@ void update_turn_checksums(void) {
     things_sum += checksums->effect_gens;
     things_sum += checksums->doors;
 
-    struct Packet* packet = get_packet(my_player_number);
-    packet->checksum = 0;
     packet->checksum += things_sum;
     packet->checksum += checksums->rooms;
     packet->checksum += checksums->players;
@@ -37,6 +37,7 @@
 #include "game_legacy.h"
 #include "net_input_lag.h"
 #include "net_checksums.h"
+#include "net_rollback.h"
 #include "keeperfx.hpp"
 #include "post_inc.h"
 
@@ -207,10 +208,12 @@ void sync_various_data()
    struct {
       uint32_t action_random_seed;
       int input_lag_turns;
+      TbBool rollback;
    } initial_sync_data;
 
    initial_sync_data.action_random_seed = game.action_random_seed;
    initial_sync_data.input_lag_turns = game.input_lag_turns;
+   initial_sync_data.rollback = start_params.net_rollback;
    if (!LbNetwork_Resync(&initial_sync_data, sizeof(initial_sync_data))) {
       ERRORLOG("Initial sync failed");
       return;
@@ -220,7 +223,8 @@ void sync_various_data()
    game.player_random_seed = game.action_random_seed * 9473 + 9479;
    game.input_lag_turns = initial_sync_data.input_lag_turns;
    game.skip_initial_input_turns = calculate_skip_input();
-   NETLOG("Initial network state synced: action_seed=%u, input_lag=%d", game.action_random_seed, game.input_lag_turns);
+   rollback_set_enabled(initial_sync_data.rollback);
+   NETLOG("Initial network state synced: action_seed=%u, input_lag=%d, rollback=%d", game.action_random_seed, game.input_lag_turns, (int)rollback_enabled());
 }
 /******************************************************************************/
 #ifdef __cplusplus
@@ -62,45 +62,211 @@ void store_sent_packet(PlayerNumber player, const struct Packet* packet) {
     }
 }
 
+/**
+ * Bundled packets are sent every turn, so they're encoded compactly.
+ * The header byte holds the amount of packets, and a bit for each which is empty (all zero) and has no data.
+ * Packets follow from the oldest; each is encoded against the one before it (or zeros for the oldest):
+ * a varint mask of fields which differ, then these fields. Integers are zigzag varints of the difference,
+ * control flags a varint of the changed bits, the checksum its 4 bytes, and byte fields themselves.
+ */
+enum BundledPacketField {
+    BPF_Turn = 0,
+    BPF_Checksum,
+    BPF_Action,
+    BPF_ActnPar1,
+    BPF_ActnPar2,
+    BPF_PosX,
+    BPF_PosY,
+    BPF_ControlFlags,
+    BPF_AddValues,
+    BPF_ActnPar3,
+    BPF_ActnPar4,
+};
+
+#define BUNDLE_COUNT_MASK 0x03
+#define BUNDLE_EMPTY_SHIFT 2
+
+struct BundleReader {
+    const unsigned char* ptr;
+    const unsigned char* end;
+    TbBool ok;
+};
+
+static unsigned char* write_varint(unsigned char* ptr, uint32_t value) {
+    while (value >= 0x80) {
+        *ptr++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *ptr++ = (unsigned char)value;
+    return ptr;
+}
+
+static unsigned char* write_delta(unsigned char* ptr, uint32_t value, uint32_t ref) {
+    int32_t delta = (int32_t)(value - ref);
+    return write_varint(ptr, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+}
+
+static uint32_t read_varint(struct BundleReader* rd) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (rd->ptr >= rd->end) {
+            rd->ok = false;
+            return 0;
+        }
+        unsigned char c = *rd->ptr++;
+        value |= (uint32_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            return value;
+        }
+    }
+    rd->ok = false;
+    return 0;
+}
+
+static uint32_t read_delta(struct BundleReader* rd, uint32_t ref) {
+    uint32_t zigzag = read_varint(rd);
+    int32_t delta = (int32_t)((zigzag >> 1) ^ (0U - (zigzag & 1)));
+    return ref + (uint32_t)delta;
+}
+
+static unsigned char read_byte(struct BundleReader* rd) {
+    if (rd->ptr >= rd->end) {
+        rd->ok = false;
+        return 0;
+    }
+    return *rd->ptr++;
+}
+
+static unsigned char* encode_packet(unsigned char* ptr, const struct Packet* packet, const struct Packet* ref) {
+    unsigned long mask = 0;
+    if (packet->turn != ref->turn) { mask |= 1UL << BPF_Turn; }
+    if (packet->checksum != ref->checksum) { mask |= 1UL << BPF_Checksum; }
+    if (packet->action != ref->action) { mask |= 1UL << BPF_Action; }
+    if (packet->actn_par1 != ref->actn_par1) { mask |= 1UL << BPF_ActnPar1; }
+    if (packet->actn_par2 != ref->actn_par2) { mask |= 1UL << BPF_ActnPar2; }
+    if (packet->pos_x != ref->pos_x) { mask |= 1UL << BPF_PosX; }
+    if (packet->pos_y != ref->pos_y) { mask |= 1UL << BPF_PosY; }
+    if (packet->control_flags != ref->control_flags) { mask |= 1UL << BPF_ControlFlags; }
+    if (packet->additional_packet_values != ref->additional_packet_values) { mask |= 1UL << BPF_AddValues; }
+    if (packet->actn_par3 != ref->actn_par3) { mask |= 1UL << BPF_ActnPar3; }
+    if (packet->actn_par4 != ref->actn_par4) { mask |= 1UL << BPF_ActnPar4; }
+    ptr = write_varint(ptr, mask);
+    if (mask & (1UL << BPF_Turn)) { ptr = write_delta(ptr, packet->turn, ref->turn); }
+    if (mask & (1UL << BPF_Checksum)) {
+        memcpy(ptr, &packet->checksum, sizeof(TbBigChecksum));
+        ptr += sizeof(TbBigChecksum);
+    }
+    if (mask & (1UL << BPF_Action)) { *ptr++ = packet->action; }
+    if (mask & (1UL << BPF_ActnPar1)) { ptr = write_delta(ptr, packet->actn_par1, ref->actn_par1); }
+    if (mask & (1UL << BPF_ActnPar2)) { ptr = write_delta(ptr, packet->actn_par2, ref->actn_par2); }
+    if (mask & (1UL << BPF_PosX)) { ptr = write_delta(ptr, packet->pos_x, ref->pos_x); }
+    if (mask & (1UL << BPF_PosY)) { ptr = write_delta(ptr, packet->pos_y, ref->pos_y); }
+    if (mask & (1UL << BPF_ControlFlags)) { ptr = write_varint(ptr, packet->control_flags ^ ref->control_flags); }
+    if (mask & (1UL << BPF_AddValues)) { *ptr++ = packet->additional_packet_values; }
+    if (mask & (1UL << BPF_ActnPar3)) { ptr = write_delta(ptr, packet->actn_par3, ref->actn_par3); }
+    if (mask & (1UL << BPF_ActnPar4)) { ptr = write_delta(ptr, packet->actn_par4, ref->actn_par4); }
+    return ptr;
+}
+
+static void decode_packet(struct BundleReader* rd, struct Packet* packet, const struct Packet* ref) {
+    *packet = *ref;
+    uint32_t mask = read_varint(rd);
+    if (mask & (1UL << BPF_Turn)) { packet->turn = read_delta(rd, ref->turn); }
+    if (mask & (1UL << BPF_Checksum)) {
+        if (rd->end - rd->ptr < (long)sizeof(TbBigChecksum)) {
+            rd->ok = false;
+            return;
+        }
+        memcpy(&packet->checksum, rd->ptr, sizeof(TbBigChecksum));
+        rd->ptr += sizeof(TbBigChecksum);
+    }
+    if (mask & (1UL << BPF_Action)) { packet->action = read_byte(rd); }
+    if (mask & (1UL << BPF_ActnPar1)) { packet->actn_par1 = read_delta(rd, ref->actn_par1); }
+    if (mask & (1UL << BPF_ActnPar2)) { packet->actn_par2 = read_delta(rd, ref->actn_par2); }
+    if (mask & (1UL << BPF_PosX)) { packet->pos_x = read_delta(rd, ref->pos_x); }
+    if (mask & (1UL << BPF_PosY)) { packet->pos_y = read_delta(rd, ref->pos_y); }
+    if (mask & (1UL << BPF_ControlFlags)) { packet->control_flags = read_varint(rd) ^ ref->control_flags; }
+    if (mask & (1UL << BPF_AddValues)) { packet->additional_packet_values = read_byte(rd); }
+    if (mask & (1UL << BPF_ActnPar3)) { packet->actn_par3 = read_delta(rd, ref->actn_par3); }
+    if (mask & (1UL << BPF_ActnPar4)) { packet->actn_par4 = read_delta(rd, ref->actn_par4); }
+}
+
+/**
+ * Encodes current packet of given player, with the ones sent in previous turns, into the buffer.
+ * @param out_buffer Buffer for the result, at least BUNDLED_PACKETS_MAX_SIZE bytes.
+ * @return Size of the encoded bundle.
+ */
 size_t bundle_packets(PlayerNumber player, const struct Packet* current_packet, char* out_buffer) {
     if (player < 0 || player >= MAX_N_USERS) {
         return 0;
     }
     struct PacketHistory* history = &packet_history[player];
-    struct BundledPacket bundled;
-    bundled.valid_count = 1;
-    memcpy(&bundled.packets[0], current_packet, sizeof(struct Packet));
-    if (history->valid_count >= 1) {
-        int prev_index = (history->write_index - 1 + HISTORY_SIZE) % HISTORY_SIZE;
-        memcpy(&bundled.packets[1], &history->packets[prev_index], sizeof(struct Packet));
-        bundled.valid_count += 1;
+    const struct Packet* packets[REDUNDANT_PACKET_COUNT];
+    int count = 1;
+    packets[0] = current_packet;
+    for (int i = 1; (i < REDUNDANT_PACKET_COUNT) && (i <= history->valid_count); i += 1) {
+        packets[i] = &history->packets[(history->write_index - i + HISTORY_SIZE) % HISTORY_SIZE];
+        count += 1;
     }
-    if (history->valid_count >= 2) {
-        int prev_prev_index = (history->write_index - 2 + HISTORY_SIZE) % HISTORY_SIZE;
-        memcpy(&bundled.packets[2], &history->packets[prev_prev_index], sizeof(struct Packet));
-        bundled.valid_count += 1;
+    unsigned char* header = (unsigned char*)out_buffer;
+    unsigned char* ptr = header + 1;
+    *header = count;
+    struct Packet empty;
+    memset(&empty, 0, sizeof(struct Packet));
+    const struct Packet* ref = &empty;
+    for (int i = count - 1; i >= 0; i -= 1) {
+        if (is_packet_empty(packets[i])) {
+            *header |= 1 << (BUNDLE_EMPTY_SHIFT + i);
+            ref = &empty;
+            continue;
+        }
+        ptr = encode_packet(ptr, packets[i], ref);
+        ref = packets[i];
     }
-    memcpy(out_buffer, &bundled, sizeof(struct BundledPacket));
-    return sizeof(struct BundledPacket);
+    return ptr - (unsigned char*)out_buffer;
 }
 
-void unbundle_packets(const char* bundled_buffer, PlayerNumber source_player) {
+/**
+ * Decodes packets bundled by another player, storing the ones not received before.
+ * @param current_packet Gets the newest packet of the bundle.
+ * @return False if the bundle is malformed.
+ */
+TbBool unbundle_packets(const char* bundled_buffer, size_t buf_size, PlayerNumber source_player, struct Packet* current_packet) {
     if (source_player < 0 || source_player >= MAX_N_USERS) {
-        return;
+        return false;
     }
-    struct BundledPacket bundled;
-    memcpy(&bundled, bundled_buffer, sizeof(struct BundledPacket));
-    if (bundled.valid_count > REDUNDANT_PACKET_COUNT) {
-        return;
+    struct BundleReader rd;
+    rd.ptr = (const unsigned char*)bundled_buffer;
+    rd.end = rd.ptr + buf_size;
+    rd.ok = true;
+    unsigned char header = read_byte(&rd);
+    int count = header & BUNDLE_COUNT_MASK;
+    if (!rd.ok || (count < 1) || (count > REDUNDANT_PACKET_COUNT)) {
+        return false;
+    }
+    struct Packet packets[REDUNDANT_PACKET_COUNT];
+    struct Packet empty;
+    memset(&empty, 0, sizeof(struct Packet));
+    const struct Packet* ref = &empty;
+    for (int i = count - 1; i >= 0; i -= 1) {
+        if ((header & (1 << (BUNDLE_EMPTY_SHIFT + i))) != 0) {
+            packets[i] = empty;
+        } else {
+            decode_packet(&rd, &packets[i], ref);
+            if (!rd.ok) {
+                return false;
+            }
+        }
+        ref = &packets[i];
     }
-    int i;
-    for (i = 0; i < bundled.valid_count; i += 1) {
-        const struct Packet* packet = &bundled.packets[i];
-        const struct Packet* existing = get_received_packet_for_player(packet->turn, source_player);
+    for (int i = 0; i < count; i += 1) {
+        const struct Packet* existing = get_received_packet_for_player(packets[i].turn, source_player);
         if (existing == NULL) {
-            store_received_packet(packet->turn, source_player, packet);
+            store_received_packet(packets[i].turn, source_player, &packets[i]);
         }
     }
+    *current_packet = packets[0];
+    return true;
 }
 
 /******************************************************************************/
@@ -28,22 +28,15 @@ extern "C" {
 #endif
 
 /******************************************************************************/
-#pragma pack(1)
-
 #define REDUNDANT_PACKET_COUNT 3
-
-struct BundledPacket {
-    unsigned char valid_count;
-    struct Packet packets[REDUNDANT_PACKET_COUNT];
-};
-
-#pragma pack()
+/** Largest size of bundled packets; header, then for each packet a field mask and fields as at most 5 byte varints. */
+#define BUNDLED_PACKETS_MAX_SIZE (1 + REDUNDANT_PACKET_COUNT * (3 + 11 * 5))
 /******************************************************************************/
 void initialize_redundant_packets(void);
 void clear_redundant_packets(void);
 void store_sent_packet(PlayerNumber player, const struct Packet* packet);
 size_t bundle_packets(PlayerNumber player, const struct Packet* current_packet, char* out_buffer);
-void unbundle_packets(const char* bundled_buffer, PlayerNumber source_player);
+TbBool unbundle_packets(const char* bundled_buffer, size_t buf_size, PlayerNumber source_player, struct Packet* current_packet);
 
 /******************************************************************************/
 #ifdef __cplusplus
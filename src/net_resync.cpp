@@ -30,10 +30,12 @@
 #include "net_game.h"
 #include "game_legacy.h"
 #include "lens_api.h"
+#include "map_data.h"
 #include "net_input_lag.h"
 #include "net_received_packets.h"
 #include "net_redundant_packets.h"
 #include "net_checksums.h"
+#include "net_rollback.h"
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -319,6 +321,12 @@ TbBool send_resync_game(void) {
   if (!result) {
     return false;
   }
+  animate_resync_progress_bar(1, 6);
+  // Map blocks are sent separately, only as many as the map uses
+  result = LbNetwork_Resync(map_blocks, map_blocks_data_size());
+  if (!result) {
+    return false;
+  }
   animate_resync_progress_bar(2, 6);
   LbNetwork_TimesyncBarrier();
   animate_resync_progress_bar(6, 6);
@@ -334,6 +342,15 @@ TbBool receive_resync_game(void) {
     if (!result) {
         return false;
     }
+    animate_resync_progress_bar(1, 6);
+    // Map size comes with the Game struct; the host sends blocks for that size
+    if (!alloc_map_blocks()) {
+        return false;
+    }
+    result = LbNetwork_Resync(map_blocks, map_blocks_data_size());
+    if (!result) {
+        return false;
+    }
     animate_resync_progress_bar(2, 6);
     LbNetwork_TimesyncBarrier();
     animate_resync_progress_bar(6, 6);
@@ -363,6 +380,7 @@ void resync_game(void) {
     clear_packet_tracking();
     clear_redundant_packets();
     clear_input_lag_queue();
+    rollback_reset();
     NETLOG("Input lag after resync: %d turns", game.input_lag_turns);
 
     clear_flag(game.system_flags, GSF_NetGameNoSync);
@@ -30,6 +30,8 @@ TbBool LbNetwork_Resync(void *data_buffer, size_t buffer_length);
 void LbNetwork_TimesyncBarrier(void);
 void animate_resync_progress_bar(int current_phase, int total_phases);
 void resync_game(void);
+void store_localised_game_structure(void);
+void recall_localised_game_structure(void);
 
 #ifdef __cplusplus
 }
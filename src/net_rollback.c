@@ -0,0 +1,416 @@
+/******************************************************************************/
+// Free implementation of Bullfrog's Dungeon Keeper strategy game.
+/******************************************************************************/
+/** @file net_rollback.c
+ *     Rollback of network game turns simulated with predicted packets.
+ * @par Purpose:
+ *     Lets a network game go on when packets of other players are late,
+ *     instead of waiting for them.
+ * @par Comment:
+ *     A late player is predicted to take no action. Before the first turn which
+ *     uses a prediction, the game state is copied; if a prediction turns out wrong
+ *     once the real packet arrives, the copy is restored and the turns since are
+ *     simulated again.
+ * @author   KeeperFX Team
+ * @date     16 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#include "pre_inc.h"
+#include "net_rollback.h"
+
+#include "globals.h"
+#include "bflib_basics.h"
+#include "bflib_network_exchange.h"
+#include "ariadne.h"
+#include "game_legacy.h"
+#include "keeperfx.hpp"
+#include "kfx_memory.h"
+#include "light_data.h"
+#include "lua_base.h"
+#include "lua_triggers.h"
+#include "map_columns.h"
+#include "map_data.h"
+#include "net_checksums.h"
+#include "net_game.h"
+#include "net_input_lag.h"
+#include "net_received_packets.h"
+#include "net_resync.h"
+#include "packets.h"
+#include "room_data.h"
+#include "post_inc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+#define ROLLBACK_TURNS_COUNT (ROLLBACK_MAX_TURNS + 1)
+
+/** Packets a turn was simulated with. */
+struct RollbackTurn {
+    GameTurn turn;
+    TbBool used;
+    /** Players whose packet was not received yet, and had to be predicted. */
+    PlayerBitFlags predicted;
+    struct Packet packets[PACKETS_COUNT];
+};
+
+static struct {
+    TbBool enabled;
+    /** Whether the snapshot holds the state from start of first_turn, the oldest turn with predicted packets. */
+    TbBool snapshot_valid;
+    GameTurn first_turn;
+    struct Game *snapshot;
+    struct Map *map_data;
+    unsigned long map_len;
+    char *lua_data;
+    size_t lua_len;
+    /** Damage events queued for the Lua tick of the first turn. */
+    void *damage_events;
+    size_t damage_events_len;
+    /** Triangulation is remade incrementally, so it can't be made again from the map alone. */
+    struct NavigationState *nav_state;
+    struct RollbackTurn turns[ROLLBACK_TURNS_COUNT];
+    /** Last received packet of every player, which predictions are made from. */
+    struct Packet last_received[PACKETS_COUNT];
+    unsigned long rollbacks_count;
+    unsigned long resimulated_turns;
+} rollback;
+
+/******************************************************************************/
+static void free_snapshot_lua(void)
+{
+    KfxFree(rollback.lua_data);
+    rollback.lua_data = NULL;
+    rollback.lua_len = 0;
+    KfxFree(rollback.damage_events);
+    rollback.damage_events = NULL;
+    rollback.damage_events_len = 0;
+}
+
+void rollback_reset(void)
+{
+    rollback.snapshot_valid = false;
+    free_snapshot_lua();
+    memset(rollback.turns, 0, sizeof(rollback.turns));
+    memset(rollback.last_received, 0, sizeof(rollback.last_received));
+}
+
+void rollback_set_enabled(TbBool enabled)
+{
+    rollback_reset();
+    if (enabled && game.packet_save_enable)
+    {
+        // The packet file would get the predictions instead of what was played
+        WARNLOG("Rollback cannot be used while saving a packet file");
+        enabled = false;
+    }
+    if (enabled && (rollback.snapshot == NULL))
+    {
+        rollback.snapshot = (struct Game *)KfxAlloc(sizeof(struct Game));
+        rollback.nav_state = alloc_navigation_state();
+        if ((rollback.snapshot == NULL) || (rollback.nav_state == NULL))
+        {
+            ERRORLOG("Cannot allocate rollback snapshot");
+            enabled = false;
+        }
+    }
+    if (!enabled && ((rollback.snapshot != NULL) || (rollback.nav_state != NULL)))
+    {
+        KfxFree(rollback.snapshot);
+        rollback.snapshot = NULL;
+        free_navigation_state(rollback.nav_state);
+        rollback.nav_state = NULL;
+        KfxFree(rollback.map_data);
+        rollback.map_data = NULL;
+        rollback.map_len = 0;
+    }
+    rollback.enabled = enabled;
+    rollback.rollbacks_count = 0;
+    rollback.resimulated_turns = 0;
+}
+
+TbBool rollback_enabled(void)
+{
+    return rollback.enabled && ((game.system_flags & GSF_NetworkActive) != 0);
+}
+
+/******************************************************************************/
+static void take_snapshot(void)
+{
+    unsigned long map_len = map_blocks_data_size();
+    if (map_len != rollback.map_len)
+    {
+        KfxFree(rollback.map_data);
+        rollback.map_data = (struct Map *)KfxAlloc(map_len);
+        rollback.map_len = (rollback.map_data != NULL) ? map_len : 0;
+        if (rollback.map_data == NULL)
+        {
+            ERRORLOG("Cannot allocate rollback snapshot of map blocks");
+            return;
+        }
+    }
+    if (!navigation_export_state(rollback.nav_state))
+    {
+        ERRORLOG("Cannot copy triangulation for rollback snapshot");
+        return;
+    }
+    light_export_system_state(&game.lightst);
+    memcpy(rollback.snapshot, &game, sizeof(struct Game));
+    memcpy(rollback.map_data, map_blocks, map_len);
+    free_snapshot_lua();
+    size_t lua_len;
+    const char *lua_data = lua_get_serialised_data(&lua_len);
+    if ((lua_data != NULL) && (lua_len > 0))
+    {
+        rollback.lua_data = (char *)KfxAlloc(lua_len);
+        if (rollback.lua_data != NULL)
+        {
+            memcpy(rollback.lua_data, lua_data, lua_len);
+            rollback.lua_len = lua_len;
+        }
+    }
+    cleanup_serialized_data();
+    size_t damage_events_len;
+    const void *damage_events = lua_get_queued_damage_events(&damage_events_len);
+    if (damage_events_len > 0)
+    {
+        rollback.damage_events = KfxAlloc(damage_events_len);
+        if (rollback.damage_events == NULL)
+        {
+            ERRORLOG("Cannot allocate rollback snapshot of damage events");
+            return;
+        }
+        memcpy(rollback.damage_events, damage_events, damage_events_len);
+        rollback.damage_events_len = damage_events_len;
+    }
+    rollback.first_turn = game.play_gameturn;
+    rollback.snapshot_valid = true;
+}
+
+/**
+ * Brings the game back to the snapshot. Unlike loading a saved game, the level
+ * stays loaded, so only the state kept outside of the Game structure is remade,
+ * or brought back from the snapshot when it can't be remade the same way.
+ */
+static void restore_snapshot(void)
+{
+    float delta_time = game.delta_time;
+    long double process_turn_time = game.process_turn_time;
+    int frame_skip = game.frame_skip;
+    store_localised_game_structure();
+    memcpy(&game, rollback.snapshot, sizeof(struct Game));
+    memcpy(map_blocks, rollback.map_data, min(rollback.map_len, map_blocks_data_size()));
+    recall_localised_game_structure();
+    game.delta_time = delta_time;
+    game.process_turn_time = process_turn_time;
+    game.frame_skip = frame_skip;
+    light_import_system_state(&game.lightst);
+    if (rollback.lua_len > 0)
+        lua_set_serialised_data(rollback.lua_data, rollback.lua_len);
+    // Events queued after the snapshot are dropped, and ones queued before are delivered again
+    lua_set_queued_damage_events(rollback.damage_events, rollback.damage_events_len);
+    invalidate_columns_index();
+    invalidate_thing_lists_index();
+    invalidate_all_room_slabs_index();
+    navigation_import_state(rollback.nav_state);
+    invalidate_replay_integrity();
+}
+
+static struct RollbackTurn *get_rollback_turn(GameTurn turn)
+{
+    return &rollback.turns[turn % ROLLBACK_TURNS_COUNT];
+}
+
+static TbBool packet_inputs_differ(const struct Packet *pckt1, const struct Packet *pckt2)
+{
+    return (pckt1->action != pckt2->action) ||
+        (pckt1->actn_par1 != pckt2->actn_par1) || (pckt1->actn_par2 != pckt2->actn_par2) ||
+        (pckt1->actn_par3 != pckt2->actn_par3) || (pckt1->actn_par4 != pckt2->actn_par4) ||
+        (pckt1->pos_x != pckt2->pos_x) || (pckt1->pos_y != pckt2->pos_y) ||
+        (pckt1->control_flags != pckt2->control_flags) ||
+        (pckt1->additional_packet_values != pckt2->additional_packet_values);
+}
+
+/**
+ * Predicts a packet which was not received yet: the player keeps the cursor
+ * and held buttons of their last packet, but takes no action.
+ */
+static void predict_packet(struct Packet *pckt, PlayerNumber plyr_idx, GameTurn packet_turn)
+{
+    *pckt = rollback.last_received[plyr_idx];
+    pckt->turn = packet_turn;
+    pckt->action = PckA_None;
+    pckt->actn_par1 = 0;
+    pckt->actn_par2 = 0;
+    pckt->actn_par3 = 0;
+    pckt->actn_par4 = 0;
+    clear_flag(pckt->control_flags, PCtr_LBtnClick|PCtr_RBtnClick|PCtr_LBtnRelease|PCtr_RBtnRelease);
+}
+
+/**
+ * Fills game packets for the current turn, predicting the ones not received yet.
+ * If the turn is simulated again, the local packet recorded for it is reused.
+ * @return True if no packet had to be predicted.
+ */
+static TbBool fill_turn_packets(PlayerNumber my_packet_num)
+{
+    GameTurn turn = game.play_gameturn;
+    GameTurn packet_turn = turn - game.input_lag_turns;
+    struct RollbackTurn *rbturn = get_rollback_turn(turn);
+    if (!rbturn->used || (rbturn->turn != turn))
+    {
+        const struct Packet *local_packet = get_local_input_lag_packet_for_turn(packet_turn);
+        if (local_packet != NULL)
+            rbturn->packets[my_packet_num] = *local_packet;
+        else
+            rbturn->packets[my_packet_num] = game.packets[my_packet_num];
+    }
+    rbturn->turn = turn;
+    rbturn->used = true;
+    rbturn->predicted = 0;
+    for (PlayerNumber i = 0; i < PACKETS_COUNT; i++)
+    {
+        if (i == my_packet_num)
+            continue;
+        const struct Packet *pckt = get_received_packet_for_player(packet_turn, i);
+        if (pckt != NULL)
+        {
+            rbturn->packets[i] = *pckt;
+            rollback.last_received[i] = *pckt;
+        } else
+        if (network_player_active(i))
+        {
+            predict_packet(&rbturn->packets[i], i, packet_turn);
+            set_flag(rbturn->predicted, to_flag(i));
+        } else
+        {
+            memset(&rbturn->packets[i], 0, sizeof(struct Packet));
+        }
+    }
+    memcpy(game.packets, rbturn->packets, sizeof(rbturn->packets));
+    return (rbturn->predicted == 0);
+}
+
+/**
+ * Checks predictions of the turns since the snapshot against packets received since.
+ * Correct predictions are replaced by the received packets.
+ * @return True if any prediction was wrong.
+ */
+static TbBool predictions_failed(void)
+{
+    for (GameTurn turn = rollback.first_turn; turn < game.play_gameturn; turn++)
+    {
+        struct RollbackTurn *rbturn = get_rollback_turn(turn);
+        for (PlayerNumber i = 0; i < PACKETS_COUNT; i++)
+        {
+            if (!flag_is_set(rbturn->predicted, to_flag(i)))
+                continue;
+            const struct Packet *pckt = get_received_packet_for_player(turn - game.input_lag_turns, i);
+            if (pckt == NULL)
+                continue;
+            if (packet_inputs_differ(pckt, &rbturn->packets[i]))
+            {
+                MULTIPLAYER_LOG("predictions_failed: packet[%d] of turn %lu was predicted wrong", (int)i, (unsigned long)turn);
+                return true;
+            }
+            rbturn->packets[i] = *pckt;
+            clear_flag(rbturn->predicted, to_flag(i));
+        }
+    }
+    return false;
+}
+
+static TbBool all_predictions_confirmed(void)
+{
+    for (GameTurn turn = rollback.first_turn; turn < game.play_gameturn; turn++)
+    {
+        if (get_rollback_turn(turn)->predicted != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Restores the snapshot and simulates the turns since again, up to the current one.
+ * Packets which still did not arrive are predicted again, and get a new snapshot.
+ */
+static void resimulate_turns(PlayerNumber my_packet_num)
+{
+    GameTurn end_turn = game.play_gameturn;
+    GameTurn start_turn = rollback.first_turn;
+    struct Packet current_packets[PACKETS_COUNT];
+    memcpy(current_packets, game.packets, sizeof(current_packets));
+    restore_snapshot();
+    rollback.snapshot_valid = false;
+    while (game.play_gameturn < end_turn)
+    {
+        // Checksums sent with packets are taken from this history, so it has to follow the new state
+        update_turn_checksums();
+        if (!fill_turn_packets(my_packet_num) && !rollback.snapshot_valid)
+            take_snapshot();
+        process_all_players_packets();
+        clear_packets();
+        if ((game.operation_flags & GOF_Paused) != 0)
+        {
+            WARNLOG("Game paused on turn %lu while simulating again",(unsigned long)game.play_gameturn);
+            break;
+        }
+        process_game_turn();
+    }
+    memcpy(game.packets, current_packets, sizeof(current_packets));
+    update_turn_checksums();
+    rollback.rollbacks_count++;
+    rollback.resimulated_turns += end_turn - start_turn;
+    SYNCDBG(7,"Simulated turns %lu-%lu again, %lu rollbacks of %lu turns so far",(unsigned long)start_turn,
+        (unsigned long)end_turn,rollback.rollbacks_count,rollback.resimulated_turns);
+}
+
+/******************************************************************************/
+/**
+ * Waits for the packets of the oldest predicted turn, if predictions reached the limit of turns.
+ */
+void rollback_wait_for_window(void)
+{
+    if (!rollback.snapshot_valid || (game.skip_initial_input_turns > 0))
+        return;
+    if (game.play_gameturn - rollback.first_turn < ROLLBACK_MAX_TURNS)
+        return;
+    LbNetwork_WaitForTurnPackets(rollback.first_turn - game.input_lag_turns, game.packets, sizeof(struct Packet));
+}
+
+/**
+ * Loads packets for the current turn, used instead of the input lag queue in rollback mode.
+ * Rolls back and simulates the previous turns again first, if their predictions were wrong.
+ * @return True if the packets of all players were received, false if any is predicted.
+ */
+TbBool rollback_load_packets(PlayerNumber my_packet_num)
+{
+    if (rollback.snapshot_valid)
+    {
+        if (predictions_failed())
+            resimulate_turns(my_packet_num);
+        else
+        if (all_predictions_confirmed())
+            rollback.snapshot_valid = false;
+    }
+    if (rollback.snapshot_valid && (game.play_gameturn - rollback.first_turn >= ROLLBACK_MAX_TURNS))
+    {
+        // Desync detection will resync the game if the predictions were wrong
+        WARNLOG("Packets of turn %lu did not arrive, keeping predictions",(unsigned long)rollback.first_turn);
+        rollback.snapshot_valid = false;
+    }
+    TbBool confirmed = fill_turn_packets(my_packet_num);
+    if (!confirmed && !rollback.snapshot_valid)
+        take_snapshot();
+    return confirmed;
+}
+
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
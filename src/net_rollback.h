@@ -0,0 +1,41 @@
+/******************************************************************************/
+// Free implementation of Bullfrog's Dungeon Keeper strategy game.
+/******************************************************************************/
+/** @file net_rollback.h
+ *     Header file for net_rollback.c.
+ * @par Purpose:
+ *     Rollback of network game turns simulated with predicted packets.
+ * @par Comment:
+ *     Just a header file - #defines, typedefs, function prototypes etc.
+ * @author   KeeperFX Team
+ * @date     16 Oct 2026
+ * @par  Copying and copyrights:
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published by
+ *     the Free Software Foundation; either version 2 of the License, or
+ *     (at your option) any later version.
+ */
+/******************************************************************************/
+#ifndef DK_NET_ROLLBACK_H
+#define DK_NET_ROLLBACK_H
+
+#include "bflib_basics.h"
+#include "globals.h"
+
+/** Amount of turns which may be simulated with predicted packets before waiting for the real ones. */
+#define ROLLBACK_MAX_TURNS 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************/
+void rollback_set_enabled(TbBool enabled);
+TbBool rollback_enabled(void);
+void rollback_reset(void);
+void rollback_wait_for_window(void);
+TbBool rollback_load_packets(PlayerNumber my_packet_num);
+/******************************************************************************/
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -22,6 +22,7 @@
 #include "net_received_packets.h"
 #include "net_input_lag.h"
 #include "net_checksums.h"
+#include "net_rollback.h"
 
 #include <math.h>
 
@@ -1653,6 +1654,19 @@ void set_local_packet_turn(void) {
 }
 
 
+/**
+ * Processes packets of all players which are not controlled by computer.
+ */
+void process_all_players_packets(void)
+{
+    for (int i = 0; i < PACKETS_COUNT; i++)
+    {
+        struct PlayerInfo* player = get_player(i);
+        if (player_exists(player) && ((player->allocflags & PlaF_CompCtrl) == 0))
+            process_players_packet(i);
+    }
+}
+
 /**
  * Exchange packets if MP game, then process all packets influencing local game state.
  */
@@ -1687,13 +1701,25 @@ void process_packets(void)
             if (exchange_result != Lb_OK) {
                 ERRORLOG("LbNetwork_Exchange failed");
             }
-            LbNetwork_WaitForMissingPackets(game.packets, sizeof(struct Packet));
+            if (rollback_enabled())
+                rollback_wait_for_window();
+            else
+                LbNetwork_WaitForMissingPackets(game.packets, sizeof(struct Packet));
         }
         replace_with_ai(old_active_players);
     }
 
-    MULTIPLAYER_LOG("process_packets: Loading packets from input lag queue");
-    load_old_packets(player->packet_num);
+    // Predicted packets carry no checksum to compare
+    TbBool packets_confirmed = true;
+    if (rollback_enabled() && (game.skip_initial_input_turns == 0))
+    {
+        MULTIPLAYER_LOG("process_packets: Loading packets with rollback");
+        packets_confirmed = rollback_load_packets(player->packet_num);
+    } else
+    {
+        MULTIPLAYER_LOG("process_packets: Loading packets from input lag queue");
+        load_old_packets(player->packet_num);
+    }
 
     if (input_lag_skips_initial_processing())
     {
@@ -1701,7 +1727,7 @@ void process_packets(void)
         return;
     }
 
-    if (checksums_different()) { //Should be called directly after LbNetwork_Exchange, to see if there's anything wrong with the received packet
+    if (packets_confirmed && checksums_different()) { //Should be called directly after LbNetwork_Exchange, to see if there's anything wrong with the received packet
         // Setting checksum problem flags
         set_flag(game.system_flags, GSF_NetGameNoSync);
         clear_flag(game.system_flags, GSF_NetSeedNoSync);
@@ -1717,13 +1743,7 @@ void process_packets(void)
     #if DEBUG_NETWORK_PACKETS
     write_debug_packets();
     #endif
-    // Process the packets
-    for (i=0; i<PACKETS_COUNT; i++)
-    {
-        player = get_player(i);
-        if (player_exists(player) && ((player->allocflags & PlaF_CompCtrl) == 0))
-        process_players_packet(i);
-    }
+    process_all_players_packets();
     // Clear all packets
     clear_packets();
     if (((game.system_flags & GSF_NetGameNoSync) != 0)
@@ -301,6 +301,20 @@ struct PacketSaveHead {
     TbBool highlight_mode;
 };
 
+/** Starts the data of SGC_ReplayTurns chunk in a packet file; turns_count turn records follow. */
+struct ReplayTurnsHead {
+    uint32_t first_turn;
+    uint32_t turns_count;
+};
+
+/** Starts the data of SGC_ReplayKeyframe chunk; followed by Game struct, map blocks and Lua data, compressed together. */
+struct ReplayKeyframeHead {
+    uint32_t turn;
+    uint32_t game_len;
+    uint32_t map_len;
+    uint32_t lua_len;
+};
+
 struct PacketEx
 {
     struct Packet packet;
@@ -340,9 +354,14 @@ void process_camera_controls(struct Camera* cam, struct Packet* pckt, struct Pla
 void process_first_person_look(struct Thing *thing, struct Packet *pckt, long current_horizontal, long current_vertical, long *out_horizontal, long *out_vertical, long *out_roll);
 TbBool can_process_creature_input(struct Thing *thing);
 void process_packets(void);
+void process_all_players_packets(void);
 void set_local_packet_turn(void);
 void clear_packets(void);
 TbBigChecksum compute_replay_integrity(void);
+void update_replay_integrity_of_thing(const struct Thing *thing);
+void touch_replay_integrity_of_thing(const struct Thing *thing);
+void remove_replay_integrity_of_thing(const struct Thing *thing);
+void invalidate_replay_integrity(void);
 void post_init_packets(void);
 
 TbBool open_new_packet_file_for_save(void);
@@ -350,6 +369,9 @@ void load_packets_for_turn(GameTurn nturn);
 TbBool open_packet_file_for_load(char *fname, struct CatalogueEntry *centry);
 short save_packets(void);
 void close_packet_file(void);
+TbBool seek_packet_file(GameTurn nturn);
+void start_replay_verification(void);
+int report_replay_verification(void);
 TbBool reinit_packets_after_load(void);
 struct Room *keeper_build_room(long stl_x,long stl_y,long plyr_idx,long rkind);
 TbBool player_sell_room_at_subtile(long plyr_idx, long stl_x, long stl_y);
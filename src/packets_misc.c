@@ -30,6 +30,14 @@
 #include "game_saves.h"
 #include "gui_topmsg.h"
 #include "config_settings.h"
+#include "keeperfx.hpp"
+#include "light_data.h"
+#include "lua_base.h"
+#include "map_data.h"
+
+#ifdef KEEPERFX_ZLIB_AVAILABLE
+#include <zlib.h>
+#endif
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -127,6 +135,604 @@ struct Packet *get_packet_direct(long pckt_idx)
     return &game.packets[pckt_idx];
 }
 
+/******************************************************************************/
+/** Amount of turns gathered in memory before they're written to the packet file as one block. */
+#define REPLAY_TURNS_PER_BLOCK   256
+/** Turns between game state keyframes in the packet file; a minute of game at normal speed. */
+#define REPLAY_KEYFRAME_INTERVAL 1200
+
+/** Position of a block of turns, or of a keyframe, within the packet file. */
+struct ReplayIndexEntry {
+    GameTurn turn;
+    GameTurn turns_count;
+    unsigned long ver;
+    /** Position and size of the chunk data, after its FileChunkHeader. */
+    long file_pos;
+    unsigned long len;
+};
+
+struct ReplayIndex {
+    struct ReplayIndexEntry *entries;
+    long count;
+    long alloc;
+};
+
+/** Turns recorded since the last block was written; the buffer starts with ReplayTurnsHead. */
+struct ReplayWriter {
+    unsigned char *buf;
+    unsigned long len;
+    unsigned long size;
+    GameTurn first_turn;
+    GameTurn turns_count;
+};
+
+struct ReplayReader {
+    TbBool uses_blocks;
+    /** The file was recorded with the checksum summing all things, from before ReplayIntegrity. */
+    TbBool legacy_integrity;
+    struct ReplayIndex blocks;
+    struct ReplayIndex keyframes;
+    /** Block of turns being played, and read position within it. */
+    unsigned char *buf;
+    unsigned long size;
+    unsigned long len;
+    unsigned long pos;
+    long block_idx;
+    TbBool seek_pending;
+    GameTurn seek_turn;
+};
+
+/** Fields of the Game struct which describe the replay itself, so must survive restoring a keyframe. */
+struct ReplayLocalState {
+    unsigned char packet_save_enable;
+    unsigned char packet_load_enable;
+    char packet_fname[150];
+    char packet_fopened;
+    TbFileHandle packet_save_fp;
+    unsigned int packet_file_pos;
+    struct PacketSaveHead packet_save_head;
+    uint32_t turns_stored;
+    unsigned char packet_loading_in_progress;
+    unsigned char packet_checksum_verify;
+    uint32_t log_things_start_turn;
+    uint32_t log_things_end_turn;
+    uint32_t turns_packetoff;
+    PlayerNumber local_plyr_idx;
+    unsigned char packet_load_initialized;
+};
+
+/** Outcome of playing a packet file with -packetverify. */
+struct ReplayVerification {
+    TbBool started;
+    TbBool finished;
+    TbBool diverged;
+    /** Game turn at which the checksum first did not match. */
+    GameTurn diverged_turn;
+    GameTurn turns_checked;
+    TbClockMSec start_clock;
+    TbClockMSec end_clock;
+};
+
+/**
+ * Replay checksum kept up to date as synchronized things change, instead of scanning all things every turn.
+ * It is the sum of a hash of every thing; the part of a thing is added when the thing is created,
+ * replaced when its model changes, and removed when it is deleted.
+ * Things which are updated, moved or change owner are only marked as touched; their parts are
+ * hashed again once per turn, when the checksum is computed.
+ */
+struct ReplayIntegrity {
+    /** Parts are only kept once the sum was built by a full scan; until then there's nothing to update. */
+    TbBool valid;
+    TbBigChecksum total;
+    TbBigChecksum parts[SYNCED_THINGS_COUNT+1];
+    /** Things to be hashed again; each one is listed once, as marked in touched. */
+    ThingIndex touched_list[SYNCED_THINGS_COUNT];
+    long touched_count;
+    unsigned char touched[SYNCED_THINGS_COUNT+1];
+};
+
+static struct ReplayWriter replay_writer;
+static struct ReplayReader replay_reader;
+static struct ReplayVerification replay_verify;
+static struct ReplayIntegrity replay_integrity;
+/******************************************************************************/
+static TbBool replay_index_add(struct ReplayIndex *idx, const struct ReplayIndexEntry *entry)
+{
+    if (idx->count >= idx->alloc)
+    {
+        long alloc = (idx->alloc > 0) ? idx->alloc * 2 : 64;
+        struct ReplayIndexEntry *entries = (struct ReplayIndexEntry *)KfxRealloc(idx->entries, alloc * sizeof(struct ReplayIndexEntry));
+        if (entries == NULL)
+            return false;
+        idx->entries = entries;
+        idx->alloc = alloc;
+    }
+    idx->entries[idx->count] = *entry;
+    idx->count++;
+    return true;
+}
+
+static void replay_index_free(struct ReplayIndex *idx)
+{
+    KfxFree(idx->entries);
+    idx->entries = NULL;
+    idx->count = 0;
+    idx->alloc = 0;
+}
+
+static TbBool replay_buffer_reserve(unsigned char **buf, unsigned long *size, unsigned long needed)
+{
+    if (needed <= *size)
+        return true;
+    unsigned long new_size = max(needed, *size * 2);
+    unsigned char *new_buf = (unsigned char *)KfxRealloc(*buf, new_size);
+    if (new_buf == NULL)
+        return false;
+    *buf = new_buf;
+    *size = new_size;
+    return true;
+}
+
+static void reset_replay_writer(void)
+{
+    struct ReplayWriter *wr = &replay_writer;
+    KfxFree(wr->buf);
+    memset(wr, 0, sizeof(struct ReplayWriter));
+    wr->len = sizeof(struct ReplayTurnsHead);
+}
+
+static void reset_replay_reader(void)
+{
+    struct ReplayReader *rd = &replay_reader;
+    replay_index_free(&rd->blocks);
+    replay_index_free(&rd->keyframes);
+    KfxFree(rd->buf);
+    memset(rd, 0, sizeof(struct ReplayReader));
+    rd->block_idx = -1;
+}
+
+/**
+ * Writes the turns gathered since the last block into the packet file.
+ */
+static TbBool flush_replay_turns(void)
+{
+    struct ReplayWriter *wr = &replay_writer;
+    if (wr->turns_count == 0)
+        return true;
+    struct ReplayTurnsHead thdr;
+    thdr.first_turn = wr->first_turn;
+    thdr.turns_count = wr->turns_count;
+    memcpy(wr->buf, &thdr, sizeof(struct ReplayTurnsHead));
+    struct FileChunkHeader hdr;
+    hdr.id = SGC_ReplayTurns;
+    hdr.ver = 0;
+    hdr.len = wr->len;
+    TbBool done = (LbFileWrite(game.packet_save_fp, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+        && (LbFileWrite(game.packet_save_fp, wr->buf, wr->len) == wr->len);
+    wr->first_turn += wr->turns_count;
+    wr->turns_count = 0;
+    wr->len = sizeof(struct ReplayTurnsHead);
+    if (!done)
+    {
+        ERRORLOG("Packet file write error");
+        return false;
+    }
+    if (!LbFileFlush(game.packet_save_fp))
+    {
+        ERRORLOG("Unable to flush PacketSave File");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Copy of the game state made for a keyframe; it is compressed and written by the save writer thread.
+ * The game thread doesn't touch the packet file until the job is completed.
+ */
+struct ReplayKeyframeJob {
+    TbBool pending;
+    TbFileHandle fhandle;
+    struct ReplayKeyframeHead khdr;
+    struct Game *game_data;
+    unsigned char *map_data;
+    char *lua_data;
+};
+
+static struct ReplayKeyframeJob replay_keyframe_job;
+
+static void free_replay_keyframe_job(struct ReplayKeyframeJob *job)
+{
+    KfxFree(job->game_data);
+    KfxFree(job->map_data);
+    KfxFree(job->lua_data);
+    job->game_data = NULL;
+    job->map_data = NULL;
+    job->lua_data = NULL;
+    job->pending = false;
+}
+
+/**
+ * Writes the keyframe at the end of the packet file. Runs on the save writer thread.
+ * Game struct, map blocks and Lua data are compressed as one stream.
+ */
+static TbBool run_replay_keyframe_job(void *data)
+{
+    struct ReplayKeyframeJob *job = (struct ReplayKeyframeJob *)data;
+    const struct ReplayKeyframeHead *khdr = &job->khdr;
+    struct FileChunkHeader hdr;
+    hdr.id = SGC_ReplayKeyframe;
+    TbBool done = false;
+    LbFileSeek(job->fhandle, 0, Lb_FILE_SEEK_END);
+#ifdef KEEPERFX_ZLIB_AVAILABLE
+    z_stream strm;
+    memset(&strm, 0, sizeof(z_stream));
+    if (deflateInit(&strm, Z_BEST_SPEED) != Z_OK)
+        return false;
+    uLong packed_size = deflateBound(&strm, khdr->game_len + khdr->map_len + khdr->lua_len);
+    unsigned char *packed = (unsigned char *)KfxAlloc(packed_size);
+    if (packed != NULL)
+    {
+        strm.next_out = packed;
+        strm.avail_out = packed_size;
+        strm.next_in = (Bytef *)job->game_data;
+        strm.avail_in = khdr->game_len;
+        int ret = deflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_OK)
+        {
+            strm.next_in = (Bytef *)job->map_data;
+            strm.avail_in = khdr->map_len;
+            ret = deflate(&strm, Z_NO_FLUSH);
+        }
+        if (ret == Z_OK)
+        {
+            strm.next_in = (Bytef *)job->lua_data;
+            strm.avail_in = khdr->lua_len;
+            ret = deflate(&strm, Z_FINISH);
+        }
+        if (ret == Z_STREAM_END)
+        {
+            hdr.ver = 1;
+            hdr.len = sizeof(struct ReplayKeyframeHead) + strm.total_out;
+            done = (LbFileWrite(job->fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+                && (LbFileWrite(job->fhandle, khdr, sizeof(struct ReplayKeyframeHead)) == sizeof(struct ReplayKeyframeHead))
+                && (LbFileWrite(job->fhandle, packed, strm.total_out) == strm.total_out);
+        }
+        KfxFree(packed);
+    }
+    deflateEnd(&strm);
+#else
+    hdr.ver = 0;
+    hdr.len = sizeof(struct ReplayKeyframeHead) + khdr->game_len + khdr->map_len + khdr->lua_len;
+    done = (LbFileWrite(job->fhandle, &hdr, sizeof(struct FileChunkHeader)) == sizeof(struct FileChunkHeader))
+        && (LbFileWrite(job->fhandle, khdr, sizeof(struct ReplayKeyframeHead)) == sizeof(struct ReplayKeyframeHead))
+        && (LbFileWrite(job->fhandle, job->game_data, khdr->game_len) == khdr->game_len)
+        && (LbFileWrite(job->fhandle, job->map_data, khdr->map_len) == khdr->map_len)
+        && ((khdr->lua_len == 0) || (LbFileWrite(job->fhandle, job->lua_data, khdr->lua_len) == khdr->lua_len));
+#endif
+    return done && LbFileFlush(job->fhandle);
+}
+
+static void complete_replay_keyframe_job(void *data, TbBool result, TbBool in_background)
+{
+    struct ReplayKeyframeJob *job = (struct ReplayKeyframeJob *)data;
+    if (!result)
+    {
+        ERRORLOG("Cannot write keyframe of turn %lu to packet file",(unsigned long)job->khdr.turn);
+    }
+    free_replay_keyframe_job(job);
+}
+
+/**
+ * Waits until the keyframe being written is in the packet file, so that the file can be used again.
+ */
+static void finish_replay_keyframe(void)
+{
+    if (replay_keyframe_job.pending)
+        finish_pending_saves();
+}
+
+/**
+ * Stores the current game state in the packet file, so that playing can be started from given turn.
+ * Only copying the state is done here; compressing and writing it is left to the save writer thread.
+ */
+static TbBool write_replay_keyframe(GameTurn turn)
+{
+    struct ReplayKeyframeJob *job = &replay_keyframe_job;
+    // Only one job is written at a time, and the previous keyframe may still use the buffers
+    finish_pending_saves();
+    // Currently there is some game data outside of structs - make sure it is updated
+    light_export_system_state(&game.lightst);
+    size_t lua_len;
+    const char *lua_data = lua_get_serialised_data(&lua_len);
+    job->fhandle = game.packet_save_fp;
+    job->khdr.turn = turn;
+    job->khdr.game_len = sizeof(struct Game);
+    job->khdr.map_len = map_blocks_data_size();
+    job->khdr.lua_len = lua_len;
+    job->game_data = (struct Game *)KfxAlloc(sizeof(struct Game));
+    job->map_data = (unsigned char *)KfxAlloc(job->khdr.map_len);
+    job->lua_data = (lua_len > 0) ? (char *)KfxAlloc(lua_len) : NULL;
+    if ((job->game_data == NULL) || (job->map_data == NULL) || ((lua_len > 0) && (job->lua_data == NULL)))
+    {
+        cleanup_serialized_data();
+        free_replay_keyframe_job(job);
+        ERRORLOG("Cannot allocate keyframe of turn %lu",(unsigned long)turn);
+        return false;
+    }
+    memcpy(job->game_data, &game, sizeof(struct Game));
+    memcpy(job->map_data, map_blocks, job->khdr.map_len);
+    if (lua_len > 0)
+        memcpy(job->lua_data, lua_data, lua_len);
+    cleanup_serialized_data();
+    job->pending = true;
+    return queue_background_write(run_replay_keyframe_job, complete_replay_keyframe_job, job);
+}
+
+/**
+ * Builds index of blocks and keyframes of the packet file, starting from current position.
+ * @return Amount of turns stored in the file.
+ */
+static GameTurn index_replay_blocks(TbFileHandle fhandle)
+{
+    struct ReplayReader *rd = &replay_reader;
+    long pos = LbFilePosition(fhandle);
+    long file_len = LbFileLengthHandle(fhandle);
+    GameTurn turns_count = 0;
+    while (pos + (long)sizeof(struct FileChunkHeader) <= file_len)
+    {
+        struct FileChunkHeader hdr;
+        LbFileSeek(fhandle, pos, Lb_FILE_SEEK_BEGINNING);
+        if (LbFileRead(fhandle, &hdr, sizeof(struct FileChunkHeader)) != sizeof(struct FileChunkHeader))
+            break;
+        struct ReplayIndexEntry entry;
+        entry.ver = hdr.ver;
+        entry.file_pos = pos + sizeof(struct FileChunkHeader);
+        entry.len = hdr.len;
+        if (entry.file_pos + (long)hdr.len > file_len)
+        {
+            // The game was closed while writing
+            WARNLOG("Packet file ends within a block, last turns are lost");
+            break;
+        }
+        if (hdr.id == SGC_ReplayTurns)
+        {
+            struct ReplayTurnsHead thdr;
+            if ((hdr.len < sizeof(struct ReplayTurnsHead)) ||
+                (LbFileRead(fhandle, &thdr, sizeof(struct ReplayTurnsHead)) != sizeof(struct ReplayTurnsHead)) ||
+                (thdr.first_turn != turns_count))
+            {
+                WARNLOG("Bad block of turns in packet file at turn %lu",(unsigned long)turns_count);
+                break;
+            }
+            entry.turn = thdr.first_turn;
+            entry.turns_count = thdr.turns_count;
+            if (!replay_index_add(&rd->blocks, &entry))
+                break;
+            turns_count += thdr.turns_count;
+        } else
+        if (hdr.id == SGC_ReplayKeyframe)
+        {
+            struct ReplayKeyframeHead khdr;
+            if ((hdr.len >= sizeof(struct ReplayKeyframeHead)) &&
+                (LbFileRead(fhandle, &khdr, sizeof(struct ReplayKeyframeHead)) == sizeof(struct ReplayKeyframeHead)))
+            {
+                entry.turn = khdr.turn;
+                entry.turns_count = 0;
+                replay_index_add(&rd->keyframes, &entry);
+            }
+        } else
+        {
+            WARNLOG("Unrecognized chunk in packet file, ID = %08lx", hdr.id);
+        }
+        pos = entry.file_pos + hdr.len;
+    }
+    SYNCDBG(7,"Packet file has %lu turns in %ld blocks, with %ld keyframes",(unsigned long)turns_count,rd->blocks.count,rd->keyframes.count);
+    return turns_count;
+}
+
+static TbBool load_replay_block(long block_idx)
+{
+    struct ReplayReader *rd = &replay_reader;
+    if ((block_idx < 0) || (block_idx >= rd->blocks.count))
+        return false;
+    const struct ReplayIndexEntry *entry = &rd->blocks.entries[block_idx];
+    if (!replay_buffer_reserve(&rd->buf, &rd->size, entry->len))
+        return false;
+    LbFileSeek(game.packet_save_fp, entry->file_pos, Lb_FILE_SEEK_BEGINNING);
+    if (LbFileRead(game.packet_save_fp, rd->buf, entry->len) != entry->len)
+        return false;
+    rd->block_idx = block_idx;
+    rd->len = entry->len;
+    rd->pos = sizeof(struct ReplayTurnsHead);
+    return true;
+}
+
+/**
+ * Reads next part of the recorded turns, whether they're stored in blocks or as a flat stream.
+ */
+static long replay_read(void *buf, unsigned long len)
+{
+    struct ReplayReader *rd = &replay_reader;
+    if (!rd->uses_blocks)
+        return LbFileRead(game.packet_save_fp, buf, len);
+    if (rd->pos >= rd->len)
+    {
+        if (!load_replay_block(rd->block_idx + 1))
+            return -1;
+    }
+    // Turns are never split between blocks
+    if (rd->pos + len > rd->len)
+        return -1;
+    memcpy(buf, rd->buf + rd->pos, len);
+    rd->pos += len;
+    return len;
+}
+
+static void store_replay_local_state(struct ReplayLocalState *local)
+{
+    local->packet_save_enable = game.packet_save_enable;
+    local->packet_load_enable = game.packet_load_enable;
+    memcpy(local->packet_fname, game.packet_fname, sizeof(local->packet_fname));
+    local->packet_fopened = game.packet_fopened;
+    local->packet_save_fp = game.packet_save_fp;
+    local->packet_file_pos = game.packet_file_pos;
+    local->packet_save_head = game.packet_save_head;
+    local->turns_stored = game.turns_stored;
+    local->packet_loading_in_progress = game.packet_loading_in_progress;
+    local->packet_checksum_verify = game.packet_checksum_verify;
+    local->log_things_start_turn = game.log_things_start_turn;
+    local->log_things_end_turn = game.log_things_end_turn;
+    local->turns_packetoff = game.turns_packetoff;
+    local->local_plyr_idx = game.local_plyr_idx;
+    local->packet_load_initialized = game.packet_load_initialized;
+}
+
+static void recall_replay_local_state(const struct ReplayLocalState *local)
+{
+    game.packet_save_enable = local->packet_save_enable;
+    game.packet_load_enable = local->packet_load_enable;
+    memcpy(game.packet_fname, local->packet_fname, sizeof(game.packet_fname));
+    game.packet_fopened = local->packet_fopened;
+    game.packet_save_fp = local->packet_save_fp;
+    game.packet_file_pos = local->packet_file_pos;
+    game.packet_save_head = local->packet_save_head;
+    game.turns_stored = local->turns_stored;
+    game.packet_loading_in_progress = local->packet_loading_in_progress;
+    game.packet_checksum_verify = local->packet_checksum_verify;
+    game.log_things_start_turn = local->log_things_start_turn;
+    game.log_things_end_turn = local->log_things_end_turn;
+    game.turns_packetoff = local->turns_packetoff;
+    game.local_plyr_idx = local->local_plyr_idx;
+    game.packet_load_initialized = local->packet_load_initialized;
+}
+
+/**
+ * Replaces the game state with one stored in a keyframe of the packet file.
+ */
+static TbBool restore_replay_keyframe(const struct ReplayIndexEntry *kfrm)
+{
+    struct ReplayKeyframeHead khdr;
+    LbFileSeek(game.packet_save_fp, kfrm->file_pos, Lb_FILE_SEEK_BEGINNING);
+    if ((kfrm->len < sizeof(struct ReplayKeyframeHead)) ||
+        (LbFileRead(game.packet_save_fp, &khdr, sizeof(struct ReplayKeyframeHead)) != sizeof(struct ReplayKeyframeHead)) ||
+        (khdr.game_len != sizeof(struct Game)))
+    {
+        WARNLOG("Incompatible keyframe of turn %lu",(unsigned long)kfrm->turn);
+        return false;
+    }
+    unsigned long packed_len = kfrm->len - sizeof(struct ReplayKeyframeHead);
+    unsigned long state_len = khdr.game_len + khdr.map_len + khdr.lua_len;
+    unsigned char *packed = (unsigned char *)KfxAlloc(packed_len);
+    unsigned char *state = (unsigned char *)KfxAlloc(state_len);
+    TbBool done = (packed != NULL) && (state != NULL) &&
+        (LbFileRead(game.packet_save_fp, packed, packed_len) == packed_len);
+    if (done)
+    {
+        if (kfrm->ver == 0)
+        {
+            done = (packed_len == state_len);
+            if (done)
+                memcpy(state, packed, state_len);
+        } else
+        {
+#ifdef KEEPERFX_ZLIB_AVAILABLE
+            uLongf len = state_len;
+            done = (uncompress(state, &len, packed, packed_len) == Z_OK) && (len == state_len);
+#else
+            WARNLOG("Compressed keyframes are not supported on this platform");
+            done = false;
+#endif
+        }
+    }
+    if (done)
+    {
+        // Map blocks have to match the map size within the stored Game struct
+        const struct Game *kfrm_game = (const struct Game *)state;
+        done = (khdr.map_len == (unsigned long)(kfrm_game->map_subtiles_x + 1) * (kfrm_game->map_subtiles_y + 1) * sizeof(struct Map));
+    }
+    if (done)
+    {
+        struct ReplayLocalState local;
+        store_replay_local_state(&local);
+        memcpy(&game, state, sizeof(struct Game));
+        alloc_map_blocks();
+        memcpy(map_blocks, state + sizeof(struct Game), min(khdr.map_len, map_blocks_data_size()));
+        reinit_level_after_load();
+        recall_replay_local_state(&local);
+        light_import_system_state(&game.lightst);
+        if (khdr.lua_len > 0)
+            lua_set_serialised_data((const char *)state + sizeof(struct Game) + khdr.map_len, khdr.lua_len);
+    } else
+    {
+        WARNLOG("Cannot read keyframe of turn %lu",(unsigned long)kfrm->turn);
+    }
+    KfxFree(packed);
+    KfxFree(state);
+    return done;
+}
+
+/**
+ * Starts playing from the keyframe nearest before the requested turn, and fast forwards to that turn.
+ * If the keyframe is not any nearer than the current turn, only fast forwards.
+ * @return The turn from which playing continues.
+ */
+static GameTurn apply_replay_seek(GameTurn nturn)
+{
+    struct ReplayReader *rd = &replay_reader;
+    rd->seek_pending = false;
+    GameTurn target = rd->seek_turn;
+    const struct ReplayIndexEntry *kfrm = NULL;
+    for (long i = 0; i < rd->keyframes.count; i++)
+    {
+        if (rd->keyframes.entries[i].turn <= target)
+            kfrm = &rd->keyframes.entries[i];
+    }
+    if ((target >= nturn) && ((kfrm == NULL) || (kfrm->turn <= nturn)))
+    {
+        game.turns_fastforward = target - nturn;
+        return nturn;
+    }
+    if (kfrm == NULL)
+    {
+        WARNLOG("No keyframe before turn %lu in packet file",(unsigned long)target);
+        return nturn;
+    }
+    // Keyframes are written at start of a block
+    long block_idx = -1;
+    for (long i = 0; i < rd->blocks.count; i++)
+    {
+        if (rd->blocks.entries[i].turn == kfrm->turn)
+        {
+            block_idx = i;
+            break;
+        }
+    }
+    if ((block_idx < 0) || !restore_replay_keyframe(kfrm))
+        return nturn;
+    rd->block_idx = block_idx - 1;
+    rd->len = 0;
+    rd->pos = 0;
+    game.pckt_gameturn = kfrm->turn;
+    game.turns_fastforward = target - kfrm->turn;
+    SYNCLOG("Replay restored from keyframe of turn %lu, fast forwarding to turn %lu",(unsigned long)kfrm->turn,(unsigned long)target);
+    return kfrm->turn;
+}
+
+/**
+ * Requests the packet file being played to continue from given turn.
+ * The seek is done when packets for the next turn are loaded.
+ */
+TbBool seek_packet_file(GameTurn nturn)
+{
+    if (!game.packet_load_enable || !game.packet_fopened)
+        return false;
+    if (nturn >= game.turns_stored)
+        return false;
+    replay_reader.seek_pending = true;
+    replay_reader.seek_turn = nturn;
+    return true;
+}
+
 void clear_packets(void)
 {
     for (int i = 0; i < PACKETS_COUNT; i++)
@@ -156,7 +762,21 @@ TbBool open_packet_file_for_load(char *fname, struct CatalogueEntry *centry)
         return false;
     }
     game.packet_file_pos = LbFilePosition(game.packet_save_fp);
-    game.turns_stored = (LbFileLengthHandle(game.packet_save_fp) - game.packet_file_pos) / PACKET_TURN_SIZE;
+    // Check how the turns are stored, from version of the chunk which was just read
+    struct FileChunkHeader hdr;
+    LbFileSeek(game.packet_save_fp, game.packet_file_pos - sizeof(struct FileChunkHeader), Lb_FILE_SEEK_BEGINNING);
+    if (LbFileRead(game.packet_save_fp, &hdr, sizeof(struct FileChunkHeader)) != sizeof(struct FileChunkHeader))
+        hdr.ver = 0;
+    reset_replay_reader();
+    replay_reader.legacy_integrity = (hdr.ver < PACKET_DATA_VER_THING_HASH);
+    if (hdr.ver >= PACKET_DATA_VER_BLOCKS)
+    {
+        replay_reader.uses_blocks = true;
+        game.turns_stored = index_replay_blocks(game.packet_save_fp);
+    } else
+    {
+        game.turns_stored = (LbFileLengthHandle(game.packet_save_fp) - game.packet_file_pos) / PACKET_TURN_SIZE;
+    }
     if ((game.packet_checksum_verify) && (!game.packet_save_head.chksum_available))
     {
         WARNMSG("PacketSave checksum not available, checking disabled.");
@@ -186,13 +806,10 @@ void post_init_packets(void)
 }
 
 /**
- * Computes verification checksum for -packetsave/-packetload replay files.
- * NOT used for multiplayer - only for single-player replay integrity checking.
+ * Checksum of -packetsave/-packetload replay files made before ReplayIntegrity.
  * Sums position/movement data of all things except ambient sounds and effect elements.
- *
- * @return Checksum value for detecting replay file corruption
  */
-TbBigChecksum compute_replay_integrity(void)
+static TbBigChecksum compute_legacy_replay_integrity(void)
 {
     TbBigChecksum sum = 0;
     for (long tng_idx = 0; tng_idx < THINGS_COUNT; tng_idx++)
@@ -212,37 +829,210 @@ TbBigChecksum compute_replay_integrity(void)
     return sum;
 }
 
+static inline uint32_t replay_hash_add(uint32_t hash, uint32_t value)
+{
+    return (hash ^ value) * 16777619u;
+}
+
+/**
+ * Hash of one thing for the replay checksum.
+ * Fields are hashed in order and the thing index is mixed in, so things swapping values change the sum.
+ * Owner, position and angle can only be hashed because things changing them are touched,
+ * see touch_replay_integrity_of_thing().
+ */
+static TbBigChecksum replay_thing_hash(const struct Thing *thing)
+{
+    uint32_t hash = replay_hash_add(2166136261u, thing->index);
+    hash = replay_hash_add(hash, thing->class_id);
+    hash = replay_hash_add(hash, thing->model);
+    hash = replay_hash_add(hash, thing->creation_turn);
+    hash = replay_hash_add(hash, thing->owner);
+    hash = replay_hash_add(hash, thing->mappos.x.val);
+    hash = replay_hash_add(hash, thing->mappos.y.val);
+    hash = replay_hash_add(hash, thing->mappos.z.val);
+    hash = replay_hash_add(hash, thing->move_angle_xy);
+    // Spread the bits, so that the parts don't cancel each other out when summed
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static TbBool thing_has_replay_integrity_part(const struct Thing *thing)
+{
+    return (thing->index > 0) && (thing->index <= SYNCED_THINGS_COUNT)
+        && ((thing->alloc_flags & TAlF_Exists) != 0) && !is_non_synchronized_thing_class(thing->class_id);
+}
+
+/**
+ * Computes the replay checksum from scratch, scanning all synchronized things.
+ * @param parts Array to be filled with hashes of things, or NULL.
+ */
+static TbBigChecksum compute_full_replay_integrity(TbBigChecksum *parts)
+{
+    TbBigChecksum sum = 0;
+    if (parts != NULL)
+        memset(parts, 0, sizeof(replay_integrity.parts));
+    for (long tng_idx = 1; tng_idx <= SYNCED_THINGS_COUNT; tng_idx++)
+    {
+        struct Thing* tng = thing_get(tng_idx);
+        if (!thing_has_replay_integrity_part(tng))
+            continue;
+        TbBigChecksum part = replay_thing_hash(tng);
+        if (parts != NULL)
+            parts[tng_idx] = part;
+        sum += part;
+    }
+    return sum;
+}
+
+/**
+ * Stores current state of given thing in the replay checksum.
+ * Called when things are created or change model; cheap when no checksum is being kept.
+ * Changes which happen many times a turn should use touch_replay_integrity_of_thing() instead.
+ */
+void update_replay_integrity_of_thing(const struct Thing *thing)
+{
+    if (!replay_integrity.valid)
+        return;
+    if (!thing_has_replay_integrity_part(thing))
+        return;
+    TbBigChecksum part = replay_thing_hash(thing);
+    replay_integrity.total += part - replay_integrity.parts[thing->index];
+    replay_integrity.parts[thing->index] = part;
+}
+
+/**
+ * Marks given thing to be hashed again before the replay checksum is computed.
+ * Called when things are updated, moved or change owner; cheap when no checksum is being kept.
+ */
+void touch_replay_integrity_of_thing(const struct Thing *thing)
+{
+    if (!replay_integrity.valid)
+        return;
+    if ((thing->index <= 0) || (thing->index > SYNCED_THINGS_COUNT))
+        return;
+    if (replay_integrity.touched[thing->index])
+        return;
+    replay_integrity.touched[thing->index] = 1;
+    replay_integrity.touched_list[replay_integrity.touched_count] = thing->index;
+    replay_integrity.touched_count++;
+}
+
+static void update_replay_integrity_of_touched_things(void)
+{
+    for (long i = 0; i < replay_integrity.touched_count; i++)
+    {
+        ThingIndex tng_idx = replay_integrity.touched_list[i];
+        replay_integrity.touched[tng_idx] = 0;
+        // Deleted things were already removed from the sum
+        update_replay_integrity_of_thing(thing_get(tng_idx));
+    }
+    replay_integrity.touched_count = 0;
+}
+
+/**
+ * Removes given thing from the replay checksum. Called when the thing is deleted.
+ */
+void remove_replay_integrity_of_thing(const struct Thing *thing)
+{
+    if (!replay_integrity.valid)
+        return;
+    if ((thing->index <= 0) || (thing->index > SYNCED_THINGS_COUNT))
+        return;
+    replay_integrity.total -= replay_integrity.parts[thing->index];
+    replay_integrity.parts[thing->index] = 0;
+}
+
+/**
+ * Makes the replay checksum be built again by a full scan, when things were replaced as a whole.
+ */
+void invalidate_replay_integrity(void)
+{
+    replay_integrity.valid = false;
+    memset(replay_integrity.touched, 0, sizeof(replay_integrity.touched));
+    replay_integrity.touched_count = 0;
+}
+
+/**
+ * Computes verification checksum for -packetsave/-packetload replay files.
+ * NOT used for multiplayer - only for single-player replay integrity checking.
+ * Sums hashes of all synchronized things, kept up to date as they change; things touched
+ * since the last call are hashed again here.
+ * With -packetfullscan, all things are also scanned every turn, and a stale sum is reported.
+ *
+ * @return Checksum value for detecting replay file corruption
+ */
+TbBigChecksum compute_replay_integrity(void)
+{
+    if (game.packet_load_enable && replay_reader.legacy_integrity)
+        return compute_legacy_replay_integrity();
+    if (!replay_integrity.valid)
+    {
+        replay_integrity.total = compute_full_replay_integrity(replay_integrity.parts);
+        replay_integrity.valid = true;
+        return replay_integrity.total;
+    }
+    update_replay_integrity_of_touched_things();
+    if (start_params.packet_checksum_full_scan)
+    {
+        TbBigChecksum sum = compute_full_replay_integrity(NULL);
+        if (sum != replay_integrity.total)
+        {
+            WARNLOG("Kept replay checksum %08lx differs from full scan %08lx at turn %lu",
+                (unsigned long)replay_integrity.total, (unsigned long)sum, (unsigned long)game.play_gameturn);
+        }
+    }
+    return replay_integrity.total;
+}
+
 short save_packets(void)
 {
     const int turn_data_size = PACKET_TURN_SIZE;
-    unsigned char pckt_buf[PACKET_TURN_SIZE+4];
+    struct ReplayWriter *wr = &replay_writer;
     TbBigChecksum chksum;
     SYNCDBG(6,"Starting");
     if (game.packet_checksum_verify)
         chksum = compute_replay_integrity();
     else
         chksum = 0;
-    LbFileSeek(game.packet_save_fp, 0, Lb_FILE_SEEK_END);
+    GameTurn turn = wr->first_turn + wr->turns_count;
+    if ((turn % REPLAY_KEYFRAME_INTERVAL) == 0)
+    {
+        // Keyframe goes between blocks, so that playing from it starts with a new block
+        finish_replay_keyframe();
+        LbFileSeek(game.packet_save_fp, 0, Lb_FILE_SEEK_END);
+        if (!flush_replay_turns())
+            return false;
+        write_replay_keyframe(turn);
+    }
+    if (!replay_buffer_reserve(&wr->buf, &wr->size, wr->len + turn_data_size + NET_PLAYERS_COUNT * PLAYER_MP_MESSAGE_LEN))
+    {
+        ERRORLOG("Cannot allocate buffer for packet file");
+        return false;
+    }
     // Prepare data in the buffer
+    unsigned char *pckt_buf = wr->buf + wr->len;
+    memset(pckt_buf, 0, turn_data_size);
     for (int i = 0; i < NET_PLAYERS_COUNT; i++)
         memcpy(&pckt_buf[i*sizeof(struct Packet)], &game.packets[i], sizeof(struct Packet));
     memcpy(&pckt_buf[NET_PLAYERS_COUNT*sizeof(struct Packet)], &chksum, sizeof(TbBigChecksum));
-    // Write buffer into file
-    if (LbFileWrite(game.packet_save_fp, &pckt_buf, turn_data_size) != turn_data_size)
-    {
-        ERRORLOG("Packet file write error");
-    }
+    wr->len += turn_data_size;
     for (int i = 0; i < NET_PLAYERS_COUNT; i++) {
         if (game.packets[i].action == PckA_PlyrMsgEnd) {
-            if (LbFileWrite(game.packet_save_fp, get_player(i)->mp_pending_message, PLAYER_MP_MESSAGE_LEN) != PLAYER_MP_MESSAGE_LEN) {
-                ERRORLOG("Chat message file write error");
-            }
+            memcpy(wr->buf + wr->len, get_player(i)->mp_pending_message, PLAYER_MP_MESSAGE_LEN);
+            wr->len += PLAYER_MP_MESSAGE_LEN;
         }
     }
-    if ( !LbFileFlush(game.packet_save_fp) )
+    wr->turns_count++;
+    // Turns are written in blocks rather than flushed every turn
+    if (wr->turns_count >= REPLAY_TURNS_PER_BLOCK)
     {
-        ERRORLOG("Unable to flush PacketSave File");
-        return false;
+        finish_replay_keyframe();
+        LbFileSeek(game.packet_save_fp, 0, Lb_FILE_SEEK_END);
+        return flush_replay_turns();
     }
     return true;
 }
@@ -251,10 +1041,19 @@ void close_packet_file(void)
 {
     if ( game.packet_fopened )
     {
+        finish_replay_keyframe();
+        // Write the turns which didn't fill a whole block
+        if (replay_writer.turns_count > 0)
+        {
+            LbFileSeek(game.packet_save_fp, 0, Lb_FILE_SEEK_END);
+            flush_replay_turns();
+        }
         LbFileClose(game.packet_save_fp);
         game.packet_fopened = 0;
         game.packet_save_fp = NULL;
     }
+    reset_replay_writer();
+    reset_replay_reader();
 }
 
 void dump_memory_to_file(const char * fname, const char * buf, size_t len)
@@ -287,6 +1086,7 @@ TbBool reinit_packets_after_load(void)
     game.packet_load_enable = false;
     game.packet_save_fp = NULL;
     game.packet_fopened = 0;
+    invalidate_replay_integrity();
     return true;
 }
 
@@ -301,7 +1101,7 @@ TbBool open_new_packet_file_for_save(void)
     game.packet_save_head.level_num = get_loaded_level_number();
     game.packet_save_head.players_exist = 0;
     game.packet_save_head.players_comp = 0;
-    game.packet_save_head.chksum_available = game.packet_checksum_verify;
+    game.packet_save_head.chksum_available = (game.packet_checksum_verify != 0);
     game.packet_save_head.isometric_view_zoom_level = settings.isometric_view_zoom_level;
     game.packet_save_head.frontview_zoom_level = settings.frontview_zoom_level;
     game.packet_save_head.isometric_tilt = settings.isometric_tilt;
@@ -339,25 +1139,96 @@ TbBool open_new_packet_file_for_save(void)
         game.packet_save_fp = NULL;
         return false;
     }
+    reset_replay_writer();
     game.packet_fopened = 1;
     return true;
 }
 
+/**
+ * Begins verifying the packet file which was just opened for load.
+ * The whole file is fast forwarded, and the game quits at its end or at the first checksum mismatch.
+ */
+void start_replay_verification(void)
+{
+    memset(&replay_verify, 0, sizeof(replay_verify));
+    if (!game.packet_fopened)
+    {
+        ERRORLOG("PacketVerify: no packet file to verify");
+        exit_keeper = 1;
+        return;
+    }
+    if (!game.packet_checksum_verify)
+    {
+        ERRORLOG("PacketVerify: packet file has no checksums to verify");
+        exit_keeper = 1;
+        return;
+    }
+    replay_verify.started = true;
+    replay_verify.start_clock = LbTimerClock();
+    game.turns_fastforward = game.turns_stored;
+}
+
+static void stop_replay_verification(void)
+{
+    if (replay_verify.finished)
+        return;
+    replay_verify.finished = true;
+    replay_verify.end_clock = LbTimerClock();
+    exit_keeper = 1;
+}
+
+/**
+ * Writes the verification result to the log, in a line meant to be read by tools.
+ * @return Process exit code; 0 if the whole file was played without a mismatch.
+ */
+int report_replay_verification(void)
+{
+    const char *result;
+    int exit_code;
+    if (replay_verify.diverged) {
+        result = "FAIL";
+        exit_code = 1;
+    } else
+    if (replay_verify.finished) {
+        result = "PASS";
+        exit_code = 0;
+    } else {
+        // Never started, or the game ended before the file did
+        result = "ERROR";
+        exit_code = 2;
+    }
+    TbClockMSec end_clock = replay_verify.finished ? replay_verify.end_clock : LbTimerClock();
+    unsigned long elapsed = replay_verify.started ? (unsigned long)(end_clock - replay_verify.start_clock) : 0;
+    double turns_per_sec = (elapsed > 0) ? (replay_verify.turns_checked * 1000.0 / elapsed) : 0.0;
+    long diverged_turn = replay_verify.diverged ? (long)replay_verify.diverged_turn : -1;
+    JUSTMSG("PacketVerify: result=%s turns=%lu stored=%lu diverged_at=%ld elapsed_ms=%lu turns_per_sec=%.1f file=\"%s\"",
+        result, (unsigned long)replay_verify.turns_checked, (unsigned long)game.turns_stored, diverged_turn,
+        elapsed, turns_per_sec, game.packet_fname);
+    return exit_code;
+}
+
 void load_packets_for_turn(GameTurn nturn)
 {
     SYNCDBG(19,"Starting");
     const int turn_data_size = PACKET_TURN_SIZE;
     unsigned char pckt_buf[PACKET_TURN_SIZE+4];
+    if (replay_reader.seek_pending)
+        nturn = apply_replay_seek(nturn);
     struct Packet* pckt = get_packet(my_player_number);
     TbBigChecksum pckt_chksum = pckt->checksum;
     if (nturn >= game.turns_stored)
     {
+        if (replay_verify.started)
+        {
+            stop_replay_verification();
+            return;
+        }
         ERRORDBG(18,"Out of turns to load from Packet File");
         erstat_inc(ESE_CantReadPackets);
         return;
     }
 
-    if (LbFileRead(game.packet_save_fp, &pckt_buf, turn_data_size) == -1)
+    if (replay_read(&pckt_buf, turn_data_size) == -1)
     {
         ERRORDBG(18,"Cannot read turn data from Packet File");
         erstat_inc(ESE_CantReadPackets);
@@ -368,7 +1239,7 @@ void load_packets_for_turn(GameTurn nturn)
         memcpy(&game.packets[i], &pckt_buf[i * sizeof(struct Packet)], sizeof(struct Packet));
     for (long i = 0; i < NET_PLAYERS_COUNT; i++) {
         if (game.packets[i].action == PckA_PlyrMsgEnd) {
-            if (LbFileRead(game.packet_save_fp, get_player(i)->mp_pending_message, PLAYER_MP_MESSAGE_LEN) == PLAYER_MP_MESSAGE_LEN) {
+            if (replay_read(get_player(i)->mp_pending_message, PLAYER_MP_MESSAGE_LEN) == PLAYER_MP_MESSAGE_LEN) {
                 game.packet_file_pos += PLAYER_MP_MESSAGE_LEN;
             } else {
                 ERRORDBG(18,"Cannot read chat message from Packet File");
@@ -381,19 +1252,31 @@ void load_packets_for_turn(GameTurn nturn)
     if (game.packet_checksum_verify)
     {
         pckt = get_packet(my_player_number);
+        TbBool in_sync = true;
         if (compute_replay_integrity() != tot_chksum)
         {
             ERRORLOG("PacketSave checksum - Out of sync (GameTurn %u)", game.play_gameturn);
-            if (!is_onscreen_msg_visible())
-                show_onscreen_msg(game_num_fps, "Out of sync");
+            in_sync = false;
         } else
         if (pckt->checksum != pckt_chksum)
         {
             ERRORLOG("Oops we are really Out Of Sync (GameTurn %u)", game.play_gameturn);
+            in_sync = false;
+        }
+        if (!in_sync)
+        {
+            if (replay_verify.started && !replay_verify.diverged)
+            {
+                replay_verify.diverged = true;
+                replay_verify.diverged_turn = game.play_gameturn;
+                stop_replay_verification();
+            }
             if (!is_onscreen_msg_visible())
                 show_onscreen_msg(game_num_fps, "Out of sync");
         }
     }
+    if (replay_verify.started && !replay_verify.finished)
+        replay_verify.turns_checked++;
 }
 
 void set_packet_pause_toggle()
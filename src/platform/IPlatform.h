@@ -68,6 +68,12 @@ public:
     virtual long         FileLength(const char* fname) = 0;
     /** Deletes a file.  Returns 1 on success, -1 on failure. */
     virtual int          FileDelete(const char* fname) = 0;
+    /** Maps a whole file read-only into memory; its pages are read on first
+     *  access and shared with the OS file cache.  Returns NULL if the file
+     *  cannot be mapped, `len` receives its size.  Default: not supported. */
+    virtual const void*  FileMap(const char* /*fname*/, size_t* len) { *len = 0; return nullptr; }
+    /** Releases memory returned by FileMap(). */
+    virtual void         FileUnmap(const void* /*data*/, size_t /*len*/) {}
 
     // ----- Path provider -----
     /** Called once at startup with the raw argc/argv before any path queries.
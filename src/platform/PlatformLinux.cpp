@@ -5,6 +5,8 @@
 #include <memory>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <fnmatch.h>
@@ -300,3 +302,24 @@ int PlatformLinux::FileDelete(const char* fname)
 {
     return remove(fname) ? -1 : 1;
 }
+
+const void* PlatformLinux::FileMap(const char* fname, size_t* len)
+{
+    *len = 0;
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    void* data = MAP_FAILED;
+    if ((fstat(fd, &st) == 0) && (st.st_size > 0))
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+    *len = st.st_size;
+    return data;
+}
+
+void PlatformLinux::FileUnmap(const void* data, size_t len)
+{
+    if (data) munmap(const_cast<void*>(data), len);
+}
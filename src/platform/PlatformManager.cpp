@@ -141,6 +141,16 @@ extern "C" int PlatformManager_FileDelete(const char* fname)
     return PlatformManager::Get()->FileDelete(fname);
 }
 
+extern "C" const void* PlatformManager_FileMap(const char* fname, size_t* len)
+{
+    return PlatformManager::Get()->FileMap(fname, len);
+}
+
+extern "C" void PlatformManager_FileUnmap(const void* data, size_t len)
+{
+    PlatformManager::Get()->FileUnmap(data, len);
+}
+
 extern "C" void PlatformManager_LogWrite(const char* message)
 {
     IPlatform* p = PlatformManager::Get();
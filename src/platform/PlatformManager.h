@@ -43,6 +43,8 @@ TbBool       PlatformManager_FileEof(TbFileHandle handle);
 short        PlatformManager_FileFlush(TbFileHandle handle);
 long         PlatformManager_FileLength(const char* fname);
 int          PlatformManager_FileDelete(const char* fname);
+const void*  PlatformManager_FileMap(const char* fname, size_t* len);
+void         PlatformManager_FileUnmap(const void* data, size_t len);
 void        PlatformManager_LogWrite(const char* message);
 /** Called once per frame to allow the platform to perform per-frame housekeeping
  *  (e.g. prevent screen blanking on Vita via sceKernelPowerTick). */
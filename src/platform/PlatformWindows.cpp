@@ -464,3 +464,31 @@ int PlatformWindows::FileDelete(const char* fname)
 {
     return remove(fname) ? -1 : 1;
 }
+
+const void* PlatformWindows::FileMap(const char* fname, size_t* len)
+{
+    *len = 0;
+    HANDLE file = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER size;
+    const void* data = nullptr;
+    if (GetFileSizeEx(file, &size) && (size.QuadPart > 0))
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
+        {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            // The view keeps the mapping alive
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    if (!data) return nullptr;
+    *len = (size_t)size.QuadPart;
+    return data;
+}
+
+void PlatformWindows::FileUnmap(const void* data, size_t /*len*/)
+{
+    if (data) UnmapViewOfFile(data);
+}
@@ -34,6 +34,8 @@ public:
     short        FileFlush(TbFileHandle handle) override;
     long         FileLength(const char* fname) override;
     int          FileDelete(const char* fname) override;
+    const void*  FileMap(const char* fname, size_t* len) override;
+    void         FileUnmap(const void* data, size_t len) override;
 
     void        SetArgv(int argc, char** argv) override;
     const char* GetDataPath() const override;
@@ -51,6 +51,7 @@
 #include "gui_soundmsgs.h"
 #include "magic_powers.h"
 #include "room_util.h"
+#include "packets.h"
 #include "game_legacy.h"
 #include "frontmenu_ingame_map.h"
 #include "keeperfx.hpp"
@@ -103,6 +104,19 @@ unsigned short const room_effect_elements[] = { TngEffElm_RedFlame, TngEffElm_Bl
 }
 #endif
 /******************************************************************************/
+/**
+ * Slabs of a room in order of the room slabs list, for picking n-th slab without walking the list.
+ * Not a part of game state; rebuilt from the list when needed.
+ */
+struct RoomSlabsIndex {
+    SlabCodedCoords *slabs;
+    unsigned long count;
+    unsigned long capacity;
+    TbBool valid;
+};
+
+static struct RoomSlabsIndex room_slabs_index[ROOMS_COUNT+1];
+/******************************************************************************/
 struct Room *room_get(RoomIndex room_idx)
 {
   if ((room_idx < 1) || (room_idx > ROOMS_COUNT))
@@ -250,38 +264,15 @@ long count_slabs_of_room_type(PlayerNumber plyr_idx, RoomKind rkind)
 
 void get_room_kind_total_and_used_capacity(struct Dungeon *dungeon, RoomKind rkind, int32_t *total_cap, int32_t *used_cap)
 {
-    unsigned int total_capacity = 0;
-    unsigned int used_capacity = 0;
-    long i = dungeon->room_list_start[rkind];
-    unsigned long k = 0;
-    while (i != 0)
-    {
-        struct Room* room = room_get(i);
-        if (room_is_invalid(room))
-        {
-            ERRORLOG("Jump to invalid room detected");
-            break;
-        }
-        i = room->next_of_owner;
-        // Per-room code
-        used_capacity += room->used_capacity;
-        total_capacity += room->total_capacity;
-        // Per-room code ends
-        k++;
-        if (k > ROOMS_COUNT)
-        {
-          ERRORLOG("Infinite loop detected when sweeping rooms list");
-          break;
-        }
-    }
-    *total_cap = total_capacity;
-    *used_cap = used_capacity;
+#if (BFDEBUG_LEVEL > 0)
+    check_room_kind_capacity_totals(dungeon, rkind);
+#endif
+    *total_cap = dungeon->room_kind_total_capacity[rkind];
+    *used_cap = dungeon->room_kind_used_capacity[rkind];
 }
 
 void get_room_kind_total_used_and_storage_capacity(struct Dungeon *dungeon, RoomKind rkind, int32_t *total_cap, int32_t *used_cap, int32_t *storaged_cap)
 {
-    unsigned int total_capacity = 0;
-    unsigned int used_capacity = 0;
     int storaged_capacity = 0;
     long i = dungeon->room_list_start[rkind];
     unsigned long k = 0;
@@ -295,8 +286,6 @@ void get_room_kind_total_used_and_storage_capacity(struct Dungeon *dungeon, Room
         }
         i = room->next_of_owner;
         // Per-room code
-        used_capacity += room->used_capacity;
-        total_capacity += room->total_capacity;
         storaged_capacity += room->capacity_used_for_storage;
         // Per-room code ends
         k++;
@@ -306,8 +295,8 @@ void get_room_kind_total_used_and_storage_capacity(struct Dungeon *dungeon, Room
           break;
         }
     }
-    *total_cap = total_capacity;
-    *used_cap = used_capacity;
+    // Storage shares the room fields with other data, so it has no totals and is summed here
+    get_room_kind_total_and_used_capacity(dungeon, rkind, total_cap, used_cap);
     *storaged_cap = storaged_capacity;
 }
 
@@ -328,6 +317,77 @@ void set_room_efficiency(struct Room *room)
     room->efficiency = calculate_room_efficiency(room);
 }
 
+static void change_room_kind_capacity_totals(const struct Room *room, long total_delta, long used_delta)
+{
+    struct Dungeon* dungeon = get_dungeon(room->owner);
+    if (dungeon_invalid(dungeon)) {
+        return;
+    }
+    dungeon->room_kind_total_capacity[room->kind] += total_delta;
+    dungeon->room_kind_used_capacity[room->kind] += used_delta;
+}
+
+/**
+ * Changes owner of a room, moving its capacity to totals of the new owner.
+ * Lists of player rooms are not updated here.
+ */
+void set_room_owner(struct Room *room, PlayerNumber owner)
+{
+    change_room_kind_capacity_totals(room, -(long)room->total_capacity, -(long)room->used_capacity);
+    room->owner = owner;
+    change_room_kind_capacity_totals(room, room->total_capacity, room->used_capacity);
+}
+
+/**
+ * Sets total capacity of a room. Room capacity should only be changed through these functions,
+ * so that the totals for the owning player stay valid.
+ */
+void set_room_total_capacity(struct Room *room, long capacity)
+{
+    long prev_capacity = room->total_capacity;
+    room->total_capacity = capacity;
+    change_room_kind_capacity_totals(room, (long)room->total_capacity - prev_capacity, 0);
+}
+
+void set_room_used_capacity(struct Room *room, long capacity)
+{
+    long prev_capacity = room->used_capacity;
+    room->used_capacity = capacity;
+    change_room_kind_capacity_totals(room, 0, (long)room->used_capacity - prev_capacity);
+}
+
+void change_room_used_capacity(struct Room *room, long delta)
+{
+    set_room_used_capacity(room, room->used_capacity + delta);
+}
+
+/**
+ * Compares capacity totals of given room kind with a full recount of the rooms.
+ * On mismatch, only logs an error; the totals are synchronized state, so a check
+ * done by debug builds only must not change them.
+ * @return True if the totals were valid.
+ */
+TbBool check_room_kind_capacity_totals(struct Dungeon *dungeon, RoomKind rkind)
+{
+    long total_capacity = 0;
+    long used_capacity = 0;
+    for (long i = 1; i < ROOMS_COUNT; i++)
+    {
+        struct Room* room = &game.rooms[i];
+        if (((room->alloc_flags & RoF_Allocated) == 0) || (room->kind != rkind))
+            continue;
+        if (get_dungeon(room->owner) != dungeon)
+            continue;
+        total_capacity += room->total_capacity;
+        used_capacity += room->used_capacity;
+    }
+    if ((dungeon->room_kind_total_capacity[rkind] == total_capacity) && (dungeon->room_kind_used_capacity[rkind] == used_capacity))
+        return true;
+    ERRORLOG("Player %d %s capacity totals are %d/%d, but rooms have %d/%d",(int)dungeon->owner,room_code_name(rkind),
+        (int)dungeon->room_kind_used_capacity[rkind],(int)dungeon->room_kind_total_capacity[rkind],(int)used_capacity,(int)total_capacity);
+    return false;
+}
+
 void init_reposition_struct(struct RoomReposition * rrepos)
 {
     rrepos->used = 0;
@@ -407,6 +467,7 @@ TbBool move_thing_to_different_room(struct Thing* thing, struct Coord3d* pos)
 
 void count_workers_in_room(struct Room *room)
 {
+#if (BFDEBUG_LEVEL > 0)
     int count = 0;
     long i = room->creatures_list;
     unsigned long k = 0;
@@ -431,12 +492,18 @@ void count_workers_in_room(struct Room *room)
           break;
         }
     }
-    room->used_capacity += count;
+    // Only reported, as this is not done by release builds
+    if (count != room->workers_count)
+    {
+        ERRORLOG("The %s index %d has %d workers, but %d are counted",room_code_name(room->kind),(int)room->index,(int)room->workers_count,count);
+    }
+#endif
+    change_room_used_capacity(room, room->workers_count);
 }
 
 void count_slabs_all_only(struct Room *room)
 {
-    room->total_capacity = room->slabs_count;
+    set_room_total_capacity(room, room->slabs_count);
 }
 
 void count_slabs_all_wth_effcncy(struct Room *room)
@@ -445,7 +512,7 @@ void count_slabs_all_wth_effcncy(struct Room *room)
     count = (count/ROOM_EFFICIENCY_MAX);
     if (count <= 1)
         count = 1;
-    room->total_capacity = count;
+    set_room_total_capacity(room, count);
 }
 
 void count_slabs_no_min_wth_effcncy(struct Room *room)
@@ -454,7 +521,7 @@ void count_slabs_no_min_wth_effcncy(struct Room *room)
     count = (count/ROOM_EFFICIENCY_MAX);
     if (count < 1)
         count = 0;
-    room->total_capacity = count;
+    set_room_total_capacity(room, count);
 }
 
 void count_slabs_div2_wth_effcncy(struct Room *room)
@@ -463,7 +530,7 @@ void count_slabs_div2_wth_effcncy(struct Room *room)
     count = ((count/ROOM_EFFICIENCY_MAX) >> 1);
     if (count <= 1)
         count = 1;
-    room->total_capacity = count;
+    set_room_total_capacity(room, count);
 }
 
 void count_slabs_div2_nomin_effcncy(struct Room *room)
@@ -472,7 +539,7 @@ void count_slabs_div2_nomin_effcncy(struct Room *room)
     count = ((count/ROOM_EFFICIENCY_MAX) >> 1);
     if (count < 1)
         count = 0;
-    room->total_capacity = count;
+    set_room_total_capacity(room, count);
 }
 
 void count_slabs_mul2_wth_effcncy(struct Room *room)
@@ -481,7 +548,7 @@ void count_slabs_mul2_wth_effcncy(struct Room *room)
     count = ((count/ROOM_EFFICIENCY_MAX) << 1);
     if (count <= 1)
         count = 1;
-    room->total_capacity = count;
+    set_room_total_capacity(room, count);
 }
 
 void count_slabs_pow2_wth_effcncy(struct Room *room)
@@ -490,7 +557,7 @@ void count_slabs_pow2_wth_effcncy(struct Room *room)
     count = (count/ROOM_EFFICIENCY_MAX/ROOM_EFFICIENCY_MAX);
     if (count <= 1)
         count = 1;
-    room->total_capacity = count;
+    set_room_total_capacity(room, count);
 }
 
 void delete_room_structure(struct Room *room)
@@ -502,6 +569,9 @@ void delete_room_structure(struct Room *room)
     }
     if ((room->alloc_flags & RoF_Allocated) != 0)
     {
+      set_room_total_capacity(room, 0);
+      set_room_used_capacity(room, 0);
+      invalidate_room_slabs_index(room);
       // This is almost remove_room_from_players_list(room, room->owner);
       // but it doesn't change room_slabs_count and is less careful - better not use too much
       if (room->owner != game.neutral_player_num)
@@ -536,6 +606,12 @@ void delete_all_room_structures(void)
         struct Room* room = &game.rooms[i];
         delete_room_structure(room);
     }
+    for (long i = 0; i < DUNGEONS_COUNT; i++)
+    {
+        struct Dungeon* dungeon = &game.dungeon[i];
+        memset(dungeon->room_kind_total_capacity, 0, sizeof(dungeon->room_kind_total_capacity));
+        memset(dungeon->room_kind_used_capacity, 0, sizeof(dungeon->room_kind_used_capacity));
+    }
 }
 
 /**
@@ -654,6 +730,46 @@ void recount_and_reassociate_room_slabs(struct Room *room)
     room->slabs_count = n;
 }
 
+/**
+ * Verifies the slabs count, which is updated when slabs are added or removed, against the room slabs list.
+ * Mismatches are only logged, so that the room state is the same as in builds which don't check it.
+ */
+TbBool check_room_slabs_count(struct Room *room)
+{
+    long n = 0;
+    unsigned long k = 0;
+    TbBool valid = true;
+    long i = room->slabs_list;
+    while (i > 0)
+    {
+        struct SlabMap* slb = get_slabmap_direct(i);
+        if (slabmap_block_invalid(slb))
+        {
+            ERRORLOG("Jump to invalid item when sweeping Slabs.");
+            return false;
+        }
+        if (slb->room_index != room->index)
+        {
+            ERRORLOG("The %s index %d has slab %ld which belongs to room %d",room_code_name(room->kind),(int)room->index,i,(int)slb->room_index);
+            valid = false;
+        }
+        i = get_next_slab_number_in_room(i);
+        n++;
+        k++;
+        if (k >= game.map_tiles_x*game.map_tiles_y)
+        {
+            ERRORLOG("Room slabs list length exceeded when sweeping");
+            return false;
+        }
+    }
+    if (room->slabs_count != n)
+    {
+        ERRORLOG("The %s index %d has %d slabs, but %ld are counted",room_code_name(room->kind),(int)room->index,(int)room->slabs_count,n);
+        valid = false;
+    }
+    return valid;
+}
+
 /** Returns coordinates of slab at mass centre of given room.
  *  Note that the slab returned may not be pat of the room - it is possible
  *   that the room is just surrounding the spot.
@@ -827,6 +943,96 @@ TbBool remove_room_from_players_list(struct Room *room, PlayerNumber plyr_idx)
     return true;
 }
 
+static TbBool room_slabs_index_append(struct RoomSlabsIndex *rsidx, SlabCodedCoords slb_num)
+{
+    if (rsidx->count >= rsidx->capacity)
+    {
+        unsigned long capacity = (rsidx->capacity > 0) ? 2 * rsidx->capacity : 16;
+        SlabCodedCoords *slabs = (SlabCodedCoords *)KfxRealloc(rsidx->slabs, capacity * sizeof(SlabCodedCoords));
+        if (slabs == NULL)
+        {
+            ERRORLOG("Cannot enlarge room slabs index to %lu slabs",capacity);
+            rsidx->valid = false;
+            return false;
+        }
+        rsidx->slabs = slabs;
+        rsidx->capacity = capacity;
+    }
+    rsidx->slabs[rsidx->count] = slb_num;
+    rsidx->count++;
+    return true;
+}
+
+static void rebuild_room_slabs_index(const struct Room *room)
+{
+    struct RoomSlabsIndex *rsidx = &room_slabs_index[room->index];
+    rsidx->count = 0;
+    rsidx->valid = true;
+    unsigned long k = 0;
+    for (SlabCodedCoords i = room->slabs_list; i != 0; i = get_next_slab_number_in_room(i))
+    {
+        if (!room_slabs_index_append(rsidx, i))
+            return;
+        k++;
+        if (k > room->slabs_count)
+        {
+            ERRORLOG("Room %s index %d slabs list length exceeded when sweeping.",room_code_name(room->kind),(int)room->index);
+            break;
+        }
+    }
+    if (rsidx->count != room->slabs_count)
+    {
+        WARNLOG("Number of slabs in %s index %d (%lu) is different than count (%u)",room_code_name(room->kind),(int)room->index,rsidx->count,(unsigned int)room->slabs_count);
+    }
+}
+
+/**
+ * Marks the slabs index of a room as outdated, so it will be rebuilt from the slabs list on next use.
+ * Needs to be called whenever the room slabs list is changed without the tiles list functions.
+ */
+void invalidate_room_slabs_index(const struct Room *room)
+{
+    room_slabs_index[room->index].valid = false;
+}
+
+void invalidate_all_room_slabs_index(void)
+{
+    for (long i = 0; i <= ROOMS_COUNT; i++)
+    {
+        room_slabs_index[i].valid = false;
+    }
+}
+
+void free_room_slabs_index(void)
+{
+    for (long i = 0; i <= ROOMS_COUNT; i++)
+    {
+        struct RoomSlabsIndex *rsidx = &room_slabs_index[i];
+        KfxFree(rsidx->slabs);
+        rsidx->slabs = NULL;
+        rsidx->count = 0;
+        rsidx->capacity = 0;
+        rsidx->valid = false;
+    }
+}
+
+/**
+ * Gives slabs of a room as an array, in the same order as in the room slabs list.
+ * @param room The room which slabs are to be returned.
+ * @param slabs_count Returns amount of slabs in the array.
+ * @return The array, valid until the room slabs are changed.
+ */
+const SlabCodedCoords *get_room_slabs(const struct Room *room, unsigned long *slabs_count)
+{
+    struct RoomSlabsIndex *rsidx = &room_slabs_index[room->index];
+    if ((!rsidx->valid) || (rsidx->count != room->slabs_count) || ((rsidx->count > 0) && (rsidx->slabs[0] != room->slabs_list)))
+    {
+        rebuild_room_slabs_index(room);
+    }
+    *slabs_count = rsidx->count;
+    return rsidx->slabs;
+}
+
 void add_slab_to_room_tiles_list(struct Room *room, MapSlabCoord slb_x, MapSlabCoord slb_y)
 {
     SlabCodedCoords slb_num = get_slab_number(slb_x, slb_y);
@@ -843,6 +1049,12 @@ void add_slab_to_room_tiles_list(struct Room *room, MapSlabCoord slb_x, MapSlabC
         nxslb->next_in_room = 0;
     }
     room->slabs_list_tail = slb_num;
+    struct RoomSlabsIndex *rsidx = &room_slabs_index[room->index];
+    if (rsidx->valid && (rsidx->count + 1 == room->slabs_count)) {
+        room_slabs_index_append(rsidx, slb_num);
+    } else {
+        rsidx->valid = false;
+    }
 }
 
 /**
@@ -859,6 +1071,8 @@ TbBool add_slab_list_to_room_tiles_list(struct Room *room, SlabCodedCoords slb_n
         struct SlabMap* pvslb = get_slabmap_direct(room->slabs_list_tail);
         pvslb->next_in_room = slb_num;
     }
+    // The joined slabs would have to be appended one by one anyway, so let the index be rebuilt when needed
+    invalidate_room_slabs_index(room);
     SlabCodedCoords tail_slb_num = slb_num;
     unsigned short k = 0;
     while (1)
@@ -885,6 +1099,7 @@ TbBool add_slab_list_to_room_tiles_list(struct Room *room, SlabCodedCoords slb_n
 void remove_slab_from_room_tiles_list(struct Room *room, MapSlabCoord slb_x, MapSlabCoord slb_y)
 {
     SlabCodedCoords slb_num = get_slab_number(slb_x, slb_y);
+    invalidate_room_slabs_index(room);
 
     struct SlabMap* rmslb = get_slabmap_direct(slb_num);
     if (slabmap_block_invalid(rmslb))
@@ -953,8 +1168,8 @@ struct Room *prepare_new_room(PlayerNumber owner, RoomKind rkind, MapSubtlCoord
         return INVALID_ROOM;
     }
     struct Room* room = allocate_free_room_structure();
-    room->owner = owner;
     room->kind = rkind;
+    set_room_owner(room, owner);
     add_room_to_global_list(room);
     add_room_to_players_list(room, owner);
     MapSlabCoord slb_x = subtile_slab(stl_x);
@@ -974,14 +1189,15 @@ struct Room *create_room(PlayerNumber owner, RoomKind rkind, MapSubtlCoord stl_x
         if (room_is_invalid(room)) {
             return INVALID_ROOM;
         }
-        recount_and_reassociate_room_slabs(room);
         update_room_central_tile_position(room);
         create_room_flag(room);
     } else
     {
-        recount_and_reassociate_room_slabs(room);
         update_room_central_tile_position(room);
     }
+#if (BFDEBUG_LEVEL > 0)
+    check_room_slabs_count(room);
+#endif
     SYNCDBG(7,"Done");
     return room;
 }
@@ -1343,7 +1559,7 @@ struct Room* link_adjacent_rooms_of_type(PlayerNumber owner, MapSubtlCoord x, Ma
             if ((room->owner == owner) && (room->kind == rkind))
             {
                 // Add the central slab to room which was found
-                room->total_capacity = 0;
+                set_room_total_capacity(room, 0);
                 add_slab_to_room_tiles_list(room, central_slb_x, central_slb_y);
                 linkroom = room;
                 break;
@@ -1370,8 +1586,6 @@ struct Room* link_adjacent_rooms_of_type(PlayerNumber owner, MapSubtlCoord x, Ma
                     {
                         return INVALID_ROOM;
                     }
-                    // Update slabs in the new list
-                    recount_and_reassociate_room_slabs(linkroom);
                     update_room_total_capacity(linkroom);
                     link_room_health(linkroom,room);
                     // Make sure creatures working in the room won't leave
@@ -1382,6 +1596,7 @@ struct Room* link_adjacent_rooms_of_type(PlayerNumber owner, MapSubtlCoord x, Ma
                     room->slabs_count = 0;
                     room->slabs_list = 0;
                     room->slabs_list_tail = 0;
+                    invalidate_room_slabs_index(room);
                     // Delete the old room
                     free_room_structure(room);
                 }
@@ -1523,20 +1738,16 @@ TbBool find_random_valid_position_for_thing_in_room(struct Thing *thing, struct
     }
     int navi_radius = abs(thing_nav_block_sizexy(thing) << 8) >> 1;
     unsigned long k;
-    long n = THING_RANDOM(thing, room->slabs_count);
-    SlabCodedCoords slbnum = room->slabs_list;
-    for (k = n; k > 0; k--)
-    {
-        if (slbnum == 0)
-            break;
-        slbnum = get_next_slab_number_in_room(slbnum);
-    }
-    if (slbnum == 0) {
+    unsigned long slabs_count;
+    const SlabCodedCoords* slabs = get_room_slabs(room, &slabs_count);
+    unsigned long n = THING_RANDOM(thing, room->slabs_count);
+    if (n >= slabs_count) {
         ERRORLOG("Taking random slab (%d/%d) in %s index %d failed - internal inconsistency.",(int)n,(int)room->slabs_count,room_code_name(room->kind),(int)room->index);
-        slbnum = room->slabs_list;
+        n = 0;
     }
-    for (k = 0; k < room->slabs_count; k++)
+    for (k = 0; (k < room->slabs_count) && (slabs_count > 0); k++)
     {
+        SlabCodedCoords slbnum = slabs[n];
         MapSlabCoord slb_x = slb_num_decode_x(slbnum);
         MapSlabCoord slb_y = slb_num_decode_y(slbnum);
         int ssub = THING_RANDOM(thing, AROUND_TILES_COUNT);
@@ -1559,9 +1770,9 @@ TbBool find_random_valid_position_for_thing_in_room(struct Thing *thing, struct
             }
             ssub = (ssub + 1) % AROUND_TILES_COUNT;
         }
-        slbnum = get_next_slab_number_in_room(slbnum);
-        if (slbnum == 0) {
-            slbnum = room->slabs_list;
+        n++;
+        if (n >= slabs_count) {
+            n = 0;
         }
     }
     ERRORLOG("Could not find valid RANDOM point in %s for creature",room_code_name(room->kind));
@@ -1621,24 +1832,20 @@ TbBool slab_is_area_inner_fill(MapSlabCoord slb_x, MapSlabCoord slb_y)
 TbBool find_random_position_at_area_of_room(struct Coord3d *pos, const struct Room *room, unsigned char room_area,
         struct Thing *thing)
 {
+    unsigned long slabs_count;
+    const SlabCodedCoords* slabs = get_room_slabs(room, &slabs_count);
     // Find a random slab in the room to be used as our starting point
-    long i = THING_RANDOM(thing, room->slabs_count);
-    unsigned long n = room->slabs_list;
-    while (i > 0)
-    {
-        n = get_next_slab_number_in_room(n);
-        i--;
-    }
+    unsigned long n = THING_RANDOM(thing, room->slabs_count);
     // Now loop starting from that point
-    i = room->slabs_count;
-    while (i > 0)
+    long i = room->slabs_count;
+    while ((i > 0) && (slabs_count > 0))
     {
         // Loop the slabs list
-        if (n <= 0) {
-            n = room->slabs_list;
+        if (n >= slabs_count) {
+            n = 0;
         }
-        MapSlabCoord slb_x = slb_num_decode_x(n);
-        MapSlabCoord slb_y = slb_num_decode_y(n);
+        MapSlabCoord slb_x = slb_num_decode_x(slabs[n]);
+        MapSlabCoord slb_y = slb_num_decode_y(slabs[n]);
         if  ((room_area == RoArC_ANY)
          || ((room_area == RoArC_BORDER) && slab_is_area_outer_border(slb_x, slb_y))
          || ((room_area == RoArC_CENTER) && slab_is_area_inner_fill(slb_x, slb_y)))
@@ -1656,7 +1863,7 @@ TbBool find_random_position_at_area_of_room(struct Coord3d *pos, const struct Ro
                 }
             }
         }
-        n = get_next_slab_number_in_room(n);
+        n++;
         i--;
     }
     return false;
@@ -2672,6 +2879,7 @@ void delete_room_slab_when_no_free_room_structures(MapCoord slb_x, MapCoord slb_
             }
             while ( roomslb->next_in_room != 0 );
         }
+        invalidate_room_slabs_index(room);
         replace_room_slab(room, slb_x, slb_y, room->owner, gnd_slab);
         slb->next_in_room = 0;
     }
@@ -3409,7 +3617,7 @@ TbBool remove_item_from_room_capacity(struct Room *room)
         ERRORLOG("Room %s index %d does not contain item to remove",room_code_name(room->kind),(int)room->index);
         return false;
     }
-    room->used_capacity--;
+    change_room_used_capacity(room, -1);
     room->capacity_used_for_storage--;
     return true;
 }
@@ -3430,7 +3638,7 @@ TbBool add_item_to_room_capacity(struct Room *room, TbBool force)
             return false;
         }
     }
-    room->used_capacity++;
+    change_room_used_capacity(room, 1);
     room->capacity_used_for_storage++;
     return true;
 }
@@ -3450,6 +3658,8 @@ static void change_ownership_or_delete_object_thing_in_room(struct Room *room, s
     if (thing_is_dragged_or_pulled(thing)) {
         return;
     }
+    // Owner is changed in many ways below; the thing is hashed again later anyway
+    touch_replay_integrity_of_thing(thing);
     // Handle specific things in rooms for which we have a special re-creation code
     PlayerNumber oldowner;
 
@@ -3835,7 +4045,7 @@ long claim_room(struct Room *room, struct Thing *claimtng)
         return 0;
     }
     research_found_room(claimtng->owner, room->kind);
-    room->owner = claimtng->owner;
+    set_room_owner(room, claimtng->owner);
     room->health = compute_room_max_health(room->slabs_count, room->efficiency);
     add_room_to_players_list(room, claimtng->owner);
     change_room_map_element_ownership(room, claimtng->owner);
@@ -3866,7 +4076,7 @@ long claim_enemy_room(struct Room *room, struct Thing *claimtng)
     research_found_room(claimtng->owner, room->kind);
     reset_state_of_creatures_working_in_room(room);
     remove_room_from_players_list(room,oldowner);
-    room->owner = claimtng->owner;
+    set_room_owner(room, claimtng->owner);
     room->health = compute_room_max_health(room->slabs_count, room->efficiency);
     add_room_to_players_list(room, claimtng->owner);
     change_room_map_element_ownership(room, claimtng->owner);
@@ -3897,7 +4107,7 @@ long take_over_room(struct Room* room, PlayerNumber newowner)
     {
         reset_state_of_creatures_working_in_room(room);
         remove_room_from_players_list(room, oldowner);
-        room->owner = newowner;
+        set_room_owner(room, newowner);
         room->health = compute_room_max_health(room->slabs_count, room->efficiency);
         add_room_to_players_list(room, newowner);
         change_room_map_element_ownership(room, newowner);
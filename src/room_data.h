@@ -123,6 +123,8 @@ struct Room {
     unsigned char flames_around_idx;
     unsigned char flame_stl;
     GameTurn creation_turn;
+    /** Amount of creatures in creatures_list. */
+    unsigned short workers_count;
 };
 
 
@@ -155,6 +157,12 @@ TbBool room_exists(const struct Room *room);
 
 unsigned long compute_room_max_health(unsigned short slabs_count,unsigned short efficiency);
 void set_room_efficiency(struct Room *room);
+void set_room_owner(struct Room *room, PlayerNumber owner);
+void set_room_total_capacity(struct Room *room, long capacity);
+void set_room_used_capacity(struct Room *room, long capacity);
+void change_room_used_capacity(struct Room *room, long delta);
+TbBool check_room_kind_capacity_totals(struct Dungeon *dungeon, RoomKind rkind);
+TbBool check_room_slabs_count(struct Room *room);
 void do_room_recalculation(struct Room* room);
 long get_room_slabs_count(PlayerNumber plyr_idx, RoomKind rkind);
 long get_room_of_role_slabs_count(PlayerNumber plyr_idx, RoomRole rrole);
@@ -193,6 +201,10 @@ unsigned short i_can_allocate_free_room_structure(void);
 void add_slab_to_room_tiles_list(struct Room *room, MapSlabCoord slb_x, MapSlabCoord slb_y);
 void remove_slab_from_room_tiles_list(struct Room *room, MapSlabCoord slb_x, MapSlabCoord slb_y);
 TbBool add_slab_list_to_room_tiles_list(struct Room *room, SlabCodedCoords slb_num);
+const SlabCodedCoords *get_room_slabs(const struct Room *room, unsigned long *slabs_count);
+void invalidate_room_slabs_index(const struct Room *room);
+void invalidate_all_room_slabs_index(void);
+void free_room_slabs_index(void);
 void delete_all_room_structures(void);
 void delete_room_structure(struct Room *room);
 void delete_room_slabbed_objects(SlabCodedCoords slb_num);
@@ -59,7 +59,7 @@ TbBool remove_food_from_food_room_if_possible(struct Thing *thing)
     }
     if ( room->used_capacity > 0 )
     {
-        room->used_capacity--;
+        change_room_used_capacity(room, -1);
     }
     thing->food.life_remaining = game.conf.rules[thing->owner].gameplay.food_life_out_of_hatchery;
     thing->parent_idx = -1;
@@ -256,7 +256,7 @@ void count_and_reposition_food_in_room_on_subtile(struct Room *room, MapSubtlCoo
     if (matching_things_at_subtile > 0) {
         // This subtile contains bodies
         SYNCDBG(19,"Got %d matching things at (%d,%d)",(int)matching_things_at_subtile,(int)stl_x,(int)stl_y);
-        room->used_capacity += matching_things_at_subtile;
+        change_room_used_capacity(room, matching_things_at_subtile);
     } else
     {
         switch (matching_things_at_subtile)
@@ -288,7 +288,7 @@ void count_food_in_room(struct Room *room)
     for (long n = 0; n < 2; n++)
     {
         // The correct count should be taken from last sweep
-        room->used_capacity = 0;
+        set_room_used_capacity(room, 0);
         room->capacity_used_for_storage = 0;
         unsigned long k = 0;
         unsigned long i = room->slabs_list;
@@ -339,7 +339,7 @@ TbBool room_create_new_food_at(struct Room *room, MapSubtlCoord stl_x, MapSubtlC
         ERRORLOG("Created chicken in a wall");
     }
     int required_cap = get_required_room_capacity_for_object(RoRoF_FoodStorage, foodtng->model, 0);
-    room->used_capacity += required_cap;
+    change_room_used_capacity(room, required_cap);
     foodtng->food.life_remaining = (foodtng->max_frames << 8) / foodtng->anim_speed - 1;
     return true;
 }
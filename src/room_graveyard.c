@@ -59,7 +59,7 @@ TbBool add_body_to_graveyard(struct Thing *deadtng, struct Room *room)
         ERRORLOG("The %s is already decomposing in %s",thing_model_name(deadtng),room_role_code_name(RoRoF_DeadStorage));
         return false;
     }
-    room->used_capacity++;
+    change_room_used_capacity(room, 1);
     deadtng->corpse.laid_to_rest = 1;
     deadtng->health = game.conf.rules[room->owner].rooms.graveyard_convert_time;
     return true;
@@ -187,7 +187,7 @@ void count_and_reposition_bodies_in_room_on_subtile(struct Room *room, MapSubtlC
     if (matching_things_at_subtile > 0) {
         // This subtile contains bodies
         SYNCDBG(19,"Got %d matching things at (%d,%d)",(int)matching_things_at_subtile,(int)stl_x,(int)stl_y);
-        room->used_capacity += matching_things_at_subtile;
+        change_room_used_capacity(room, matching_things_at_subtile);
     } else
     {
         switch (matching_things_at_subtile)
@@ -219,7 +219,7 @@ void count_bodies_in_room(struct Room *room)
     for (long n = 0; n < 2; n++)
     {
         // The correct count should be taken from last sweep
-        room->used_capacity = 0;
+        set_room_used_capacity(room, 0);
         //room->capacity_used_for_storage = 0;
         unsigned long k = 0;
         unsigned long i = room->slabs_list;
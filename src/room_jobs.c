@@ -172,7 +172,7 @@ TbBool add_creature_to_work_room(struct Thing *creatng, struct Room *room, Creat
     int required_cap = get_required_room_capacity_for_job(jobpref, creatng->model);
     if (room->used_capacity + required_cap > room->total_capacity)
         return false;
-    room->used_capacity += required_cap;
+    change_room_used_capacity(room, required_cap);
     cctrl->work_room_id = room->index;
     cctrl->prev_in_room = 0;
     if (room->creatures_list != 0)
@@ -192,6 +192,7 @@ TbBool add_creature_to_work_room(struct Thing *creatng, struct Room *room, Creat
         cctrl->next_in_room = 0;
     }
     room->creatures_list = creatng->index;
+    room->workers_count++;
     cctrl->creature_control_flags |= CCFlg_IsInRoomList;
     return true;
 }
@@ -208,7 +209,7 @@ TbBool remove_creature_from_specific_room(struct Thing *creatng, struct Room *ro
     }
     int required_cap = get_required_room_capacity_for_job(jobpref, creatng->model);
     if (room->used_capacity >= required_cap) {
-        room->used_capacity -= required_cap;
+        change_room_used_capacity(room, -required_cap);
     } else {
         WARNLOG("Attempt to remove a creature from room %s with too little used space", room_code_name(room->kind));
     }
@@ -232,6 +233,9 @@ TbBool remove_creature_from_specific_room(struct Thing *creatng, struct Room *ro
             ERRORLOG("Linked list of rooms has invalid next element on thing %d",(int)creatng->index);
         }
     }
+    if (room->workers_count > 0) {
+        room->workers_count--;
+    }
     cctrl->last_work_room_id = cctrl->work_room_id;
     cctrl->work_room_id = 0;
     cctrl->creature_control_flags &= ~CCFlg_IsInRoomList;
@@ -296,7 +296,7 @@ void count_lair_occupants_on_slab(struct Room *room,MapSlabCoord slb_x, MapSlabC
                 struct CreatureControl* cctrl = creature_control_get_from_thing(creatng);
                 cctrl->lair_room_id = room->index;
                 room->content_per_model[creatng->model]++;
-                room->used_capacity += required_cap;
+                change_room_used_capacity(room, required_cap);
             }
         }
     }
@@ -304,7 +304,7 @@ void count_lair_occupants_on_slab(struct Room *room,MapSlabCoord slb_x, MapSlabC
 
 void count_lair_occupants(struct Room *room)
 {
-    room->used_capacity = 0;
+    set_room_used_capacity(room, 0);
     memset(room->content_per_model, 0, sizeof(room->content_per_model));
     unsigned long k = 0;
     unsigned long i = room->slabs_list;
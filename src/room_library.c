@@ -695,7 +695,7 @@ void count_and_reposition_books_in_room_on_subtile(struct Room *room, MapSubtlCo
     if (matching_things_at_subtile > 0) {
         // This subtile contains spells
         SYNCDBG(19,"Got %d matching things at (%d,%d)",(int)matching_things_at_subtile,(int)stl_x,(int)stl_y);
-        room->used_capacity += matching_things_at_subtile;
+        change_room_used_capacity(room, matching_things_at_subtile);
     } else
     {
         switch (matching_things_at_subtile)
@@ -732,7 +732,7 @@ void count_books_in_room(struct Room *room)
     for (long n = 0; n < 2; n++)
     {
         // The correct count should be taken from last sweep
-        room->used_capacity = 0;
+        set_room_used_capacity(room, 0);
         room->capacity_used_for_storage = 0;
         unsigned long k = 0;
         unsigned long i = room->slabs_list;
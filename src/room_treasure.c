@@ -48,17 +48,17 @@ void count_gold_slabs_wth_effcncy(struct Room *room)
     unsigned long count = room->slabs_count * subefficiency;
     if (count < 1)
         count = 1;
-    room->total_capacity = count;
+    set_room_total_capacity(room, count);
 }
 
 void count_gold_slabs_full(struct Room *room)
 {
-    room->total_capacity = room->slabs_count * get_wealth_size_types_count();
+    set_room_total_capacity(room, room->slabs_count * get_wealth_size_types_count());
 }
 
 void count_gold_slabs_div2(struct Room* room)
 {
-    room->total_capacity = room->slabs_count * get_wealth_size_types_count() / 2;
+    set_room_total_capacity(room, room->slabs_count * get_wealth_size_types_count() / 2);
 }
 
 struct Thing *find_gold_hoarde_at(MapSubtlCoord stl_x, MapSubtlCoord stl_y)
@@ -157,7 +157,7 @@ void count_gold_hoardes_in_room(struct Room *room)
     long wealth_size_holds = game.conf.rules[room->owner].gameplay.gold_per_hoard / get_wealth_size_types_count();
     GoldAmount max_hoard_size_in_room = wealth_size_holds * room->total_capacity / room->slabs_count;
     // First, set the values to something big; this will prevent logging warnings on add/remove_gold_from_hoarde()
-    room->used_capacity = room->total_capacity;
+    set_room_used_capacity(room, room->total_capacity);
     room->capacity_used_for_storage = room->used_capacity * wealth_size_holds;
     unsigned long k = 0;
     long i = room->slabs_list;
@@ -200,6 +200,6 @@ void count_gold_hoardes_in_room(struct Room *room)
         }
     }
     room->capacity_used_for_storage = all_gold_amount;
-    room->used_capacity = all_wealth_size;
+    set_room_used_capacity(room, all_wealth_size);
 }
 /******************************************************************************/
@@ -164,7 +164,7 @@ void remove_body_from_graveyard(struct Thing *thing)
         ERRORLOG("The %s is not in graveyard",thing_model_name(thing));
         return;
     }
-    room->used_capacity--;
+    change_room_used_capacity(room, -1);
     thing->corpse.laid_to_rest = 0;
     struct Dungeon* dungeon = get_dungeon(room->owner);
     dungeon->bodies_rotten_for_vampire++;
@@ -72,6 +72,7 @@
 #include "magic_powers.h"
 #include "map_blocks.h"
 #include "map_utils.h"
+#include "packets.h"
 #include "player_instances.h"
 #include "config_players.h"
 #include "power_hand.h"
@@ -4731,6 +4732,7 @@ void change_creature_owner(struct Thing *creatng, PlayerNumber nowner)
     }
     // Add the creature to new owner
     creatng->owner = nowner;
+    touch_replay_integrity_of_thing(creatng);
     set_first_creature(creatng);
     set_start_state(creatng);
     if (!is_neutral_thing(creatng))
@@ -6225,6 +6227,7 @@ void transfer_creature_data_and_gold(struct Thing *oldtng, struct Thing *newtng)
     newcctrl->kills_num_enemy = oldcctrl->kills_num_enemy;
     newcctrl->joining_age = oldcctrl->joining_age;
     newtng->creation_turn = oldtng->creation_turn;
+    update_replay_integrity_of_thing(newtng);
 
     if (ncrconf->gold_hold >= oldtng->creature.gold_carried)
     {
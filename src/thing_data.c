@@ -37,6 +37,7 @@
 #include "engine_arrays.h"
 #include "kjm_input.h"
 #include "gui_topmsg.h"
+#include "packets.h"
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -51,7 +52,7 @@ TbBool is_non_synchronized_thing_class(unsigned char class_id)
 static struct Thing *get_oldest_replaceable_effect(void)
 {
     if (game.thing_lists[TngList_EffectElems].index > 0) {
-        struct Thing *old_effect = thing_get(game.thing_lists[TngList_EffectElems].index);
+        struct Thing *old_effect = get_oldest_thing_in_list(&game.thing_lists[TngList_EffectElems]);
         if (!thing_is_invalid(old_effect)) {
             return old_effect;
         }
@@ -113,6 +114,13 @@ static struct Thing *allocate_thing(enum ThingAllocationPool pool_type, const ch
 struct Thing *allocate_free_thing_structure_f(unsigned char class_id, const char *func_name)
 {
     if (is_non_synchronized_thing_class(class_id)) {
+        if ((class_id == TCls_EffectElem) && (game.thing_lists[TngList_EffectElems].count >= game.conf.effects_conf.elements_budget)) {
+            // Over the elements budget - the oldest element gives its slot to the new one
+            struct Thing *old_effect = get_oldest_replaceable_effect();
+            if (old_effect != INVALID_THING) {
+                delete_thing_structure(old_effect, 0);
+            }
+        }
         if (game.unsynced_free_things_count == 0) {
             // No free slots - try deleting old effect and search again
             struct Thing *old_effect = get_oldest_replaceable_effect();
@@ -186,6 +194,7 @@ void delete_thing_structure_f(struct Thing *thing, TbBool deleting_everything, c
     }
     remove_thing_from_its_class_list(thing);
     remove_thing_from_mapwho(thing);
+    remove_replay_integrity_of_thing(thing);
     if (thing->index > 0) {
         if (thing->index <= SYNCED_THINGS_COUNT) {
             push_free_thing_index(game.synced_free_things, &game.synced_free_things_count, SYNCED_THINGS_COUNT, thing->index);
@@ -78,13 +78,30 @@ struct EffectElementConfigStats *get_effect_element_model_stats(ThingModel tngmo
     return &game.conf.effects_conf.effectelement_cfgstats[tngmodel];
 }
 
+/**
+ * Checks whether a new effect element at given position could be seen by any player.
+ * When most of the elements budget is used, only elements near to player cameras are created,
+ * so that the ones which are seen aren't replaced by far away ones.
+ */
+static TbBool effect_element_worth_creating_at(const struct Coord3d *pos)
+{
+    if (!any_player_close_enough_to_see(pos)) {
+        return false;
+    }
+    const struct EffectsConfig *effects_conf = &game.conf.effects_conf;
+    if (game.thing_lists[TngList_EffectElems].count < effects_conf->elements_budget * 3 / 4) {
+        return true;
+    }
+    return any_player_camera_within(pos, effects_conf->elements_lod_distance);
+}
+
 struct Thing *create_effect_element(const struct Coord3d *pos, ThingModel eelmodel, PlayerNumber owner)
 {
     long i;
     if (!i_can_allocate_free_thing_structure(TCls_EffectElem)) {
         return INVALID_THING;
     }
-    if (!any_player_close_enough_to_see(pos)) {
+    if (!effect_element_worth_creating_at(pos)) {
         return INVALID_THING;
     }
     struct EffectElementConfigStats* eestat = get_effect_element_model_stats(eelmodel);
@@ -376,29 +393,28 @@ void move_effect_blocked(struct Thing *thing, struct Coord3d *prev_pos, struct C
     remove_relevant_forces_from_thing_after_slide(thing, next_pos, blocked_flags);
 }
 
-TngUpdateRet move_effect_element(struct Thing *thing)
+/**
+ * Computes where the effect element moves this turn, and whether it hits a wall on the way.
+ * Only reads the map, so it may run on any thread.
+ */
+static void prepare_effect_element_move(const struct Thing *thing, struct EffectElementUpdate *upd)
 {
-    SYNCDBG(18,"Starting");
-    TRACE_THING(thing);
-    struct Coord3d pos;
-    TbBool within_map_limits = get_thing_next_position(&pos, thing);
-    if ( positions_equivalent(&thing->mappos, &pos) ) {
-        return TUFRet_Unchanged;
+    TbBool within_map_limits = get_thing_next_position(&upd->next_pos, thing);
+    if ( positions_equivalent(&thing->mappos, &upd->next_pos) ) {
+        return;
     }
+    upd->flags |= EEUpF_Moved;
     if (!flag_is_set(thing->movement_flags,TMvF_GoThroughWalls))
     {
         if (!within_map_limits)
         {
-            move_effect_blocked(thing, &thing->mappos, &pos);
+            upd->flags |= EEUpF_Blocked;
         } else
-        if (thing_in_wall_at(thing, &pos) && thing_in_wall_at(thing,&thing->mappos))
+        if (thing_in_wall_at(thing, &upd->next_pos) && thing_in_wall_at(thing,&thing->mappos))
         {
-            move_effect_blocked(thing, &thing->mappos, &pos);
+            upd->flags |= EEUpF_Blocked;
         }
     }
-    thing->move_angle_xy = get_angle_xy_to(&thing->mappos, &pos);
-    move_thing_in_map(thing, &pos);
-    return TUFRet_Modified;
 }
 
 void change_effect_element_into_another(struct Thing *thing, long nmodel)
@@ -422,24 +438,22 @@ void change_effect_element_into_another(struct Thing *thing, long nmodel)
     thing->max_frames = keepersprite_frames(thing->anim_sprite);
 }
 
-TngUpdateRet update_effect_element(struct Thing *elemtng)
+/**
+ * First stage of effect element update, which changes only the element itself.
+ * Doesn't create or delete things nor use random numbers, so elements may be
+ * prepared on worker threads; anything else is left for finish_effect_element_update().
+ */
+void prepare_effect_element_update(struct Thing *elemtng, struct EffectElementUpdate *upd)
 {
     long i;
-    SYNCDBG(18,"Starting");
-    TRACE_THING(elemtng);
     struct EffectElementConfigStats* eestats = get_effect_element_model_stats(elemtng->model);
+    upd->flags = 0;
     // Check if effect health dropped to zero; delete it, or decrease health for the next check
     HitPoints health = elemtng->health;
     if (health <= 0)
     {
-        if (eestats->transform_model != 0)
-        {
-            change_effect_element_into_another(elemtng, eestats->transform_model);
-        } else
-        {
-            delete_thing_structure(elemtng, 0);
-        }
-        return TUFRet_Deleted;
+        upd->flags |= EEUpF_Expired;
+        return;
     }
     elemtng->health = health-1;
     // Set dynamic properties of the effect
@@ -468,17 +482,13 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
     {
       if (((elemtng->creation_turn - game.play_gameturn) % i) == 0)
       {
-          struct Thing *subeff = create_effect_element(&elemtng->mappos, eestats->subeffect_model, elemtng->owner);
-          if (!thing_is_invalid(subeff))
-          {
-              subeff->move_angle_xy = elemtng->move_angle_xy;
-          }
+          upd->flags |= EEUpF_SpawnSubeffect;
       }
     }
     switch (eestats->move_type)
     {
     case 1:
-        move_effect_element(elemtng);
+        prepare_effect_element_move(elemtng, upd);
         break;
     case 2:
         i = elemtng->veloc_base.x.val;
@@ -505,11 +515,11 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
             if (i > 16) i = 16;
             elemtng->veloc_base.z.val = i;
         }
-        move_effect_element(elemtng);
+        prepare_effect_element_move(elemtng, upd);
         break;
     case 3:
         elemtng->veloc_base.z.val = 32;
-        move_effect_element(elemtng);
+        prepare_effect_element_move(elemtng, upd);
         break;
     case 4:
         health = elemtng->health;
@@ -518,17 +528,69 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
             elemtng->veloc_base.z.val = bounce_table[health];
         } else
         {
-            ERRORLOG("Illegal effect element bounce life: %d", (int)health);
+            upd->flags |= EEUpF_BadBounceLife;
         }
-        move_effect_element(elemtng);
+        prepare_effect_element_move(elemtng, upd);
         break;
     case 5:
         break;
     default:
-        ERRORLOG("Invalid effect element move type %d of model %d!",(int)eestats->move_type, elemtng->model);
-        move_effect_element(elemtng);
+        upd->flags |= EEUpF_BadMoveType;
+        prepare_effect_element_move(elemtng, upd);
         break;
     }
+}
+
+/**
+ * Second stage of effect element update; creates sub-effects and moves the element on map.
+ * Elements have to be finished in order of their list, so that results are the same as
+ * if every element was updated at once.
+ */
+TngUpdateRet finish_effect_element_update(struct Thing *elemtng, const struct EffectElementUpdate *upd)
+{
+    long i;
+    struct EffectElementConfigStats* eestats = get_effect_element_model_stats(elemtng->model);
+    if ((upd->flags & EEUpF_Expired) != 0)
+    {
+        if (eestats->transform_model != 0)
+        {
+            change_effect_element_into_another(elemtng, eestats->transform_model);
+        } else
+        {
+            delete_thing_structure(elemtng, 0);
+        }
+        return TUFRet_Deleted;
+    }
+    if ((upd->flags & EEUpF_SpawnSubeffect) != 0)
+    {
+        struct Coord3d pos = elemtng->mappos;
+        struct Thing *subeff = create_effect_element(&pos, eestats->subeffect_model, elemtng->owner);
+        // Over the elements budget, the oldest element gives its slot to the new one; it may be this one
+        if (subeff == elemtng)
+            return TUFRet_Deleted;
+        if (!thing_is_invalid(subeff))
+        {
+            subeff->move_angle_xy = elemtng->move_angle_xy;
+        }
+    }
+    if ((upd->flags & EEUpF_BadBounceLife) != 0)
+    {
+        ERRORLOG("Illegal effect element bounce life: %d", (int)elemtng->health);
+    }
+    if ((upd->flags & EEUpF_BadMoveType) != 0)
+    {
+        ERRORLOG("Invalid effect element move type %d of model %d!",(int)eestats->move_type, elemtng->model);
+    }
+    if ((upd->flags & EEUpF_Moved) != 0)
+    {
+        struct Coord3d pos = upd->next_pos;
+        if ((upd->flags & EEUpF_Blocked) != 0)
+        {
+            move_effect_blocked(elemtng, &elemtng->mappos, &pos);
+        }
+        elemtng->move_angle_xy = get_angle_xy_to(&elemtng->mappos, &pos);
+        move_thing_in_map(elemtng, &pos);
+    }
 
     if (eestats->unanimated != 1)
       return TUFRet_Modified;
@@ -544,6 +606,15 @@ TngUpdateRet update_effect_element(struct Thing *elemtng)
     return TUFRet_Modified;
 }
 
+TngUpdateRet update_effect_element(struct Thing *elemtng)
+{
+    SYNCDBG(18,"Starting");
+    TRACE_THING(elemtng);
+    struct EffectElementUpdate upd;
+    prepare_effect_element_update(elemtng, &upd);
+    return finish_effect_element_update(elemtng, &upd);
+}
+
 struct Thing *create_effect_generator(struct Coord3d *pos, ThingModel model, unsigned short range, unsigned short owner, long parent_idx)
 {
 
@@ -1162,18 +1233,10 @@ long explosion_effect_affecting_map_block(struct Thing *efftng, struct Thing *tn
         tngsrc = efftng;
     }
     long num_affected = 0;
-    unsigned long k = 0;
-    long i = get_mapwho_thing_index(mapblk);
-    while (i != 0)
+    struct MapwhoSweep sweep;
+    for (struct Thing* thing = mapwho_sweep_first(&sweep, mapblk); thing != NULL; thing = mapwho_sweep_next(&sweep))
     {
-        struct Thing* thing = thing_get(i);
         TRACE_THING(thing);
-        if (thing_is_invalid(thing))
-        {
-            ERRORLOG("Jump to invalid thing detected");
-            break;
-        }
-        i = thing->next_on_mapblk;
         // Per thing processing block
         if ((thing->class_id == TCls_Door) && (efftng->shot_effect.hit_type != THit_CrtrsOnlyNotOwn)) //TODO: Find pretty way to say that WoP traps should not destroy doors. And make it configurable through configs.
         {
@@ -1190,13 +1253,6 @@ long explosion_effect_affecting_map_block(struct Thing *efftng, struct Thing *tn
             }
         }
         // Per thing processing block ends
-        k++;
-        if (k > THINGS_COUNT)
-        {
-            ERRORLOG("Infinite loop detected when sweeping things list");
-            break_mapwho_infinite_chain(mapblk);
-            break;
-        }
     }
     return num_affected;
 }
@@ -1321,18 +1377,10 @@ long explosion_affecting_map_block(struct Thing *tngsrc, const struct Map *mapbl
     else
         owner = -1;
     long num_affected = 0;
-    unsigned long k = 0;
-    long i = get_mapwho_thing_index(mapblk);
-    while (i != 0)
+    struct MapwhoSweep sweep;
+    for (struct Thing* thing = mapwho_sweep_first(&sweep, mapblk); thing != NULL; thing = mapwho_sweep_next(&sweep))
     {
-        struct Thing* thing = thing_get(i);
         TRACE_THING(thing);
-        if (thing_is_invalid(thing))
-        {
-            WARNLOG("Jump out of things array");
-            break;
-        }
-        i = thing->next_on_mapblk;
         // Should never happen - only existing thing shall be in list
         if (!thing_exists(thing))
         {
@@ -1355,13 +1403,6 @@ long explosion_affecting_map_block(struct Thing *tngsrc, const struct Map *mapbl
             }
         }
         // Per thing processing block ends
-        k++;
-        if (k > THINGS_COUNT)
-        {
-            ERRORLOG("Infinite loop detected when sweeping things list");
-            break_mapwho_infinite_chain(mapblk);
-            break;
-        }
     }
     return num_affected;
 }
@@ -1493,18 +1534,10 @@ long poison_cloud_affecting_map_block(struct Thing *tngsrc, const struct Map *ma
     else
         owner = -1;
     long num_affected = 0;
-    unsigned long k = 0;
-    long i = get_mapwho_thing_index(mapblk);
-    while (i != 0)
+    struct MapwhoSweep sweep;
+    for (struct Thing* thing = mapwho_sweep_first(&sweep, mapblk); thing != NULL; thing = mapwho_sweep_next(&sweep))
     {
-        struct Thing* thing = thing_get(i);
         TRACE_THING(thing);
-        if (thing_is_invalid(thing))
-        {
-            WARNLOG("Jump out of things array");
-            break;
-        }
-        i = thing->next_on_mapblk;
         // Should never happen - only existing thing shall be in list
         if (!thing_exists(thing))
         {
@@ -1518,13 +1551,6 @@ long poison_cloud_affecting_map_block(struct Thing *tngsrc, const struct Map *ma
                 num_affected++;
         }
         // Per thing processing block ends
-        k++;
-        if (k > THINGS_COUNT)
-        {
-            ERRORLOG("Infinite loop detected when sweeping things list");
-            break_mapwho_infinite_chain(mapblk);
-            break;
-        }
     }
     return num_affected;
 }
@@ -262,11 +262,26 @@ enum ThingEffectElements {
 };
 
 /******************************************************************************/
+/** Results of the first stage of effect element update, which are used by the second one. */
+enum EffectElementUpdateFlags {
+    EEUpF_Expired         = 0x01,
+    EEUpF_SpawnSubeffect  = 0x02,
+    EEUpF_Moved           = 0x04,
+    EEUpF_Blocked         = 0x08,
+    EEUpF_BadBounceLife   = 0x10,
+    EEUpF_BadMoveType     = 0x20,
+};
+
 #pragma pack(1)
 
 struct Thing;
 
 #pragma pack()
+
+struct EffectElementUpdate {
+    struct Coord3d next_pos;
+    unsigned char flags;
+};
 /******************************************************************************/
 extern const int birth_effect_element[];
 /******************************************************************************/
@@ -278,6 +293,8 @@ struct Thing *create_effect_generator(struct Coord3d *pos, ThingModel model, uns
 struct Thing *create_effect_element(const struct Coord3d *pos, ThingModel eelmodel, PlayerNumber owner);
 struct Thing* create_used_effect_or_element(const struct Coord3d* pos, EffectOrEffElModel effect_id, PlayerNumber plyr_idx, ThingIndex parent_idx);
 TngUpdateRet update_effect_element(struct Thing *thing);
+void prepare_effect_element_update(struct Thing *elemtng, struct EffectElementUpdate *upd);
+TngUpdateRet finish_effect_element_update(struct Thing *elemtng, const struct EffectElementUpdate *upd);
 TngUpdateRet update_effect(struct Thing *thing);
 TngUpdateRet process_effect_generator(struct Thing *thing);
 void process_spells_affected_by_effect_elements(struct Thing *thing);
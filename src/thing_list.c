@@ -49,6 +49,7 @@
 #include "game_legacy.h"
 #include "keeperfx.hpp"
 #include "bflib_planar.h"
+#include "bflib_jobs.h"
 #include "post_inc.h"
 
 #ifdef __cplusplus
@@ -78,6 +79,55 @@ Thing_Class_Func class_functions[] = {
 
 unsigned long thing_create_errors = 0;
 
+/** Capacity of each list in the index; removed things leave holes until compaction, so there's room for more than THINGS_COUNT. */
+#define THING_LIST_ITEMS_MAX (2*(THINGS_COUNT))
+/** Lists of things which are indexed; the lists after them hold lights. */
+#define THING_LISTS_INDEXED  TngList_StaticLights
+
+/**
+ * Things of every StructureList kept in dense arrays of indices, so that sweeping a list
+ * reads the array instead of following next_of_class through whole Thing structs.
+ * Things are appended when added to a list, and sweeps go from the end of the array,
+ * which gives the order of the linked list - it starts with the newest thing.
+ * Removed things leave zero behind, as moving items could break a sweep in progress.
+ */
+struct ThingListsIndex {
+    ThingIndex items[THING_LISTS_INDEXED][THING_LIST_ITEMS_MAX];
+    /** Amount of used entries in items of each list, including holes. */
+    unsigned long count[THING_LISTS_INDEXED];
+    unsigned long holes[THING_LISTS_INDEXED];
+    /** Entries of items before this one are all holes; the oldest thing of a list is the first one after. */
+    unsigned long first_used[THING_LISTS_INDEXED];
+    /** Position of every thing within items of its list. */
+    unsigned short slot[THINGS_COUNT];
+    /** Changed whenever positions in items change, so sweeps in progress know they can't continue. */
+    unsigned long generation;
+    TbBool valid;
+};
+
+static struct ThingListsIndex thing_lists_index;
+
+/** Amount of effect elements prepared by a worker thread at once. */
+#define EFFECT_ELEMENTS_JOB_BATCH 64
+
+/** Effect element which is updated in two stages - prepared in parallel, then finished in order of the list. */
+struct EffectElementJobItem {
+    struct Thing *thing;
+    /** Position of the element within the index of its list, to check if it was deleted before it is finished. */
+    unsigned long pos;
+    /** Elements in limbo or following a leader aren't moved by themselves, and are updated the usual way. */
+    TbBool serial;
+    struct EffectElementUpdate upd;
+};
+
+static struct EffectElementJobItem effect_elements_job[THINGS_COUNT];
+
+#if defined(__GNUC__)
+#define prefetch_thing(tng_idx) __builtin_prefetch(game.things.lookup[tng_idx])
+#else
+#define prefetch_thing(tng_idx)
+#endif
+
 const struct NamedCommand class_commands[] = {
   {"Object",        TCls_Object},
   {"Shot",          TCls_Shot},
@@ -93,6 +143,8 @@ const struct NamedCommand class_commands[] = {
   {NULL,              0},
   };
 
+static void update_thing_velocity(struct Thing *thing);
+static void update_thing_after_move(struct Thing *thing);
 /******************************************************************************/
 
 void set_previous_thing_position(struct Thing *thing) {
@@ -100,6 +152,221 @@ void set_previous_thing_position(struct Thing *thing) {
     thing->previous_floor_height = thing->floor_height;
 }
 
+/******************************************************************************/
+static long get_thing_list_id(const struct StructureList *list)
+{
+    long list_id = list - game.thing_lists;
+    if ((list_id < 0) || (list_id >= THING_LISTS_INDEXED))
+        return -1;
+    return list_id;
+}
+
+/**
+ * Marks the index of thing lists to be remade from the linked lists before next sweep.
+ * To be called whenever thing lists are changed other than by adding and removing things.
+ */
+void invalidate_thing_lists_index(void)
+{
+    thing_lists_index.valid = false;
+    thing_lists_index.generation++;
+}
+
+static void rebuild_thing_lists_index(void)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    for (long list_id = 0; list_id < THING_LISTS_INDEXED; list_id++)
+    {
+        unsigned long n = 0;
+        ThingIndex i = game.thing_lists[list_id].index;
+        while ((i > 0) && (i < THINGS_COUNT) && (n < THINGS_COUNT))
+        {
+            n++;
+            i = thing_get(i)->next_of_class;
+        }
+        // The newest thing is at head of the list, and goes at end of the array
+        tlidx->count[list_id] = n;
+        tlidx->holes[list_id] = 0;
+        tlidx->first_used[list_id] = 0;
+        i = game.thing_lists[list_id].index;
+        while (n > 0)
+        {
+            n--;
+            tlidx->items[list_id][n] = i;
+            tlidx->slot[i] = n;
+            i = thing_get(i)->next_of_class;
+        }
+    }
+    tlidx->generation++;
+    tlidx->valid = true;
+    SYNCDBG(9,"Rebuilt, %lu creatures, %lu effect elements",tlidx->count[TngList_Creatures],tlidx->count[TngList_EffectElems]);
+}
+
+/**
+ * Removes holes left by removed things from the index of thing lists.
+ * Can't be called while any list is being swept.
+ */
+void compact_thing_lists_index(void)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    if (!tlidx->valid)
+    {
+        rebuild_thing_lists_index();
+        return;
+    }
+    TbBool changed = false;
+    for (long list_id = 0; list_id < THING_LISTS_INDEXED; list_id++)
+    {
+        if (tlidx->holes[list_id] == 0)
+            continue;
+        ThingIndex *items = tlidx->items[list_id];
+        unsigned long n = 0;
+        for (unsigned long k = 0; k < tlidx->count[list_id]; k++)
+        {
+            if (items[k] == 0)
+                continue;
+            items[n] = items[k];
+            tlidx->slot[items[n]] = n;
+            n++;
+        }
+        tlidx->count[list_id] = n;
+        tlidx->holes[list_id] = 0;
+        tlidx->first_used[list_id] = 0;
+        changed = true;
+    }
+    if (changed)
+        tlidx->generation++;
+}
+
+static void add_thing_to_lists_index(const struct Thing *thing, const struct StructureList *list)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    long list_id = get_thing_list_id(list);
+    if (!tlidx->valid || (list_id < 0))
+        return;
+    if (tlidx->count[list_id] >= THING_LIST_ITEMS_MAX)
+    {
+        // Compacting here could move things under a sweep in progress; remake the index before next sweep instead
+        WARNLOG("No space in index of thing list %ld, remaking it",list_id);
+        invalidate_thing_lists_index();
+        return;
+    }
+    unsigned long n = tlidx->count[list_id];
+    tlidx->items[list_id][n] = thing->index;
+    tlidx->slot[thing->index] = n;
+    tlidx->count[list_id] = n + 1;
+}
+
+static void remove_thing_from_lists_index(const struct Thing *thing, const struct StructureList *list)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    long list_id = get_thing_list_id(list);
+    if (!tlidx->valid || (list_id < 0))
+        return;
+    unsigned long n = tlidx->slot[thing->index];
+    if ((n >= tlidx->count[list_id]) || (tlidx->items[list_id][n] != thing->index))
+    {
+        ERRORLOG("Thing %d is not where the index of its list says",(int)thing->index);
+        invalidate_thing_lists_index();
+        return;
+    }
+    tlidx->items[list_id][n] = 0;
+    tlidx->holes[list_id]++;
+}
+
+/**
+ * Starts going through things of given list, in the order of the list.
+ * Things added during the sweep are not visited; removed ones are skipped.
+ * @return The first thing, or NULL if the list is empty.
+ */
+struct Thing *thing_list_sweep_first(struct ThingListSweep *sweep, const struct StructureList *list)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    sweep->list_id = get_thing_list_id(list);
+    sweep->linked_next = list->index;
+    sweep->linked_count = 0;
+    sweep->pos = 0;
+    if (sweep->list_id < 0)
+    {
+        // Not one of the game lists; only the links can be followed
+        sweep->generation = tlidx->generation - 1;
+        return thing_list_sweep_next(sweep);
+    }
+    if (!tlidx->valid)
+        rebuild_thing_lists_index();
+    sweep->generation = tlidx->generation;
+    sweep->pos = tlidx->count[sweep->list_id];
+    return thing_list_sweep_next(sweep);
+}
+
+/**
+ * Gives next thing of a sweep started by thing_list_sweep_first().
+ * @return The thing, or NULL if there are no more.
+ */
+struct Thing *thing_list_sweep_next(struct ThingListSweep *sweep)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    if (sweep->generation != tlidx->generation)
+    {
+        // Positions in the index changed since the sweep started; continue from the last thing like before there was an index
+        ThingIndex i = sweep->linked_next;
+        if (i == 0)
+            return NULL;
+        struct Thing *thing = thing_get(i);
+        if (thing_is_invalid(thing))
+        {
+            ERRORLOG("Jump to invalid thing detected");
+            return NULL;
+        }
+        sweep->linked_count++;
+        if (sweep->linked_count > THINGS_COUNT)
+        {
+            ERRORLOG("Infinite loop detected when sweeping things list");
+            return NULL;
+        }
+        sweep->linked_next = thing->next_of_class;
+        return thing;
+    }
+    const ThingIndex *items = tlidx->items[sweep->list_id];
+    while (sweep->pos > 0)
+    {
+        sweep->pos--;
+        ThingIndex i = items[sweep->pos];
+        if (i == 0)
+            continue;
+        if (sweep->pos > 0)
+            prefetch_thing(items[sweep->pos - 1]);
+        struct Thing *thing = game.things.lookup[i];
+        sweep->linked_next = thing->next_of_class;
+        return thing;
+    }
+    return NULL;
+}
+
+/**
+ * Gives the thing which was added to given list before any other thing which is still there.
+ * @return The thing, or INVALID_THING if the list is empty.
+ */
+struct Thing *get_oldest_thing_in_list(const struct StructureList *list)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    long list_id = get_thing_list_id(list);
+    if (list_id < 0)
+    {
+        ERRORLOG("Oldest thing can only be found in a list of things");
+        return INVALID_THING;
+    }
+    if (!tlidx->valid)
+        rebuild_thing_lists_index();
+    const ThingIndex *items = tlidx->items[list_id];
+    unsigned long n = tlidx->first_used[list_id];
+    while ((n < tlidx->count[list_id]) && (items[n] == 0))
+        n++;
+    tlidx->first_used[list_id] = n;
+    if (n >= tlidx->count[list_id])
+        return INVALID_THING;
+    return thing_get(items[n]);
+}
+
 /**
  * Adds thing at beginning of a StructureList.
  * @param thing
@@ -124,6 +391,7 @@ void add_thing_to_list(struct Thing *thing, struct StructureList *list)
         prevtng->prev_of_class = thing->index;
     }
     list->index = thing->index;
+    add_thing_to_lists_index(thing, list);
 }
 
 void remove_thing_from_list(struct Thing *thing, struct StructureList *slist)
@@ -131,6 +399,7 @@ void remove_thing_from_list(struct Thing *thing, struct StructureList *slist)
     struct Thing *sibtng;
     if ((thing->alloc_flags & TAlF_IsInStrucList) == 0)
         return;
+    remove_thing_from_lists_index(thing, slist);
     if (thing->index == slist->index)
     {
         slist->index = thing->next_of_class;
@@ -234,6 +503,7 @@ void add_thing_to_its_class_list(struct Thing *thing)
     struct StructureList* slist = get_list_for_thing_class(thing->class_id);
     if (slist != NULL)
         add_thing_to_list(thing, slist);
+    update_replay_integrity_of_thing(thing);
 }
 
 /**
@@ -983,16 +1253,9 @@ void update_things_in_list(struct StructureList *list)
 {
     SYNCDBG(18,"Starting");
     unsigned long k = 0;
-    int i = list->index;
-    while (i != 0)
+    struct ThingListSweep sweep;
+    for (struct Thing* thing = thing_list_sweep_first(&sweep, list); thing != NULL; thing = thing_list_sweep_next(&sweep))
     {
-        struct Thing* thing = thing_get(i);
-        if (thing_is_invalid(thing))
-        {
-            ERRORLOG("Jump to invalid thing detected");
-            break;
-      }
-      i = thing->next_of_class;
       // Per-thing code
       if ((thing->alloc_flags & TAlF_IsFollowingLeader) == 0)
       {
@@ -1003,13 +1266,9 @@ void update_things_in_list(struct StructureList *list)
           }
       }
       set_previous_thing_position(thing);
+      touch_replay_integrity_of_thing(thing);
       // Per-thing code ends
       k++;
-      if (k > THINGS_COUNT)
-      {
-        ERRORLOG("Infinite loop detected when sweeping things list");
-        break;
-      }
     }
     SYNCDBG(19,"Finished, %d items",(int)k);
 }
@@ -1022,25 +1281,14 @@ unsigned long update_cave_in_things(void)
 {
     unsigned long k = 0;
     const struct StructureList* slist = get_list_for_thing_class(TCls_CaveIn);
-    int i = slist->index;
-    while (i != 0)
+    struct ThingListSweep sweep;
+    for (struct Thing* thing = thing_list_sweep_first(&sweep, slist); thing != NULL; thing = thing_list_sweep_next(&sweep))
     {
-        struct Thing* thing = thing_get(i);
-        if (thing_is_invalid(thing))
-        {
-            ERRORLOG("Jump to invalid thing detected");
-            break;
-        }
-        i = thing->next_of_class;
         // Per-thing code
         update_cave_in(thing);
+        touch_replay_integrity_of_thing(thing);
         // Per-thing code ends
         k++;
-        if (k > THINGS_COUNT)
-        {
-            ERRORLOG("Infinite loop detected when sweeping things list");
-            break;
-        }
     }
     return k;
 }
@@ -1053,25 +1301,13 @@ unsigned long update_things_sounds_in_list(struct StructureList *list)
 {
     SYNCDBG(18,"Starting");
     unsigned long k = 0;
-    int i = list->index;
-    while (i != 0)
+    struct ThingListSweep sweep;
+    for (struct Thing* thing = thing_list_sweep_first(&sweep, list); thing != NULL; thing = thing_list_sweep_next(&sweep))
     {
-        struct Thing* thing = thing_get(i);
-        if (thing_is_invalid(thing))
-        {
-            ERRORLOG("Jump to invalid thing detected");
-            break;
-        }
-        i = thing->next_of_class;
         // Per-thing code
         update_thing_sound(thing);
         // Per-thing code ends
         k++;
-        if (k > THINGS_COUNT)
-        {
-            ERRORLOG("Infinite loop detected when sweeping things list");
-            break;
-        }
     }
     return k;
 }
@@ -1080,16 +1316,9 @@ unsigned long update_creatures_not_in_list(void)
 {
   SYNCDBG(18,"Starting");
   unsigned long k = 0;
-  int i = game.thing_lists[TngList_Creatures].index;
-  while (i != 0)
+  struct ThingListSweep sweep;
+  for (struct Thing* thing = thing_list_sweep_first(&sweep, &game.thing_lists[TngList_Creatures]); thing != NULL; thing = thing_list_sweep_next(&sweep))
   {
-      struct Thing* thing = thing_get(i);
-      if (thing_is_invalid(thing))
-      {
-          ERRORLOG("Jump to invalid thing detected");
-          break;
-    }
-    i = thing->next_of_class;
     // Per-thing code
     if (thing->index == 0)
     {
@@ -1105,36 +1334,114 @@ unsigned long update_creatures_not_in_list(void)
       }
     }
     set_previous_thing_position(thing);
+    touch_replay_integrity_of_thing(thing);
     // Per-thing code ends
     k++;
-    if (k > THINGS_COUNT)
-    {
-      ERRORLOG("Infinite loop detected when sweeping things list");
-      break;
-    }
   }
   SYNCDBG(18,"Finished");
   return k;
 }
 
+static void prepare_effect_elements_job(void *data, long first, long count)
+{
+    struct EffectElementJobItem *items = (struct EffectElementJobItem *)data;
+    for (long k = first; k < first + count; k++)
+    {
+        struct EffectElementJobItem *item = &items[k];
+        if (item->serial)
+            continue;
+        update_thing_velocity(item->thing);
+        prepare_effect_element_update(item->thing, &item->upd);
+    }
+}
+
+/**
+ * Checks whether an element gathered for the update is still in its list, and wasn't
+ * deleted while finishing elements before it.
+ */
+static TbBool effect_element_job_item_listed(const struct EffectElementJobItem *item, unsigned long generation)
+{
+    const struct ThingListsIndex *tlidx = &thing_lists_index;
+    const struct Thing *thing = item->thing;
+    if (tlidx->generation == generation)
+        return (tlidx->items[TngList_EffectElems][item->pos] == thing->index);
+    // The index was remade, so a reused slot can't be told apart; that only happens when the index overflows
+    return thing_exists(thing) && (thing->class_id == TCls_EffectElem) && ((thing->alloc_flags & TAlF_IsInStrucList) != 0);
+}
+
+/**
+ * Makes per game turn update of effect elements; gives the same results as update_things_in_list().
+ * The elements only change themselves until they are moved on map, so that part is done on
+ * worker threads. Moving, spawning sub-effects and deleting is then done in order of the list,
+ * so things are allocated and unsynced random numbers used the same way as before.
+ * @return Returns amount of effect elements in list.
+ */
+static unsigned long update_effect_elements(void)
+{
+    struct ThingListsIndex *tlidx = &thing_lists_index;
+    SYNCDBG(18,"Starting");
+    if (!tlidx->valid)
+        rebuild_thing_lists_index();
+    const ThingIndex *tng_idxs = tlidx->items[TngList_EffectElems];
+    long n = 0;
+    for (unsigned long pos = tlidx->count[TngList_EffectElems]; (pos > 0) && (n < THINGS_COUNT); )
+    {
+        pos--;
+        ThingIndex i = tng_idxs[pos];
+        if (i == 0)
+            continue;
+        struct EffectElementJobItem *item = &effect_elements_job[n];
+        item->thing = game.things.lookup[i];
+        item->pos = pos;
+        item->serial = ((item->thing->alloc_flags & (TAlF_IsFollowingLeader|TAlF_IsInLimbo)) != 0);
+        n++;
+    }
+    unsigned long generation = tlidx->generation;
+    LbJobsParallelFor(n, EFFECT_ELEMENTS_JOB_BATCH, prepare_effect_elements_job, effect_elements_job);
+    for (long k = 0; k < n; k++)
+    {
+        struct EffectElementJobItem *item = &effect_elements_job[k];
+        struct Thing *thing = item->thing;
+        if (!effect_element_job_item_listed(item, generation))
+            continue;
+        if (item->serial)
+        {
+            if ((thing->alloc_flags & (TAlF_IsFollowingLeader|TAlF_IsInLimbo)) == TAlF_IsInLimbo) {
+                update_thing_animation(thing);
+            }
+        } else
+        if (finish_effect_element_update(thing, &item->upd) != TUFRet_Deleted)
+        {
+            update_thing_after_move(thing);
+        }
+        set_previous_thing_position(thing);
+    }
+    SYNCDBG(19,"Finished, %d items",(int)n);
+    return n;
+}
+
 void update_things(void)
 {
     SYNCDBG(7,"Starting");
     optimised_lights = 0;
     total_lights = 0;
     do_lights = game.lish.light_enabled;
+    // No list is being swept yet, so the index may be compacted
+    compact_thing_lists_index();
+    start_mapwho_sweeps_cache();
     update_things_in_list(&game.thing_lists[TngList_Creatures]);
     update_creatures_not_in_list();
     update_things_in_list(&game.thing_lists[TngList_Traps]);
     update_things_in_list(&game.thing_lists[TngList_Shots]);
     update_things_in_list(&game.thing_lists[TngList_Objects]);
     update_things_in_list(&game.thing_lists[TngList_Effects]);
-    update_things_in_list(&game.thing_lists[TngList_EffectElems]);
+    update_effect_elements();
     update_things_in_list(&game.thing_lists[TngList_DeadCreatrs]);
     update_things_in_list(&game.thing_lists[TngList_EffectGens]);
     update_things_in_list(&game.thing_lists[TngList_Doors]);
     update_things_sounds_in_list(&game.thing_lists[TngList_AmbientSnds]);
     update_cave_in_things();
+    stop_mapwho_sweeps_cache();
     game.map_changed_for_nagivation = 0;
     SYNCDBG(9,"Finished");
 }
@@ -1351,12 +1658,235 @@ void init_creature_states_for_player(PlayerNumber plyr_idx)
     }
 }
 
+/** Capacity of the cache for all map blocks; blocks swept again after their things changed take more space. */
+#define MAPWHO_SWEEPS_ITEMS_MAX (4*(THINGS_COUNT))
+
+/**
+ * Synchronized things on map blocks, remembered during update of things when a block is first swept.
+ * Blocks near explosions and clouds are mostly filled with effect elements, which area effects
+ * never affect; with the cache, every area effect in a turn which reaches a block goes only
+ * through the things it may affect, and the long chain is followed once.
+ * Order of the things is the same as in mapwho, so things are affected in the same order.
+ */
+struct MapwhoSweepsCache {
+    /** Stamp of the things cached for each block; the cache of a block is valid if it's at least first_stamp. */
+    unsigned long *stamps;
+    unsigned long *starts;
+    unsigned short *counts;
+    unsigned long cells_count;
+    ThingIndex items[MAPWHO_SWEEPS_ITEMS_MAX];
+    unsigned long items_count;
+    unsigned long first_stamp;
+    unsigned long next_stamp;
+    TbBool active;
+};
+
+static struct MapwhoSweepsCache mapwho_sweeps_cache;
+
+static void forget_all_mapwho_sweeps(void)
+{
+    struct MapwhoSweepsCache *mwcache = &mapwho_sweeps_cache;
+    if (mwcache->next_stamp >= ULONG_MAX - THINGS_COUNT)
+    {
+        memset(mwcache->stamps, 0, mwcache->cells_count * sizeof(mwcache->stamps[0]));
+        mwcache->next_stamp = 0;
+    }
+    mwcache->next_stamp++;
+    mwcache->first_stamp = mwcache->next_stamp;
+    mwcache->items_count = 0;
+}
+
+/**
+ * Starts remembering things swept on map blocks; to be called when update of things begins.
+ * Everything which changes mapwho chains must go through place_thing_in_mapwho() and
+ * remove_thing_from_mapwho() until the cache is stopped.
+ */
+void start_mapwho_sweeps_cache(void)
+{
+    struct MapwhoSweepsCache *mwcache = &mapwho_sweeps_cache;
+    unsigned long count = (unsigned long)(game.map_subtiles_x + 1) * (game.map_subtiles_y + 1);
+    if ((mwcache->cells_count != count) || (mwcache->stamps == NULL))
+    {
+        free_mapwho_sweeps_cache();
+        mwcache->stamps = (unsigned long *)KfxCalloc(count, sizeof(mwcache->stamps[0]));
+        mwcache->starts = (unsigned long *)KfxCalloc(count, sizeof(mwcache->starts[0]));
+        mwcache->counts = (unsigned short *)KfxCalloc(count, sizeof(mwcache->counts[0]));
+        if ((mwcache->stamps == NULL) || (mwcache->starts == NULL) || (mwcache->counts == NULL))
+        {
+            WARNLOG("Cannot allocate mapwho sweeps cache, going without it");
+            free_mapwho_sweeps_cache();
+            return;
+        }
+        mwcache->cells_count = count;
+    }
+    forget_all_mapwho_sweeps();
+    mwcache->active = true;
+}
+
+void stop_mapwho_sweeps_cache(void)
+{
+    mapwho_sweeps_cache.active = false;
+}
+
+void free_mapwho_sweeps_cache(void)
+{
+    struct MapwhoSweepsCache *mwcache = &mapwho_sweeps_cache;
+    KfxFree(mwcache->stamps);
+    KfxFree(mwcache->starts);
+    KfxFree(mwcache->counts);
+    mwcache->stamps = NULL;
+    mwcache->starts = NULL;
+    mwcache->counts = NULL;
+    mwcache->cells_count = 0;
+    mwcache->active = false;
+}
+
+static long get_mapwho_sweeps_cell(const struct Map *mapblk)
+{
+    struct MapwhoSweepsCache *mwcache = &mapwho_sweeps_cache;
+    if (!mwcache->active || map_block_invalid(mapblk))
+        return -1;
+    long cell = mapblk - map_blocks;
+    if ((cell < 0) || ((unsigned long)cell >= mwcache->cells_count))
+        return -1;
+    return cell;
+}
+
+/**
+ * Drops cached things of the block in which given thing is placed; other things never get
+ * into cache, so they may come and go freely.
+ */
+static void forget_mapwho_sweep_of_thing(const struct Thing *thing)
+{
+    if (is_non_synchronized_thing_class(thing->class_id))
+        return;
+    long cell = get_mapwho_sweeps_cell(get_map_block_at(thing->mappos.x.stl.num, thing->mappos.y.stl.num));
+    if (cell >= 0)
+        mapwho_sweeps_cache.stamps[cell] = 0;
+}
+
+/**
+ * Goes through the whole mapwho chain of a block and remembers its synchronized things.
+ * @return Gives false if the things can't be remembered, and the block should be swept by links.
+ */
+static TbBool cache_mapwho_sweep(long cell, const struct Map *mapblk)
+{
+    struct MapwhoSweepsCache *mwcache = &mapwho_sweeps_cache;
+    unsigned long start = mwcache->items_count;
+    unsigned long n = 0;
+    unsigned long k = 0;
+    ThingIndex i = get_mapwho_thing_index(mapblk);
+    while (i != 0)
+    {
+        struct Thing* thing = thing_get(i);
+        if (thing_is_invalid(thing))
+        {
+            ERRORLOG("Jump to invalid thing detected");
+            break;
+        }
+        i = thing->next_on_mapblk;
+        if (!is_non_synchronized_thing_class(thing->class_id))
+        {
+            if ((start + n >= MAPWHO_SWEEPS_ITEMS_MAX) || (n >= USHRT_MAX))
+                return false;
+            mwcache->items[start + n] = thing->index;
+            n++;
+        }
+        k++;
+        if (k > THINGS_COUNT)
+        {
+            ERRORLOG("Infinite loop detected when sweeping things list");
+            break_mapwho_infinite_chain(mapblk);
+            return false;
+        }
+    }
+    mwcache->items_count = start + n;
+    mwcache->starts[cell] = start;
+    mwcache->counts[cell] = n;
+    mwcache->stamps[cell] = mwcache->next_stamp;
+    mwcache->next_stamp++;
+    return true;
+}
+
+/**
+ * Starts going through things on given map block, in order of the mapwho chain.
+ * During update of things, non-synchronized things are skipped if the block is cached;
+ * otherwise all things are given. Things added to the block during the sweep are not given.
+ * @return The first thing, or NULL if there are none.
+ */
+struct Thing *mapwho_sweep_first(struct MapwhoSweep *sweep, const struct Map *mapblk)
+{
+    struct MapwhoSweepsCache *mwcache = &mapwho_sweeps_cache;
+    sweep->mapblk = mapblk;
+    sweep->cell = get_mapwho_sweeps_cell(mapblk);
+    sweep->next_on_mapblk = get_mapwho_thing_index(mapblk);
+    sweep->count = 0;
+    if (sweep->cell >= 0)
+    {
+        if (mwcache->stamps[sweep->cell] < mwcache->first_stamp)
+        {
+            if (!cache_mapwho_sweep(sweep->cell, mapblk))
+                sweep->cell = -1;
+        }
+    }
+    if (sweep->cell >= 0)
+    {
+        sweep->stamp = mwcache->stamps[sweep->cell];
+        sweep->pos = mwcache->starts[sweep->cell];
+        sweep->end = sweep->pos + mwcache->counts[sweep->cell];
+    }
+    return mapwho_sweep_next(sweep);
+}
+
+/**
+ * Gives next thing of a sweep started by mapwho_sweep_first().
+ * @return The thing, or NULL if there are no more.
+ */
+struct Thing *mapwho_sweep_next(struct MapwhoSweep *sweep)
+{
+    struct MapwhoSweepsCache *mwcache = &mapwho_sweeps_cache;
+    if ((sweep->cell >= 0) && (!mwcache->active || (sweep->stamp < mwcache->first_stamp) || (mwcache->stamps[sweep->cell] != sweep->stamp)))
+    {
+        // Synchronized things on the block changed while processing the previous thing; continue by the links
+        sweep->cell = -1;
+    }
+    struct Thing *thing;
+    if (sweep->cell >= 0)
+    {
+        if (sweep->pos >= sweep->end)
+            return NULL;
+        thing = thing_get(mwcache->items[sweep->pos]);
+        sweep->pos++;
+    } else
+    {
+        ThingIndex i = sweep->next_on_mapblk;
+        if (i == 0)
+            return NULL;
+        thing = thing_get(i);
+        if (thing_is_invalid(thing))
+        {
+            ERRORLOG("Jump to invalid thing detected");
+            return NULL;
+        }
+        sweep->count++;
+        if (sweep->count > THINGS_COUNT)
+        {
+            ERRORLOG("Infinite loop detected when sweeping things list");
+            break_mapwho_infinite_chain(sweep->mapblk);
+            return NULL;
+        }
+    }
+    sweep->next_on_mapblk = thing->next_on_mapblk;
+    return thing;
+}
+
 void remove_thing_from_mapwho(struct Thing *thing)
 {
     struct Thing *mwtng;
     SYNCDBG(18,"Starting");
     if ((thing->alloc_flags & TAlF_IsInMapWho) == 0)
         return;
+    forget_mapwho_sweep_of_thing(thing);
     if (thing->prev_on_mapblk > 0)
     {
         mwtng = thing_get(thing->prev_on_mapblk);
@@ -1373,6 +1903,9 @@ void remove_thing_from_mapwho(struct Thing *thing)
         {
             WARNLOG("Moving lost %s %d from %d, %d", thing_class_and_model_name(thing->class_id, thing->model),
                     thing->index, thing->mappos.x.stl.num, thing->mappos.y.stl.num);
+            // Its real block isn't known, so none of the remembered ones can be trusted
+            if (mapwho_sweeps_cache.active)
+                forget_all_mapwho_sweeps();
         }
         set_mapwho_thing_index(mapblk, thing->next_on_mapblk);
     }
@@ -1396,6 +1929,7 @@ void place_thing_in_mapwho(struct Thing *thing)
     SYNCDBG(18,"Starting");
     if ((thing->alloc_flags & TAlF_IsInMapWho) != 0)
         return;
+    forget_mapwho_sweep_of_thing(thing);
     struct Map* mapblk = get_map_block_at(thing->mappos.x.stl.num, thing->mappos.y.stl.num);
     thing->next_on_mapblk = get_mapwho_thing_index(mapblk);
     if (thing->next_on_mapblk > 0)
@@ -1411,6 +1945,7 @@ void place_thing_in_mapwho(struct Thing *thing)
     set_mapwho_thing_index(mapblk, thing->index);
     thing->prev_on_mapblk = 0;
     thing->alloc_flags |= TAlF_IsInMapWho;
+    touch_replay_integrity_of_thing(thing);
 }
 
 struct Thing *find_base_thing_on_mapwho(ThingClass oclass, ThingModel model, MapSubtlCoord stl_x, MapSubtlCoord stl_y)
@@ -1573,23 +2108,19 @@ struct Thing *find_random_thing_in_room(ThingClass tngclass, ThingModel tngmodel
         return INVALID_THING;
     }
 
-    SlabCodedCoords current_slb = room->slabs_list;
+    unsigned long slabs_count;
+    const SlabCodedCoords *slabs = get_room_slabs(room, &slabs_count);
     unsigned int current_slab_idx = GAME_RANDOM(room->slabs_count);
 
-    for (size_t i = 0; i < current_slab_idx; i++)
-    {
-        current_slb = get_next_slab_number_in_room(current_slb);
-    }
-
     static const int STL_PER_SLB_2D = STL_PER_SLB * STL_PER_SLB;
 
-    for (size_t i = 0; i < room->slabs_count; i++)
+    for (size_t i = 0; (i < room->slabs_count) && (slabs_count > 0); i++)
     {
-        if ( room->slabs_count == current_slab_idx )
+        if (current_slab_idx >= slabs_count)
         {
             current_slab_idx = 0;
-            current_slb = room->slabs_list;
         }
+        SlabCodedCoords current_slb = slabs[current_slab_idx];
 
         MapSlabCoord slb_x = slb_num_decode_x(current_slb);
         MapSlabCoord slb_y = slb_num_decode_y(current_slb);
@@ -1608,7 +2139,6 @@ struct Thing *find_random_thing_in_room(ThingClass tngclass, ThingModel tngmodel
             subtile = (subtile + 1) % STL_PER_SLB_2D;
         }
 
-        current_slb = get_next_slab_number_in_room(current_slb);
         ++current_slab_idx;
     }
     return INVALID_THING;
@@ -1663,6 +2193,61 @@ long count_things_of_class_with_filter(Thing_Maximizer_Filter filter, MaxTngFilt
     return match_count;
 }
 
+/**
+ * Stores indices of the things best matching given filter.
+ * Only things for which filter function returns max value are stored, in class list order.
+ * @param filter Filter function reference.
+ * @param param Filter function parameters struct.
+ * @param tng_idxs Array to be filled with indices of matched things.
+ * @param max_count Size of the tng_idxs array.
+ * @return Count of best matched things; if larger than max_count, only the first ones are stored.
+ */
+long collect_things_of_class_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param, ThingIndex *tng_idxs, long max_count)
+{
+    long maximizer = 0;
+    long match_count = 0;
+    SYNCDBG(19,"Starting");
+    const struct StructureList* slist = get_list_for_thing_class(param->class_id);
+    if (slist == NULL) {
+        return 0;
+    }
+    long i = slist->index;
+    unsigned long k = 0;
+    while (i != 0)
+    {
+        struct Thing* thing = thing_get(i);
+        if (thing_is_invalid(thing))
+        {
+            ERRORLOG("Jump to invalid thing detected");
+            break;
+        }
+        i = thing->next_of_class;
+        // Per-thing code
+        long n = filter(thing, param, maximizer);
+        if (n > maximizer)
+        {
+            // Better match found - previously stored ones no longer count
+            maximizer = n;
+            match_count = 0;
+        }
+        if (n == maximizer)
+        {
+            if (match_count < max_count) {
+                tng_idxs[match_count] = thing->index;
+            }
+            match_count++;
+        }
+        // Per-thing code ends
+        k++;
+        if (k > slist->count)
+        {
+            ERRORLOG("Infinite loop detected when sweeping things list");
+            break;
+        }
+    }
+    return match_count;
+}
+
 /**
  * Out of things best matching given filter, returns the one of given index.
  * Only things for which filter function returns max value are counted.
@@ -1733,6 +2318,42 @@ struct Thing *get_random_thing_of_class_with_filter(Thing_Maximizer_Filter filte
     return get_nth_thing_of_class_with_filter(filter, param, PLAYER_RANDOM(plyr_idx, match_count));
 }
 
+/**
+ * Stores indices of all things of given class and model owned by given player, optionally only near given position.
+ * @param tngclass Class of the things.
+ * @param tngmodel Model of the things, -1 or creature wildcard for any.
+ * @param plyr_idx Owner of the things, -1 for any.
+ * @param center Center of the area to search in, or NULL to search whole map.
+ * @param range Max distance from center, in map coordinates.
+ * @param tng_idxs Array to be filled with indices of matched things.
+ * @param max_count Size of the tng_idxs array.
+ * @return Count of matched things; if larger than max_count, only the first ones are stored.
+ */
+long collect_things_of_class_and_model_owned_by(int tngclass, int tngmodel, PlayerNumber plyr_idx,
+    const struct Coord3d *center, MapCoordDelta range, ThingIndex *tng_idxs, long max_count)
+{
+    SYNCDBG(19,"Starting");
+    Thing_Maximizer_Filter filter;
+    struct CompoundTngFilterParam param;
+    param.class_id = tngclass;
+    param.model_id = tngmodel;
+    param.plyr_idx = plyr_idx;
+    if (center != NULL)
+    {
+        filter = in_action_point_thing_filter_is_of_class_and_model_and_owned_by;
+        param.primary_number = center->x.val;
+        param.secondary_number = center->y.val;
+        param.tertiary_number = range;
+    } else
+    {
+        filter = anywhere_thing_filter_is_of_class_and_model_and_owned_by;
+        param.primary_number = 0;
+        param.secondary_number = 0;
+        param.tertiary_number = 0;
+    }
+    return collect_things_of_class_with_filter(filter, &param, tng_idxs, max_count);
+}
+
 long do_to_all_things_of_class_and_model(int tngclass, int tngmodel, Thing_Bool_Modifier do_cb)
 {
     SYNCDBG(19,"Starting");
@@ -3112,14 +3733,12 @@ void stop_all_things_playing_samples(void)
   }
 }
 
-TbBool update_thing(struct Thing *thing)
+/**
+ * Applies pushes to velocity of a thing, before its class function moves it.
+ * Changes only the thing itself.
+ */
+static void update_thing_velocity(struct Thing *thing)
 {
-    Thing_Class_Func classfunc;
-    SYNCDBG(18,"Thing index %d, class %d",(int)thing->index,(int)thing->class_id);
-    TRACE_THING(thing);
-    if (thing_is_invalid(thing))
-        return false;
-
     if ((thing->movement_flags & TMvF_Immobile) == 0)
     {
         if ((thing->state_flags & TF1_PushAdd) != 0)
@@ -3146,16 +3765,14 @@ TbBool update_thing(struct Thing *thing)
           thing->state_flags &= ~TF1_PushOnce;
         }
     }
-    if (thing->class_id < sizeof(class_functions)/sizeof(class_functions[0]))
-        classfunc = class_functions[thing->class_id];
-    else
-        classfunc = NULL;
-    if (classfunc == NULL)
-        return false;
-    if (classfunc(thing) == TUFRet_Deleted) {
-        return false;
-    }
-    SYNCDBG(18,"Class function end ok");
+}
+
+/**
+ * Part of thing update which goes after its class function - inertia, gravity,
+ * animation, sound and light.
+ */
+static void update_thing_after_move(struct Thing *thing)
+{
     if ((thing->movement_flags & TMvF_Immobile) == 0)
     {
         if (thing->mappos.z.val > thing->floor_height)
@@ -3214,6 +3831,28 @@ TbBool update_thing(struct Thing *thing)
             thing->light_id = 0;
         }
     }
+}
+
+TbBool update_thing(struct Thing *thing)
+{
+    Thing_Class_Func classfunc;
+    SYNCDBG(18,"Thing index %d, class %d",(int)thing->index,(int)thing->class_id);
+    TRACE_THING(thing);
+    if (thing_is_invalid(thing))
+        return false;
+
+    update_thing_velocity(thing);
+    if (thing->class_id < sizeof(class_functions)/sizeof(class_functions[0]))
+        classfunc = class_functions[thing->class_id];
+    else
+        classfunc = NULL;
+    if (classfunc == NULL)
+        return false;
+    if (classfunc(thing) == TUFRet_Deleted) {
+        return false;
+    }
+    SYNCDBG(18,"Class function end ok");
+    update_thing_after_move(thing);
     SYNCDBG(18,"Finished");
     return true;
 }
@@ -4143,6 +4782,8 @@ long count_creatures_in_dungeon_controlled_and_of_model_flags(const struct Dunge
 void break_mapwho_infinite_chain(const struct Map *mapblk)
 {
     SYNCDBG(8,"Starting");
+    if (mapwho_sweeps_cache.active)
+        forget_all_mapwho_sweeps();
     long i_first = get_mapwho_thing_index(mapblk);
     long i_prev[2];
     i_prev[1] = 0;
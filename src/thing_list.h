@@ -34,6 +34,7 @@ extern "C" {
 #define SYNCED_THINGS_COUNT    8192
 #define UNSYNCED_THINGS_COUNT  4096
 #define THINGS_COUNT           SYNCED_THINGS_COUNT+UNSYNCED_THINGS_COUNT
+#define THING_LISTS_COUNT      13
 
 enum ThingClassIndex {
     TCls_Empty        =  0,
@@ -184,6 +185,29 @@ struct Things {
     struct Thing *end;
 };
 
+/** State of going through things of a StructureList; see thing_list_sweep_first(). */
+struct ThingListSweep {
+    long list_id;
+    long pos;
+    unsigned long generation;
+    /** Next thing by the list links, used if the dense index was remade during the sweep. */
+    ThingIndex linked_next;
+    unsigned long linked_count;
+};
+
+/** State of going through things on a map block; see mapwho_sweep_first(). */
+struct MapwhoSweep {
+    const struct Map *mapblk;
+    /** Cached block being swept, or -1 if going by the mapwho links. */
+    long cell;
+    unsigned long stamp;
+    unsigned long pos;
+    unsigned long end;
+    /** Next thing by the mapwho links when the current one was given, as it was before it got processed. */
+    ThingIndex next_on_mapblk;
+    unsigned long count;
+};
+
 
 #pragma pack()
 /******************************************************************************/
@@ -197,6 +221,11 @@ void remove_thing_from_its_class_list(struct Thing *thing);
 void add_thing_to_its_class_list(struct Thing *thing);
 ThingIndex get_thing_class_list_head(ThingClass class_id);
 struct StructureList *get_list_for_thing_class(ThingClass class_id);
+void invalidate_thing_lists_index(void);
+void compact_thing_lists_index(void);
+struct Thing *thing_list_sweep_first(struct ThingListSweep *sweep, const struct StructureList *list);
+struct Thing *thing_list_sweep_next(struct ThingListSweep *sweep);
+struct Thing *get_oldest_thing_in_list(const struct StructureList *list);
 
 long creature_near_filter_is_owned_by(const struct Thing *thing, FilterParam val);
 
@@ -255,8 +284,11 @@ long switch_owned_objects_on_destoyed_slab_to_neutral(MapSlabCoord slb_x, MapSla
 struct Thing *get_random_thing_of_class_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param, PlayerNumber plyr_idx);
 struct Thing *get_nth_thing_of_class_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param, long tngindex);
 long count_things_of_class_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param);
+long collect_things_of_class_with_filter(Thing_Maximizer_Filter filter, MaxTngFilterParam param, ThingIndex *tng_idxs, long max_count);
 long do_to_all_things_of_class_and_model(int tngclass, int tngmodel, Thing_Bool_Modifier do_cb);
 // Final routines to select thing anywhere on map but only of one given class
+long collect_things_of_class_and_model_owned_by(int tngclass, int tngmodel, PlayerNumber plyr_idx,
+    const struct Coord3d *center, MapCoordDelta range, ThingIndex *tng_idxs, long max_count);
 struct Thing *get_nearest_thing_of_class_and_model_owned_by(MapCoord pos_x, MapCoord pos_y, PlayerNumber plyr_idx, int tngclass, int tngmodel);
 struct Thing *get_random_trap_of_model_owned_by_and_armed(ThingModel tngmodel, PlayerNumber plyr_idx, TbBool armed);
 struct Thing *get_random_door_of_model_owned_by_and_locked(ThingModel tngmodel, PlayerNumber plyr_idx, TbBool locked);
@@ -306,6 +338,11 @@ struct Thing *find_base_thing_on_mapwho(ThingClass oclass, ThingModel okind, Map
 struct Thing *find_object_of_genre_on_mapwho(long genre, MapSubtlCoord stl_x, MapSubtlCoord stl_y);
 void remove_thing_from_mapwho(struct Thing *thing);
 void place_thing_in_mapwho(struct Thing *thing);
+void start_mapwho_sweeps_cache(void);
+void stop_mapwho_sweeps_cache(void);
+void free_mapwho_sweeps_cache(void);
+struct Thing *mapwho_sweep_first(struct MapwhoSweep *sweep, const struct Map *mapblk);
+struct Thing *mapwho_sweep_next(struct MapwhoSweep *sweep);
 
 struct Thing *find_hero_gate_of_number(long num);
 long get_free_hero_gate_number(void);
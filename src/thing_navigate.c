@@ -33,6 +33,7 @@
 #include "map_blocks.h"
 #include "thing_list.h"
 #include "thing_objects.h"
+#include "packets.h"
 #include "thing_stats.h"
 #include "thing_physics.h"
 #include "dungeon_data.h"
@@ -369,6 +370,7 @@ void move_thing_in_map_f(struct Thing *thing, const struct Coord3d *pos, const c
         place_thing_in_mapwho(thing);
     }
     thing->floor_height = get_thing_height_at(thing, &thing->mappos);
+    touch_replay_integrity_of_thing(thing);
 }
 
 TbBool move_creature_to_nearest_valid_position(struct Thing *thing)
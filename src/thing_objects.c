@@ -46,6 +46,7 @@
 #include "gui_topmsg.h"
 #include "gui_soundmsgs.h"
 #include "engine_arrays.h"
+#include "packets.h"
 #include "sounds.h"
 #include "creature_states_pray.h"
 #include "game_legacy.h"
@@ -261,7 +262,7 @@ void destroy_food(struct Thing *foodtng)
             int required_cap = get_required_room_capacity_for_object(RoRoF_FoodStorage, foodtng->model, 0);
             if (room->used_capacity >= required_cap)
             {
-                room->used_capacity -= required_cap;
+                change_room_used_capacity(room, -required_cap);
             }
             foodtng->food.life_remaining = game.conf.rules[plyr_idx].gameplay.food_life_out_of_hatchery;
         }
@@ -320,6 +321,7 @@ void change_object_owner(struct Thing *objtng, PlayerNumber nowner)
     //TODO make this function more advanced - switch object types and update dungeon and rooms for spellbook/workshop box/lair
     SYNCDBG(6,"Starting for %s, owner %d to %d",thing_model_name(objtng),(int)objtng->owner,(int)nowner);
     objtng->owner = nowner;
+    touch_replay_integrity_of_thing(objtng);
 }
 
 /**
@@ -627,7 +629,7 @@ TbBool creature_remove_lair_totem_from_room(struct Thing *creatng, struct Room *
         result = false;
     } else
     {
-        room->used_capacity -= required_cap;
+        change_room_used_capacity(room, -required_cap);
         room->content_per_model[creatng->model]--;
     }
     cctrl->lair_room_id = 0;
@@ -686,7 +688,7 @@ static long food_moves(struct Thing *objtng)
         {
             if (room_role_matches(room->kind, RoRoF_FoodSpawn) && (room->owner == objtng->owner) && (room->total_capacity > room->used_capacity))
             {
-                room->used_capacity++;
+                change_room_used_capacity(room, 1);
                 objtng->food.life_remaining = -1;
                 objtng->parent_idx = room->index;
             }
@@ -1955,7 +1957,7 @@ struct Thing *create_gold_hoarde(struct Room *room, const struct Coord3d *pos, G
             dungeon->total_money_owned += thing->valuable.gold_stored;
         }
         int wealth_size = get_wealth_size_of_gold_amount(thing->valuable.gold_stored);
-        room->used_capacity += wealth_size;
+        change_room_used_capacity(room, wealth_size);
     }
     return thing;
 }
@@ -1985,7 +1987,7 @@ GoldAmount add_gold_to_hoarde(struct Thing *gldtng, struct Room *room, GoldAmoun
             room_code_name(room->kind),(int)room->index,(int)room->used_capacity,(int)gldtng->index,(int)wealth_size,(long)gldtng->valuable.gold_stored);
         wealth_size = room->used_capacity;
     }
-    room->used_capacity -= wealth_size;
+    change_room_used_capacity(room, -wealth_size);
     // Add amount of gold
     gldtng->valuable.gold_stored += amount;
     room->capacity_used_for_storage += amount;
@@ -1998,9 +2000,10 @@ GoldAmount add_gold_to_hoarde(struct Thing *gldtng, struct Room *room, GoldAmoun
     }
     // Add new wealth size
     wealth_size = get_wealth_size_of_gold_amount(gldtng->valuable.gold_stored);
-    room->used_capacity += wealth_size;
+    change_room_used_capacity(room, wealth_size);
     // switch hoard object model
     gldtng->model = gold_hoard_objects[wealth_size-1];
+    update_replay_integrity_of_thing(gldtng);
     // Set visual appearance
     struct ObjectConfigStats* objst = get_object_model_stats(gldtng->model);
     unsigned short i = objst->sprite_anim_idx;
@@ -2034,7 +2037,7 @@ GoldAmount remove_gold_from_hoarde(struct Thing *gldtng, struct Room *room, Gold
             room_code_name(room->kind),(int)room->index,(int)room->used_capacity,(int)gldtng->index,(int)wealth_size,(long)gldtng->valuable.gold_stored);
         wealth_size = room->used_capacity;
     }
-    room->used_capacity -= wealth_size;
+    change_room_used_capacity(room, -wealth_size);
     // Add amount of gold
     gldtng->valuable.gold_stored -= amount;
     room->capacity_used_for_storage -= amount;
@@ -2050,9 +2053,10 @@ GoldAmount remove_gold_from_hoarde(struct Thing *gldtng, struct Room *room, Gold
     }
     // Add new wealth size
     wealth_size = get_wealth_size_of_gold_amount(gldtng->valuable.gold_stored);
-    room->used_capacity += wealth_size;
+    change_room_used_capacity(room, wealth_size);
     // switch hoard object model
     gldtng->model = gold_hoard_objects[wealth_size-1];
+    update_replay_integrity_of_thing(gldtng);
     // Set visual appearance
     struct ObjectConfigStats* objst = get_object_model_stats(gldtng->model);
     unsigned short i = objst->sprite_anim_idx;
@@ -855,6 +855,44 @@ TbBool things_collide_while_first_moves_to(const struct Thing *firstng, const st
     return thing_on_thing_at(firstng, dstpos, sectng);
 }
 
+/**
+ * Fills the box swept by a thing moving to given position, for quick rejection of things it can't collide with.
+ * @see thing_may_collide_with_move_sweep()
+ */
+void get_thing_move_sweep(struct ThingMoveSweep *sweep, const struct Thing *firstng, const struct Coord3d *dstpos)
+{
+    sweep->min_x = min((MapCoordDelta)firstng->mappos.x.val, (MapCoordDelta)dstpos->x.val);
+    sweep->max_x = max((MapCoordDelta)firstng->mappos.x.val, (MapCoordDelta)dstpos->x.val);
+    sweep->min_y = min((MapCoordDelta)firstng->mappos.y.val, (MapCoordDelta)dstpos->y.val);
+    sweep->max_y = max((MapCoordDelta)firstng->mappos.y.val, (MapCoordDelta)dstpos->y.val);
+    sweep->min_z = min((MapCoordDelta)firstng->mappos.z.val, (MapCoordDelta)dstpos->z.val);
+    sweep->max_z = max((MapCoordDelta)firstng->mappos.z.val, (MapCoordDelta)dstpos->z.val);
+    sweep->size_xy = firstng->solid_size_xy;
+    sweep->size_z = firstng->solid_size_z;
+}
+
+/**
+ * Checks whether a thing is near enough to the box swept by a moving thing to collide with it.
+ * All the points checked by things_collide_while_first_moves_to() lie within the box, so if this
+ * gives false, that function would give false as well; the other way round is not true.
+ */
+TbBool thing_may_collide_with_move_sweep(const struct ThingMoveSweep *sweep, const struct Thing *sectng)
+{
+    MapCoordDelta dist_collide = (sectng->solid_size_xy + sweep->size_xy) / 2;
+    if (((MapCoordDelta)sectng->mappos.x.val <= sweep->min_x - dist_collide) || ((MapCoordDelta)sectng->mappos.x.val >= sweep->max_x + dist_collide)) {
+        return false;
+    }
+    if (((MapCoordDelta)sectng->mappos.y.val <= sweep->min_y - dist_collide) || ((MapCoordDelta)sectng->mappos.y.val >= sweep->max_y + dist_collide)) {
+        return false;
+    }
+    dist_collide = (sectng->solid_size_z + sweep->size_z) / 2;
+    MapCoordDelta shift_z = - (MapCoordDelta)sectng->mappos.z.val - (sectng->solid_size_z >> 1) + (sweep->size_z >> 1);
+    if ((sweep->min_z + shift_z >= dist_collide) || (sweep->max_z + shift_z <= -dist_collide)) {
+        return false;
+    }
+    return true;
+}
+
 TbBool thing_is_exempt_from_z_axis_clipping(const struct Thing *thing)
 {
     if (thing_is_shot(thing))
@@ -35,6 +35,18 @@ struct Dungeon;
 struct ComponentVector;
 
 #pragma pack()
+
+/** Box containing every point checked by things_collide_while_first_moves_to() for a moving thing. */
+struct ThingMoveSweep {
+    MapCoordDelta min_x;
+    MapCoordDelta max_x;
+    MapCoordDelta min_y;
+    MapCoordDelta max_y;
+    MapCoordDelta min_z;
+    MapCoordDelta max_z;
+    unsigned short size_xy;
+    unsigned short size_z;
+};
 /******************************************************************************/
 TbBool thing_touching_floor(const struct Thing *thing);
 TbBool thing_touching_flight_altitude(const struct Thing *thing);
@@ -42,6 +54,8 @@ TbBool thing_above_flight_altitude(const struct Thing* thing);
 
 TbBool thing_on_thing_at(const struct Thing *firstng, const struct Coord3d *pos, const struct Thing *sectng);
 TbBool things_collide_while_first_moves_to(const struct Thing *firstng, const struct Coord3d *dstpos, const struct Thing *sectng);
+void get_thing_move_sweep(struct ThingMoveSweep *sweep, const struct Thing *firstng, const struct Coord3d *dstpos);
+TbBool thing_may_collide_with_move_sweep(const struct ThingMoveSweep *sweep, const struct Thing *sectng);
 TbBool cross_x_boundary_first(const struct Coord3d *pos1, const struct Coord3d *pos2);
 TbBool cross_y_boundary_first(const struct Coord3d *pos1, const struct Coord3d *pos2);
 
@@ -1443,7 +1443,8 @@ HitTargetFlags collide_filter_thing_is_shootable(const struct Thing *thing, cons
     return thing_is_shootable(thing, shot_owner, hit_targets);
 }
 
-struct Thing *get_thing_collided_with_at_satisfying_filter_for_subtile(struct Thing *shotng, struct Coord3d *pos, Thing_Collide_Func filter, HitTargetFlags param1, long param2, MapSubtlCoord stl_x, MapSubtlCoord stl_y)
+static struct Thing *get_thing_collided_with_at_satisfying_filter_for_subtile(struct Thing *shotng, struct Coord3d *pos, const struct ThingMoveSweep *sweep,
+    Thing_Collide_Func filter, HitTargetFlags param1, long param2, MapSubtlCoord stl_x, MapSubtlCoord stl_y)
 {
     struct Thing* parntng = get_parent_thing(shotng);
     struct Map* mapblk = get_map_block_at(stl_x, stl_y);
@@ -1460,7 +1461,8 @@ struct Thing *get_thing_collided_with_at_satisfying_filter_for_subtile(struct Th
         }
         i = thing->next_on_mapblk;
         // Per thing code start
-        if (thing->index != shotng->index)
+        // Things far from the path are dropped before the filter, as most things on mapwho are nowhere near it
+        if ((thing->index != shotng->index) && thing_may_collide_with_move_sweep(sweep, thing))
         {
             if (filter(thing, parntng, param1, param2))
             {
@@ -1481,8 +1483,15 @@ struct Thing *get_thing_collided_with_at_satisfying_filter_for_subtile(struct Th
     return false;
 }
 
+/**
+ * Finds a thing which the moving thing collides with on its way to given position.
+ * Searches subtiles around the target position; within them, only things near the path
+ * of the moving thing are given to the filter.
+ */
 struct Thing *get_thing_collided_with_at_satisfying_filter(struct Thing *shotng, struct Coord3d *pos, Thing_Collide_Func filter, HitTargetFlags hit_targets, long a5)
 {
+    struct ThingMoveSweep sweep;
+    get_thing_move_sweep(&sweep, shotng, pos);
     MapSubtlCoord stl_x_min;
     MapSubtlCoord stl_y_min;
     MapSubtlCoord stl_x_max;
@@ -1506,7 +1515,7 @@ struct Thing *get_thing_collided_with_at_satisfying_filter(struct Thing *shotng,
     {
         for (MapSubtlCoord stl_x = stl_x_min; stl_x <= stl_x_max; stl_x++)
         {
-            struct Thing* coltng = get_thing_collided_with_at_satisfying_filter_for_subtile(shotng, pos, filter, hit_targets, a5, stl_x, stl_y);
+            struct Thing* coltng = get_thing_collided_with_at_satisfying_filter_for_subtile(shotng, pos, &sweep, filter, hit_targets, a5, stl_x, stl_y);
             if (!thing_is_invalid(coltng)) {
                 return coltng;
             }
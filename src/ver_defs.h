@@ -0,0 +1,7 @@
+#define VER_MAJOR       1
+#define VER_MINOR       3
+#define VER_RELEASE     1
+#define VER_BUILD       0
+#define VER_STRING      "1.3.1.0 "
+#define PACKAGE_SUFFIX  ""
+
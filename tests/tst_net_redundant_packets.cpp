@@ -0,0 +1,168 @@
+#include "tst_main.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <packets.h>
+#include <net_redundant_packets.h>
+#include <net_received_packets.h>
+
+#define SENDER_PLAYER 0
+#define SOURCE_PLAYER 1
+
+static struct Packet make_packet(GameTurn turn, unsigned char action, int32_t actn_par1, int32_t pos_x, int32_t pos_y, uint32_t control_flags)
+{
+    struct Packet pckt;
+    memset(&pckt, 0, sizeof(pckt));
+    pckt.turn = turn;
+    pckt.checksum = 0x9E3779B9u ^ turn;
+    pckt.action = action;
+    pckt.actn_par1 = actn_par1;
+    pckt.pos_x = pos_x;
+    pckt.pos_y = pos_y;
+    pckt.control_flags = control_flags;
+    return pckt;
+}
+
+static bool packets_equal(const struct Packet *a, const struct Packet *b)
+{
+    return (a->turn == b->turn) && (a->checksum == b->checksum) && (a->action == b->action)
+        && (a->actn_par1 == b->actn_par1) && (a->actn_par2 == b->actn_par2)
+        && (a->pos_x == b->pos_x) && (a->pos_y == b->pos_y) && (a->control_flags == b->control_flags)
+        && (a->additional_packet_values == b->additional_packet_values)
+        && (a->actn_par3 == b->actn_par3) && (a->actn_par4 == b->actn_par4);
+}
+
+static void reset_packets()
+{
+    initialize_redundant_packets();
+    initialize_packet_tracking();
+}
+
+ADD_TEST(test_bundle_round_trip)
+{
+    reset_packets();
+    struct Packet p1 = make_packet(100, 5, 12, 3000, 4000, 0x0001);
+    struct Packet p2 = make_packet(101, 5, -7, 2990, 4100, 0x8001);
+    p2.actn_par2 = INT32_MIN;
+    p2.actn_par4 = INT32_MAX;
+    p2.additional_packet_values = 0xA5;
+    struct Packet p3 = make_packet(102, 9, -7, 12, 4100, 0x8000);
+    p3.actn_par3 = -1;
+    store_sent_packet(SENDER_PLAYER, &p1);
+    store_sent_packet(SENDER_PLAYER, &p2);
+    char buf[BUNDLED_PACKETS_MAX_SIZE];
+    size_t size = bundle_packets(SENDER_PLAYER, &p3, buf);
+    CU_ASSERT(size > 0);
+    CU_ASSERT(size <= BUNDLED_PACKETS_MAX_SIZE);
+
+    struct Packet current;
+    memset(&current, 0, sizeof(current));
+    CU_ASSERT(unbundle_packets(buf, size, SOURCE_PLAYER, &current));
+    CU_ASSERT(packets_equal(&current, &p3));
+    const struct Packet *rcvd = get_received_packet_for_player(p1.turn, SOURCE_PLAYER);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(rcvd);
+    CU_ASSERT(packets_equal(rcvd, &p1));
+    rcvd = get_received_packet_for_player(p2.turn, SOURCE_PLAYER);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(rcvd);
+    CU_ASSERT(packets_equal(rcvd, &p2));
+}
+
+ADD_TEST(test_bundle_first_turn_without_history)
+{
+    reset_packets();
+    struct Packet p1 = make_packet(1, 2, 0, 0, 0, 0);
+    char buf[BUNDLED_PACKETS_MAX_SIZE];
+    size_t size = bundle_packets(SENDER_PLAYER, &p1, buf);
+    CU_ASSERT_EQUAL(buf[0], 1);
+
+    struct Packet current;
+    CU_ASSERT(unbundle_packets(buf, size, SOURCE_PLAYER, &current));
+    CU_ASSERT(packets_equal(&current, &p1));
+}
+
+ADD_TEST(test_bundle_with_empty_packet)
+{
+    reset_packets();
+    struct Packet empty;
+    memset(&empty, 0, sizeof(empty));
+    struct Packet p1 = make_packet(40, 3, 1, 2, 3, 4);
+    struct Packet p3 = make_packet(42, 3, 1, 2, 3, 4);
+    store_sent_packet(SENDER_PLAYER, &p1);
+    store_sent_packet(SENDER_PLAYER, &empty);
+    char buf[BUNDLED_PACKETS_MAX_SIZE];
+    size_t size = bundle_packets(SENDER_PLAYER, &p3, buf);
+
+    struct Packet current;
+    CU_ASSERT(unbundle_packets(buf, size, SOURCE_PLAYER, &current));
+    CU_ASSERT(packets_equal(&current, &p3));
+    const struct Packet *rcvd = get_received_packet_for_player(p1.turn, SOURCE_PLAYER);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(rcvd);
+    CU_ASSERT(packets_equal(rcvd, &p1));
+}
+
+ADD_TEST(test_bundle_recovers_missing_packets)
+{
+    reset_packets();
+    struct Packet sent[4];
+    for (int i = 0; i < 4; i++)
+    {
+        sent[i] = make_packet(200 + i, 7, i * 3, 1000 - i * 50, 800 + i, 1u << i);
+    }
+    // The receiver only got the first packet; the next two were lost
+    store_received_packet(sent[0].turn, SOURCE_PLAYER, &sent[0]);
+    CU_ASSERT_PTR_NULL(get_received_packet_for_player(sent[1].turn, SOURCE_PLAYER));
+    CU_ASSERT_PTR_NULL(get_received_packet_for_player(sent[2].turn, SOURCE_PLAYER));
+
+    store_sent_packet(SENDER_PLAYER, &sent[0]);
+    store_sent_packet(SENDER_PLAYER, &sent[1]);
+    store_sent_packet(SENDER_PLAYER, &sent[2]);
+    char buf[BUNDLED_PACKETS_MAX_SIZE];
+    size_t size = bundle_packets(SENDER_PLAYER, &sent[3], buf);
+    CU_ASSERT_EQUAL(buf[0] & 0x03, REDUNDANT_PACKET_COUNT);
+
+    struct Packet current;
+    CU_ASSERT(unbundle_packets(buf, size, SOURCE_PLAYER, &current));
+    CU_ASSERT(packets_equal(&current, &sent[3]));
+    for (int i = 0; i < 3; i++)
+    {
+        const struct Packet *rcvd = get_received_packet_for_player(sent[i].turn, SOURCE_PLAYER);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(rcvd);
+        CU_ASSERT(packets_equal(rcvd, &sent[i]));
+    }
+}
+
+ADD_TEST(test_unbundle_rejects_truncated_input)
+{
+    reset_packets();
+    struct Packet p1 = make_packet(300, 5, 100000, -5, 70000, 0xFFFFFFFFu);
+    struct Packet p2 = make_packet(301, 6, -100000, 5, 0, 0x10);
+    store_sent_packet(SENDER_PLAYER, &p1);
+    char buf[BUNDLED_PACKETS_MAX_SIZE];
+    size_t size = bundle_packets(SENDER_PLAYER, &p2, buf);
+
+    struct Packet current;
+    for (size_t len = 0; len < size; len++)
+    {
+        CU_ASSERT_FALSE(unbundle_packets(buf, len, SOURCE_PLAYER, &current));
+    }
+    CU_ASSERT_PTR_NULL(get_received_packet_for_player(p1.turn, SOURCE_PLAYER));
+    CU_ASSERT_PTR_NULL(get_received_packet_for_player(p2.turn, SOURCE_PLAYER));
+    CU_ASSERT(unbundle_packets(buf, size, SOURCE_PLAYER, &current));
+}
+
+ADD_TEST(test_unbundle_rejects_malformed_input)
+{
+    reset_packets();
+    struct Packet current;
+    // No packets in the bundle
+    const char no_packets[] = {0x00};
+    CU_ASSERT_FALSE(unbundle_packets(no_packets, sizeof(no_packets), SOURCE_PLAYER, &current));
+    // Field mask varint which never ends
+    const char endless_varint[] = {0x01, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF};
+    CU_ASSERT_FALSE(unbundle_packets(endless_varint, sizeof(endless_varint), SOURCE_PLAYER, &current));
+    // Invalid source player
+    char buf[BUNDLED_PACKETS_MAX_SIZE];
+    struct Packet p1 = make_packet(5, 1, 1, 1, 1, 1);
+    size_t size = bundle_packets(SENDER_PLAYER, &p1, buf);
+    CU_ASSERT_FALSE(unbundle_packets(buf, size, -1, &current));
+}
@@ -0,0 +1,89 @@
+#include "tst_main.h"
+
+#include <string.h>
+#include <keeperfx.hpp>
+#include <game_legacy.h>
+#include <packets.h>
+#include <thing_data.h>
+#include <thing_list.h>
+
+#define TEST_THING_INDEX 5
+
+static struct Thing *make_test_thing(void)
+{
+    init_lookups();
+    struct Thing *thing = thing_get(TEST_THING_INDEX);
+    memset(thing, 0, sizeof(struct Thing));
+    thing->alloc_flags = TAlF_Exists;
+    thing->index = TEST_THING_INDEX;
+    thing->class_id = TCls_Object;
+    thing->model = 3;
+    thing->owner = 1;
+    thing->mappos.x.val = 1000;
+    thing->mappos.y.val = 2000;
+    thing->mappos.z.val = 0;
+    thing->move_angle_xy = 512;
+    invalidate_replay_integrity();
+    return thing;
+}
+
+static void delete_test_thing(struct Thing *thing)
+{
+    memset(thing, 0, sizeof(struct Thing));
+    invalidate_replay_integrity();
+}
+
+static TbBigChecksum full_scan_replay_integrity(void)
+{
+    invalidate_replay_integrity();
+    return compute_replay_integrity();
+}
+
+ADD_TEST(test_replay_integrity_moved_thing_changes_checksum)
+{
+    struct Thing *thing = make_test_thing();
+    TbBigChecksum sum_before = compute_replay_integrity();
+    thing->mappos.x.val += 256;
+    touch_replay_integrity_of_thing(thing);
+    TbBigChecksum sum_moved = compute_replay_integrity();
+    CU_ASSERT_NOT_EQUAL(sum_moved, sum_before);
+    // The kept checksum has to match one built from scratch
+    CU_ASSERT_EQUAL(sum_moved, full_scan_replay_integrity());
+    // Moving back gives the previous checksum
+    thing->mappos.x.val -= 256;
+    touch_replay_integrity_of_thing(thing);
+    CU_ASSERT_EQUAL(compute_replay_integrity(), sum_before);
+    delete_test_thing(thing);
+}
+
+ADD_TEST(test_replay_integrity_owner_and_angle_change_checksum)
+{
+    struct Thing *thing = make_test_thing();
+    TbBigChecksum sum_before = compute_replay_integrity();
+    thing->owner = 2;
+    touch_replay_integrity_of_thing(thing);
+    TbBigChecksum sum_owner = compute_replay_integrity();
+    CU_ASSERT_NOT_EQUAL(sum_owner, sum_before);
+    CU_ASSERT_EQUAL(sum_owner, full_scan_replay_integrity());
+    thing->move_angle_xy = 1024;
+    touch_replay_integrity_of_thing(thing);
+    TbBigChecksum sum_angle = compute_replay_integrity();
+    CU_ASSERT_NOT_EQUAL(sum_angle, sum_owner);
+    CU_ASSERT_EQUAL(sum_angle, full_scan_replay_integrity());
+    delete_test_thing(thing);
+}
+
+ADD_TEST(test_replay_integrity_touched_once_per_turn)
+{
+    struct Thing *thing = make_test_thing();
+    compute_replay_integrity();
+    // Thing moved several times within a turn is hashed with its final position
+    for (int i = 0; i < 4; i++)
+    {
+        thing->mappos.y.val += 64;
+        touch_replay_integrity_of_thing(thing);
+    }
+    TbBigChecksum sum_kept = compute_replay_integrity();
+    CU_ASSERT_EQUAL(sum_kept, full_scan_replay_integrity());
+    delete_test_thing(thing);
+}
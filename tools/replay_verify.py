@@ -0,0 +1,150 @@
+"""
+Verifies many recorded packet files (.pck) against the current game build.
+
+Each file is played in a separate keeperfx process started with -packetverify,
+which fast forwards the whole replay with checksum verification and quits at its
+end or at the first turn where the game state differs from the recording.
+The processes run in parallel; the result line each one writes to its log is
+collected into a per-file report.
+
+Usage:
+    python3 tools/replay_verify.py --game <dir with keeperfx> [options] <.pck files or dirs>
+
+Exit code is 0 when all files pass, 1 if any file diverged or failed to run,
+2 when the game or the packet files are not found.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from typing import List, Optional
+
+RESULT_LINE = re.compile(
+    r'PacketVerify: result=(?P<result>\w+) turns=(?P<turns>\d+) stored=(?P<stored>\d+) '
+    r'diverged_at=(?P<diverged_at>-?\d+) elapsed_ms=(?P<elapsed_ms>\d+) '
+    r'turns_per_sec=(?P<tps>[\d.]+)')
+
+
+class VerifyResult:
+    def __init__(self, path: str):
+        self.path = path
+        self.result = "ERROR"
+        self.turns = 0
+        self.stored = 0
+        self.diverged_at = -1
+        self.turns_per_sec = 0.0
+        self.exit_code: Optional[int] = None
+        self.note = ""
+
+    @property
+    def passed(self) -> bool:
+        return self.result == "PASS"
+
+
+def _find_executable(game_dir: str, name: Optional[str]) -> Optional[str]:
+    candidates = [name] if name else ["keeperfx.exe", "keeperfx"]
+    for cand in candidates:
+        path = cand if os.path.isabs(cand) else os.path.join(game_dir, cand)
+        if os.path.isfile(path):
+            return path
+    return None
+
+
+def _collect_files(inputs: List[str]) -> List[str]:
+    files = []
+    for item in inputs:
+        if os.path.isdir(item):
+            for root, _, names in os.walk(item):
+                files.extend(os.path.join(root, n) for n in sorted(names) if n.lower().endswith(".pck"))
+        else:
+            files.append(item)
+    return files
+
+
+def _verify_one(exe: str, game_dir: str, path: str, index: int, timeout: float, keep_logs: bool) -> VerifyResult:
+    res = VerifyResult(path)
+    # The log goes to the game data folder; every worker needs a file of its own
+    log_name = f"replay_verify_{os.getpid()}_{index}.log"
+    log_path = os.path.join(game_dir, log_name)
+    env = dict(os.environ)
+    env.setdefault("SDL_VIDEODRIVER", "dummy")
+    env.setdefault("SDL_AUDIODRIVER", "dummy")
+    cmd = [exe, "-packetverify", os.path.abspath(path), "-nointro", "-nosound", "-log", log_name]
+    try:
+        proc = subprocess.run(cmd, cwd=game_dir, env=env, timeout=timeout,
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        res.exit_code = proc.returncode
+    except subprocess.TimeoutExpired:
+        res.note = f"timed out after {timeout:.0f}s"
+    try:
+        with open(log_path, "r", errors="replace") as f:
+            for line in f:
+                m = RESULT_LINE.search(line)
+                if m:
+                    res.result = m.group("result")
+                    res.turns = int(m.group("turns"))
+                    res.stored = int(m.group("stored"))
+                    res.diverged_at = int(m.group("diverged_at"))
+                    res.turns_per_sec = float(m.group("tps"))
+    except OSError:
+        if not res.note:
+            res.note = "no log written"
+    else:
+        if not keep_logs and res.passed:
+            os.remove(log_path)
+        elif not res.passed:
+            res.note = res.note or f"see {log_path}"
+    return res
+
+
+def _format(res: VerifyResult) -> str:
+    if res.result == "FAIL":
+        detail = f"diverged at turn {res.diverged_at}"
+    elif res.result == "PASS":
+        detail = f"{res.turns} turns"
+    else:
+        detail = res.note or f"exit code {res.exit_code}"
+    return f"{res.result:5} {res.turns_per_sec:9.1f} turns/s  {detail:30}  {res.path}"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Verify packet files in parallel keeperfx processes.")
+    parser.add_argument("inputs", nargs="+", help="packet files, or folders searched for *.pck")
+    parser.add_argument("--game", required=True, help="folder of the game install to run")
+    parser.add_argument("--exe", help="game executable, relative to --game (default keeperfx[.exe])")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1, help="parallel processes")
+    parser.add_argument("--timeout", type=float, default=600.0, help="seconds allowed per file")
+    parser.add_argument("--keep-logs", action="store_true", help="keep logs of passed files too")
+    args = parser.parse_args()
+
+    game_dir = os.path.abspath(args.game)
+    exe = _find_executable(game_dir, args.exe)
+    if exe is None:
+        print(f"ERROR: game executable not found in {game_dir}", file=sys.stderr)
+        return 2
+    files = _collect_files(args.inputs)
+    if not files:
+        print("ERROR: no packet files given", file=sys.stderr)
+        return 2
+
+    start = time.monotonic()
+    results = []
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        futures = [pool.submit(_verify_one, exe, game_dir, path, i, args.timeout, args.keep_logs)
+                   for i, path in enumerate(files)]
+        for fut in as_completed(futures):
+            res = fut.result()
+            results.append(res)
+            print(_format(res), flush=True)
+
+    failed = [r for r in results if not r.passed]
+    print(f"\n{len(results) - len(failed)}/{len(results)} passed in {time.monotonic() - start:.1f}s")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())